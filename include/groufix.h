@@ -15,6 +15,7 @@
 #include "groufix/core/formats.h"
 #include "groufix/core/gamepad.h"
 #include "groufix/core/heap.h"
+#include "groufix/core/jobs.h"
 #include "groufix/core/keys.h"
 #include "groufix/core/log.h"
 #include "groufix/core/refs.h"
@@ -90,5 +91,17 @@ GFX_API void gfx_wait_events(void);
  */
 GFX_API void gfx_wake(void);
 
+/**
+ * Logs contention statistics of all internal locks (at info level).
+ * Only available if groufix was built with GFX_LOCK_STATS defined
+ * (i.e. `make LOCK_STATS=ON`), otherwise a warning is logged.
+ * Can be called from any thread.
+ *
+ * Statistics are aggregated per lock initialization site and reset by
+ * gfx_terminate. Per site it logs the number of (contended) acquisitions,
+ * total & max wait time and average & max hold time (of writers only).
+ */
+GFX_API void gfx_debug_lock_stats(void);
+
 
 #endif
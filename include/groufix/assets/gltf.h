@@ -55,6 +55,22 @@ typedef enum GFXGltfMaterialFlags
 GFX_BIT_FIELD(GFXGltfMaterialFlags)
 
 
+/**
+ * glTF vertex attribute quantization flags.
+ */
+typedef enum GFXGltfQuantizeFlags
+{
+	GFX_GLTF_QUANTIZE_NONE      = 0x0000,
+	GFX_GLTF_QUANTIZE_NORMALS   = 0x0001, // Octahedral SNORM16 normals & tangents.
+	GFX_GLTF_QUANTIZE_NORMALS_8 = 0x0003, // Octahedral SNORM8, implies NORMALS.
+	GFX_GLTF_QUANTIZE_TEXCOORDS = 0x0004, // UNORM16 if within [0,1], half otherwise.
+	GFX_GLTF_QUANTIZE_POSITIONS = 0x0008  // UNORM16 within the mesh bounds.
+
+} GFXGltfQuantizeFlags;
+
+GFX_BIT_FIELD(GFXGltfQuantizeFlags)
+
+
 /**
  * glTF material alpha mode.
  */
@@ -72,9 +88,8 @@ typedef enum GFXGltfAlphaMode
  */
 typedef struct GFXGltfBuffer
 {
-	size_t     size;
-	void*      bin;
-	GFXBuffer* buffer;
+	size_t size;
+	void*  bin;
 
 } GFXGltfBuffer;
 
@@ -194,6 +209,25 @@ typedef struct GFXGltfMaterial
 } GFXGltfMaterial;
 
 
+/**
+ * glTF primitive level of detail definition.
+ */
+typedef struct GFXGltfLod
+{
+	GFXBufferRef indices; // Referencing GFXGltfResult::buffer.
+	uint32_t     numIndices;
+
+	// Approximate (object-space) deviation from the full-resolution
+	// primitive: the square root of the area-weighted quadric error in unit
+	// cube space, scaled by the largest mesh extent. Not a strict bound, but
+	// usable to select levels; it projects to roughly
+	// error / distance * (viewport height / 2) pixels for a perspective
+	// projection with a vertical fov of 90 degrees.
+	float error;
+
+} GFXGltfLod;
+
+
 /**
  * glTF primitive definition.
  */
@@ -202,6 +236,30 @@ typedef struct GFXGltfPrimitive
 	GFXPrimitive*    primitive;
 	GFXGltfMaterial* material;
 
+	// Vertex input of primitive, referencing GFXGltfResult::buffer.
+	GFXBufferRef  indices; // GFX_REF_NULL if not indexed.
+	size_t        numAttributes;
+	GFXAttribute* attributes;
+
+	// Position dequantization, p * posScale + posOffset.
+	float posScale;
+	float posOffset[3];
+
+	// Object-space bounds of all (dequantized) positions, min > max if unknown.
+	float min[3];
+	float max[3];
+
+	// Levels of detail, coarser & in ascending error, 0 if not generated.
+	// Drawn with the same vertex input & index size as the primitive itself.
+	size_t      numLods;
+	GFXGltfLod* lods;
+
+	// Meshlets, referencing GFXGltfResult::meshlets, 0 if not built.
+	size_t       numMeshlets;
+	GFXBufferRef meshlets;  // GFXMeshlet descriptors.
+	GFXBufferRef vertices;  // uint32_t vertex indices.
+	GFXBufferRef triangles; // uint8_t[3] local vertex indices.
+
 } GFXGltfPrimitive;
 
 
@@ -259,6 +317,8 @@ typedef struct GFXGltfResult
 
 	size_t         numBuffers;
 	GFXGltfBuffer* buffers;
+	GFXBuffer*     buffer;   // Packed vertex & index data, may be NULL.
+	GFXBuffer*     meshlets; // Packed meshlet data, may be NULL.
 
 	size_t     numImages;
 	GFXImage** images;
@@ -294,6 +354,19 @@ typedef struct GFXGltfOptions
 	size_t       orderSize;      // Size of `attributeOrder`.
 	const char** attributeOrder; // Name index -> attribute location.
 
+	bool         parallel;   // Non-zero to load buffers & images in parallel.
+	unsigned int numThreads; // Maximum #threads (including the caller), 0 = #CPUs.
+
+	bool  optimize; // Non-zero to reorder triangles & vertices for the GPU.
+	float overdraw; // Overdraw reordering threshold (e.g. 1.05), 0 to disable.
+
+	GFXGltfQuantizeFlags quantize; // Vertex attributes to quantize.
+
+	bool meshlets; // Non-zero to build meshlets for indexed triangle lists.
+
+	size_t       numLods;   // Levels of detail to generate.
+	const float* lodErrors; // Maximum error of each level, relative to mesh extents.
+
 } GFXGltfOptions;
 
 
@@ -308,6 +381,69 @@ typedef struct GFXGltfOptions
  * @param inc     Optional stream includer.
  * @param result  Cannot be NULL, output parsing results.
  * @return Non-zero on success.
+ *
+ * If options->parallel is set, all buffers and images are read & decoded in
+ * parallel on the job scheduler of groufix, the calling thread helps out and
+ * blocks until done. inc is accessed by one thread at a time, but image
+ * streams it resolved may be read by multiple threads concurrently.
+ * The order of all results is the same either way.
+ * All uploads are recorded as asynchronous transfers, they are not flushed.
+ *
+ * EXT_meshopt_compression buffer views are decoded (see groufix/assets/mesh.h)
+ * directly into their host buffer in result->buffers, on the same threads.
+ * Buffers that only hold such decoded data are not read from the stream.
+ * Decoded data is host data like any other buffer data; all processing reads
+ * from it and its referenced ranges are copied into result->buffer on upload.
+ *
+ * Only the byte ranges of buffer views referenced by vertex and index
+ * accessors are uploaded, packed into the single result->buffer, which all
+ * primitives reference. Other data (e.g. images) never ends up on the GPU.
+ *
+ * If options->optimize is set, the triangles of indexed triangle lists are
+ * reordered for vertex cache efficiency, then for overdraw if
+ * options->overdraw is set (see gfx_mesh_optimize_overdraw), after which
+ * their vertices are reordered to match (see groufix/assets/mesh.h).
+ * Optimized primitives get their own de-interleaved copy of all consumed
+ * attributes. The time taken & achieved ACMR are logged as info.
+ *
+ * If options->quantize is set, 32-bit float attributes are converted to
+ * smaller formats, given the device supports them as vertex attributes:
+ *  NORMALS:   normals become RG octahedral encodings, tangents become
+ *             RGBA as (octahedral x, octahedral y, w, 0), both SNORM.
+ *  TEXCOORDS: RG UNORM16 if all values are within [0,1], RG half otherwise.
+ *  POSITIONS: RGBA UNORM16 with w = 0, normalized to the bounds of the mesh.
+ *             Shaders must compute xyz * posScale + posOffset, which is
+ *             the same for all quantized primitives of a mesh and the
+ *             identity for non-quantized primitives.
+ * Quantized primitives also get their own de-interleaved copy of all
+ * consumed attributes. Attributes that are already quantized
+ * (KHR_mesh_quantization) are consumed as-is.
+ *
+ * If options->meshlets is set, indexed triangle lists with float positions
+ * are split into meshlets after optimization (see gfx_mesh_build_meshlets),
+ * using GFX_MESHLET_MAX_VERTICES and GFX_MESHLET_MAX_TRIANGLES. Their
+ * descriptors, vertex indices & triangles are packed into result->meshlets,
+ * a storage buffer, each range aligned to be bound to a GFXGroup as-is.
+ * Triangles are padded to 4 bytes so shaders can read them as uints.
+ * The triangles of each meshlet are also a range of the primitive's indices,
+ * so culled meshlets can be drawn without mesh shaders using indirect draws.
+ * Such primitives also get their own de-interleaved copy of all attributes.
+ *
+ * If options->numLods is set, indexed triangle lists with float positions are
+ * simplified after optimization (see gfx_mesh_simplify), once for each error
+ * in options->lodErrors (e.g. 0.01 for 1% of the largest mesh extent).
+ * The indices of each level are packed into result->buffer, levels that do
+ * not remove any more triangles are skipped. Such primitives also get their
+ * own de-interleaved copy of all attributes.
+ *
+ * If flags contains GFX_IMAGE_READABLE, result->buffer & result->meshlets
+ * are allocated with GFX_MEMORY_READ_WRITE, which gfx_store_gltf_cache requires.
+ *
+ * Images sampled by any texture with a mipmap min filter are loaded with
+ * GFX_IMAGE_MIPMAPS, their mipmaps are generated on the graphics queue.
+ * KTX2 images are loaded using gfx_load_ktx2. For textures with a
+ * KHR_texture_basisu source, its fallback image is only loaded if the source
+ * could not be loaded, e.g. if the device does not support its format.
  */
 GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
                            const GFXGltfOptions* options,
@@ -325,5 +461,40 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
  */
 GFX_API void gfx_release_gltf(GFXGltfResult* result);
 
+/**
+ * Stores a parsing result as a binary cache, see gfx_load_gltf_cache.
+ * @param result Cannot be NULL, loaded with GFX_IMAGE_READABLE.
+ * @param dst    Destination stream, cannot be NULL.
+ * @return Non-zero on success.
+ *
+ * All vertex, index & image data is read back from the GPU, meaning this
+ * blocks until all prior operations on them are done (see gfx_read).
+ * result->buffers are not stored.
+ */
+GFX_API bool gfx_store_gltf_cache(const GFXGltfResult* result,
+                                  const GFXWriter* dst);
+
+/**
+ * Loads a binary cache stored by gfx_store_gltf_cache.
+ * @param heap   Heap to allocate resources from, cannot be NULL.
+ * @param sem    Semaphore to inject signal commands in, cannot be NULL.
+ * @param flags  Only GFX_IMAGE_READABLE is used.
+ * @param usage  Image usage to use for any images.
+ * @param src    Source stream, cannot be NULL.
+ * @param result Cannot be NULL, output results, as by gfx_load_gltf.
+ * @return Zero on failure or if stored by a different version or build.
+ *
+ * The cache holds processed vertex, index & meshlet data and all images in
+ * their final format (including mipmaps), which are uploaded straight from
+ * the source stream; if it is in memory (see gfx_io_raw_init), it is not copied.
+ * The cache is specific to the build of groufix that stored it.
+ * Images are the same as stored, regardless of device support.
+ * result->buffers will be empty, clear result with gfx_release_gltf.
+ */
+GFX_API bool gfx_load_gltf_cache(GFXHeap* heap, GFXSemaphore* sem,
+                                 GFXImageFlags flags, GFXImageUsage usage,
+                                 const GFXReader* src,
+                                 GFXGltfResult* result);
+
 
 #endif
@@ -27,7 +27,13 @@ typedef enum GFXImageFlags
 	GFX_IMAGE_KEEP_FORMAT = 0x0003, // Both KEEP_TYPE and KEEP_ORDER.
 
 	GFX_IMAGE_TYPE_BEFORE_ORDER = 0x0004,
-	GFX_IMAGE_ORDER_BEFORE_TYPE = 0x0008
+	GFX_IMAGE_ORDER_BEFORE_TYPE = 0x0008,
+
+	GFX_IMAGE_MIPMAPS     = 0x0010, // Allocate & generate all mipmaps.
+	GFX_IMAGE_COMPRESS    = 0x0020, // Encode to BC1/BC3/BC4/BC5 on the CPU.
+	GFX_IMAGE_COMPRESS_HQ = 0x0060, // Implies COMPRESS, BC7 for RGB(A).
+	GFX_IMAGE_READABLE    = 0x0080, // Allocate with GFX_MEMORY_READ_WRITE.
+	GFX_IMAGE_HALF        = 0x0100  // Load HDR images as 16-bit floats.
 
 } GFXImageFlags;
 
@@ -41,10 +47,77 @@ GFX_BIT_FIELD(GFXImageFlags)
  * @param flags Flags to influence the format of the allocated image.
  * @param src   Source stream, cannot be NULL.
  * @return NULL on failure.
+ *
+ * KTX2 streams are recognized and forwarded to gfx_load_ktx2.
+ *
+ * If GFX_IMAGE_MIPMAPS is given, the full mipmap chain is allocated and
+ * generated on the GPU (see GFX_TRANSFER_MIPMAPS), the image is allocated with
+ * GFX_MEMORY_READ_WRITE. If the format does not support linear blitting,
+ * only a single mipmap is allocated.
+ * The loaded image is signaled in sem only after all mipmaps are generated.
+ *
+ * If GFX_IMAGE_COMPRESS is given, 8-bit images are encoded on the CPU to
+ * BC4, BC5, BC1 or BC3 for 1, 2, 3 or 4 components respectively, or to BC7
+ * for 3 or 4 components if GFX_IMAGE_COMPRESS_HQ is given.
+ * Mipmaps are then generated on the CPU and the image is allocated with
+ * GFX_MEMORY_WRITE. Falls back to an uncompressed format if the device does
+ * not support the compressed format with the given usage.
+ *
+ * If GFX_IMAGE_READABLE is given, the image is always allocated with
+ * GFX_MEMORY_READ_WRITE, so it can be read back (e.g. see gfx_read).
+ *
+ * If GFX_IMAGE_HALF is given, HDR images are converted to 16-bit floats on
+ * the CPU (rounding to nearest even), halving their size. If not supported,
+ * falls back to 16-bit and 8-bit integers like any other HDR image.
+ * Component expansion (e.g. RGB to RGBA if RGB is not supported) and type
+ * narrowing are done on the CPU as well, using SSE2 if available.
  */
 GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
                                  GFXImageFlags flags, GFXImageUsage usage,
                                  const GFXReader* src);
 
+/**
+ * Parses a KTX2 stream into a groufix image, uploading all levels as-is.
+ * @param heap  Heap to allocate the image from, cannot be NULL.
+ * @param sem   Semaphore to inject signal commands in, cannot be NULL.
+ * @param flags Only GFX_IMAGE_MIPMAPS and GFX_IMAGE_READABLE are used.
+ * @param src   Source stream, cannot be NULL.
+ * @return NULL on failure.
+ *
+ * Block-compressed (BCn/ETC2/EAC/ASTC) data is uploaded without decoding,
+ * fails if the device does not support the stored format with the given
+ * usage, allowing the caller to fall back to another source.
+ * Supercompressed (e.g. Basis Universal) data is not supported.
+ * If the stream is in memory (see gfx_io_raw_init), it is not copied.
+ * GFX_IMAGE_MIPMAPS is only used if the stream specifies a level count of 0.
+ */
+GFX_API GFXImage* gfx_load_ktx2(GFXHeap* heap, GFXSemaphore* sem,
+                                GFXImageFlags flags, GFXImageUsage usage,
+                                const GFXReader* src);
+
+/**
+ * Encodes 8-bit image data into BCn blocks on the CPU.
+ * @param fmt        Must be a BC1, BC3, BC4, BC5 or BC7 UNORM or SRGB format.
+ * @param width      Must be > 0.
+ * @param height     Must be > 0.
+ * @param comps      Components per texel in src, must be 1 to 4.
+ * @param src        Tightly packed texels, cannot be NULL.
+ * @param dst        Output blocks, cannot be NULL.
+ * @param numThreads Number of threads to encode with, 0 for all CPUs.
+ * @param mse        Output mean squared error per component, may be NULL.
+ * @return Zero if the format is not supported.
+ *
+ * dst must hold ceil(width/4) * ceil(height/4) blocks,
+ * each 8 bytes for BC1/BC4 and 16 bytes for BC3/BC5/BC7.
+ * Missing components are encoded as 0, missing alpha as 1.
+ * If groufix is initialized, blocks are encoded in parallel on the job
+ * scheduler of groufix (also when called from within a job), the calling
+ * thread helps out. Otherwise all blocks are encoded on the calling thread.
+ */
+GFX_API bool gfx_encode_bcn(GFXFormat fmt,
+                            uint32_t width, uint32_t height, unsigned char comps,
+                            const void* src, void* dst,
+                            unsigned int numThreads, double* mse);
+
 
 #endif
@@ -0,0 +1,232 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+
+#ifndef GFX_ASSETS_MESH_H
+#define GFX_ASSETS_MESH_H
+
+#include "groufix/def.h"
+
+
+/**
+ * Default post-transform vertex cache size to optimize for.
+ */
+#define GFX_MESH_CACHE_SIZE 16
+
+
+/**
+ * Default meshlet limits, as commonly preferred by mesh shading hardware.
+ */
+#define GFX_MESHLET_MAX_VERTICES  64
+#define GFX_MESHLET_MAX_TRIANGLES 124
+
+
+/**
+ * Meshlet descriptor, laid out to be read as-is by shaders (std430).
+ *
+ * The normal cone can be used to cull a back-facing meshlet if:
+ *  dot(center - cameraPos, coneAxis) >= coneCutoff * length(center - cameraPos) + radius
+ * A coneCutoff of 1 (with a zero axis) means it can never be culled.
+ */
+typedef struct GFXMeshlet
+{
+	uint32_t vertexOffset;   // Into the meshlet vertices.
+	uint32_t triangleOffset; // Into the meshlet & source triangles.
+	uint32_t numVertices;
+	uint32_t numTriangles;
+
+	float center[3]; // Bounding sphere.
+	float radius;
+
+	float coneAxis[3]; // Normal cone.
+	float coneCutoff;
+
+} GFXMeshlet;
+
+
+/**
+ * Mesh compression filter, as used by EXT_meshopt_compression.
+ */
+typedef enum GFXMeshFilter
+{
+	GFX_MESH_FILTER_NONE,
+	GFX_MESH_FILTER_OCTAHEDRAL,  // 4x int8 or 4x int16 normals.
+	GFX_MESH_FILTER_QUATERNION,  // 4x int16 quaternions.
+	GFX_MESH_FILTER_EXPONENTIAL  // Shared-exponent 32-bit floats.
+
+} GFXMeshFilter;
+
+
+/**
+ * Computes the average cache miss ratio (ACMR) of a triangle list,
+ * i.e. #vertex shader invocations per triangle, simulating a FIFO cache.
+ * @param numIndices Must be a multiple of 3.
+ * @param indices    Cannot be NULL if numIndices > 0.
+ * @param numVertices All indices must be < numVertices.
+ * @param cacheSize  Must be > 0.
+ * @return Ranges from 0.5 (optimal) to 3.0 (no reuse), 0 if no triangles.
+ */
+GFX_API float gfx_mesh_acmr(size_t numIndices, const uint32_t* indices,
+                            size_t numVertices, unsigned int cacheSize);
+
+/**
+ * Reorders the triangles of a triangle list for vertex cache efficiency,
+ * using Tipsify (Sander et al. 2007).
+ * @param numIndices Must be a multiple of 3.
+ * @param src        Input indices, cannot be NULL if numIndices > 0.
+ * @param dst        Output indices, cannot be NULL if numIndices > 0.
+ * @param numVertices All indices must be < numVertices.
+ * @param cacheSize  Must be > 0.
+ * @return Zero on failure (out of memory).
+ *
+ * src and dst cannot overlap.
+ */
+GFX_API bool gfx_mesh_optimize_cache(size_t numIndices,
+                                     const uint32_t* src, uint32_t* dst,
+                                     size_t numVertices, unsigned int cacheSize);
+
+/**
+ * Reorders clusters of triangles to reduce overdraw, keeping most of the
+ * vertex cache efficiency. Should be used after gfx_mesh_optimize_cache.
+ * @param indices   Indices to reorder in-place, cannot be NULL if numIndices > 0.
+ * @param positions Vertex positions as 3 floats each, cannot be NULL.
+ * @param stride    Byte stride between positions.
+ * @param cacheSize Must be > 0.
+ * @param threshold Maximum ACMR degradation (e.g. 1.05 for 5%), must be >= 1.
+ * @return Zero on failure (out of memory).
+ *
+ * Clusters facing away from the mesh center are drawn first.
+ */
+GFX_API bool gfx_mesh_optimize_overdraw(size_t numIndices, uint32_t* indices,
+                                        size_t numVertices,
+                                        const void* positions, size_t stride,
+                                        unsigned int cacheSize, float threshold);
+
+/**
+ * Computes a vertex remapping so vertices are fetched in index order.
+ * @param indices Indices to remap in-place, cannot be NULL if numIndices > 0.
+ * @param remap   Output of numVertices remapped indices, cannot be NULL,
+ *                UINT32_MAX for vertices that are not referenced.
+ * @return Number of referenced vertices (i.e. new number of vertices).
+ */
+GFX_API size_t gfx_mesh_optimize_fetch(size_t numIndices, uint32_t* indices,
+                                       size_t numVertices, uint32_t* remap);
+
+/**
+ * Computes the maximum number of meshlets gfx_mesh_build_meshlets can output.
+ * @param numIndices Must be a multiple of 3.
+ */
+GFX_API size_t gfx_mesh_meshlets_bound(size_t numIndices,
+                                       unsigned int maxVertices,
+                                       unsigned int maxTriangles);
+
+/**
+ * Splits a triangle list into meshlets, keeping the triangle order,
+ * each triangle is simply added to the current meshlet until it is full.
+ * Should be used after gfx_mesh_optimize_cache to get well-connected meshlets.
+ * @param numIndices   Must be a multiple of 3.
+ * @param indices      Cannot be NULL if numIndices > 0.
+ * @param numVertices  All indices must be < numVertices.
+ * @param positions    Vertex positions as 3 floats each, cannot be NULL.
+ * @param stride       Byte stride between positions.
+ * @param maxVertices  Must be >= 3 and <= 255.
+ * @param maxTriangles Must be > 0.
+ * @param meshlets     Output, see gfx_mesh_meshlets_bound, cannot be NULL.
+ * @param vertices     Output of at most numIndices vertex indices, cannot be NULL.
+ * @param triangles    Output of numIndices local vertex indices, cannot be NULL.
+ * @return Number of meshlets, zero on failure (out of memory) or if empty.
+ *
+ * As triangles are kept in order, the triangles of a meshlet also form a
+ * contiguous range of indices, meaning meshlets can be drawn as ranges of
+ * the source index buffer (e.g. with indirect draws) after culling.
+ */
+GFX_API size_t gfx_mesh_build_meshlets(size_t numIndices, const uint32_t* indices,
+                                       size_t numVertices,
+                                       const void* positions, size_t stride,
+                                       unsigned int maxVertices,
+                                       unsigned int maxTriangles,
+                                       GFXMeshlet* meshlets,
+                                       uint32_t* vertices, uint8_t* triangles);
+
+/**
+ * Simplifies a triangle list by collapsing edges in order of quadric error
+ * (Garland & Heckbert 1997), keeping all vertices in place so the result
+ * can share the source vertex buffer.
+ * @param numIndices    Must be a multiple of 3.
+ * @param indices       Cannot be NULL if numIndices > 0.
+ * @param numVertices   All indices must be < numVertices.
+ * @param positions     Vertex positions as 3 floats each, cannot be NULL.
+ * @param stride        Byte stride between positions.
+ * @param targetIndices Number of indices to simplify down to.
+ * @param targetError   Maximum error, relative to the mesh extent (e.g. 0.01 for 1%).
+ * @param dst           Output of at most numIndices indices, cannot be NULL if numIndices > 0.
+ * @param error         Outputs the resulting relative error, may be NULL.
+ *                      This is the square root of the area-weighted quadric
+ *                      error in unit cube space, an approximate metric.
+ * @return Number of output indices, a multiple of 3.
+ *
+ * dst may be equal to indices, but cannot overlap otherwise.
+ * Simplification stops at whichever target is reached first.
+ * Vertices on borders and attribute seams (i.e. vertices with equal
+ * positions) are locked. On failure (out of memory) indices is copied as-is.
+ */
+GFX_API size_t gfx_mesh_simplify(size_t numIndices, const uint32_t* indices,
+                                 size_t numVertices,
+                                 const void* positions, size_t stride,
+                                 size_t targetIndices, float targetError,
+                                 uint32_t* dst, float* error);
+
+/**
+ * Decodes a meshoptimizer compressed vertex buffer (the 'ATTRIBUTES' mode
+ * of EXT_meshopt_compression).
+ * @param numVertices Number of vertices to decode.
+ * @param stride      Byte size of a vertex, must be a multiple of 4, <= 256.
+ * @param size        Byte size of src.
+ * @param src         Encoded data, cannot be NULL.
+ * @param dst         Output of numVertices * stride bytes, cannot be NULL.
+ * @return Zero if src is malformed.
+ */
+GFX_API bool gfx_mesh_decode_vertices(size_t numVertices, size_t stride,
+                                      size_t size, const void* src, void* dst);
+
+/**
+ * Decodes a meshoptimizer compressed triangle list (the 'TRIANGLES' mode
+ * of EXT_meshopt_compression).
+ * @param numIndices Must be a multiple of 3.
+ * @param indexSize  Must be sizeof(uint16_t) or sizeof(uint32_t).
+ * @param size       Byte size of src.
+ * @param src        Encoded data, cannot be NULL.
+ * @param dst        Output of numIndices indices, cannot be NULL.
+ * @return Zero if src is malformed.
+ */
+GFX_API bool gfx_mesh_decode_triangles(size_t numIndices, size_t indexSize,
+                                       size_t size, const void* src, void* dst);
+
+/**
+ * Decodes a meshoptimizer compressed index sequence (the 'INDICES' mode
+ * of EXT_meshopt_compression).
+ * @see gfx_mesh_decode_triangles, except numIndices can be anything.
+ */
+GFX_API bool gfx_mesh_decode_indices(size_t numIndices, size_t indexSize,
+                                     size_t size, const void* src, void* dst);
+
+/**
+ * Applies a decoding filter in-place, after gfx_mesh_decode_vertices.
+ * @param count  Number of elements to filter.
+ * @param stride Byte size of an element.
+ * @param data   Elements to filter, cannot be NULL if count > 0.
+ * @return Zero if stride is invalid for the filter.
+ *
+ * OCTAHEDRAL requires a stride of 4 or 8, QUATERNION of 8,
+ * EXPONENTIAL a multiple of 4.
+ */
+GFX_API bool gfx_mesh_decode_filter(GFXMeshFilter filter,
+                                    size_t count, size_t stride, void* data);
+
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+
+#ifndef GFX_ASSETS_SCENE_H
+#define GFX_ASSETS_SCENE_H
+
+#include "groufix/assets/gltf.h"
+#include "groufix/def.h"
+
+
+/**
+ * Flattened scene graph definition, for fast (incremental) updates.
+ * All node data is stored in separate arrays, sorted by depth,
+ * i.e. roots come first and parents always come before their children.
+ * Matrices are 16 floats each, column-major.
+ * Bounds are 8 floats each, as min (x,y,z,1) followed by max (x,y,z,1),
+ * and are empty (min > max) for nodes without mesh or bounds.
+ */
+typedef struct GFXSceneGraph
+{
+	size_t numNodes;
+
+	// Read-only.
+	const GFXGltfNode** nodes;   // Source node of each graph node.
+	uint32_t*           parents; // Parent graph node, UINT32_MAX for roots.
+	float*              locals;  // Local matrices.
+	float*              worlds;  // World matrices.
+	float*              bounds;  // World-space AABBs.
+
+	// Private.
+	float*              meshBounds; // Object-space AABBs of meshes.
+	unsigned char*      dirty;
+	uint32_t*           map;  // Source node index -> graph node.
+	const GFXGltfNode*  base; // First source node.
+
+} GFXSceneGraph;
+
+
+/**
+ * Composes a column-major scale-rotate-translate matrix:
+ * m = mat(t) * mat(r) * mat(s)
+ * @param m Output 16 floats, cannot be NULL.
+ * @param t Translation vector (x,y,z), cannot be NULL.
+ * @param r Rotation quaternion (x,y,z,w), cannot be NULL.
+ * @param s Scale vector (x,y,z), cannot be NULL.
+ */
+GFX_API void gfx_scene_compose(float* m,
+                               const float* t, const float* r, const float* s);
+
+/**
+ * Initializes a scene graph from all nodes of a glTF result.
+ * @param graph Cannot be NULL.
+ * @param gltf  Cannot be NULL, must outlive the graph.
+ * @return Zero on failure.
+ *
+ * The object-space bounds of each node's mesh are the union of the
+ * (dequantized) position bounds of all its primitives.
+ * All nodes start out dirty, call gfx_scene_graph_update before reading.
+ */
+GFX_API bool gfx_scene_graph_init(GFXSceneGraph* graph, const GFXGltfResult* gltf);
+
+/**
+ * Clears a scene graph, invalidating its contents.
+ * @param graph Cannot be NULL.
+ */
+GFX_API void gfx_scene_graph_clear(GFXSceneGraph* graph);
+
+/**
+ * Retrieves the graph node of a glTF node.
+ * @param graph Cannot be NULL.
+ * @param node  Must be a node of the glTF result the graph was built from.
+ * @return Index into all node data of graph.
+ */
+GFX_API size_t gfx_scene_graph_find(const GFXSceneGraph* graph,
+                                    const GFXGltfNode* node);
+
+/**
+ * Sets the local transform of a graph node, marking its subtree dirty.
+ * @param graph Cannot be NULL.
+ * @param node  Must be < graph->numNodes.
+ * @see gfx_scene_compose.
+ */
+GFX_API void gfx_scene_graph_set(GFXSceneGraph* graph, size_t node,
+                                 const float* t, const float* r, const float* s);
+
+/**
+ * Sets the local matrix of a graph node, marking its subtree dirty.
+ * @param graph  Cannot be NULL.
+ * @param node   Must be < graph->numNodes.
+ * @param matrix 16 floats, column-major, cannot be NULL.
+ */
+GFX_API void gfx_scene_graph_set_matrix(GFXSceneGraph* graph, size_t node,
+                                        const float* matrix);
+
+/**
+ * Recomputes the world matrices & bounds of all dirty subtrees.
+ * @param graph Cannot be NULL.
+ * @return Number of updated nodes.
+ *
+ * All nodes are visited in a single linear pass, only the dirty ones are
+ * recomputed, using SSE if available. Bounds are transformed as
+ * (center, extents) pairs, giving the tightest AABB of the transformed box.
+ */
+GFX_API size_t gfx_scene_graph_update(GFXSceneGraph* graph);
+
+
+#endif
@@ -102,6 +102,8 @@ typedef enum GFXFormatFeatures
 	GFX_FORMAT_ATTACHMENT_BLEND     = 0x0100,
 	GFX_FORMAT_IMAGE_READ           = 0x0200,
 	GFX_FORMAT_IMAGE_WRITE          = 0x0400,
+	GFX_FORMAT_IMAGE_BLIT_SRC       = 0x0800,
+	GFX_FORMAT_IMAGE_BLIT_DST       = 0x1000,
 
 } GFXFormatFeatures;
 
@@ -531,7 +531,9 @@ typedef enum GFXTransferFlags
 	GFX_TRANSFER_NONE  = 0x0000,
 	GFX_TRANSFER_ASYNC = 0x0001,
 	GFX_TRANSFER_FLUSH = 0x0002,
-	GFX_TRANSFER_BLOCK = 0x0004 // Implies GFX_TRANSFER_FLUSH.
+	GFX_TRANSFER_BLOCK = 0x0004, // Implies GFX_TRANSFER_FLUSH.
+
+	GFX_TRANSFER_MIPMAPS = 0x0008 // Generate mipmaps of the destination image.
 
 } GFXTransferFlags;
 
@@ -549,6 +551,19 @@ typedef enum GFXFilter
 } GFXFilter;
 
 
+/**
+ * Mapped write operation, host memory to write into before submitting it.
+ */
+typedef struct GFXMappedWrite
+{
+	// All private.
+	GFXReference ref;
+	void*        staging;
+	void*        host;
+
+} GFXMappedWrite;
+
+
 /**
  * Reads data from a memory resource reference.
  * @param src        Cannot be NULL/GFX_REF_NULL.
@@ -578,6 +593,13 @@ typedef enum GFXFilter
  *  One of a pair can have a size of zero and it will be ignored.
  *  Likewise, with two images, one can have a width/height/depth of zero.
  *
+ * If GFX_TRANSFER_MIPMAPS is passed and the destination is a (non-attachment)
+ * image, all mipmaps following the mipmap of each destination region are
+ * regenerated afterwards, each by a linear blit from its predecessor.
+ * The image must be created with GFX_MEMORY_READ_WRITE and its format must
+ * support GFX_FORMAT_SAMPLED_IMAGE_LINEAR. Blitting requires a graphics queue,
+ * meaning GFX_TRANSFER_ASYNC is ignored. Ignored by gfx_read.
+ *
  * gfx_read only:
  *  Will act as if GFX_TRANSFER_BLOCK is always passed!
  *  Note this means gfx_read will _always_ trigger a flush.
@@ -598,6 +620,45 @@ GFX_API bool gfx_write(const void* src, GFXReference dst,
                        const GFXRegion* srcRegions, const GFXRegion* dstRegions,
                        const GFXInject* injs);
 
+/**
+ * Maps host memory to write data into, to then be written to a memory
+ * resource reference, without first copying it from other host memory.
+ * @param write      Cannot be NULL, output write operation.
+ * @param dst        Cannot be GFX_REF_NULL.
+ * @param numRegions Must be > 0.
+ * @param srcRegions Cannot be NULL, regions within the returned pointer.
+ * @param dstRegions Cannot be NULL.
+ * @return NULL on failure, write is left invalid.
+ *
+ * Unless dst is a host visible buffer, this directly maps a new staging
+ * buffer, sized to cover all srcRegions.
+ * The returned pointer stays valid until gfx_unmap_write or gfx_cancel_write.
+ * Must be followed by exactly one call to either.
+ */
+GFX_API void* gfx_map_write(GFXMappedWrite* write, GFXReference dst,
+                            size_t numRegions,
+                            const GFXRegion* srcRegions, const GFXRegion* dstRegions);
+
+/**
+ * Submits a mapped write operation, writing to its memory resource reference.
+ * @param write Cannot be NULL, must be mapped with gfx_map_write.
+ * @return Non-zero on success, the host memory is unmapped either way.
+ * @see gfx_write.
+ *
+ * srcRegions and dstRegions must be equal to those passed to gfx_map_write.
+ */
+GFX_API bool gfx_unmap_write(GFXMappedWrite* write,
+                             GFXTransferFlags flags,
+                             size_t numRegions, size_t numInjs,
+                             const GFXRegion* srcRegions, const GFXRegion* dstRegions,
+                             const GFXInject* injs);
+
+/**
+ * Unmaps a mapped write operation without submitting anything.
+ * @param write Cannot be NULL, must be mapped with gfx_map_write.
+ */
+GFX_API void gfx_cancel_write(GFXMappedWrite* write);
+
 /**
  * Copies data from one memory resource reference to another.
  * @see gfx_read.
@@ -0,0 +1,92 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+
+#ifndef GFX_CORE_JOBS_H
+#define GFX_CORE_JOBS_H
+
+#include "groufix/def.h"
+
+
+/**
+ * Job entry point.
+ */
+typedef void (*GFXJobFunc)(void* arg);
+
+
+/**
+ * Job counter definition, to join on all jobs forked with it.
+ * Must be zero initialized, can be reused once joined.
+ */
+typedef struct GFXJobCounter
+{
+	// Read-only.
+	GFX_ATOMIC(size_t) pending;
+
+} GFXJobCounter;
+
+
+/**
+ * Job scheduler definition.
+ */
+typedef struct GFXJobs GFXJobs;
+
+
+/**
+ * Creates a job scheduler, i.e. a fixed pool of worker threads.
+ * @param numWorkers Number of worker threads, 0 for the number of logical cores.
+ * @return NULL on failure.
+ *
+ * Each worker owns a deque of jobs, forked jobs are pushed to the deque of
+ * the forking worker, idle workers steal jobs from the deques of others.
+ * Workers are attached to groufix and inherit the logging state of the
+ * calling thread, they sleep when there are no jobs left.
+ */
+GFX_API GFXJobs* gfx_create_jobs(unsigned int numWorkers);
+
+/**
+ * Destroys a job scheduler, finishing all pending jobs first.
+ * Cannot be called from within a job of the scheduler!
+ */
+GFX_API void gfx_destroy_jobs(GFXJobs* jobs);
+
+/**
+ * Retrieves the number of worker threads of a job scheduler.
+ * @param jobs Cannot be NULL.
+ */
+GFX_API unsigned int gfx_jobs_get_num_workers(GFXJobs* jobs);
+
+/**
+ * Forks a number of jobs, to be executed by any worker.
+ * @param jobs    Cannot be NULL.
+ * @param counter Counter to join on, may be NULL.
+ * @param func    Entry point of all jobs, cannot be NULL.
+ * @param args    Argument of the first job, each next one is stride bytes further.
+ * @param stride  Byte stride between arguments, 0 to pass the same argument.
+ *
+ * Can be called from any thread, including from within jobs.
+ * Never fails; if a job cannot be queued, it is executed immediately.
+ */
+GFX_API void gfx_jobs_fork(GFXJobs* jobs, GFXJobCounter* counter,
+                           size_t numJobs, GFXJobFunc func,
+                           void* args, size_t stride);
+
+/**
+ * Blocks until all jobs forked with a counter are done.
+ * The calling thread executes pending jobs while waiting.
+ * @param jobs    Cannot be NULL.
+ * @param counter Cannot be NULL.
+ *
+ * Can be called from any thread, including from within jobs.
+ * Threads that are not a worker of jobs go to sleep once there are no
+ * pending jobs left to execute, instead of spinning.
+ */
+GFX_API void gfx_jobs_join(GFXJobs* jobs, GFXJobCounter* counter);
+
+
+#endif
@@ -595,6 +595,10 @@ typedef struct GFXComputable
  * The object(s) pointed to by state cannot be moved or copied and must
  * remain constant as long as the renderable is being used in function calls!
  * To update state, call this function again.
+ *
+ * If supported by the device (Vulkan 1.3 or VK_EXT_extended_dynamic_state),
+ * cull mode, front face, topology, depth test & stencil state are recorded
+ * as dynamic state, renderables only differing in these share a pipeline.
  */
 GFX_API bool gfx_renderable(GFXRenderable* renderable,
                             GFXPass* pass, GFXTechnique* tech, GFXPrimitive* prim,
@@ -1343,6 +1347,110 @@ GFX_API bool gfx_tech_dynamic(GFXTechnique* technique,
 GFX_API bool gfx_tech_lock(GFXTechnique* technique);
 
 
+/****************************
+ * Technique permutations.
+ ****************************/
+
+/**
+ * Technique permutations definition.
+ */
+typedef struct GFXPermutations GFXPermutations;
+
+
+/**
+ * Specialization constant domain (i.e. all its allowed values).
+ */
+typedef struct GFXConstantDomain
+{
+	uint32_t       id;
+	GFXShaderStage stage;
+	size_t         size; // Must be sizeof(value.(i32|u32|f)).
+
+	size_t             numValues; // Must be > 0.
+	const GFXConstant* values;    // Duplicates are ignored.
+
+} GFXConstantDomain;
+
+
+/**
+ * Creates a set of permutations (i.e. variants) of a technique, one for each
+ * combination of specialization constant values.
+ * @param technique  Cannot be NULL, cannot be locked.
+ * @param numDomains Must be > 0.
+ * @param domains    Cannot be NULL, each domain must have a distinct id/stage.
+ * @param budget     Maximum number of variants, 0 for unbounded.
+ * @return NULL on failure.
+ *
+ * All configuration of technique (constants, samplers, immutable & dynamic
+ * bindings) is copied into every variant, the technique itself is not used
+ * afterwards and can be erased or locked independently.
+ * Every variant is a separately locked technique of the same renderer,
+ * thus the permutations must be destroyed before the renderer is.
+ */
+GFX_API GFXPermutations* gfx_tech_create_permutations(GFXTechnique* technique,
+                                                      size_t numDomains,
+                                                      const GFXConstantDomain* domains,
+                                                      size_t budget);
+
+/**
+ * Destroys a set of permutations, erasing all of its variants.
+ */
+GFX_API void gfx_destroy_permutations(GFXPermutations* perms);
+
+/**
+ * Retrieves the number of value combinations (i.e. possible variants).
+ * @param perms Cannot be NULL.
+ * @return SIZE_MAX on overflow.
+ */
+GFX_API size_t gfx_permutations_get_count(GFXPermutations* perms);
+
+/**
+ * Retrieves (or creates) the variant for a combination of values.
+ * @param perms  Cannot be NULL.
+ * @param values Cannot be NULL, one value for each domain (in order).
+ * @return NULL if a value is not in its domain, on budget exhaustion or failure.
+ *
+ * Thread-safe with respect to perms.
+ * The returned technique is locked and remains valid until perms is destroyed.
+ */
+GFX_API GFXTechnique* gfx_permutations_get(GFXPermutations* perms,
+                                           const GFXConstant* values);
+
+/**
+ * Registers renderable parameters to warm up all variants for.
+ * @param perms Cannot be NULL.
+ * @param pass  Cannot be NULL, must be a render pass of the same renderer.
+ * @param prim  May be NULL.
+ * @param state May be NULL.
+ * @return Non-zero on success.
+ * @see gfx_renderable.
+ *
+ * Thread-safe with respect to perms.
+ * Registering the same parameters more than once is a no-op.
+ * Not necessary (and ignored) for compute techniques.
+ */
+GFX_API bool gfx_permutations_register(GFXPermutations* perms,
+                                       GFXPass* pass, GFXPrimitive* prim,
+                                       const GFXRenderState* state);
+
+/**
+ * Warms up the internal pipeline cache for every reachable variant
+ * with all registered parameters.
+ * @param perms      Cannot be NULL.
+ * @param numThreads Maximum #threads (including the calling thread), 0 = #CPUs.
+ * @return Number of successfully warmed up pipelines.
+ * @see gfx_renderable_warmup.
+ *
+ * A variant is reachable once it is retrieved with gfx_permutations_get,
+ * i.e. the full set of combinations is never enumerated.
+ * Pipelines are created in parallel on the job scheduler of groufix,
+ * each unique pipeline is only created once.
+ * Has the same restrictions as gfx_renderable_warmup and gfx_computable_warmup.
+ */
+GFX_API size_t gfx_permutations_warmup(GFXPermutations* perms,
+                                       unsigned int numThreads);
+
+
 /****************************
  * Set creation and modification.
  ****************************/
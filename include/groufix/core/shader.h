@@ -70,6 +70,53 @@ typedef enum GFXShaderResourceType
 typedef struct GFXShader GFXShader;
 
 
+/**
+ * Shader batch compilation source.
+ */
+typedef struct GFXShaderSource
+{
+	GFXShader*        shader; // Cannot be NULL.
+	GFXShaderLanguage language;
+	bool              optimize;
+
+	const GFXReader* src; // Source stream, cannot be NULL.
+	const GFXWriter* out; // Optional SPIR-V bytecode output stream.
+	const GFXWriter* err; // Optional error/warning output stream.
+
+	// Output, non-zero if successfully compiled.
+	bool result;
+
+} GFXShaderSource;
+
+
+/**
+ * Shader cache definition.
+ */
+typedef struct GFXShaderCache GFXShaderCache;
+
+
+/**
+ * Include cache definition.
+ */
+typedef struct GFXIncludeCache GFXIncludeCache;
+
+
+/**
+ * Shader cache statistics.
+ */
+typedef struct GFXShaderCacheStats
+{
+	size_t entries;
+	size_t size;    // Total size of all entries in bytes.
+	size_t maxSize; // 0 = unbounded.
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+
+} GFXShaderCacheStats;
+
+
 /**
  * Creates a shader.
  * @param stage  Shader stage, exactly 1 stage must be set.
@@ -108,14 +155,172 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
                                 const GFXWriter* out, const GFXWriter* err);
 
 /**
- * Loads SPIR-V bytecode for use.
+ * Compiles multiple shaders in parallel, on the job scheduler of groufix.
+ * @param shaders    Cannot be NULL if numShaders > 0.
+ * @param cache      Optional shader cache, shared by all threads.
+ * @param inc        Optional stream includer, shared by all threads.
+ * @param numThreads Maximum #threads (including the calling thread), 0 = #CPUs.
+ * @return Number of successfully compiled shaders.
+ *
+ * The calling thread helps compiling, no new threads are started per batch.
+ * Each job reuses a single compiler for all the shaders it compiles.
+ * Every URI is resolved only once per batch (see gfx_create_include_cache),
+ * inc is accessed by one thread at a time. The `result` field of each source
+ * is set to non-zero on success, all errors/warnings of a shader are written
+ * to its own `err` stream.
+ * All streams of a source are only accessed by one thread at a time.
+ * @see gfx_shader_compile_cached.
+ */
+GFX_API size_t gfx_shader_compile_batch(size_t numShaders,
+                                        GFXShaderSource* shaders,
+                                        GFXShaderCache* cache,
+                                        const GFXIncluder* inc,
+                                        unsigned int numThreads);
+
+/**
+ * Loads SPIR-V bytecode or groufix shader data for use.
  * @param shader Cannot be NULL.
  * @param src    Source bytecode stream, cannot be NULL.
  * @return Non-zero on success.
  *
  * Silently fails if shader already stores SPIR-V bytecode.
+ * If src contains groufix shader data (see gfx_shader_store),
+ * no reflection is performed, the stored metadata is used instead.
  */
 GFX_API bool gfx_shader_load(GFXShader* shader, const GFXReader* src);
 
+/**
+ * Stores groufix shader data, i.e. the SPIR-V bytecode with all of its
+ * reflection metadata, to be loaded back in with gfx_shader_load.
+ * @param shader Cannot be NULL.
+ * @param dst    Destination stream, cannot be NULL.
+ * @return Non-zero on success.
+ *
+ * Fails if shader does not store SPIR-V bytecode yet.
+ * The bytecode is only kept if the shader was compiled with a shader cache
+ * (see gfx_shader_compile_cached) or loaded from SPIR-V (not groufix data).
+ * The data is only valid for the same groufix build and shader stage.
+ */
+GFX_API bool gfx_shader_store(GFXShader* shader, const GFXWriter* dst);
+
+
+/****************************
+ * Shader (SPIR-V) cache.
+ ****************************/
+
+/**
+ * Creates a shader cache, mapping shader sources to SPIR-V bytecode.
+ * @param maxSize Maximum size of all entries in bytes, 0 for unbounded.
+ * @return NULL on failure.
+ *
+ * When full, the least recently used entries are evicted.
+ */
+GFX_API GFXShaderCache* gfx_create_shader_cache(size_t maxSize);
+
+/**
+ * Destroys a shader cache.
+ */
+GFX_API void gfx_destroy_shader_cache(GFXShaderCache* cache);
+
+/**
+ * Retrieves the current statistics of a shader cache.
+ * @param cache Cannot be NULL.
+ *
+ * Can be called from any thread.
+ */
+GFX_API GFXShaderCacheStats gfx_shader_cache_get_stats(GFXShaderCache* cache);
+
+/**
+ * Writes a human readable listing of all entries of a shader cache.
+ * @param cache Cannot be NULL.
+ * @param dst   Destination stream, cannot be NULL.
+ * @return Non-zero on success.
+ *
+ * Can be called from any thread.
+ */
+GFX_API bool gfx_shader_cache_dump(GFXShaderCache* cache, const GFXWriter* dst);
+
+/**
+ * Loads groufix shader cache data, merging it into a shader cache.
+ * @param cache Cannot be NULL.
+ * @param src   Source stream, cannot be NULL.
+ * @return Non-zero on success.
+ *
+ * Can be called from any thread.
+ * Already present entries are not replaced.
+ */
+GFX_API bool gfx_shader_cache_load(GFXShaderCache* cache, const GFXReader* src);
+
+/**
+ * Stores the current groufix shader cache data.
+ * @param cache Cannot be NULL.
+ * @param dst   Destination stream, cannot be NULL.
+ * @return Non-zero on success.
+ *
+ * Can be called from any thread.
+ */
+GFX_API bool gfx_shader_cache_store(GFXShaderCache* cache, const GFXWriter* dst);
+
+/**
+ * Equivalent to gfx_shader_compile, but consults a shader cache first.
+ * @param cache Shader cache to use, NULL to compile without cache.
+ * @see gfx_shader_compile.
+ *
+ * Entries are keyed on the source, all resolved #include directives,
+ * language, optimize flag, target API version and (if optimizing) the
+ * device limits. On a hit shaderc is skipped and the cached SPIR-V is
+ * passed to gfx_shader_load, nothing is written to err in that case.
+ * Thread-safe with respect to the cache.
+ */
+GFX_API bool gfx_shader_compile_cached(GFXShader* shader, GFXShaderCache* cache,
+                                       GFXShaderLanguage language, bool optimize,
+                                       const GFXReader* src, const GFXIncluder* inc,
+                                       const GFXWriter* out, const GFXWriter* err);
+
+
+
+/****************************
+ * Include cache.
+ ****************************/
+
+/**
+ * Creates an include cache, a thread-safe memoizing includer.
+ * @param inc Includer to forward to, cannot be NULL.
+ * @return NULL on failure.
+ *
+ * Every URI is normalized ('\\' becomes '/', duplicate '/', '.' and
+ * resolvable '..' segments are removed) and only resolved & read once,
+ * the normalized URI is passed to inc. Failures are remembered too.
+ * inc is accessed by one thread at a time, must outlive the cache.
+ */
+GFX_API GFXIncludeCache* gfx_create_include_cache(const GFXIncluder* inc);
+
+/**
+ * Destroys an include cache.
+ * All streams resolved through it must be released first!
+ */
+GFX_API void gfx_destroy_include_cache(GFXIncludeCache* cache);
+
+/**
+ * Retrieves the includer of an include cache, to resolve URIs with.
+ * Can be called from any thread.
+ * @return NULL if cache is NULL.
+ *
+ * Resolved streams are binary streams over in-memory data.
+ * Resolving and releasing is thread-safe.
+ */
+GFX_API const GFXIncluder* gfx_include_cache_get_includer(GFXIncludeCache* cache);
+
+/**
+ * Invalidates cached data, it will be resolved again on next use.
+ * @param cache Cannot be NULL.
+ * @param uri   URI to invalidate, NULL to invalidate all URIs.
+ *
+ * Can be called from any thread.
+ * Already resolved streams remain valid until released.
+ */
+GFX_API void gfx_include_cache_invalidate(GFXIncludeCache* cache,
+                                          const char* uri);
+
 
 #endif
@@ -32,7 +32,7 @@ typedef struct GFXImguiDrawer
 	GFXPass*     pass;
 
 	GFXTechnique* tech;
-	GFXDeque      data;   // Stores { unsigned int, GFXPrimitive*, GFXRenderable, void* }.
+	GFXDeque      data;   // Stores { unsigned int, GFXPrimitive*, GFXRenderable, void*, uint64_t* }.
 	GFXVec        fonts;  // Stores GFXImage*.
 	GFXMap        images; // Stores GFXImage* : GFXSet*.
 
@@ -88,6 +88,7 @@ GFX_API void gfx_terminate(void)
 		return;
 
 	// Terminate the contents of the engine.
+	gfx_jobs_terminate_();
 	gfx_gamepads_terminate_();
 	gfx_monitors_terminate_();
 	gfx_devices_terminate_();
@@ -0,0 +1,683 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/assets/image.h"
+#include "groufix/core/log.h"
+#include "groufix/core/threads.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+	(defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define GFX_BCN_SSE2_
+#endif
+
+
+// Minimum number of block rows for each encoding thread.
+#define GFX_BCN_ROWS_PER_THREAD_ 16
+
+
+// Checks if a format can be encoded to.
+#define GFX_BCN_IS_SUPPORTED_(fmt) \
+	((fmt).order == GFX_ORDER_BCn && \
+	((fmt).type == GFX_UNORM || (fmt).type == GFX_SRGB) && \
+	((fmt).comps[0] == 1 || (fmt).comps[0] == 3 || (fmt).comps[0] == 4 || \
+	(fmt).comps[0] == 5 || (fmt).comps[0] == 7))
+
+
+// Number of channels a BCn format encodes.
+#define GFX_BCN_CHANNELS_(n) \
+	((n) == 4 ? 1 : (n) == 5 ? 2 : (n) == 1 ? 3 : 4)
+
+
+/****************************
+ * Interpolation weights of a BC1 color palette (in 1/3rds) and
+ * BC7 4-bit index palette (in 1/64ths), by index.
+ */
+static const float gfx_bcn_bc1_weights_[4] = {
+	0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f
+};
+
+static const int gfx_bcn_bc7_weights_[16] = {
+	0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+
+/****************************
+ * Block encoding job, shared by all encoded ranges of block rows.
+ */
+typedef struct GFXBcnJob_
+{
+	const unsigned char* src;
+	unsigned char*       dst;
+
+	uint32_t      width;
+	uint32_t      height;
+	unsigned char comps;
+	unsigned char n; // BCn.
+
+	// Output, total squared error.
+	atomic_uint_least64_t err;
+
+} GFXBcnJob_;
+
+
+/****************************
+ * Fetches a 4x4 block of texels as RGBA, edge texels are repeated.
+ * Missing components are 0, missing alpha is 255.
+ */
+static void gfx_bcn_fetch_(const GFXBcnJob_* job, uint32_t bx, uint32_t by,
+                           unsigned char block[16][4])
+{
+	for (uint32_t y = 0; y < 4; ++y)
+		for (uint32_t x = 0; x < 4; ++x)
+		{
+			const uint32_t sx = GFX_MIN(bx * 4 + x, job->width - 1);
+			const uint32_t sy = GFX_MIN(by * 4 + y, job->height - 1);
+			const unsigned char* p =
+				job->src + ((size_t)sy * job->width + sx) * job->comps;
+
+			unsigned char* t = block[y * 4 + x];
+			t[0] = p[0];
+			t[1] = (job->comps > 1) ? p[1] : 0;
+			t[2] = (job->comps > 2) ? p[2] : 0;
+			t[3] = (job->comps > 3) ? p[3] : 255;
+		}
+}
+
+/****************************
+ * Selects the nearest palette entry for each texel of a block.
+ * @param palette    Entries to select from.
+ * @param numEntries Must be <= 16.
+ * @param indices    Output, selected index for each texel.
+ * @return Total squared error of the selection.
+ */
+static uint32_t gfx_bcn_select_(unsigned char block[16][4],
+                                unsigned char palette[][4],
+                                int numEntries, unsigned char indices[16])
+{
+#if defined (GFX_BCN_SSE2_)
+	// Unpack all texels to 16 bits, two texels per register.
+	const __m128i zero = _mm_setzero_si128();
+	__m128i texels[8];
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const __m128i t = _mm_loadu_si128((const __m128i*)block[i * 4]);
+		texels[i * 2 + 0] = _mm_unpacklo_epi8(t, zero);
+		texels[i * 2 + 1] = _mm_unpackhi_epi8(t, zero);
+	}
+
+	__m128i bestErr[4];
+	__m128i bestInd[4];
+
+	for (int i = 0; i < 4; ++i)
+		bestErr[i] = _mm_set1_epi32(INT32_MAX),
+		bestInd[i] = zero;
+
+	for (int e = 0; e < numEntries; ++e)
+	{
+		const __m128i p = _mm_set_epi16(
+			palette[e][3], palette[e][2], palette[e][1], palette[e][0],
+			palette[e][3], palette[e][2], palette[e][1], palette[e][0]);
+
+		const __m128i ind = _mm_set1_epi32(e);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			// Squared distances, sum channel pairs of 2 texels each.
+			const __m128i d0 = _mm_sub_epi16(texels[i * 2 + 0], p);
+			const __m128i d1 = _mm_sub_epi16(texels[i * 2 + 1], p);
+			const __m128 s0 = _mm_castsi128_ps(_mm_madd_epi16(d0, d0));
+			const __m128 s1 = _mm_castsi128_ps(_mm_madd_epi16(d1, d1));
+
+			// Then sum the pairs themselves to get 4 texel distances.
+			const __m128i err = _mm_add_epi32(
+				_mm_castps_si128(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(2,0,2,0))),
+				_mm_castps_si128(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(3,1,3,1))));
+
+			const __m128i less = _mm_cmplt_epi32(err, bestErr[i]);
+			bestErr[i] = _mm_or_si128(
+				_mm_and_si128(less, err), _mm_andnot_si128(less, bestErr[i]));
+			bestInd[i] = _mm_or_si128(
+				_mm_and_si128(less, ind), _mm_andnot_si128(less, bestInd[i]));
+		}
+	}
+
+	// Store the results.
+	int32_t errs[16];
+	int32_t inds[16];
+	uint32_t total = 0;
+
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_si128((__m128i*)(errs + i * 4), bestErr[i]),
+		_mm_storeu_si128((__m128i*)(inds + i * 4), bestInd[i]);
+
+	for (int i = 0; i < 16; ++i)
+		indices[i] = (unsigned char)inds[i],
+		total += (uint32_t)errs[i];
+
+	return total;
+
+#else
+	uint32_t total = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		uint32_t bestErr = UINT32_MAX;
+
+		for (int e = 0; e < numEntries; ++e)
+		{
+			uint32_t err = 0;
+			for (int c = 0; c < 4; ++c)
+			{
+				const int d = (int)block[i][c] - (int)palette[e][c];
+				err += (uint32_t)(d * d);
+			}
+
+			if (err < bestErr)
+				bestErr = err,
+				indices[i] = (unsigned char)e;
+		}
+
+		total += bestErr;
+	}
+
+	return total;
+#endif
+}
+
+/****************************
+ * Computes initial endpoints of a block along its principal axis.
+ * @param n Number of channels to consider, <= 4.
+ */
+static void gfx_bcn_pca_(unsigned char block[16][4], int n,
+                         float e0[4], float e1[4])
+{
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float cov[4][4] = { { 0.0f } };
+
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < n; ++c)
+			mean[c] += (float)block[i][c] / 16.0f;
+
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < n; ++c)
+			for (int d = 0; d < n; ++d)
+				cov[c][d] +=
+					((float)block[i][c] - mean[c]) *
+					((float)block[i][d] - mean[d]);
+
+	// Power iteration to find the principal axis.
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	for (int it = 0; it < 8; ++it)
+	{
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float len = 0.0f;
+
+		for (int c = 0; c < n; ++c)
+		{
+			for (int d = 0; d < n; ++d)
+				next[c] += cov[c][d] * axis[d];
+
+			len = fmaxf(len, fabsf(next[c]));
+		}
+
+		// Uniform block, no axis.
+		if (len < 1e-6f)
+		{
+			for (int c = 0; c < 4; ++c)
+				e0[c] = e1[c] = (c < n) ? mean[c] : 0.0f;
+
+			return;
+		}
+
+		for (int c = 0; c < n; ++c)
+			axis[c] = next[c] / len;
+	}
+
+	// Project all texels onto the axis to get the extents.
+	float tMin = INFINITY;
+	float tMax = -INFINITY;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < n; ++c)
+			t += ((float)block[i][c] - mean[c]) * axis[c];
+
+		tMin = fminf(tMin, t);
+		tMax = fmaxf(tMax, t);
+	}
+
+	float len = 0.0f;
+	for (int c = 0; c < n; ++c)
+		len += axis[c] * axis[c];
+
+	for (int c = 0; c < 4; ++c)
+	{
+		e0[c] = (c < n) ?
+			GFX_CLAMP(mean[c] + axis[c] * tMin / len, 0.0f, 255.0f) : 0.0f;
+		e1[c] = (c < n) ?
+			GFX_CLAMP(mean[c] + axis[c] * tMax / len, 0.0f, 255.0f) : 0.0f;
+	}
+}
+
+/****************************
+ * Refits endpoints to a block given its palette indices (least squares).
+ * @param n       Number of channels to consider, <= 4.
+ * @param weights Weight of e1 for each index.
+ */
+static void gfx_bcn_refine_(unsigned char block[16][4], int n,
+                            const unsigned char indices[16],
+                            const float* weights,
+                            float e0[4], float e1[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const float b = weights[indices[i]];
+		const float a = 1.0f - b;
+
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+
+		for (int c = 0; c < n; ++c)
+			ax[c] += a * (float)block[i][c],
+			bx[c] += b * (float)block[i][c];
+	}
+
+	// Singular if all texels use the same index.
+	const float det = aa * bb - ab * ab;
+	if (fabsf(det) < 1e-6f) return;
+
+	for (int c = 0; c < n; ++c)
+	{
+		e0[c] = GFX_CLAMP((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+		e1[c] = GFX_CLAMP((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+	}
+}
+
+/****************************
+ * Writes bits to a zero-initialized block, LSB first.
+ */
+static void gfx_bcn_put_(unsigned char* out, unsigned int* pos,
+                         uint32_t value, unsigned int bits)
+{
+	for (unsigned int b = 0; b < bits; ++b, ++(*pos))
+		out[*pos >> 3] |= (unsigned char)(((value >> b) & 1) << (*pos & 7));
+}
+
+/****************************
+ * Encodes a single channel of a block as a BC4 block (8 bytes).
+ * @return Total squared error.
+ */
+static uint32_t gfx_bcn_encode_bc4_(unsigned char block[16][4], int c,
+                                    unsigned char* out)
+{
+	int lo = 255, hi = 0;
+	for (int i = 0; i < 16; ++i)
+		lo = GFX_MIN(lo, (int)block[i][c]),
+		hi = GFX_MAX(hi, (int)block[i][c]);
+
+	// Always use the 8 value mode, so the largest value comes first.
+	// Each texel is directly quantized onto the range.
+	const int range = hi - lo;
+	uint64_t bits = 0;
+	uint32_t err = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const int v = block[i][c];
+		const int k = (range == 0) ? 0 : ((hi - v) * 14 + range) / (2 * range);
+		const int d = v - ((7 - k) * hi + k * lo) / 7;
+
+		bits |= (uint64_t)(k == 0 ? 0 : k == 7 ? 1 : k + 1) << (3 * i);
+		err += (uint32_t)(d * d);
+	}
+
+	out[0] = (unsigned char)hi;
+	out[1] = (unsigned char)lo;
+
+	for (int b = 0; b < 6; ++b)
+		out[2 + b] = (unsigned char)(bits >> (8 * b));
+
+	return err;
+}
+
+/****************************
+ * Quantizes endpoints to RGB565, in a BC1 palette.
+ */
+static uint16_t gfx_bcn_565_(const float e[4], unsigned char dec[4])
+{
+	const uint16_t r = (uint16_t)lrintf(e[0] * 31.0f / 255.0f);
+	const uint16_t g = (uint16_t)lrintf(e[1] * 63.0f / 255.0f);
+	const uint16_t b = (uint16_t)lrintf(e[2] * 31.0f / 255.0f);
+
+	dec[0] = (unsigned char)((r << 3) | (r >> 2));
+	dec[1] = (unsigned char)((g << 2) | (g >> 4));
+	dec[2] = (unsigned char)((b << 3) | (b >> 2));
+	dec[3] = 0;
+
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+/****************************
+ * Encodes the color of a block as a BC1 block (8 bytes).
+ * @return Total squared error.
+ */
+static uint32_t gfx_bcn_encode_bc1_(unsigned char block[16][4],
+                                    unsigned char* out)
+{
+	// Ignore alpha.
+	unsigned char rgb[16][4];
+	for (int i = 0; i < 16; ++i)
+		memcpy(rgb[i], block[i], 3),
+		rgb[i][3] = 0;
+
+	float e0[4], e1[4];
+	gfx_bcn_pca_(rgb, 3, e0, e1);
+
+	uint32_t bestErr = UINT32_MAX;
+	uint16_t best[2] = { 0, 0 };
+	unsigned char bestInd[16];
+
+	// Fit, refine the endpoints & fit once more.
+	for (int it = 0; it < 2; ++it)
+	{
+		unsigned char palette[4][4];
+		uint16_t c0 = gfx_bcn_565_(e0, palette[0]);
+		uint16_t c1 = gfx_bcn_565_(e1, palette[1]);
+
+		// The 4 color mode requires c0 > c1.
+		if (c0 < c1)
+		{
+			uint16_t t = c0; c0 = c1; c1 = t;
+			unsigned char p[4]; memcpy(p, palette[0], 4);
+			memcpy(palette[0], palette[1], 4); memcpy(palette[1], p, 4);
+			float f[4]; memcpy(f, e0, sizeof(f));
+			memcpy(e0, e1, sizeof(f)); memcpy(e1, f, sizeof(f));
+		}
+
+		// If equal, only the first entry is valid.
+		int numEntries = 4;
+		if (c0 == c1) numEntries = 1;
+
+		for (int c = 0; c < 3; ++c)
+			palette[2][c] = (unsigned char)((2 * palette[0][c] + palette[1][c]) / 3),
+			palette[3][c] = (unsigned char)((palette[0][c] + 2 * palette[1][c]) / 3);
+
+		palette[2][3] = palette[3][3] = 0;
+
+		unsigned char indices[16];
+		const uint32_t err =
+			gfx_bcn_select_(rgb, palette, numEntries, indices);
+
+		if (err < bestErr)
+		{
+			bestErr = err;
+			best[0] = c0;
+			best[1] = c1;
+			memcpy(bestInd, indices, sizeof(indices));
+		}
+
+		if (err == 0) break;
+		gfx_bcn_refine_(rgb, 3, indices, gfx_bcn_bc1_weights_, e0, e1);
+	}
+
+	out[0] = (unsigned char)best[0];
+	out[1] = (unsigned char)(best[0] >> 8);
+	out[2] = (unsigned char)best[1];
+	out[3] = (unsigned char)(best[1] >> 8);
+
+	for (int b = 0; b < 4; ++b)
+		out[4 + b] = (unsigned char)(
+			bestInd[b * 4 + 0] |
+			bestInd[b * 4 + 1] << 2 |
+			bestInd[b * 4 + 2] << 4 |
+			bestInd[b * 4 + 3] << 6);
+
+	return bestErr;
+}
+
+/****************************
+ * Quantizes an endpoint to 7 bits + p-bit (BC7 mode 6).
+ */
+static void gfx_bcn_rgbap_(const float e[4],
+                           unsigned char q[4], unsigned char* p,
+                           unsigned char dec[4])
+{
+	float bestErr = INFINITY;
+
+	for (unsigned char pb = 0; pb < 2; ++pb)
+	{
+		unsigned char tq[4];
+		float err = 0.0f;
+
+		for (int c = 0; c < 4; ++c)
+		{
+			const long v = lrintf((e[c] - (float)pb) * 0.5f);
+			tq[c] = (unsigned char)GFX_CLAMP(v, 0, 127);
+
+			const float d = (float)((tq[c] << 1) | pb) - e[c];
+			err += d * d;
+		}
+
+		if (err < bestErr)
+		{
+			bestErr = err;
+			*p = pb;
+			memcpy(q, tq, 4);
+		}
+	}
+
+	for (int c = 0; c < 4; ++c)
+		dec[c] = (unsigned char)((q[c] << 1) | *p);
+}
+
+/****************************
+ * Encodes a block as a BC7 block using mode 6 (16 bytes).
+ * @return Total squared error.
+ */
+static uint32_t gfx_bcn_encode_bc7_(unsigned char block[16][4],
+                                    unsigned char* out)
+{
+	float weights[16];
+	for (int w = 0; w < 16; ++w)
+		weights[w] = (float)gfx_bcn_bc7_weights_[w] / 64.0f;
+
+	float e0[4], e1[4];
+	gfx_bcn_pca_(block, 4, e0, e1);
+
+	uint32_t bestErr = UINT32_MAX;
+	unsigned char bestQ[2][4], bestP[2];
+	unsigned char bestInd[16];
+
+	// Fit, refine the endpoints & fit once more.
+	for (int it = 0; it < 2; ++it)
+	{
+		unsigned char q[2][4], p[2], dec[2][4];
+		gfx_bcn_rgbap_(e0, q[0], p + 0, dec[0]);
+		gfx_bcn_rgbap_(e1, q[1], p + 1, dec[1]);
+
+		unsigned char palette[16][4];
+		for (int w = 0; w < 16; ++w)
+			for (int c = 0; c < 4; ++c)
+				palette[w][c] = (unsigned char)((
+					(64 - gfx_bcn_bc7_weights_[w]) * dec[0][c] +
+					gfx_bcn_bc7_weights_[w] * dec[1][c] + 32) >> 6);
+
+		unsigned char indices[16];
+		const uint32_t err =
+			gfx_bcn_select_(block, palette, 16, indices);
+
+		if (err < bestErr)
+		{
+			bestErr = err;
+			memcpy(bestQ, q, sizeof(q));
+			memcpy(bestP, p, sizeof(p));
+			memcpy(bestInd, indices, sizeof(indices));
+		}
+
+		if (err == 0) break;
+		gfx_bcn_refine_(block, 4, indices, weights, e0, e1);
+	}
+
+	// The anchor (first) index has an implicit 0 MSB,
+	// if it is set, swap the endpoints & invert all indices.
+	if (bestInd[0] & 8)
+	{
+		unsigned char t[4];
+		memcpy(t, bestQ[0], 4);
+		memcpy(bestQ[0], bestQ[1], 4);
+		memcpy(bestQ[1], t, 4);
+
+		const unsigned char tp = bestP[0];
+		bestP[0] = bestP[1];
+		bestP[1] = tp;
+
+		for (int i = 0; i < 16; ++i)
+			bestInd[i] = (unsigned char)(15 - bestInd[i]);
+	}
+
+	// Mode 6: RGBA 7.7.7.7 endpoints, 1 p-bit each, 4 bits indices.
+	unsigned int pos = 0;
+	memset(out, 0, 16);
+	gfx_bcn_put_(out, &pos, 1 << 6, 7);
+
+	for (int c = 0; c < 4; ++c)
+		gfx_bcn_put_(out, &pos, bestQ[0][c], 7),
+		gfx_bcn_put_(out, &pos, bestQ[1][c], 7);
+
+	gfx_bcn_put_(out, &pos, bestP[0], 1);
+	gfx_bcn_put_(out, &pos, bestP[1], 1);
+
+	for (int i = 0; i < 16; ++i)
+		gfx_bcn_put_(out, &pos, bestInd[i], i == 0 ? 3 : 4);
+
+	return bestErr;
+}
+
+/****************************
+ * Encodes a range of block rows of a job, for use in gfx_jobs_parallel_.
+ * @param ptr GFXBcnJob_*, cannot be NULL.
+ * @return Number of encoded block rows.
+ */
+static size_t gfx_bcn_encode_rows_(void* ptr, size_t begin, size_t end)
+{
+	GFXBcnJob_* job = ptr;
+	assert(job != NULL);
+
+	const uint32_t blocksX = (job->width + 3) / 4;
+	const size_t blockSize = (job->n == 1 || job->n == 4) ? 8 : 16;
+
+	uint64_t err = 0;
+
+	for (uint32_t by = (uint32_t)begin; by < end; ++by)
+		for (uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			unsigned char block[16][4];
+			gfx_bcn_fetch_(job, bx, by, block);
+
+			unsigned char* out =
+				job->dst + ((size_t)by * blocksX + bx) * blockSize;
+
+			switch (job->n)
+			{
+			case 1:
+				err += gfx_bcn_encode_bc1_(block, out);
+				break;
+
+			case 3:
+				err += gfx_bcn_encode_bc4_(block, 3, out);
+				err += gfx_bcn_encode_bc1_(block, out + 8);
+				break;
+
+			case 4:
+				err += gfx_bcn_encode_bc4_(block, 0, out);
+				break;
+
+			case 5:
+				err += gfx_bcn_encode_bc4_(block, 0, out);
+				err += gfx_bcn_encode_bc4_(block, 1, out + 8);
+				break;
+
+			case 7:
+				err += gfx_bcn_encode_bc7_(block, out);
+				break;
+			}
+		}
+
+	atomic_fetch_add(&job->err, err);
+
+	return end - begin;
+}
+
+/****************************/
+GFX_API bool gfx_encode_bcn(GFXFormat fmt,
+                            uint32_t width, uint32_t height, unsigned char comps,
+                            const void* src, void* dst,
+                            unsigned int numThreads, double* mse)
+{
+	assert(width > 0);
+	assert(height > 0);
+	assert(comps >= 1 && comps <= 4);
+	assert(src != NULL);
+	assert(dst != NULL);
+
+	if (!GFX_BCN_IS_SUPPORTED_(fmt))
+	{
+		gfx_log_error(
+			"Cannot encode to format, "
+			"only BC1, BC3, BC4, BC5 and BC7 are supported.");
+
+		return 0;
+	}
+
+	// Split the block rows over jobs on the shared job scheduler,
+	// but don't bother splitting for only a few rows.
+	const uint32_t rows = (height + 3) / 4;
+
+	if (numThreads == 0)
+		numThreads = gfx_thread_count_();
+
+	numThreads = GFX_MIN(numThreads,
+		GFX_MAX(1, rows / GFX_BCN_ROWS_PER_THREAD_));
+
+	GFXBcnJob_ job = {
+		.src = src,
+		.dst = dst,
+		.width = width,
+		.height = height,
+		.comps = comps,
+		.n = fmt.comps[0]
+	};
+
+	atomic_init(&job.err, 0);
+	gfx_jobs_parallel_(rows, numThreads, gfx_bcn_encode_rows_, &job);
+
+	// Output the mean squared error over all encoded channels.
+	if (mse != NULL)
+	{
+		const unsigned int channels =
+			GFX_MIN((unsigned int)GFX_BCN_CHANNELS_(fmt.comps[0]), comps);
+
+		*mse = (double)atomic_load(&job.err) /
+			((double)rows * (double)((width + 3) / 4) * 16.0 * channels);
+	}
+
+	return 1;
+}
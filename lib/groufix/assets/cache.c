@@ -0,0 +1,1286 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/assets/gltf.h"
+#include "groufix/core/log.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// glTF cache identification.
+#define GFX_GLTF_CACHE_MAGIC_   "GFXGLTFC"
+#define GFX_GLTF_CACHE_VERSION_ 4
+
+
+// Alignment of all sections (in bytes).
+#define GFX_GLTF_CACHE_ALIGN_ ((size_t)16)
+
+
+// Maximum #mipmaps of a cached image.
+#define GFX_GLTF_CACHE_MAX_MIPMAPS_ 32
+
+
+// #textures of a material.
+#define GFX_GLTF_CACHE_TEXTURES_ 18
+
+
+// Converts a pointer to an index + 1, 0 for NULL.
+#define GFX_GLTF_CACHE_INDEX_(array, ptr) \
+	((ptr) == NULL ? (uintptr_t)0 : (uintptr_t)((ptr) - (array)) + 1)
+
+
+/****************************
+ * Cache sections, in order of appearance.
+ */
+typedef enum GFXGltfCacheSection_
+{
+	GFX_GLTF_CACHE_IMAGES_,
+	GFX_GLTF_CACHE_SAMPLERS_,
+	GFX_GLTF_CACHE_MATERIALS_,
+	GFX_GLTF_CACHE_PRIMITIVES_,
+	GFX_GLTF_CACHE_ATTRIBUTES_,
+	GFX_GLTF_CACHE_LODS_,
+	GFX_GLTF_CACHE_MESHES_,
+	GFX_GLTF_CACHE_NODES_,
+	GFX_GLTF_CACHE_SCENES_,
+	GFX_GLTF_CACHE_NODE_PTRS_,
+
+	GFX_GLTF_CACHE_NUM_SECTIONS_
+
+} GFXGltfCacheSection_;
+
+
+/****************************
+ * Cache header.
+ */
+typedef struct GFXGltfCacheHeader_
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t layout; // Hash of the layout of all sections.
+
+	uint64_t bufferSize;   // Packed vertex & index data, 0 for none.
+	uint64_t meshletsSize; // Packed meshlet data, 0 for none.
+	uint64_t scene;      // Default scene index + 1, 0 for none.
+	uint64_t counts[GFX_GLTF_CACHE_NUM_SECTIONS_];
+
+} GFXGltfCacheHeader_;
+
+
+/****************************
+ * Cached image.
+ */
+typedef struct GFXGltfCacheImage_
+{
+	GFXImageType type;
+	GFXFormat    format;
+
+	uint32_t mipmaps; // 0 for a NULL image.
+	uint32_t layers;
+	uint32_t width;
+	uint32_t height;
+	uint32_t depth;
+
+	uint64_t offset; // Of all tightly packed mipmaps.
+	uint64_t size;
+
+} GFXGltfCacheImage_;
+
+
+/****************************
+ * Cached primitive.
+ */
+typedef struct GFXGltfCachePrimitive_
+{
+	GFXTopology topology;
+	uint32_t    numVertices;
+	uint32_t    numIndices;
+	uint32_t    indexSize;
+
+	uint64_t indices;       // Buffer offset, UINT64_MAX if not indexed.
+	uint64_t material;      // Index + 1, 0 for none.
+	uint64_t numAttributes; // Consecutive in the attributes section.
+	uint64_t numLods;       // Consecutive in the levels of detail section.
+
+	float posScale;
+	float posOffset[3];
+	float min[3];
+	float max[3];
+
+	uint64_t numMeshlets;
+	uint64_t meshlets; // Meshlet buffer offsets, if numMeshlets > 0.
+	uint64_t vertices;
+	uint64_t triangles;
+
+} GFXGltfCachePrimitive_;
+
+
+/****************************
+ * Cached vertex attribute.
+ */
+typedef struct GFXGltfCacheAttribute_
+{
+	GFXFormat    format;
+	uint32_t     offset;
+	uint32_t     stride;
+	GFXInputRate rate;
+
+	uint64_t buffer; // Buffer offset.
+
+} GFXGltfCacheAttribute_;
+
+
+/****************************
+ * Cached level of detail.
+ */
+typedef struct GFXGltfCacheLod_
+{
+	uint64_t indices; // Buffer offset.
+	uint32_t numIndices;
+	float    error;
+
+} GFXGltfCacheLod_;
+
+
+/****************************
+ * Element sizes of all sections.
+ * Materials, meshes, nodes & scenes are stored as-is, with all pointers
+ * replaced by indices (or offsets into the node pointers section).
+ */
+static const size_t gfx_gltf_cache_sizes_[] = {
+	sizeof(GFXGltfCacheImage_),
+	sizeof(GFXGltfSampler),
+	sizeof(GFXGltfMaterial),
+	sizeof(GFXGltfCachePrimitive_),
+	sizeof(GFXGltfCacheAttribute_),
+	sizeof(GFXGltfCacheLod_),
+	sizeof(GFXGltfMesh),
+	sizeof(GFXGltfNode),
+	sizeof(GFXGltfScene),
+	sizeof(uint64_t)
+};
+
+
+/****************************
+ * Computes the layout hash, so a cache is never loaded by a build
+ * that lays out (or swizzles pointers in) any section differently.
+ */
+static uint32_t gfx_gltf_cache_layout_(void)
+{
+	const uint16_t endian = 1;
+
+	const size_t layout[] = {
+		sizeof(void*),
+		sizeof(size_t),
+		sizeof(GFXGltfCacheHeader_),
+		*(const unsigned char*)&endian,
+		gfx_gltf_cache_sizes_[0], gfx_gltf_cache_sizes_[1],
+		gfx_gltf_cache_sizes_[2], gfx_gltf_cache_sizes_[3],
+		gfx_gltf_cache_sizes_[4], gfx_gltf_cache_sizes_[5],
+		gfx_gltf_cache_sizes_[6], gfx_gltf_cache_sizes_[7],
+		gfx_gltf_cache_sizes_[8], gfx_gltf_cache_sizes_[9]
+	};
+
+	// FNV-1a.
+	const unsigned char* bytes = (const unsigned char*)layout;
+	uint32_t hash = 2166136261u;
+
+	for (size_t b = 0; b < sizeof(layout); ++b)
+		hash = (hash ^ bytes[b]) * 16777619u;
+
+	return hash;
+}
+
+/****************************
+ * Computes the offsets of all sections.
+ * @param counts  Element counts of all sections.
+ * @param len     Size of the entire cache, sections must fit in it.
+ * @param offsets Output offsets, of GFX_GLTF_CACHE_NUM_SECTIONS_ + 1,
+ *                the last being the offset of the packed buffer data.
+ * @return Zero if the sections do not fit in len.
+ */
+static bool gfx_gltf_cache_offsets_(const uint64_t* counts, uint64_t len,
+                                    uint64_t* offsets)
+{
+	uint64_t offset =
+		GFX_ALIGN_UP(sizeof(GFXGltfCacheHeader_), GFX_GLTF_CACHE_ALIGN_);
+
+	for (size_t s = 0; s < GFX_GLTF_CACHE_NUM_SECTIONS_; ++s)
+	{
+		if (offset > len || counts[s] > (len - offset) / gfx_gltf_cache_sizes_[s])
+			return 0;
+
+		offsets[s] = offset;
+		offset = GFX_ALIGN_UP(
+			offset + counts[s] * gfx_gltf_cache_sizes_[s], GFX_GLTF_CACHE_ALIGN_);
+	}
+
+	offsets[GFX_GLTF_CACHE_NUM_SECTIONS_] = offset;
+
+	return offset <= len;
+}
+
+/****************************
+ * Retrieves all textures of a material.
+ * @param textures Output array of GFX_GLTF_CACHE_TEXTURES_ textures.
+ */
+static void gfx_gltf_cache_textures_(GFXGltfMaterial* material,
+                                     GFXGltfTexture** textures)
+{
+	GFXGltfTexture* all[GFX_GLTF_CACHE_TEXTURES_] = {
+		&material->pbr.baseColor,
+		&material->pbr.metallicRoughness,
+		&material->pbr.diffuse,
+		&material->pbr.specularGlossiness,
+		&material->normal,
+		&material->occlusion,
+		&material->emissive,
+		&material->clearcoat,
+		&material->clearcoatRoughness,
+		&material->clearcoatNormal,
+		&material->iridescence,
+		&material->iridescenceThickness,
+		&material->sheenColor,
+		&material->sheenRoughness,
+		&material->specular,
+		&material->specularColor,
+		&material->transmission,
+		&material->thickness
+	};
+
+	memcpy(textures, all, sizeof(all));
+}
+
+/****************************
+ * Computes the region & byte size of an image mipmap,
+ * with all layers tightly packed.
+ * @param region Output image region, cannot be NULL.
+ */
+static uint64_t gfx_gltf_cache_mipmap_(GFXFormat format, uint32_t layers,
+                                       uint32_t width, uint32_t height,
+                                       uint32_t depth, uint32_t mipmap,
+                                       GFXRegion* region)
+{
+	const uint32_t blockSize = GFX_FORMAT_BLOCK_SIZE(format) / CHAR_BIT;
+	const uint32_t blockWidth = GFX_FORMAT_BLOCK_WIDTH(format);
+	const uint32_t blockHeight = GFX_FORMAT_BLOCK_HEIGHT(format);
+
+	const uint32_t w = GFX_MAX(1, width >> mipmap);
+	const uint32_t h = GFX_MAX(1, height >> mipmap);
+	const uint32_t d = GFX_MAX(1, depth >> mipmap);
+
+	*region = (GFXRegion){
+		.aspect = GFX_IMAGE_COLOR,
+		.mipmap = mipmap,
+		.layer = 0,
+		.numLayers = layers,
+		.x = 0,
+		.y = 0,
+		.z = 0,
+		.width = w,
+		.height = h,
+		.depth = d
+	};
+
+	return (uint64_t)blockSize * layers * d *
+		((w + blockWidth - 1) / blockWidth) *
+		((h + blockHeight - 1) / blockHeight);
+}
+
+/****************************
+ * Writes data to a stream, padded to GFX_GLTF_CACHE_ALIGN_.
+ * @return Zero on failure.
+ */
+static bool gfx_gltf_cache_write_(const GFXWriter* dst,
+                                  const void* data, uint64_t size)
+{
+	static const unsigned char zeros[GFX_GLTF_CACHE_ALIGN_] = { 0 };
+	const uint64_t pad = GFX_ALIGN_UP(size, GFX_GLTF_CACHE_ALIGN_) - size;
+
+	return
+		(size == 0 || gfx_io_write(dst, data, (size_t)size) == (long long)size) &&
+		(pad == 0 || gfx_io_write(dst, zeros, (size_t)pad) == (long long)pad);
+}
+
+/****************************
+ * Flushes & blocks the heap of a resource, unless it was the last.
+ * @param last In/out last flushed heap, cannot be NULL.
+ */
+static void gfx_gltf_cache_block_(GFXHeap* heap, GFXHeap** last)
+{
+	if (heap != *last && gfx_heap_flush(heap))
+		gfx_heap_block(heap);
+
+	*last = heap;
+}
+
+/****************************
+ * Reads back an entire buffer & writes it to a stream.
+ * @param last In/out last flushed heap, cannot be NULL.
+ * @return Zero on failure.
+ */
+static bool gfx_gltf_cache_store_buffer_(const GFXWriter* dst,
+                                         GFXBuffer* buffer, GFXHeap** last)
+{
+	void* bin = malloc((size_t)buffer->size);
+	if (bin == NULL) return 0;
+
+	const GFXRegion region = {
+		.offset = 0,
+		.size = buffer->size
+	};
+
+	gfx_gltf_cache_block_(gfx_buffer_get_heap(buffer), last);
+
+	const bool success =
+		gfx_read(gfx_ref_buffer(buffer), bin,
+			GFX_TRANSFER_NONE, 1, 0, &region, &region, NULL) &&
+		gfx_gltf_cache_write_(dst, bin, buffer->size);
+
+	free(bin);
+
+	return success;
+}
+
+/****************************
+ * Allocates a buffer & writes it straight from a cache.
+ * @return NULL on failure.
+ */
+static GFXBuffer* gfx_gltf_cache_load_buffer_(GFXHeap* heap, GFXSemaphore* sem,
+                                              GFXImageFlags flags,
+                                              GFXBufferUsage usage,
+                                              GFXAccessMask mask,
+                                              const unsigned char* bytes,
+                                              uint64_t offset, uint64_t size)
+{
+	GFXBuffer* buffer = gfx_alloc_buffer(heap,
+		(flags & GFX_IMAGE_READABLE) ?
+			GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+		usage, size);
+
+	if (buffer == NULL)
+		return NULL;
+
+	const GFXRegion srcRegion = {
+		.offset = offset,
+		.size = size
+	};
+
+	const GFXRegion dstRegion = {
+		.offset = 0,
+		.size = size
+	};
+
+	const GFXInject inject =
+		gfx_sem_sig(sem, mask, GFX_STAGE_ANY);
+
+	if (!gfx_write(bytes, gfx_ref_buffer(buffer),
+		GFX_TRANSFER_ASYNC,
+		1, 1, &srcRegion, &dstRegion, &inject))
+	{
+		gfx_free_buffer(buffer);
+		return NULL;
+	}
+
+	return buffer;
+}
+
+/****************************
+ * Copies a section of a cache into a new allocation.
+ * @param success Set to zero when out of memory, cannot be NULL.
+ * @return NULL if the section is empty.
+ */
+static void* gfx_gltf_cache_copy_(const unsigned char* bytes,
+                                  const uint64_t* counts, const uint64_t* offsets,
+                                  GFXGltfCacheSection_ section, bool* success)
+{
+	const size_t size =
+		(size_t)counts[section] * gfx_gltf_cache_sizes_[section];
+
+	if (size == 0)
+		return NULL;
+
+	void* ret = malloc(size);
+	if (ret == NULL)
+		*success = 0;
+	else
+		memcpy(ret, bytes + offsets[section], size);
+
+	return ret;
+}
+
+/****************************/
+GFX_API bool gfx_store_gltf_cache(const GFXGltfResult* result,
+                                  const GFXWriter* dst)
+{
+	assert(result != NULL);
+	assert(dst != NULL);
+
+	unsigned char* meta = NULL;
+	void* bin = NULL;
+
+	// All GPU data must be readable.
+	bool readable =
+		(result->buffer == NULL || (result->buffer->flags & GFX_MEMORY_READ)) &&
+		(result->meshlets == NULL || (result->meshlets->flags & GFX_MEMORY_READ));
+
+	for (size_t i = 0; i < result->numImages; ++i)
+		if (result->images[i] != NULL)
+			readable = readable && (result->images[i]->flags & GFX_MEMORY_READ);
+
+	if (!readable)
+	{
+		gfx_log_error(
+			"Cannot store glTF cache, result was not loaded with "
+			"GFX_IMAGE_READABLE.");
+
+		return 0;
+	}
+
+	// Compute all section counts.
+	GFXGltfCacheHeader_ header = {
+		.version = GFX_GLTF_CACHE_VERSION_,
+		.layout = gfx_gltf_cache_layout_(),
+		.bufferSize = result->buffer != NULL ? result->buffer->size : 0,
+		.meshletsSize = result->meshlets != NULL ? result->meshlets->size : 0,
+		.scene = GFX_GLTF_CACHE_INDEX_(result->scenes, result->scene),
+		.counts = {
+			[GFX_GLTF_CACHE_IMAGES_] = result->numImages,
+			[GFX_GLTF_CACHE_SAMPLERS_] = result->numSamplers,
+			[GFX_GLTF_CACHE_MATERIALS_] = result->numMaterials,
+			[GFX_GLTF_CACHE_PRIMITIVES_] = result->numPrimitives,
+			[GFX_GLTF_CACHE_MESHES_] = result->numMeshes,
+			[GFX_GLTF_CACHE_NODES_] = result->numNodes,
+			[GFX_GLTF_CACHE_SCENES_] = result->numScenes
+		}
+	};
+
+	memcpy(header.magic, GFX_GLTF_CACHE_MAGIC_, sizeof(header.magic));
+
+	for (size_t p = 0; p < result->numPrimitives; ++p)
+		header.counts[GFX_GLTF_CACHE_ATTRIBUTES_] +=
+			result->primitives[p].numAttributes,
+		header.counts[GFX_GLTF_CACHE_LODS_] +=
+			result->primitives[p].numLods;
+
+	for (size_t n = 0; n < result->numNodes; ++n)
+		header.counts[GFX_GLTF_CACHE_NODE_PTRS_] +=
+			result->nodes[n].numChildren;
+
+	for (size_t s = 0; s < result->numScenes; ++s)
+		header.counts[GFX_GLTF_CACHE_NODE_PTRS_] +=
+			result->scenes[s].numNodes;
+
+	uint64_t offsets[GFX_GLTF_CACHE_NUM_SECTIONS_ + 1];
+	gfx_gltf_cache_offsets_(header.counts, UINT64_MAX, offsets);
+
+	// Allocate all metadata in one go.
+	const uint64_t metaSize = offsets[GFX_GLTF_CACHE_NUM_SECTIONS_];
+	meta = calloc(1, (size_t)metaSize);
+	if (meta == NULL) goto clean;
+
+	memcpy(meta, &header, sizeof(header));
+
+	// Images, data follows the packed buffer & meshlet data.
+	uint64_t dataOffset = metaSize +
+		GFX_ALIGN_UP(header.bufferSize, GFX_GLTF_CACHE_ALIGN_) +
+		GFX_ALIGN_UP(header.meshletsSize, GFX_GLTF_CACHE_ALIGN_);
+
+	GFXGltfCacheImage_* images =
+		(GFXGltfCacheImage_*)(meta + offsets[GFX_GLTF_CACHE_IMAGES_]);
+
+	for (size_t i = 0; i < result->numImages; ++i)
+	{
+		const GFXImage* image = result->images[i];
+		if (image == NULL) continue;
+
+		if (image->mipmaps > GFX_GLTF_CACHE_MAX_MIPMAPS_)
+		{
+			gfx_log_error(
+				"Cannot store glTF cache, image %"GFX_PRIs" has too "
+				"many mipmaps.",
+				i);
+
+			goto clean;
+		}
+
+		images[i] = (GFXGltfCacheImage_){
+			.type = image->type,
+			.format = image->format,
+			.mipmaps = image->mipmaps,
+			.layers = image->layers,
+			.width = image->width,
+			.height = image->height,
+			.depth = image->depth,
+			.offset = dataOffset,
+			.size = 0
+		};
+
+		for (uint32_t l = 0; l < image->mipmaps; ++l)
+		{
+			GFXRegion region;
+			images[i].size += gfx_gltf_cache_mipmap_(
+				image->format, image->layers,
+				image->width, image->height, image->depth, l, &region);
+		}
+
+		dataOffset = GFX_ALIGN_UP(
+			dataOffset + images[i].size, GFX_GLTF_CACHE_ALIGN_);
+	}
+
+	// Samplers.
+	if (result->numSamplers > 0)
+		memcpy(meta + offsets[GFX_GLTF_CACHE_SAMPLERS_],
+			result->samplers, sizeof(GFXGltfSampler) * result->numSamplers);
+
+	// Materials, swizzle all texture pointers.
+	GFXGltfMaterial* materials =
+		(GFXGltfMaterial*)(meta + offsets[GFX_GLTF_CACHE_MATERIALS_]);
+
+	for (size_t m = 0; m < result->numMaterials; ++m)
+	{
+		GFXGltfTexture* textures[GFX_GLTF_CACHE_TEXTURES_];
+		materials[m] = result->materials[m];
+		gfx_gltf_cache_textures_(materials + m, textures);
+
+		for (size_t t = 0; t < GFX_GLTF_CACHE_TEXTURES_; ++t)
+		{
+			uintptr_t image = 0;
+			for (size_t i = 0; i < result->numImages; ++i)
+				if (textures[t]->image != NULL &&
+					textures[t]->image == result->images[i])
+				{
+					image = (uintptr_t)i + 1;
+					break;
+				}
+
+			textures[t]->image = (GFXImage*)image;
+			textures[t]->sampler = (GFXGltfSampler*)GFX_GLTF_CACHE_INDEX_(
+				result->samplers, textures[t]->sampler);
+		}
+	}
+
+	// Primitives, attributes & levels of detail.
+	GFXGltfCachePrimitive_* prims =
+		(GFXGltfCachePrimitive_*)(meta + offsets[GFX_GLTF_CACHE_PRIMITIVES_]);
+	GFXGltfCacheAttribute_* attribs =
+		(GFXGltfCacheAttribute_*)(meta + offsets[GFX_GLTF_CACHE_ATTRIBUTES_]);
+	GFXGltfCacheLod_* lods =
+		(GFXGltfCacheLod_*)(meta + offsets[GFX_GLTF_CACHE_LODS_]);
+
+	for (size_t p = 0; p < result->numPrimitives; ++p)
+	{
+		const GFXGltfPrimitive* prim = result->primitives + p;
+
+		if (
+			(!GFX_REF_IS_NULL(prim->indices) &&
+				prim->indices.obj != result->buffer) ||
+			(prim->numMeshlets > 0 && (
+				prim->meshlets.obj != result->meshlets ||
+				prim->vertices.obj != result->meshlets ||
+				prim->triangles.obj != result->meshlets)))
+		{
+			gfx_log_error(
+				"Cannot store glTF cache, primitive %"GFX_PRIs" does not "
+				"reference the packed buffer.",
+				p);
+
+			goto clean;
+		}
+
+		prims[p] = (GFXGltfCachePrimitive_){
+			.topology = prim->primitive->topology,
+			.numVertices = prim->primitive->numVertices,
+			.numIndices = prim->primitive->numIndices,
+			.indexSize = (uint32_t)prim->primitive->indexSize,
+			.indices = GFX_REF_IS_NULL(prim->indices) ?
+				UINT64_MAX : prim->indices.offset,
+			.material = GFX_GLTF_CACHE_INDEX_(
+				result->materials, prim->material),
+			.numAttributes = prim->numAttributes,
+			.numLods = prim->numLods,
+			.posScale = prim->posScale,
+			.posOffset = {
+				prim->posOffset[0],
+				prim->posOffset[1],
+				prim->posOffset[2]
+			},
+			.min = { prim->min[0], prim->min[1], prim->min[2] },
+			.max = { prim->max[0], prim->max[1], prim->max[2] },
+
+			.numMeshlets = prim->numMeshlets,
+			.meshlets = prim->numMeshlets > 0 ? prim->meshlets.offset : 0,
+			.vertices = prim->numMeshlets > 0 ? prim->vertices.offset : 0,
+			.triangles = prim->numMeshlets > 0 ? prim->triangles.offset : 0
+		};
+
+		for (size_t a = 0; a < prim->numAttributes; ++a, ++attribs)
+		{
+			if (prim->attributes[a].buffer.obj != result->buffer)
+			{
+				gfx_log_error(
+					"Cannot store glTF cache, primitive %"GFX_PRIs" does not "
+					"reference the packed buffer.",
+					p);
+
+				goto clean;
+			}
+
+			*attribs = (GFXGltfCacheAttribute_){
+				.format = prim->attributes[a].format,
+				.offset = prim->attributes[a].offset,
+				.stride = prim->attributes[a].stride,
+				.rate = prim->attributes[a].rate,
+				.buffer = prim->attributes[a].buffer.offset
+			};
+		}
+
+		for (size_t l = 0; l < prim->numLods; ++l, ++lods)
+		{
+			if (prim->lods[l].indices.obj != result->buffer)
+			{
+				gfx_log_error(
+					"Cannot store glTF cache, primitive %"GFX_PRIs" does not "
+					"reference the packed buffer.",
+					p);
+
+				goto clean;
+			}
+
+			*lods = (GFXGltfCacheLod_){
+				.indices = prim->lods[l].indices.offset,
+				.numIndices = prim->lods[l].numIndices,
+				.error = prim->lods[l].error
+			};
+		}
+	}
+
+	// Meshes, swizzle primitive pointers.
+	GFXGltfMesh* meshes =
+		(GFXGltfMesh*)(meta + offsets[GFX_GLTF_CACHE_MESHES_]);
+
+	for (size_t m = 0; m < result->numMeshes; ++m)
+	{
+		meshes[m] = result->meshes[m];
+		meshes[m].primitives = (GFXGltfPrimitive*)(uintptr_t)
+			(result->meshes[m].primitives - result->primitives);
+	}
+
+	// Nodes & scenes, swizzle all pointers.
+	GFXGltfNode* nodes =
+		(GFXGltfNode*)(meta + offsets[GFX_GLTF_CACHE_NODES_]);
+	GFXGltfScene* scenes =
+		(GFXGltfScene*)(meta + offsets[GFX_GLTF_CACHE_SCENES_]);
+	uint64_t* nodePtrs =
+		(uint64_t*)(meta + offsets[GFX_GLTF_CACHE_NODE_PTRS_]);
+
+	uintptr_t nodePtrsLoc = 0;
+
+	for (size_t n = 0; n < result->numNodes; ++n)
+	{
+		const GFXGltfNode* node = result->nodes + n;
+
+		nodes[n] = *node;
+		nodes[n].parent = (GFXGltfNode*)
+			GFX_GLTF_CACHE_INDEX_(result->nodes, node->parent);
+		nodes[n].children = (GFXGltfNode**)nodePtrsLoc;
+		nodes[n].mesh = (GFXGltfMesh*)
+			GFX_GLTF_CACHE_INDEX_(result->meshes, node->mesh);
+
+		for (size_t c = 0; c < node->numChildren; ++c)
+			nodePtrs[nodePtrsLoc++] =
+				(uint64_t)(node->children[c] - result->nodes);
+	}
+
+	for (size_t s = 0; s < result->numScenes; ++s)
+	{
+		const GFXGltfScene* scene = result->scenes + s;
+
+		scenes[s] = *scene;
+		scenes[s].nodes = (GFXGltfNode**)nodePtrsLoc;
+
+		for (size_t n = 0; n < scene->numNodes; ++n)
+			nodePtrs[nodePtrsLoc++] =
+				(uint64_t)(scene->nodes[n] - result->nodes);
+	}
+
+	// Write all metadata.
+	if (!gfx_gltf_cache_write_(dst, meta, metaSize))
+		goto clean;
+
+	// Make sure all uploads are done, then read back & write all data.
+	GFXHeap* heap = NULL;
+
+	if (header.bufferSize > 0 &&
+		!gfx_gltf_cache_store_buffer_(dst, result->buffer, &heap))
+	{
+		goto clean;
+	}
+
+	if (header.meshletsSize > 0 &&
+		!gfx_gltf_cache_store_buffer_(dst, result->meshlets, &heap))
+	{
+		goto clean;
+	}
+
+	for (size_t i = 0; i < result->numImages; ++i)
+	{
+		GFXImage* image = result->images[i];
+		if (image == NULL) continue;
+
+		bin = malloc((size_t)images[i].size);
+		if (bin == NULL) goto clean;
+
+		GFXRegion srcRegions[GFX_GLTF_CACHE_MAX_MIPMAPS_];
+		GFXRegion dstRegions[GFX_GLTF_CACHE_MAX_MIPMAPS_];
+		uint64_t offset = 0;
+
+		for (uint32_t l = 0; l < image->mipmaps; ++l)
+		{
+			dstRegions[l] = (GFXRegion){
+				.offset = offset,
+				.rowSize = 0,
+				.numRows = 0
+			};
+
+			offset += gfx_gltf_cache_mipmap_(
+				image->format, image->layers,
+				image->width, image->height, image->depth, l, srcRegions + l);
+		}
+
+		gfx_gltf_cache_block_(gfx_image_get_heap(image), &heap);
+
+		if (
+			!gfx_read(gfx_ref_image(image), bin,
+				GFX_TRANSFER_NONE, image->mipmaps, 0,
+				srcRegions, dstRegions, NULL) ||
+			!gfx_gltf_cache_write_(dst, bin, images[i].size))
+		{
+			goto clean;
+		}
+
+		free(bin);
+		bin = NULL;
+	}
+
+	free(meta);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(meta);
+	free(bin);
+	gfx_log_error("Failed to store glTF cache to stream.");
+
+	return 0;
+}
+
+/****************************/
+GFX_API bool gfx_load_gltf_cache(GFXHeap* heap, GFXSemaphore* sem,
+                                 GFXImageFlags flags, GFXImageUsage usage,
+                                 const GFXReader* src,
+                                 GFXGltfResult* result)
+{
+	assert(heap != NULL);
+	assert(sem != NULL);
+	assert(src != NULL);
+	assert(result != NULL);
+
+	// Map the entire stream into memory,
+	// in-memory streams are used as-is.
+	const void* source;
+	const long long len = gfx_io_raw_init(&source, src);
+
+	if (len <= 0)
+	{
+		gfx_log_error("Could not read glTF cache from stream.");
+		gfx_io_raw_clear(&source, src);
+
+		return 0;
+	}
+
+	const unsigned char* bytes = source;
+
+	// Validate the header.
+	GFXGltfCacheHeader_ header;
+	uint64_t offsets[GFX_GLTF_CACHE_NUM_SECTIONS_ + 1];
+
+	if ((size_t)len < sizeof(header))
+	{
+		gfx_log_error("Could not read glTF cache from stream.");
+		gfx_io_raw_clear(&source, src);
+
+		return 0;
+	}
+
+	memcpy(&header, bytes, sizeof(header));
+
+	if (
+		memcmp(header.magic, GFX_GLTF_CACHE_MAGIC_, sizeof(header.magic)) ||
+		header.version != GFX_GLTF_CACHE_VERSION_ ||
+		header.layout != gfx_gltf_cache_layout_())
+	{
+		gfx_log_warn(
+			"glTF cache is not a cache or stored by a different "
+			"version or build of groufix.");
+
+		gfx_io_raw_clear(&source, src);
+
+		return 0;
+	}
+
+	const uint64_t* counts = header.counts;
+
+	const size_t numImages = (size_t)counts[GFX_GLTF_CACHE_IMAGES_];
+	const size_t numPrims = (size_t)counts[GFX_GLTF_CACHE_PRIMITIVES_];
+	const size_t numAttribs = (size_t)counts[GFX_GLTF_CACHE_ATTRIBUTES_];
+	const size_t numLods = (size_t)counts[GFX_GLTF_CACHE_LODS_];
+	const size_t numNodePtrs = (size_t)counts[GFX_GLTF_CACHE_NODE_PTRS_];
+	const size_t numNodes = (size_t)counts[GFX_GLTF_CACHE_NODES_];
+
+	// Setup all output arrays.
+	// From this point onwards we need to clean on failure.
+	GFXBuffer* buffer = NULL;
+	GFXBuffer* meshlets = NULL;
+	GFXImage** images = NULL;
+	GFXGltfSampler* samplers = NULL;
+	GFXGltfMaterial* materials = NULL;
+	GFXGltfPrimitive* primitives = NULL;
+	GFXAttribute* attributes = NULL;
+	GFXGltfLod* lods = NULL;
+	GFXGltfMesh* meshes = NULL;
+	GFXGltfNode* nodes = NULL;
+	GFXGltfScene* scenes = NULL;
+	GFXGltfNode** nodePtrs = NULL;
+
+	if (!gfx_gltf_cache_offsets_(counts, (uint64_t)len, offsets))
+	{
+		gfx_log_error("glTF cache is out of range.");
+		goto clean;
+	}
+
+	const uint64_t bufferOffset = offsets[GFX_GLTF_CACHE_NUM_SECTIONS_];
+	const uint64_t meshletsOffset =
+		bufferOffset + GFX_ALIGN_UP(header.bufferSize, GFX_GLTF_CACHE_ALIGN_);
+
+	if (
+		header.bufferSize > (uint64_t)len - bufferOffset ||
+		meshletsOffset > (uint64_t)len ||
+		header.meshletsSize > (uint64_t)len - meshletsOffset ||
+		header.scene > counts[GFX_GLTF_CACHE_SCENES_])
+	{
+		gfx_log_error("glTF cache is out of range.");
+		goto clean;
+	}
+
+	bool success = 1;
+	samplers = gfx_gltf_cache_copy_(
+		bytes, counts, offsets, GFX_GLTF_CACHE_SAMPLERS_, &success);
+	materials = gfx_gltf_cache_copy_(
+		bytes, counts, offsets, GFX_GLTF_CACHE_MATERIALS_, &success);
+	meshes = gfx_gltf_cache_copy_(
+		bytes, counts, offsets, GFX_GLTF_CACHE_MESHES_, &success);
+	nodes = gfx_gltf_cache_copy_(
+		bytes, counts, offsets, GFX_GLTF_CACHE_NODES_, &success);
+	scenes = gfx_gltf_cache_copy_(
+		bytes, counts, offsets, GFX_GLTF_CACHE_SCENES_, &success);
+
+	if (numImages > 0)
+		success = success &&
+			(images = calloc(numImages, sizeof(GFXImage*))) != NULL;
+	if (numPrims > 0)
+		success = success &&
+			(primitives = calloc(numPrims, sizeof(GFXGltfPrimitive))) != NULL;
+	if (numAttribs > 0)
+		success = success &&
+			(attributes = malloc(sizeof(GFXAttribute) * numAttribs)) != NULL;
+	if (numLods > 0)
+		success = success &&
+			(lods = malloc(sizeof(GFXGltfLod) * numLods)) != NULL;
+	if (numNodePtrs > 0)
+		success = success &&
+			(nodePtrs = malloc(sizeof(GFXGltfNode*) * numNodePtrs)) != NULL;
+
+	if (!success) goto clean;
+
+	// Allocate & write packed buffers, straight from the source.
+	if (header.bufferSize > 0)
+	{
+		buffer = gfx_gltf_cache_load_buffer_(
+			heap, sem, flags,
+			GFX_BUFFER_VERTEX | GFX_BUFFER_INDEX,
+			GFX_ACCESS_VERTEX_READ | GFX_ACCESS_INDEX_READ,
+			bytes, bufferOffset, header.bufferSize);
+
+		if (buffer == NULL) goto clean;
+	}
+
+	if (header.meshletsSize > 0)
+	{
+		meshlets = gfx_gltf_cache_load_buffer_(
+			heap, sem, flags,
+			GFX_BUFFER_STORAGE, GFX_ACCESS_STORAGE_READ,
+			bytes, meshletsOffset, header.meshletsSize);
+
+		if (meshlets == NULL) goto clean;
+	}
+
+	// Allocate & write all images, all mipmaps at once.
+	const GFXGltfCacheImage_* cimages =
+		(const GFXGltfCacheImage_*)(bytes + offsets[GFX_GLTF_CACHE_IMAGES_]);
+
+	for (size_t i = 0; i < numImages; ++i)
+	{
+		GFXGltfCacheImage_ cimage;
+		memcpy(&cimage, cimages + i, sizeof(cimage));
+
+		if (cimage.mipmaps == 0)
+			continue;
+
+		GFXRegion srcRegions[GFX_GLTF_CACHE_MAX_MIPMAPS_];
+		GFXRegion dstRegions[GFX_GLTF_CACHE_MAX_MIPMAPS_];
+		uint64_t size = 0;
+
+		if (cimage.mipmaps <= GFX_GLTF_CACHE_MAX_MIPMAPS_)
+			for (uint32_t l = 0; l < cimage.mipmaps; ++l)
+			{
+				srcRegions[l] = (GFXRegion){
+					.offset = cimage.offset + size,
+					.rowSize = 0,
+					.numRows = 0
+				};
+
+				size += gfx_gltf_cache_mipmap_(
+					cimage.format, cimage.layers,
+					cimage.width, cimage.height, cimage.depth, l, dstRegions + l);
+			}
+
+		if (
+			cimage.mipmaps > GFX_GLTF_CACHE_MAX_MIPMAPS_ ||
+			size != cimage.size ||
+			cimage.offset > (uint64_t)len ||
+			size > (uint64_t)len - cimage.offset)
+		{
+			gfx_log_error(
+				"glTF cache image %"GFX_PRIs" is out of range.",
+				i);
+
+			goto clean;
+		}
+
+		images[i] = gfx_alloc_image(heap,
+			cimage.type,
+			(flags & GFX_IMAGE_READABLE) ?
+				GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+			usage, cimage.format, cimage.mipmaps, cimage.layers,
+			cimage.width, cimage.height, cimage.depth);
+
+		if (images[i] == NULL) goto clean;
+
+		const GFXAccessMask mask =
+			((usage & GFX_IMAGE_SAMPLED) ||
+			(usage & GFX_IMAGE_SAMPLED_LINEAR) ||
+			(usage & GFX_IMAGE_SAMPLED_MINMAX) ?
+				GFX_ACCESS_SAMPLED_READ : 0) |
+			((usage & GFX_IMAGE_STORAGE) ?
+				GFX_ACCESS_STORAGE_READ_WRITE : 0);
+
+		const GFXInject inject =
+			gfx_sem_sig(sem, mask, GFX_STAGE_ANY);
+
+		if (!gfx_write(bytes, gfx_ref_image(images[i]),
+			GFX_TRANSFER_ASYNC,
+			cimage.mipmaps, 1, srcRegions, dstRegions, &inject))
+		{
+			goto clean;
+		}
+	}
+
+	// Unswizzle all material textures.
+	for (size_t m = 0; m < counts[GFX_GLTF_CACHE_MATERIALS_]; ++m)
+	{
+		GFXGltfTexture* textures[GFX_GLTF_CACHE_TEXTURES_];
+		gfx_gltf_cache_textures_(materials + m, textures);
+
+		for (size_t t = 0; t < GFX_GLTF_CACHE_TEXTURES_; ++t)
+		{
+			const uintptr_t image = (uintptr_t)textures[t]->image;
+			const uintptr_t sampler = (uintptr_t)textures[t]->sampler;
+
+			if (image > numImages || sampler > counts[GFX_GLTF_CACHE_SAMPLERS_])
+			{
+				gfx_log_error("glTF cache material %"GFX_PRIs" is out of range.", m);
+				goto clean;
+			}
+
+			textures[t]->image = image > 0 ? images[image - 1] : NULL;
+			textures[t]->sampler = sampler > 0 ? samplers + (sampler - 1) : NULL;
+		}
+	}
+
+	// Create all primitives.
+	const GFXGltfCachePrimitive_* cprims =
+		(const GFXGltfCachePrimitive_*)(bytes + offsets[GFX_GLTF_CACHE_PRIMITIVES_]);
+	const GFXGltfCacheAttribute_* cattribs =
+		(const GFXGltfCacheAttribute_*)(bytes + offsets[GFX_GLTF_CACHE_ATTRIBUTES_]);
+	const GFXGltfCacheLod_* clods =
+		(const GFXGltfCacheLod_*)(bytes + offsets[GFX_GLTF_CACHE_LODS_]);
+
+	for (size_t p = 0, a = 0, l = 0; p < numPrims; ++p)
+	{
+		GFXGltfCachePrimitive_ cprim;
+		memcpy(&cprim, cprims + p, sizeof(cprim));
+
+		if (
+			cprim.material > counts[GFX_GLTF_CACHE_MATERIALS_] ||
+			cprim.numAttributes == 0 ||
+			cprim.numAttributes > numAttribs - a ||
+			cprim.numLods > numLods - l ||
+			(cprim.indices != UINT64_MAX &&
+				cprim.indices >= header.bufferSize) ||
+			(cprim.numMeshlets > 0 && (
+				cprim.meshlets >= header.meshletsSize ||
+				cprim.vertices >= header.meshletsSize ||
+				cprim.triangles >= header.meshletsSize)))
+		{
+			gfx_log_error("glTF cache primitive %"GFX_PRIs" is out of range.", p);
+			goto clean;
+		}
+
+		GFXAttribute* attribs = attributes + a;
+
+		for (size_t pa = 0; pa < cprim.numAttributes; ++pa, ++a)
+		{
+			GFXGltfCacheAttribute_ cattr;
+			memcpy(&cattr, cattribs + a, sizeof(cattr));
+
+			if (cattr.buffer >= header.bufferSize)
+			{
+				gfx_log_error("glTF cache primitive %"GFX_PRIs" is out of range.", p);
+				goto clean;
+			}
+
+			attribs[pa] = (GFXAttribute){
+				.format = cattr.format,
+				.offset = cattr.offset,
+				.stride = cattr.stride,
+				.rate = cattr.rate,
+				.buffer = gfx_ref_buffer_at(buffer, cattr.buffer)
+			};
+		}
+
+		GFXGltfLod* plods = lods + l;
+
+		for (size_t pl = 0; pl < cprim.numLods; ++pl, ++l)
+		{
+			GFXGltfCacheLod_ clod;
+			memcpy(&clod, clods + l, sizeof(clod));
+
+			if (clod.indices >= header.bufferSize)
+			{
+				gfx_log_error("glTF cache primitive %"GFX_PRIs" is out of range.", p);
+				goto clean;
+			}
+
+			plods[pl] = (GFXGltfLod){
+				.indices = gfx_ref_buffer_at(buffer, clod.indices),
+				.numIndices = clod.numIndices,
+				.error = clod.error
+			};
+		}
+
+		const GFXBufferRef indices = cprim.indices == UINT64_MAX ?
+			GFX_REF_NULL : gfx_ref_buffer_at(buffer, cprim.indices);
+
+		GFXPrimitive* prim = gfx_alloc_prim(heap,
+			0, 0, cprim.topology,
+			cprim.numIndices, (char)cprim.indexSize,
+			cprim.numVertices,
+			indices,
+			(size_t)cprim.numAttributes, attribs);
+
+		if (prim == NULL) goto clean;
+
+		primitives[p] = (GFXGltfPrimitive){
+			.primitive = prim,
+			.material = cprim.material > 0 ?
+				materials + (cprim.material - 1) : NULL,
+
+			.indices = indices,
+			.numAttributes = (size_t)cprim.numAttributes,
+			.attributes = attribs,
+
+			.posScale = cprim.posScale,
+			.posOffset = {
+				cprim.posOffset[0],
+				cprim.posOffset[1],
+				cprim.posOffset[2]
+			},
+			.min = { cprim.min[0], cprim.min[1], cprim.min[2] },
+			.max = { cprim.max[0], cprim.max[1], cprim.max[2] },
+
+			.numLods = (size_t)cprim.numLods,
+			.lods = plods,
+
+			.numMeshlets = (size_t)cprim.numMeshlets,
+			.meshlets = cprim.numMeshlets == 0 ? GFX_REF_NULL :
+				gfx_ref_buffer_at(meshlets, cprim.meshlets),
+			.vertices = cprim.numMeshlets == 0 ? GFX_REF_NULL :
+				gfx_ref_buffer_at(meshlets, cprim.vertices),
+			.triangles = cprim.numMeshlets == 0 ? GFX_REF_NULL :
+				gfx_ref_buffer_at(meshlets, cprim.triangles)
+		};
+	}
+
+	// Unswizzle all meshes.
+	for (size_t m = 0; m < counts[GFX_GLTF_CACHE_MESHES_]; ++m)
+	{
+		const uintptr_t first = (uintptr_t)meshes[m].primitives;
+
+		if (meshes[m].numPrimitives > numPrims ||
+			first > numPrims - meshes[m].numPrimitives)
+		{
+			gfx_log_error("glTF cache mesh %"GFX_PRIs" is out of range.", m);
+			goto clean;
+		}
+
+		meshes[m].primitives = primitives + first;
+	}
+
+	// Unswizzle all nodes & scenes.
+	const uint64_t* cnodePtrs =
+		(const uint64_t*)(bytes + offsets[GFX_GLTF_CACHE_NODE_PTRS_]);
+
+	for (size_t np = 0; np < numNodePtrs; ++np)
+	{
+		uint64_t node;
+		memcpy(&node, cnodePtrs + np, sizeof(node));
+
+		if (node >= numNodes)
+		{
+			gfx_log_error("glTF cache node pointers are out of range.");
+			goto clean;
+		}
+
+		nodePtrs[np] = nodes + node;
+	}
+
+	for (size_t n = 0; n < numNodes; ++n)
+	{
+		const uintptr_t parent = (uintptr_t)nodes[n].parent;
+		const uintptr_t children = (uintptr_t)nodes[n].children;
+		const uintptr_t mesh = (uintptr_t)nodes[n].mesh;
+
+		if (
+			parent > numNodes ||
+			mesh > counts[GFX_GLTF_CACHE_MESHES_] ||
+			nodes[n].numChildren > numNodePtrs ||
+			children > numNodePtrs - nodes[n].numChildren)
+		{
+			gfx_log_error("glTF cache node %"GFX_PRIs" is out of range.", n);
+			goto clean;
+		}
+
+		nodes[n].parent = parent > 0 ? nodes + (parent - 1) : NULL;
+		nodes[n].children = nodePtrs != NULL ? nodePtrs + children : NULL;
+		nodes[n].mesh = mesh > 0 ? meshes + (mesh - 1) : NULL;
+	}
+
+	for (size_t s = 0; s < counts[GFX_GLTF_CACHE_SCENES_]; ++s)
+	{
+		const uintptr_t sceneNodes = (uintptr_t)scenes[s].nodes;
+
+		if (
+			scenes[s].numNodes > numNodePtrs ||
+			sceneNodes > numNodePtrs - scenes[s].numNodes)
+		{
+			gfx_log_error("glTF cache scene %"GFX_PRIs" is out of range.", s);
+			goto clean;
+		}
+
+		scenes[s].nodes = nodePtrs != NULL ? nodePtrs + sceneNodes : NULL;
+	}
+
+	// gfx_release_gltf frees node pointers through the first node.
+	if (numNodePtrs > 0 && (numNodes == 0 || nodes[0].children != nodePtrs))
+	{
+		gfx_log_error("glTF cache node pointers are out of range.");
+		goto clean;
+	}
+
+	gfx_io_raw_clear(&source, src);
+
+	// Claim all data and return.
+	result->scene = header.scene > 0 ? scenes + (header.scene - 1) : NULL;
+
+	result->numBuffers = 0;
+	result->buffers = NULL;
+	result->buffer = buffer;
+	result->meshlets = meshlets;
+
+	result->numImages = numImages;
+	result->images = images;
+
+	result->numSamplers = (size_t)counts[GFX_GLTF_CACHE_SAMPLERS_];
+	result->samplers = samplers;
+
+	result->numMaterials = (size_t)counts[GFX_GLTF_CACHE_MATERIALS_];
+	result->materials = materials;
+
+	result->numPrimitives = numPrims;
+	result->primitives = primitives;
+
+	result->numMeshes = (size_t)counts[GFX_GLTF_CACHE_MESHES_];
+	result->meshes = meshes;
+
+	result->numNodes = numNodes;
+	result->nodes = nodes;
+
+	result->numScenes = (size_t)counts[GFX_GLTF_CACHE_SCENES_];
+	result->scenes = scenes;
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	// Flush & block the heap so all memory transfers have been completed
+	// and no command buffers reference the resources anymore!
+	gfx_heap_flush(heap);
+	gfx_heap_block(heap);
+
+	if (primitives != NULL)
+		for (size_t p = 0; p < numPrims; ++p)
+			gfx_free_prim(primitives[p].primitive);
+
+	if (images != NULL)
+		for (size_t i = 0; i < numImages; ++i)
+			gfx_free_image(images[i]);
+
+	gfx_free_buffer(buffer);
+	gfx_free_buffer(meshlets);
+
+	free(images);
+	free(samplers);
+	free(materials);
+	free(primitives);
+	free(attributes);
+	free(lods);
+	free(meshes);
+	free(nodes);
+	free(scenes);
+	free(nodePtrs);
+
+	gfx_io_raw_clear(&source, src);
+	gfx_log_error("Failed to load glTF cache from stream.");
+
+	return 0;
+}
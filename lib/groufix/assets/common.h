@@ -0,0 +1,87 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+
+#ifndef GFX_ASSETS_COMMON_H_
+#define GFX_ASSETS_COMMON_H_
+
+#include "groufix/assets/image.h"
+#include "groufix/def.h"
+#include <string.h>
+
+
+// Checks if the format has features to support the requested image usage.
+#define GFX_IMAGE_FMT_SUPPORTED_(usage, feats) \
+	((feats & GFX_FORMAT_IMAGE_WRITE) && \
+	((feats & GFX_FORMAT_SAMPLED_IMAGE) || !(usage & GFX_IMAGE_SAMPLED)) && \
+	((feats & GFX_FORMAT_SAMPLED_IMAGE_LINEAR) || !(usage & GFX_IMAGE_SAMPLED_LINEAR)) && \
+	((feats & GFX_FORMAT_SAMPLED_IMAGE_MINMAX) || !(usage & GFX_IMAGE_SAMPLED_MINMAX)) && \
+	((feats & GFX_FORMAT_STORAGE_IMAGE) || !(usage & GFX_IMAGE_STORAGE)) && \
+	((feats & GFX_FORMAT_ATTACHMENT_BLEND) || !(usage & GFX_IMAGE_BLEND)) && \
+	((feats & GFX_FORMAT_ATTACHMENT) || \
+		!((GFX_IMAGE_INPUT | GFX_IMAGE_OUTPUT | GFX_IMAGE_TRANSIENT) & usage)))
+
+
+// Checks if the format has features to generate mipmaps (by blitting).
+#define GFX_IMAGE_FMT_MIPMAPS_(feats) \
+	((feats & GFX_FORMAT_IMAGE_READ) && \
+	(feats & GFX_FORMAT_IMAGE_BLIT_SRC) && (feats & GFX_FORMAT_IMAGE_BLIT_DST) && \
+	(feats & GFX_FORMAT_SAMPLED_IMAGE_LINEAR))
+
+
+/**
+ * Retrieves the access mask to signal a loaded image with.
+ */
+static inline GFXAccessMask gfx_image_mask_(GFXImageUsage usage)
+{
+	return
+		((usage & GFX_IMAGE_SAMPLED) ||
+		(usage & GFX_IMAGE_SAMPLED_LINEAR) ||
+		(usage & GFX_IMAGE_SAMPLED_MINMAX) ?
+			GFX_ACCESS_SAMPLED_READ : 0) |
+		((usage & GFX_IMAGE_STORAGE) ?
+			GFX_ACCESS_STORAGE_READ_WRITE : 0);
+}
+
+
+/**
+ * Converts a 32-bit float to a 16-bit half float, rounding to nearest even.
+ * NaNs stay (quiet) NaNs, too large values become infinity.
+ */
+static inline uint16_t gfx_half_(float f)
+{
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+
+	const uint32_t sign = (x >> 16) & 0x8000u;
+	const uint32_t absx = x & 0x7fffffffu;
+
+	// NaN & Inf (or too large).
+	if (absx >= 0x47800000u)
+		return (uint16_t)(sign | 0x7c00u | (absx > 0x7f800000u ? 0x200u : 0u));
+
+	// Subnormal (or zero), let the FPU round.
+	if (absx < 0x38800000u)
+	{
+		float a;
+		memcpy(&a, &absx, sizeof(a));
+		a += 0.5f; // 2^-1, so the half mantissa ends up in the low bits.
+
+		uint32_t r;
+		memcpy(&r, &a, sizeof(r));
+		return (uint16_t)(sign | (r - 0x3f000000u));
+	}
+
+	// Normal, rebias & round to nearest even,
+	// values that round up to 2^16 end up as infinity.
+	const uint32_t odd = (absx >> 13) & 1u;
+	return (uint16_t)(sign | ((absx + 0xc8000fffu + odd) >> 13));
+}
+
+
+#endif
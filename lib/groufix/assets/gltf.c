@@ -6,10 +6,16 @@
  * www     : <www.vuzzel.nl>
  */
 
+#include "groufix/assets/common.h"
 #include "groufix/assets/gltf.h"
+#include "groufix/assets/mesh.h"
+#include "groufix/assets/scene.h"
 #include "groufix/containers/vec.h"
 #include "groufix/core/log.h"
+#include "groufix/core/threads.h"
+#include "groufix.h"
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -123,21 +129,30 @@
 	(wrap) == 0x8743 ? GFX_WRAP_CLAMP_TO_EDGE_MIRROR : \
 	(wrap) == 0x812d ? GFX_WRAP_CLAMP_TO_BORDER : GFX_WRAP_REPEAT)
 
+#define GFX_GLTF_STRIDE_(pAccessor) \
+	((pAccessor)->buffer_view == NULL || \
+	(pAccessor)->buffer_view->stride == 0 ? \
+		(pAccessor)->stride : (pAccessor)->buffer_view->stride)
+
+
+// Alignment of each buffer view range in the packed buffer.
+#define GFX_GLTF_PACK_ALIGN_ ((size_t)16)
+
+
+// Alignment of each range in the packed meshlet buffer,
+// the maximum minStorageBufferOffsetAlignment allowed by Vulkan.
+#define GFX_GLTF_MESHLET_ALIGN_ ((size_t)256)
+
 
 // Helpers to transform glTF data array pointers to groufix.
 #define GFX_FROM_GLTF_(vec, array, pElem) \
 	((pElem) != NULL ? gfx_vec_at(&(vec), (size_t)((pElem) - (array))) : NULL)
 
-#define GFX_FROM_GLTF_ACCESSOR_(pAccessor) \
-	((pAccessor) != NULL && (pAccessor)->buffer_view != NULL ? \
-		GFX_FROM_GLTF_( \
-			buffers, data->buffers, (pAccessor)->buffer_view->buffer) : NULL)
-
 #define GFX_FROM_GLTF_TEXVIEW_(view) \
 	(GFXGltfTexture){ \
 		.image = (view).texture != NULL ? \
-			*(GFXImage**)GFX_FROM_GLTF_( \
-				images, data->images, (view).texture->image) : NULL, \
+			gfx_gltf_texture_image_( \
+				data, gfx_vec_at(&images, 0), (view).texture) : NULL, \
 		.sampler = (view).texture != NULL ? \
 			GFX_FROM_GLTF_( \
 				samplers, data->samplers, (view).texture->sampler) : NULL \
@@ -152,6 +167,116 @@
 		UCHAR_MAX)
 
 
+/****************************
+ * glTF loading context, shared by all loading threads.
+ */
+typedef struct GFXGltfLoader_
+{
+	const cgltf_data*  data;
+	const GFXIncluder* inc;
+	GFXMutex_*         incLock; // Locks inc, NULL if not loading in parallel.
+
+	GFXHeap*      heap;
+	GFXSemaphore* sem;
+	GFXImageFlags flags;
+	GFXImageUsage usage;
+
+	GFXGltfBuffer* buffers; // Output, one for each glTF buffer.
+	GFXImage**     images;  // Output, one for each glTF image.
+
+
+	// Current job.
+	bool (*job)(struct GFXGltfLoader_*, size_t);
+
+} GFXGltfLoader_;
+
+
+/****************************
+ * Referenced byte range of a glTF buffer view, relative to the view.
+ */
+typedef struct GFXGltfView_
+{
+	size_t begin; // SIZE_MAX if not referenced.
+	size_t end;
+
+	uint64_t offset; // Offset of begin in the packed buffer.
+
+} GFXGltfView_;
+
+
+/****************************
+ * Simplified level of detail of a processed primitive.
+ */
+typedef struct GFXGltfLevel_
+{
+	size_t   offset; // Of its indices in the processed bin.
+	uint32_t numIndices;
+	float    error;  // Object-space.
+
+} GFXGltfLevel_;
+
+
+/****************************
+ * Processed (optimized and/or quantized) index & vertex data of a primitive.
+ * Indices come first, followed by each consumed attribute (tightly packed),
+ * followed by the indices of each level of detail,
+ * each starting at a multiple of GFX_GLTF_PACK_ALIGN_.
+ */
+typedef struct GFXGltfProcessed_
+{
+	void*      bin; // NULL if not processed.
+	size_t     size;
+	size_t     numVertices;
+	GFXFormat* formats; // Format of each consumed attribute.
+
+	float posScale; // Position dequantization transform.
+	float posOffset[3];
+
+	uint64_t offset; // Offset of bin in the packed buffer.
+
+	size_t         numLods;
+	GFXGltfLevel_* lods; // NULL if not generated.
+
+	// Meshlet descriptors, followed by vertices & triangles,
+	// each starting at a multiple of GFX_GLTF_MESHLET_ALIGN_.
+	void*  meshlets; // NULL if not built.
+	size_t meshletsSize;
+	size_t numMeshlets;
+	size_t verticesOffset;
+	size_t trianglesOffset;
+
+	uint64_t meshletsOffset; // Offset of meshlets in the packed meshlet buffer.
+
+} GFXGltfProcessed_;
+
+
+/****************************
+ * Vertex attribute quantization method.
+ */
+typedef enum GFXGltfQuantize_
+{
+	GFX_GLTF_QUANTIZE_NONE_,
+	GFX_GLTF_QUANTIZE_OCT_,      // Octahedral normal.
+	GFX_GLTF_QUANTIZE_OCT_W_,    // Octahedral tangent + w.
+	GFX_GLTF_QUANTIZE_UNORM_,    // Within [0,1].
+	GFX_GLTF_QUANTIZE_HALF_,     // Half float.
+	GFX_GLTF_QUANTIZE_POSITION_  // Normalized to the mesh bounds.
+
+} GFXGltfQuantize_;
+
+
+/****************************
+ * glTF image usage by textures.
+ */
+typedef enum GFXGltfImageUse_
+{
+	GFX_GLTF_IMAGE_REQUIRED_ = 0x0001,
+	GFX_GLTF_IMAGE_BASISU_   = 0x0002, // KHR_texture_basisu source with fallback.
+	GFX_GLTF_IMAGE_FALLBACK_ = 0x0004  // Fallback of a KHR_texture_basisu source.
+
+} GFXGltfImageUse_;
+
+
 /****************************
  * Compares (case insensitive) two NULL-terminated strings.
  * One of the strings may terminate with '_', its remains will be ignored.
@@ -223,47 +348,6 @@ static GFXFormat gfx_gltf_attribute_fmt_(cgltf_component_type cType,
 	};
 }
 
-/****************************
- * Creates a 4x4 column-major scale-rotate-translate matrix:
- * m = mat(t) * mat(q) * mat(s)
- *  where
- *   t = [x,y,z]   (translation vector)
- *   q = [x,y,z,w] (rotation quaternion)
- *   s = [x,y,z]   (scale vector)
- */
-static void gfx_gltf_to_mat_(float* m,
-                             const float* t, const float* q, const float* s)
-{
-	// Quaternion -> matrix.
-	const float sq0 = q[0] * q[0];
-	const float sq1 = q[1] * q[1];
-	const float sq2 = q[2] * q[2];
-	const float sq3 = q[3] * q[3];
-	const float l = 2.0f / sqrtf(sq0 + sq1 + sq2 + sq3);
-
-	// Scale it as we go.
-	m[0] = s[0] * (1.0f - l * (sq1 - sq2));
-	m[1] = s[0] * l * (q[0] * q[1] + q[2] * q[3]);
-	m[2] = s[0] * l * (q[0] * q[2] - q[1] * q[3]);
-	m[3] = 0.0f;
-
-	m[4] = s[1] * l * (q[0] * q[1] - q[2] * q[3]);
-	m[5] = s[1] * (1.0f - l * (sq0 - sq2));
-	m[6] = s[1] * l * (q[1] * q[2] + q[0] * q[3]);
-	m[7] = 0.0f;
-
-	m[8] = s[2] * l * (q[0] * q[2] + q[1] * q[3]);
-	m[9] = s[2] * l * (q[1] * q[2] - q[0] * q[3]);
-	m[10] = s[2] * (1.0f - l * (sq0 - sq1));
-	m[11] = 0.0f;
-
-	// Stick in translation.
-	m[12] = t[0];
-	m[13] = t[1];
-	m[14] = t[2];
-	m[15] = 1.0f;
-}
-
 /****************************
  * Decodes an encoded URI into a newly allocated string.
  * @return Must call free() on success!
@@ -374,12 +458,15 @@ static void* gfx_gltf_decode_base64_(size_t size, const char* src)
 /****************************
  * Resolves and reads a buffer URI.
  * @param inc  Includer to use, may be NULL.
+ * @param lock Lock to acquire while resolving & releasing, may be NULL.
  * @param uri  Data URI to resolve, cannot be NULL, must be NULL-terminated.
  * @param size Output length of the returned buffer.
  * @return NULL on failure.
+ *
+ * The lock is not held while reading the resolved stream.
  */
-static void* gfx_gltf_include_buffer_(const GFXIncluder* inc, const char* uri,
-                                      size_t* size)
+static void* gfx_gltf_include_buffer_(const GFXIncluder* inc, GFXMutex_* lock,
+                                      const char* uri, size_t* size)
 {
 	assert(uri != NULL);
 	assert(size != NULL);
@@ -401,7 +488,11 @@ static void* gfx_gltf_include_buffer_(const GFXIncluder* inc, const char* uri,
 		return NULL;
 	}
 
+	// The includer is only accessed by one thread at a time.
+	if (lock != NULL) gfx_mutex_lock_(lock);
 	const GFXReader* src = gfx_io_resolve(inc, dec);
+	if (lock != NULL) gfx_mutex_unlock_(lock);
+
 	free(dec); // Immediately free.
 
 	if (src == NULL)
@@ -412,32 +503,30 @@ static void* gfx_gltf_include_buffer_(const GFXIncluder* inc, const char* uri,
 
 	// Allocate binary buffer.
 	long long len = gfx_io_len(src);
-	if (len <= 0) goto clean;
-
-	void* bin = malloc((size_t)len);
-	if (bin == NULL) goto clean;
+	void* bin = (len > 0) ? malloc((size_t)len) : NULL;
 
 	// Read source.
-	len = gfx_io_read(src, bin, (size_t)len);
-	if (len <= 0)
+	if (bin != NULL)
 	{
-		free(bin);
-		goto clean;
+		len = gfx_io_read(src, bin, (size_t)len);
+		if (len <= 0)
+		{
+			free(bin);
+			bin = NULL;
+		}
 	}
 
 	// Release the stream & output.
+	if (lock != NULL) gfx_mutex_lock_(lock);
 	gfx_io_release(inc, src);
+	if (lock != NULL) gfx_mutex_unlock_(lock);
 
-	*size = (size_t)len;
-	return bin;
-
-
-	// Cleanup on failure.
-clean:
-	gfx_log_error("Could not read data from stream to load URI: %s.", uri);
+	if (bin == NULL)
+		gfx_log_error("Could not read data from stream to load URI: %s.", uri);
+	else
+		*size = (size_t)len;
 
-	gfx_io_release(inc, src);
-	return NULL;
+	return bin;
 }
 
 /****************************
@@ -483,12 +572,16 @@ static GFXImage* gfx_gltf_decode_image_(const char* src,
 }
 
 /****************************
- * Resolves and reads an image URI.
- * @param inc Includer to use, may be NULL.
- * @param uri Data URI to resolve, cannot be NULL, must be NULL-terminated.
+ * Resolves and loads an image URI.
+ * @param inc  Includer to use, may be NULL.
+ * @param lock Lock to acquire while resolving & releasing, may be NULL.
+ * @param uri  Data URI to resolve, cannot be NULL, must be NULL-terminated.
  * @return NULL on failure.
+ *
+ * The lock is not held while reading & decoding the resolved stream.
  */
-static GFXImage* gfx_gltf_include_image_(const GFXIncluder* inc, const char* uri,
+static GFXImage* gfx_gltf_include_image_(const GFXIncluder* inc, GFXMutex_* lock,
+                                         const char* uri,
                                          GFXHeap* heap, GFXSemaphore* sem,
                                          GFXImageFlags flags, GFXImageUsage usage)
 {
@@ -511,7 +604,11 @@ static GFXImage* gfx_gltf_include_image_(const GFXIncluder* inc, const char* uri
 		return NULL;
 	}
 
+	// The includer is only accessed by one thread at a time.
+	if (lock != NULL) gfx_mutex_lock_(lock);
 	const GFXReader* src = gfx_io_resolve(inc, dec);
+	if (lock != NULL) gfx_mutex_unlock_(lock);
+
 	free(dec); // Immediately free.
 
 	if (src == NULL)
@@ -520,128 +617,1604 @@ static GFXImage* gfx_gltf_include_image_(const GFXIncluder* inc, const char* uri
 		return NULL;
 	}
 
-	// Simply load the image.
-	GFXImage* image = gfx_load_image(heap, sem, flags, usage, src);
-	if (image == NULL)
-		gfx_log_error("Failed to load image URI: %s.", uri);
+	// Simply load the image.
+	GFXImage* image = gfx_load_image(heap, sem, flags, usage, src);
+	if (image == NULL)
+		gfx_log_error("Failed to load image URI: %s.", uri);
+
+	// Release the stream & output.
+	if (lock != NULL) gfx_mutex_lock_(lock);
+	gfx_io_release(inc, src);
+	if (lock != NULL) gfx_mutex_unlock_(lock);
+
+	return image;
+}
+
+/****************************
+ * Checks whether all elements of an accessor fit in its buffer view,
+ * computed without overflowing (unlike offset + (count-1) * stride + size).
+ * @param size Size of the buffer view in bytes.
+ */
+static bool gfx_gltf_accessor_fits_(const cgltf_accessor* cacc, size_t size)
+{
+	if (cacc->offset > size)
+		return 0;
+
+	if (cacc->count == 0)
+		return 1;
+
+	const size_t stride = GFX_GLTF_STRIDE_(cacc);
+	const size_t elem = cgltf_calc_size(cacc->type, cacc->component_type);
+	const size_t avail = size - cacc->offset;
+
+	return
+		elem <= avail &&
+		(stride == 0 || cacc->count - 1 <= (avail - elem) / stride);
+}
+
+/****************************
+ * Retrieves the loaded data of a (non-sparse) accessor.
+ * @param buffers Must hold all loaded glTF buffers.
+ * @return NULL if not loaded or out of bounds.
+ */
+static const unsigned char* gfx_gltf_accessor_data_(const cgltf_data* data,
+                                                    const GFXGltfBuffer* buffers,
+                                                    const cgltf_accessor* cacc)
+{
+	assert(data != NULL);
+	assert(buffers != NULL);
+	assert(cacc != NULL);
+
+	const cgltf_buffer_view* cview = cacc->buffer_view;
+	if (cview == NULL || cacc->is_sparse)
+		return NULL;
+
+	const GFXGltfBuffer* buffer = buffers + (cview->buffer - data->buffers);
+
+	if (
+		buffer->bin == NULL ||
+		cview->size > buffer->size ||
+		cview->offset > buffer->size - cview->size ||
+		!gfx_gltf_accessor_fits_(cacc, cview->size))
+	{
+		return NULL;
+	}
+
+	return (const unsigned char*)buffer->bin + cview->offset + cacc->offset;
+}
+
+/****************************
+ * Octahedral encoding of a (unit) direction vector.
+ * @param n   Input xyz, cannot be NULL.
+ * @param out Output xy within [-1,1], cannot be NULL.
+ */
+static void gfx_gltf_oct_(const float* n, float* out)
+{
+	const float l = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+	const float x = l > 0.0f ? n[0] / l : 0.0f;
+	const float y = l > 0.0f ? n[1] / l : 0.0f;
+
+	// Fold the lower hemisphere over the diagonals.
+	if (n[2] < 0.0f)
+	{
+		out[0] = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		out[1] = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+	}
+	else
+	{
+		out[0] = x;
+		out[1] = y;
+	}
+}
+
+/****************************
+ * Picks the quantization method & format of a vertex attribute.
+ * @param src         Attribute data, cannot be NULL.
+ * @param numVertices Number of vertices in src.
+ * @param positions   Non-zero to quantize positions.
+ * @param fmt         Input format, output quantized format.
+ * @return GFX_GLTF_QUANTIZE_NONE_ if not quantized (fmt is untouched).
+ */
+static GFXGltfQuantize_ gfx_gltf_quantize_fmt_(GFXDevice* device,
+                                               GFXGltfQuantizeFlags flags,
+                                               const cgltf_attribute* cattr,
+                                               const unsigned char* src,
+                                               size_t numVertices,
+                                               bool positions,
+                                               GFXFormat* fmt)
+{
+	assert(cattr != NULL);
+	assert(src != NULL);
+	assert(fmt != NULL);
+
+	const cgltf_accessor* cacc = cattr->data;
+	if (cacc->component_type != cgltf_component_type_r_32f)
+		return GFX_GLTF_QUANTIZE_NONE_;
+
+	const bool snorm8 =
+		(flags & GFX_GLTF_QUANTIZE_NORMALS_8) == GFX_GLTF_QUANTIZE_NORMALS_8;
+
+	GFXGltfQuantize_ quant = GFX_GLTF_QUANTIZE_NONE_;
+	GFXFormat qFmt = GFX_FORMAT_EMPTY;
+
+	switch (cattr->type)
+	{
+	case cgltf_attribute_type_position:
+		if (positions && cacc->type == cgltf_type_vec3)
+			quant = GFX_GLTF_QUANTIZE_POSITION_,
+			qFmt = GFX_FORMAT_R16G16B16A16_UNORM;
+		break;
+
+	case cgltf_attribute_type_normal:
+		if ((flags & GFX_GLTF_QUANTIZE_NORMALS) && cacc->type == cgltf_type_vec3)
+			quant = GFX_GLTF_QUANTIZE_OCT_,
+			qFmt = snorm8 ?
+				GFX_FORMAT_R8G8_SNORM : GFX_FORMAT_R16G16_SNORM;
+		break;
+
+	case cgltf_attribute_type_tangent:
+		if ((flags & GFX_GLTF_QUANTIZE_NORMALS) && cacc->type == cgltf_type_vec4)
+			quant = GFX_GLTF_QUANTIZE_OCT_W_,
+			qFmt = snorm8 ?
+				GFX_FORMAT_R8G8B8A8_SNORM : GFX_FORMAT_R16G16B16A16_SNORM;
+		break;
+
+	case cgltf_attribute_type_texcoord:
+		if ((flags & GFX_GLTF_QUANTIZE_TEXCOORDS) && cacc->type == cgltf_type_vec2)
+		{
+			// Use UNORM if everything is within [0,1].
+			const size_t stride = GFX_GLTF_STRIDE_(cacc);
+			quant = GFX_GLTF_QUANTIZE_UNORM_;
+			qFmt = GFX_FORMAT_R16G16_UNORM;
+
+			for (size_t v = 0; v < numVertices; ++v)
+			{
+				const float* uv = (const float*)(src + v * stride);
+				if (!(uv[0] >= 0.0f && uv[0] <= 1.0f &&
+					uv[1] >= 0.0f && uv[1] <= 1.0f))
+				{
+					quant = GFX_GLTF_QUANTIZE_HALF_;
+					qFmt = GFX_FORMAT_R16G16_SFLOAT;
+					break;
+				}
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// Fall back to the original format if not supported.
+	if (
+		quant == GFX_GLTF_QUANTIZE_NONE_ ||
+		!(gfx_format_support(qFmt, device) & GFX_FORMAT_VERTEX_BUFFER))
+	{
+		return GFX_GLTF_QUANTIZE_NONE_;
+	}
+
+	*fmt = qFmt;
+	return quant;
+}
+
+/****************************
+ * Quantizes a single vertex attribute element.
+ * @param fmt     Quantized format, as output by gfx_gltf_quantize_fmt_.
+ * @param src     Input float components, cannot be NULL.
+ * @param dequant Position dequantization transform (scale, offset xyz).
+ * @param dst     Output element, cannot be NULL.
+ */
+static void gfx_gltf_quantize_(GFXGltfQuantize_ quant, GFXFormat fmt,
+                               const float* src, const float* dequant,
+                               void* dst)
+{
+	float v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	size_t comps = 2;
+
+	switch (quant)
+	{
+	case GFX_GLTF_QUANTIZE_OCT_:
+		gfx_gltf_oct_(src, v);
+		break;
+
+	case GFX_GLTF_QUANTIZE_OCT_W_:
+		gfx_gltf_oct_(src, v);
+		v[2] = src[3];
+		comps = 4;
+		break;
+
+	case GFX_GLTF_QUANTIZE_POSITION_:
+		v[0] = (src[0] - dequant[1]) / dequant[0];
+		v[1] = (src[1] - dequant[2]) / dequant[0];
+		v[2] = (src[2] - dequant[3]) / dequant[0];
+		comps = 4;
+		break;
+
+	default:
+		v[0] = src[0];
+		v[1] = src[1];
+		break;
+	}
+
+	for (size_t c = 0; c < comps; ++c)
+		if (quant == GFX_GLTF_QUANTIZE_HALF_)
+			((uint16_t*)dst)[c] = gfx_half_(v[c]);
+
+		else if (fmt.type == GFX_SNORM && fmt.comps[0] == 8)
+			((int8_t*)dst)[c] =
+				(int8_t)lrintf(GFX_CLAMP(v[c], -1.0f, 1.0f) * 127.0f);
+
+		else if (fmt.type == GFX_SNORM)
+			((int16_t*)dst)[c] =
+				(int16_t)lrintf(GFX_CLAMP(v[c], -1.0f, 1.0f) * 32767.0f);
+
+		else
+			((uint16_t*)dst)[c] =
+				(uint16_t)lrintf(GFX_CLAMP(v[c], 0.0f, 1.0f) * 65535.0f);
+}
+
+/****************************
+ * Writes processed indices with the given index size.
+ * @param dst Output of numIndices * indexSize bytes.
+ */
+static void gfx_gltf_indices_(size_t numIndices, const uint32_t* indices,
+                              size_t indexSize, void* dst)
+{
+	for (size_t i = 0; i < numIndices; ++i)
+		switch (indexSize)
+		{
+		case sizeof(uint8_t):
+			((uint8_t*)dst)[i] = (uint8_t)indices[i]; break;
+		case sizeof(uint16_t):
+			((uint16_t*)dst)[i] = (uint16_t)indices[i]; break;
+		default:
+			((uint32_t*)dst)[i] = indices[i]; break;
+		}
+}
+
+/****************************
+ * Builds the meshlets of a processed glTF primitive.
+ * @param indices Processed indices.
+ * @param pos     Processed vertex positions as 3 floats each, cannot be NULL.
+ * @param out     Output processed data, out->numVertices must be set.
+ * @return Zero on failure (out of memory).
+ */
+static bool gfx_gltf_meshlets_(size_t numIndices, const uint32_t* indices,
+                               const float* pos,
+                               GFXGltfProcessed_* out)
+{
+	assert(pos != NULL);
+	assert(out != NULL);
+
+	const size_t bound = gfx_mesh_meshlets_bound(
+		numIndices, GFX_MESHLET_MAX_VERTICES, GFX_MESHLET_MAX_TRIANGLES);
+
+	GFXMeshlet* meshlets = malloc(sizeof(GFXMeshlet) * bound);
+	uint32_t* vertices = malloc(sizeof(uint32_t) * numIndices);
+	uint8_t* triangles = malloc(numIndices);
+
+	if (meshlets == NULL || vertices == NULL || triangles == NULL)
+		goto clean;
+
+	const size_t numMeshlets = gfx_mesh_build_meshlets(
+		numIndices, indices, out->numVertices, pos, sizeof(float) * 3,
+		GFX_MESHLET_MAX_VERTICES, GFX_MESHLET_MAX_TRIANGLES,
+		meshlets, vertices, triangles);
+
+	if (numMeshlets == 0)
+		goto clean;
+
+	// Lay out all data as it will be uploaded.
+	const GFXMeshlet* last = meshlets + (numMeshlets - 1);
+	const size_t numMeshletVertices = last->vertexOffset + last->numVertices;
+
+	out->numMeshlets = numMeshlets;
+	out->verticesOffset = GFX_ALIGN_UP(
+		sizeof(GFXMeshlet) * numMeshlets, GFX_GLTF_MESHLET_ALIGN_);
+	out->trianglesOffset = out->verticesOffset + GFX_ALIGN_UP(
+		sizeof(uint32_t) * numMeshletVertices, GFX_GLTF_MESHLET_ALIGN_);
+	out->meshletsSize = GFX_ALIGN_UP(
+		out->trianglesOffset + numIndices, GFX_GLTF_MESHLET_ALIGN_);
+
+	out->meshlets = calloc(1, out->meshletsSize);
+	if (out->meshlets == NULL) goto clean;
+
+	unsigned char* bin = out->meshlets;
+	memcpy(bin, meshlets, sizeof(GFXMeshlet) * numMeshlets);
+	memcpy(bin + out->verticesOffset, vertices, sizeof(uint32_t) * numMeshletVertices);
+	memcpy(bin + out->trianglesOffset, triangles, numIndices);
+
+	free(meshlets);
+	free(vertices);
+	free(triangles);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(meshlets);
+	free(vertices);
+	free(triangles);
+
+	return 0;
+}
+
+/****************************
+ * Generates the levels of detail of a processed glTF primitive,
+ * each simplified from the processed indices with its own error target.
+ * @param indices Processed indices.
+ * @param pos     Processed vertex positions as 3 floats each, cannot be NULL.
+ * @param reorder Whether to optimize each level for the vertex cache.
+ * @param lods    Output indices of all levels, must be initialized.
+ * @param out     Output processed data, out->numVertices must be set.
+ * @return Zero on failure (out of memory).
+ *
+ * The offset of each output level is its first index in lods.
+ * Levels that do not remove any more triangles are skipped.
+ */
+static bool gfx_gltf_lods_(const GFXGltfOptions* options,
+                           size_t numIndices, const uint32_t* indices,
+                           const float* pos, bool reorder,
+                           GFXVec* lods, GFXGltfProcessed_* out)
+{
+	assert(options != NULL);
+	assert(options->lodErrors != NULL);
+	assert(pos != NULL);
+	assert(lods != NULL);
+	assert(out != NULL);
+
+	out->lods = malloc(sizeof(GFXGltfLevel_) * options->numLods);
+	uint32_t* simplified = malloc(sizeof(uint32_t) * numIndices * 2);
+
+	if (out->lods == NULL || simplified == NULL)
+		goto clean;
+
+	// Errors are relative to the extent of the mesh.
+	float min[3] = { INFINITY, INFINITY, INFINITY };
+	float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+	for (size_t v = 0; v < out->numVertices; ++v)
+		for (size_t c = 0; c < 3; ++c)
+			min[c] = GFX_MIN(min[c], pos[v * 3 + c]),
+			max[c] = GFX_MAX(max[c], pos[v * 3 + c]);
+
+	const float extent = GFX_MAX(max[0] - min[0],
+		GFX_MAX(max[1] - min[1], max[2] - min[2]));
+
+	size_t prev = numIndices;
+
+	for (size_t l = 0; l < options->numLods; ++l)
+	{
+		float error;
+		uint32_t* lod = simplified;
+
+		const size_t count = gfx_mesh_simplify(
+			numIndices, indices, out->numVertices, pos, sizeof(float) * 3,
+			0, options->lodErrors[l], simplified, &error);
+
+		if (count == 0 || count >= prev)
+			continue;
+
+		if (reorder && gfx_mesh_optimize_cache(
+			count, simplified, simplified + numIndices,
+			out->numVertices, GFX_MESH_CACHE_SIZE))
+		{
+			lod = simplified + numIndices;
+		}
+
+		if (!gfx_vec_push(lods, count, lod))
+			goto clean;
+
+		out->lods[out->numLods++] = (GFXGltfLevel_){
+			.offset = lods->size - count,
+			.numIndices = (uint32_t)count,
+			.error = error * extent
+		};
+
+		prev = count;
+	}
+
+	free(simplified);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(out->lods);
+	free(simplified);
+
+	out->numLods = 0;
+	out->lods = NULL;
+
+	return 0;
+}
+
+/****************************
+ * Processes the index & vertex data of a glTF primitive for the GPU.
+ * Triangles & vertices of indexed triangle lists are reordered if
+ * options->optimize is set, attributes are quantized as by options->quantize,
+ * meshlets are built if options->meshlets is set and levels of detail are
+ * generated if options->numLods is set.
+ * @param buffers Must hold all loaded glTF buffers.
+ * @param dequant Position dequantization transform, NULL to not quantize.
+ * @param out     Output data, out->bin is NULL if not processed.
+ * @param acmr    Output ACMR before & after optimization, untouched if not.
+ * @param bytes   Output vertex data size before & after processing.
+ * @return Zero on failure (out of memory).
+ */
+static bool gfx_gltf_process_(const cgltf_data* data,
+                              const GFXGltfBuffer* buffers,
+                              GFXDevice* device,
+                              const GFXGltfOptions* options,
+                              const cgltf_primitive* cprim,
+                              size_t numAttributes, const size_t* attribOrder,
+                              const float* dequant,
+                              GFXGltfProcessed_* out,
+                              float* acmr, size_t* bytes)
+{
+	assert(data != NULL);
+	assert(buffers != NULL);
+	assert(options != NULL);
+	assert(cprim != NULL);
+	assert(out != NULL);
+	assert(acmr != NULL);
+	assert(bytes != NULL);
+
+	*out = (GFXGltfProcessed_){
+		.bin = NULL, .size = 0, .numVertices = 0, .formats = NULL,
+		.posScale = 1.0f, .posOffset = { 0.0f, 0.0f, 0.0f }
+	};
+
+	const cgltf_accessor* cind = cprim->indices;
+	const size_t numIndices = cind != NULL ? cind->count : 0;
+	const size_t indexSize = numIndices > 0 ?
+		GFX_GLTF_INDEX_SIZE_(cind->component_type) : 0;
+
+	if (numAttributes == 0 || (numIndices > 0 && indexSize == 0))
+		return 1;
+
+	const bool triangles =
+		cprim->type == cgltf_primitive_type_triangles &&
+		numIndices > 0 && numIndices % 3 == 0;
+
+	const bool reorder = options->optimize && triangles;
+
+	// Get all data, give up if anything is out of the ordinary.
+	const unsigned char* indexData = numIndices > 0 ?
+		gfx_gltf_accessor_data_(data, buffers, cind) : NULL;
+	const unsigned char* attribData[numAttributes];
+	const void* positions = NULL;
+	size_t posStride = 0;
+	size_t numVertices = SIZE_MAX;
+
+	if (numIndices > 0 && indexData == NULL)
+		return 1;
+
+	for (size_t a = 0; a < numAttributes; ++a)
+	{
+		const cgltf_attribute* cattr = &cprim->attributes[attribOrder[a]];
+		attribData[a] = gfx_gltf_accessor_data_(data, buffers, cattr->data);
+
+		if (attribData[a] == NULL)
+			return 1;
+
+		numVertices = GFX_MIN(numVertices, cattr->data->count);
+
+		if (
+			cattr->type == cgltf_attribute_type_position &&
+			cattr->data->type == cgltf_type_vec3 &&
+			cattr->data->component_type == cgltf_component_type_r_32f)
+		{
+			positions = attribData[a];
+			posStride = GFX_GLTF_STRIDE_(cattr->data);
+		}
+	}
+
+	if (numVertices == 0 || numVertices > UINT32_MAX)
+		return 1;
+
+	// Pick all output formats.
+	GFXFormat formats[numAttributes];
+	GFXGltfQuantize_ quants[numAttributes];
+	bool quantized = 0;
+
+	for (size_t a = 0; a < numAttributes; ++a)
+	{
+		const cgltf_attribute* cattr = &cprim->attributes[attribOrder[a]];
+		formats[a] = gfx_gltf_attribute_fmt_(
+			cattr->data->component_type,
+			cattr->data->type,
+			cattr->data->normalized);
+
+		quants[a] = gfx_gltf_quantize_fmt_(
+			device, options->quantize, cattr, attribData[a],
+			numVertices, dequant != NULL, formats + a);
+
+		quantized = quantized || quants[a] != GFX_GLTF_QUANTIZE_NONE_;
+	}
+
+	const bool build = options->meshlets && triangles && positions != NULL;
+	const bool simplify =
+		options->numLods > 0 && options->lodErrors != NULL &&
+		triangles && positions != NULL;
+
+	if (!reorder && !quantized && !build && !simplify)
+		return 1;
+
+	float* pos = NULL;
+	GFXVec lods;
+	gfx_vec_init(&lods, sizeof(uint32_t));
+
+	// Read all indices.
+	uint32_t* indices = malloc(sizeof(uint32_t) * (numIndices * 2 + numVertices));
+	if (indices == NULL) return 0;
+
+	uint32_t* optimized = indices + numIndices;
+	uint32_t* remap = optimized + numIndices;
+
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		const unsigned char* index = indexData + i * GFX_GLTF_STRIDE_(cind);
+		indices[i] =
+			(indexSize == sizeof(uint8_t)) ? *index :
+			(indexSize == sizeof(uint16_t)) ? *(const uint16_t*)index :
+			*(const uint32_t*)index;
+
+		if (indices[i] >= numVertices)
+		{
+			free(indices);
+			return 1;
+		}
+	}
+
+	if (reorder)
+	{
+		// Optimize for the vertex cache, then for overdraw and vertex fetch.
+		acmr[0] = gfx_mesh_acmr(
+			numIndices, indices, numVertices, GFX_MESH_CACHE_SIZE);
+
+		if (!gfx_mesh_optimize_cache(
+			numIndices, indices, optimized, numVertices, GFX_MESH_CACHE_SIZE))
+		{
+			goto clean;
+		}
+
+		if (options->overdraw > 0.0f && positions != NULL &&
+			!gfx_mesh_optimize_overdraw(
+				numIndices, optimized, numVertices, positions, posStride,
+				GFX_MESH_CACHE_SIZE, GFX_MAX(1.0f, options->overdraw)))
+		{
+			goto clean;
+		}
+
+		out->numVertices =
+			gfx_mesh_optimize_fetch(numIndices, optimized, numVertices, remap);
+
+		acmr[1] = gfx_mesh_acmr(
+			numIndices, optimized, out->numVertices, GFX_MESH_CACHE_SIZE);
+	}
+	else
+	{
+		// Keep the original order.
+		memcpy(optimized, indices, sizeof(uint32_t) * numIndices);
+		out->numVertices = numVertices;
+
+		for (size_t v = 0; v < numVertices; ++v)
+			remap[v] = (uint32_t)v;
+	}
+
+	// Remap positions to match the final indices.
+	if (build || simplify)
+	{
+		pos = malloc(sizeof(float) * 3 * out->numVertices);
+		if (pos == NULL) goto clean;
+
+		for (size_t v = 0; v < numVertices; ++v)
+			if (remap[v] != UINT32_MAX)
+				memcpy(pos + remap[v] * 3,
+					(const char*)positions + posStride * v, sizeof(float) * 3);
+	}
+
+	// Build meshlets & levels of detail on the final indices.
+	if (build && !gfx_gltf_meshlets_(numIndices, optimized, pos, out))
+		goto clean;
+
+	if (simplify && !gfx_gltf_lods_(
+		options, numIndices, optimized, pos, reorder, &lods, out))
+	{
+		goto clean;
+	}
+
+	// Compute the size of & allocate the output.
+	out->size = GFX_ALIGN_UP(numIndices * indexSize, GFX_GLTF_PACK_ALIGN_);
+
+	for (size_t l = 0; l < out->numLods; ++l)
+		out->size += GFX_ALIGN_UP(
+			out->lods[l].numIndices * indexSize, GFX_GLTF_PACK_ALIGN_);
+
+	bytes[0] = 0;
+	bytes[1] = 0;
+
+	for (size_t a = 0; a < numAttributes; ++a)
+	{
+		const size_t elemSize = GFX_FORMAT_BLOCK_SIZE(formats[a]) / CHAR_BIT;
+		out->size += GFX_ALIGN_UP(
+			out->numVertices * elemSize, GFX_GLTF_PACK_ALIGN_);
+
+		bytes[0] += numVertices * cgltf_calc_size(
+			cprim->attributes[attribOrder[a]].data->type,
+			cprim->attributes[attribOrder[a]].data->component_type);
+		bytes[1] += out->numVertices * elemSize;
+	}
+
+	out->bin = malloc(out->size);
+	out->formats = malloc(sizeof(GFXFormat) * numAttributes);
+
+	if (out->bin == NULL || out->formats == NULL)
+		goto clean;
+
+	memcpy(out->formats, formats, sizeof(GFXFormat) * numAttributes);
+
+	if (dequant != NULL)
+	{
+		out->posScale = dequant[0];
+		out->posOffset[0] = dequant[1];
+		out->posOffset[1] = dequant[2];
+		out->posOffset[2] = dequant[3];
+	}
+
+	// Write indices & remapped (quantized) vertices.
+	unsigned char* bin = out->bin;
+
+	gfx_gltf_indices_(numIndices, optimized, indexSize, bin);
+	bin += GFX_ALIGN_UP(numIndices * indexSize, GFX_GLTF_PACK_ALIGN_);
+
+	for (size_t a = 0; a < numAttributes; ++a)
+	{
+		const cgltf_accessor* cacc = cprim->attributes[attribOrder[a]].data;
+		const size_t srcSize = cgltf_calc_size(cacc->type, cacc->component_type);
+		const size_t elemSize = GFX_FORMAT_BLOCK_SIZE(formats[a]) / CHAR_BIT;
+		const size_t stride = GFX_GLTF_STRIDE_(cacc);
+
+		for (size_t v = 0; v < numVertices; ++v)
+			if (remap[v] != UINT32_MAX)
+			{
+				if (quants[a] == GFX_GLTF_QUANTIZE_NONE_)
+					memcpy(bin + remap[v] * elemSize,
+						attribData[a] + v * stride, srcSize);
+				else
+					gfx_gltf_quantize_(quants[a], formats[a],
+						(const float*)(attribData[a] + v * stride), dequant,
+						bin + remap[v] * elemSize);
+			}
+
+		bin += GFX_ALIGN_UP(out->numVertices * elemSize, GFX_GLTF_PACK_ALIGN_);
+	}
+
+	// Write the indices of all levels of detail.
+	for (size_t l = 0; l < out->numLods; ++l)
+	{
+		const size_t count = out->lods[l].numIndices;
+
+		gfx_gltf_indices_(count, gfx_vec_at(&lods, out->lods[l].offset),
+			indexSize, bin);
+
+		out->lods[l].offset = (size_t)(bin - (unsigned char*)out->bin);
+		bin += GFX_ALIGN_UP(count * indexSize, GFX_GLTF_PACK_ALIGN_);
+	}
+
+	free(indices);
+	free(pos);
+	gfx_vec_clear(&lods);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(indices);
+	free(pos);
+	gfx_vec_clear(&lods);
+	free(out->bin);
+	free(out->formats);
+	free(out->meshlets);
+	free(out->lods);
+
+	*out = (GFXGltfProcessed_){
+		.bin = NULL, .size = 0, .numVertices = 0, .formats = NULL,
+		.posScale = 1.0f, .posOffset = { 0.0f, 0.0f, 0.0f }
+	};
+
+	return 0;
+}
+
+/****************************
+ * Extends the referenced range of a buffer view by an accessor.
+ * @param views Must hold one for each glTF buffer view.
+ * @return Zero if the accessor has no buffer view.
+ *
+ * The range begins at a multiple of GFX_GLTF_PACK_ALIGN_, so rebased
+ * accessor offsets keep their alignment once packed.
+ */
+static bool gfx_gltf_view_ref_(const cgltf_data* data, GFXGltfView_* views,
+                               const cgltf_accessor* cacc)
+{
+	assert(data != NULL);
+	assert(views != NULL);
+
+	if (cacc == NULL || cacc->buffer_view == NULL)
+		return 0;
+
+	GFXGltfView_* view = views + (cacc->buffer_view - data->buffer_views);
+	view->begin = GFX_MIN(view->begin,
+		GFX_ALIGN_DOWN(cacc->offset, GFX_GLTF_PACK_ALIGN_));
+
+	// Accessors outside of their view mark the view as out of bounds.
+	if (!gfx_gltf_accessor_fits_(cacc, cacc->buffer_view->size))
+	{
+		view->end = SIZE_MAX;
+		return 1;
+	}
+
+	const size_t size = cacc->count == 0 ? 0 :
+		(cacc->count - 1) * GFX_GLTF_STRIDE_(cacc) +
+		cgltf_calc_size(cacc->type, cacc->component_type);
+
+	view->end = GFX_MAX(view->end, cacc->offset + size);
+
+	return 1;
+}
+
+/****************************
+ * Allocates a single buffer & uploads all referenced buffer view ranges,
+ * followed by all processed primitive data.
+ * @param buffers   Must hold all loaded glTF buffers.
+ * @param views     Must hold one for each glTF buffer view, offsets are output.
+ * @param processed Must hold numPrims primitives, offsets are output.
+ * @param readable  Whether to allocate the buffer with GFX_MEMORY_READ.
+ * @param buffer    Output buffer, NULL if nothing is referenced.
+ * @return Non-zero on success.
+ *
+ * On failure, buffer may still be set and must be freed by the caller,
+ * as uploads may already be recorded.
+ */
+static bool gfx_gltf_pack_(GFXHeap* heap, GFXSemaphore* sem,
+                           const cgltf_data* data,
+                           const GFXGltfBuffer* buffers, GFXGltfView_* views,
+                           size_t numPrims, GFXGltfProcessed_* processed,
+                           bool readable, GFXBuffer** buffer)
+{
+	assert(heap != NULL);
+	assert(sem != NULL);
+	assert(data != NULL);
+	assert(buffer != NULL);
+
+	*buffer = NULL;
+
+	// Validate & pack all referenced ranges.
+	uint64_t size = 0;
+
+	for (size_t v = 0; v < data->buffer_views_count; ++v)
+	{
+		const cgltf_buffer_view* cview = data->buffer_views + v;
+		GFXGltfView_* view = views + v;
+
+		if (view->begin == SIZE_MAX)
+			continue;
+
+		const GFXGltfBuffer* buff = buffers + (cview->buffer - data->buffers);
+
+		if (
+			buff->bin == NULL || view->end > cview->size ||
+			cview->offset > buff->size ||
+			view->end > buff->size - cview->offset)
+		{
+			gfx_log_error(
+				"Buffer view %"GFX_PRIs" is out of bounds or its "
+				"buffer could not be loaded.",
+				v);
+
+			return 0;
+		}
+
+		view->offset = size;
+		size = GFX_ALIGN_UP(
+			size + (view->end - view->begin), GFX_GLTF_PACK_ALIGN_);
+	}
+
+	// Processed data is already aligned.
+	const uint64_t optOffset = size;
+
+	for (size_t p = 0; p < numPrims; ++p)
+		if (processed[p].bin != NULL)
+			processed[p].offset = size,
+			size += processed[p].size;
+
+	// Nothing to allocate.
+	if (size == 0)
+		return 1;
+
+	// Allocate.
+	*buffer = gfx_alloc_buffer(heap,
+		readable ? GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+		GFX_BUFFER_VERTEX | GFX_BUFFER_INDEX,
+		size);
+
+	if (*buffer == NULL)
+		return 0;
+
+	// Write all ranges, one operation for each glTF buffer.
+	GFXRegion* regions =
+		malloc(sizeof(GFXRegion) * 2 * GFX_MAX(1, data->buffer_views_count));
+
+	if (regions == NULL)
+		goto clean;
+
+	for (size_t b = 0; b < data->buffers_count; ++b)
+	{
+		size_t numRegions = 0;
+
+		for (size_t v = 0; v < data->buffer_views_count; ++v)
+		{
+			const cgltf_buffer_view* cview = data->buffer_views + v;
+			const GFXGltfView_* view = views + v;
+
+			if (
+				view->begin == SIZE_MAX || view->end == view->begin ||
+				cview->buffer != data->buffers + b)
+			{
+				continue;
+			}
+
+			regions[numRegions] = (GFXRegion){
+				.offset = cview->offset + view->begin,
+				.size = view->end - view->begin
+			};
+
+			regions[data->buffer_views_count + numRegions] = (GFXRegion){
+				.offset = view->offset,
+				.size = view->end - view->begin
+			};
+
+			++numRegions;
+		}
+
+		if (numRegions == 0)
+			continue;
+
+		const GFXInject inject =
+			gfx_sem_sig(sem,
+				GFX_ACCESS_VERTEX_READ | GFX_ACCESS_INDEX_READ, GFX_STAGE_ANY);
+
+		if (!gfx_write(buffers[b].bin, gfx_ref_buffer(*buffer),
+			GFX_TRANSFER_ASYNC,
+			numRegions, 1,
+			regions, regions + data->buffer_views_count, &inject))
+		{
+			goto clean;
+		}
+	}
+
+	free(regions);
+
+	// Gather & write all processed data in one go.
+	if (size > optOffset)
+	{
+		unsigned char* bin = malloc((size_t)(size - optOffset));
+		if (bin == NULL) return 0;
+
+		for (size_t p = 0; p < numPrims; ++p)
+			if (processed[p].bin != NULL)
+				memcpy(bin + (processed[p].offset - optOffset),
+					processed[p].bin, processed[p].size);
+
+		const GFXRegion srcRegion = {
+			.offset = 0,
+			.size = size - optOffset
+		};
+
+		const GFXRegion dstRegion = {
+			.offset = optOffset,
+			.size = size - optOffset
+		};
+
+		const GFXInject inject =
+			gfx_sem_sig(sem,
+				GFX_ACCESS_VERTEX_READ | GFX_ACCESS_INDEX_READ, GFX_STAGE_ANY);
+
+		const bool success = gfx_write(bin, gfx_ref_buffer(*buffer),
+			GFX_TRANSFER_ASYNC,
+			1, 1, &srcRegion, &dstRegion, &inject);
+
+		free(bin);
+		return success;
+	}
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(regions);
+
+	return 0;
+}
+
+/****************************
+ * Allocates a single storage buffer & uploads all built meshlet data.
+ * @param processed Must hold numPrims primitives, offsets are output.
+ * @param readable  Whether to allocate the buffer with GFX_MEMORY_READ.
+ * @param buffer    Output buffer, NULL if no meshlets were built.
+ * @return Non-zero on success.
+ */
+static bool gfx_gltf_pack_meshlets_(GFXHeap* heap, GFXSemaphore* sem,
+                                    size_t numPrims, GFXGltfProcessed_* processed,
+                                    bool readable, GFXBuffer** buffer)
+{
+	assert(heap != NULL);
+	assert(sem != NULL);
+	assert(buffer != NULL);
+
+	*buffer = NULL;
+
+	// Meshlet data is already aligned.
+	uint64_t size = 0;
+
+	for (size_t p = 0; p < numPrims; ++p)
+		if (processed[p].meshlets != NULL)
+			processed[p].meshletsOffset = size,
+			size += processed[p].meshletsSize;
+
+	// Nothing to allocate.
+	if (size == 0)
+		return 1;
+
+	// Allocate & gather all data.
+	*buffer = gfx_alloc_buffer(heap,
+		readable ? GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+		GFX_BUFFER_STORAGE,
+		size);
+
+	unsigned char* bin = malloc((size_t)size);
+
+	if (*buffer == NULL || bin == NULL)
+	{
+		free(bin);
+		return 0;
+	}
+
+	for (size_t p = 0; p < numPrims; ++p)
+		if (processed[p].meshlets != NULL)
+			memcpy(bin + processed[p].meshletsOffset,
+				processed[p].meshlets, processed[p].meshletsSize);
+
+	// Write it all in one go.
+	const GFXRegion region = {
+		.offset = 0,
+		.size = size
+	};
+
+	const GFXInject inject =
+		gfx_sem_sig(sem, GFX_ACCESS_STORAGE_READ, GFX_STAGE_ANY);
+
+	const bool success = gfx_write(bin, gfx_ref_buffer(*buffer),
+		GFX_TRANSFER_ASYNC,
+		1, 1, &region, &region, &inject);
+
+	free(bin);
+
+	return success;
+}
+
+/****************************
+ * Reorders named glTF attributes based on given options.
+ * @param cprim       glTF primitive's attributes to reorder, cannot be NULL.
+ * @param attribOrder Output array of ordered attribute indices, cannot be NULL.
+ * @return Actual number of attributes to consume.
+ *
+ * attribOrder's size must be cprim->attributes_count.
+ */
+static size_t gfx_gltf_order_attributes_(const cgltf_primitive* cprim,
+                                         const GFXGltfOptions* options,
+                                         size_t* attribOrder)
+{
+	assert(cprim != NULL);
+	assert(cprim->attributes_count > 0);
+	assert(attribOrder != NULL);
+
+	const size_t numAttributes =
+		options != NULL && options->maxAttributes > 0 ?
+			GFX_MIN(options->maxAttributes, cprim->attributes_count) :
+			cprim->attributes_count;
+
+	if (options == NULL || options->orderSize == 0)
+		// Keep order if no options are given.
+		for (size_t a = 0; a < numAttributes; ++a)
+			attribOrder[a] = a;
+	else
+	{
+		// Keep track of used glTF attributes.
+		bool attribUsed[cprim->attributes_count];
+		for (size_t ca = 0; ca < cprim->attributes_count; ++ca)
+			attribUsed[ca] = 0;
+
+		// Go over all given attribute order names (in order).
+		size_t a = 0;
+		for (size_t o = 0;
+			o < options->orderSize && a < numAttributes; ++o)
+		{
+			// See if they match any glTF attributes.
+			for (size_t ca = 0; ca < cprim->attributes_count; ++ca)
+				if (!attribUsed[ca] && gfx_gltf_cmp_attributes_(
+					options->attributeOrder[o],
+					cprim->attributes[ca].name))
+				{
+					attribOrder[a++] = ca;
+					attribUsed[ca] = 1;
+					break;
+				}
+		}
+
+		// Fill in the rest with remaining unused attributes.
+		for (size_t ca = 0;
+			ca < cprim->attributes_count && a < numAttributes; ++ca)
+		{
+			if (!attribUsed[ca])
+				attribOrder[a++] = ca;
+		}
+	}
+
+	return numAttributes;
+}
+
+/****************************
+ * Computes the position dequantization transform of a glTF mesh.
+ * @param buffers Must hold all loaded glTF buffers.
+ * @param dequant Output transform (scale, offset xyz), cannot be NULL.
+ * @return Zero if not all primitives have loaded float positions.
+ */
+static bool gfx_gltf_dequant_(const cgltf_data* data,
+                              const GFXGltfBuffer* buffers,
+                              const GFXGltfOptions* options,
+                              const cgltf_mesh* cmesh,
+                              float* dequant)
+{
+	assert(data != NULL);
+	assert(buffers != NULL);
+	assert(cmesh != NULL);
+	assert(dequant != NULL);
+
+	float min[3] = { INFINITY, INFINITY, INFINITY };
+	float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+	for (size_t p = 0; p < cmesh->primitives_count; ++p)
+	{
+		const cgltf_primitive* cprim = &cmesh->primitives[p];
+		if (cprim->attributes_count == 0)
+			return 0;
+
+		size_t attribOrder[cprim->attributes_count];
+		size_t numAttributes =
+			gfx_gltf_order_attributes_(cprim, options, attribOrder);
+
+		// Find the consumed position attribute.
+		const cgltf_accessor* cacc = NULL;
+		for (size_t a = 0; a < numAttributes; ++a)
+			if (cprim->attributes[attribOrder[a]].type ==
+				cgltf_attribute_type_position)
+			{
+				cacc = cprim->attributes[attribOrder[a]].data;
+				break;
+			}
+
+		if (
+			cacc == NULL ||
+			cacc->type != cgltf_type_vec3 ||
+			cacc->component_type != cgltf_component_type_r_32f)
+		{
+			return 0;
+		}
+
+		const unsigned char* src = gfx_gltf_accessor_data_(data, buffers, cacc);
+		if (src == NULL) return 0;
+
+		// Do not trust the accessor's min & max, compute them.
+		const size_t stride = GFX_GLTF_STRIDE_(cacc);
+
+		for (size_t v = 0; v < cacc->count; ++v)
+		{
+			const float* pos = (const float*)(src + v * stride);
+			for (size_t c = 0; c < 3; ++c)
+				min[c] = GFX_MIN(min[c], pos[c]),
+				max[c] = GFX_MAX(max[c], pos[c]);
+		}
+	}
+
+	if (!(min[0] <= max[0] && min[1] <= max[1] && min[2] <= max[2]))
+		return 0;
+
+	// Use a uniform scale, so the mesh is not distorted.
+	const float extent = GFX_MAX(max[0] - min[0],
+		GFX_MAX(max[1] - min[1], max[2] - min[2]));
+
+	if (!isfinite(extent))
+		return 0;
+
+	dequant[0] = extent > 0.0f ? extent : 1.0f;
+	dequant[1] = min[0];
+	dequant[2] = min[1];
+	dequant[3] = min[2];
+
+	return 1;
+}
+
+/****************************
+ * Checks whether a glTF buffer only holds EXT_meshopt_compression output,
+ * i.e. all its buffer views are compressed & it is not compressed data.
+ */
+static bool gfx_gltf_is_fallback_(const cgltf_data* data, size_t b)
+{
+	assert(data != NULL);
+	assert(b < data->buffers_count);
+
+	bool fallback = 0;
+
+	for (size_t v = 0; v < data->buffer_views_count; ++v)
+	{
+		const cgltf_buffer_view* cview = data->buffer_views + v;
+
+		if (cview->buffer == data->buffers + b)
+		{
+			if (!cview->has_meshopt_compression) return 0;
+			fallback = 1;
+		}
+
+		if (
+			cview->has_meshopt_compression &&
+			cview->meshopt_compression.buffer == data->buffers + b)
+		{
+			return 0;
+		}
+	}
+
+	return fallback;
+}
+
+/****************************
+ * Loads a single glTF buffer into loader->buffers.
+ * @param loader Cannot be NULL.
+ * @param b      Index of the buffer to load.
+ * @return Non-zero on success.
+ */
+static bool gfx_gltf_load_buffer_(GFXGltfLoader_* loader, size_t b)
+{
+	assert(loader != NULL);
+	assert(b < loader->data->buffers_count);
+
+	const cgltf_data* data = loader->data;
+	GFXGltfBuffer* buffer = loader->buffers + b;
+
+	buffer->size = data->buffers[b].size;
+
+	const char* uri = data->buffers[b].uri;
+
+	// Check if EXT_meshopt_compression output,
+	// do not load any (fallback) data, it will be decoded into.
+	if (gfx_gltf_is_fallback_(data, b))
+	{
+		buffer->bin = calloc(GFX_MAX(1, buffer->size), 1);
+		if (buffer->bin == NULL) return 0;
+	}
+
+	// Check if data URI.
+	else if (uri != NULL && strncmp(uri, "data:", 5) == 0)
+	{
+		// Decode as base64.
+		const char* base64 = gfx_gltf_get_base64_(uri);
+		if (base64 == NULL)
+		{
+			gfx_log_error("Buffer data URIs can only be base64.");
+			return 0;
+		}
+
+		buffer->bin = gfx_gltf_decode_base64_(buffer->size, base64);
+		if (buffer->bin == NULL)
+		{
+			gfx_log_error("Failed to decode base64 buffer data URI.");
+			return 0;
+		}
+	}
+
+	// Check if actual URI.
+	else if (uri != NULL)
+	{
+		buffer->bin = gfx_gltf_include_buffer_(
+			loader->inc, loader->incLock, uri, &buffer->size);
+
+		if (buffer->bin == NULL)
+			return 0;
+	}
+
+	// Check if it references the GLB-stored BIN chunk.
+	// Only the first buffer can reference it, according to the specs!
+	else if (b == 0 && data->bin_size >= buffer->size && buffer->size > 0)
+	{
+		buffer->bin = malloc(buffer->size);
+		if (buffer->bin == NULL) return 0;
+
+		memcpy(buffer->bin, data->bin, buffer->size);
+	}
+
+	return 1;
+}
+
+/****************************
+ * Decodes a single EXT_meshopt_compression glTF buffer view,
+ * directly into its loaded buffer in loader->buffers.
+ * @param loader Cannot be NULL.
+ * @param v      Index of the buffer view to decode.
+ * @return Non-zero on success.
+ */
+static bool gfx_gltf_decode_view_(GFXGltfLoader_* loader, size_t v)
+{
+	assert(loader != NULL);
+	assert(v < loader->data->buffer_views_count);
+
+	const cgltf_data* data = loader->data;
+	const cgltf_buffer_view* cview = data->buffer_views + v;
+	const cgltf_meshopt_compression* cmc = &cview->meshopt_compression;
+
+	if (!cview->has_meshopt_compression)
+		return 1;
+
+	const GFXGltfBuffer* src = loader->buffers + (cmc->buffer - data->buffers);
+	const GFXGltfBuffer* dst = loader->buffers + (cview->buffer - data->buffers);
+
+	// Validate all ranges & strides.
+	const bool isIndex =
+		cmc->mode == cgltf_meshopt_compression_mode_triangles ||
+		cmc->mode == cgltf_meshopt_compression_mode_indices;
+
+	if (
+		src->bin == NULL || dst->bin == NULL ||
+		cmc->size > src->size || cmc->offset > src->size - cmc->size ||
+		cmc->stride == 0 || cmc->count > cview->size / cmc->stride ||
+		cview->size > dst->size || cview->offset > dst->size - cview->size ||
+		(isIndex && cmc->stride != sizeof(uint16_t) &&
+			cmc->stride != sizeof(uint32_t)) ||
+		(!isIndex && (cmc->stride > 256 || cmc->stride % 4 != 0)) ||
+		(cmc->mode == cgltf_meshopt_compression_mode_triangles &&
+			cmc->count % 3 != 0))
+	{
+		gfx_log_error(
+			"Compressed buffer view %"GFX_PRIs" is out of bounds or "
+			"has an invalid stride.",
+			v);
+
+		return 0;
+	}
+
+	const unsigned char* in = (const unsigned char*)src->bin + cmc->offset;
+	unsigned char* out = (unsigned char*)dst->bin + cview->offset;
+	bool success;
+
+	switch (cmc->mode)
+	{
+	case cgltf_meshopt_compression_mode_attributes:
+		success =
+			gfx_mesh_decode_vertices(
+				cmc->count, cmc->stride, cmc->size, in, out) &&
+			gfx_mesh_decode_filter(
+				cmc->filter == cgltf_meshopt_compression_filter_octahedral ?
+					GFX_MESH_FILTER_OCTAHEDRAL :
+				cmc->filter == cgltf_meshopt_compression_filter_quaternion ?
+					GFX_MESH_FILTER_QUATERNION :
+				cmc->filter == cgltf_meshopt_compression_filter_exponential ?
+					GFX_MESH_FILTER_EXPONENTIAL :
+					GFX_MESH_FILTER_NONE,
+				cmc->count, cmc->stride, out);
+		break;
+
+	case cgltf_meshopt_compression_mode_triangles:
+		success = gfx_mesh_decode_triangles(
+			cmc->count, cmc->stride, cmc->size, in, out);
+		break;
+
+	case cgltf_meshopt_compression_mode_indices:
+		success = gfx_mesh_decode_indices(
+			cmc->count, cmc->stride, cmc->size, in, out);
+		break;
+
+	default:
+		success = 0;
+		break;
+	}
+
+	if (!success)
+		gfx_log_error(
+			"Failed to decode compressed buffer view %"GFX_PRIs".",
+			v);
+
+	return success;
+}
+
+/****************************
+ * Computes how a glTF image is used by all textures.
+ * @param data Cannot be NULL.
+ * @param i    Index of the image.
+ * @return Never zero, unused images are required.
+ */
+static GFXGltfImageUse_ gfx_gltf_image_use_(const cgltf_data* data, size_t i)
+{
+	assert(data != NULL);
+	assert(i < data->images_count);
+
+	const cgltf_image* cimg = data->images + i;
+	GFXGltfImageUse_ use = 0;
+
+	for (size_t t = 0; t < data->textures_count; ++t)
+	{
+		const cgltf_texture* ctex = data->textures + t;
+		const cgltf_image* basisu = ctex->has_basisu ? ctex->basisu_image : NULL;
+
+		if (basisu == cimg)
+			use |= (ctex->image != NULL) ?
+				GFX_GLTF_IMAGE_BASISU_ : GFX_GLTF_IMAGE_REQUIRED_;
+
+		if (ctex->image == cimg)
+			use |= (basisu != NULL) ?
+				GFX_GLTF_IMAGE_FALLBACK_ : GFX_GLTF_IMAGE_REQUIRED_;
+	}
+
+	return (use == 0) ? GFX_GLTF_IMAGE_REQUIRED_ : use;
+}
+
+/****************************
+ * Retrieves the loaded image of a glTF texture.
+ * Prefers the KHR_texture_basisu source, if it could be loaded.
+ * @param data   Cannot be NULL.
+ * @param images Cannot be NULL, loaded images.
+ * @param ctex   Cannot be NULL.
+ */
+static GFXImage* gfx_gltf_texture_image_(const cgltf_data* data,
+                                         GFXImage** images,
+                                         const cgltf_texture* ctex)
+{
+	assert(data != NULL);
+	assert(images != NULL);
+	assert(ctex != NULL);
+
+	if (ctex->has_basisu && ctex->basisu_image != NULL)
+	{
+		GFXImage* image = images[ctex->basisu_image - data->images];
+		if (image != NULL) return image;
+	}
+
+	return (ctex->image != NULL) ?
+		images[ctex->image - data->images] : NULL;
+}
+
+/****************************
+ * Computes the image flags to load a glTF image with.
+ * Mipmaps are generated if any texture samples it with a mipmap min filter.
+ * @param data  Cannot be NULL.
+ * @param i     Index of the image.
+ * @param flags Flags given by the user.
+ */
+static GFXImageFlags gfx_gltf_image_flags_(const cgltf_data* data, size_t i,
+                                           GFXImageFlags flags)
+{
+	assert(data != NULL);
+	assert(i < data->images_count);
+
+	for (size_t t = 0; t < data->textures_count; ++t)
+	{
+		const cgltf_texture* ctex = data->textures + t;
+		const cgltf_image* basisu = ctex->has_basisu ? ctex->basisu_image : NULL;
+
+		if (ctex->sampler == NULL ||
+			(ctex->image != data->images + i && basisu != data->images + i))
+		{
+			continue;
+		}
+
+		// GL_(NEAREST|LINEAR)_MIPMAP_(NEAREST|LINEAR).
+		const int minFilter = (int)ctex->sampler->min_filter;
+		if (minFilter >= 0x2700 && minFilter <= 0x2703)
+			return flags | GFX_IMAGE_MIPMAPS;
+	}
+
+	return flags;
+}
+
+/****************************
+ * Loads a single glTF image into loader->images.
+ * All buffers must be loaded already!
+ * @param loader Cannot be NULL.
+ * @param i      Index of the image to load.
+ * @return Non-zero on success.
+ */
+static bool gfx_gltf_load_image_(GFXGltfLoader_* loader, size_t i)
+{
+	assert(loader != NULL);
+	assert(i < loader->data->images_count);
+
+	const cgltf_data* data = loader->data;
+	GFXImage** image = loader->images + i;
+
+	const GFXImageFlags flags =
+		gfx_gltf_image_flags_(data, i, loader->flags);
+
+	const char* uri = data->images[i].uri;
+	const cgltf_buffer_view* cview = data->images[i].buffer_view;
+
+	// Check if data URI.
+	if (uri != NULL && strncmp(uri, "data:", 5) == 0)
+	{
+		// Decode as base64.
+		const char* base64 = gfx_gltf_get_base64_(uri);
+		if (base64 == NULL)
+		{
+			gfx_log_error("Image data URIs can only be base64.");
+			return 0;
+		}
+
+		*image = gfx_gltf_decode_image_(base64,
+			loader->heap, loader->sem, flags, loader->usage);
+
+		if (*image == NULL)
+			return 0;
+	}
+
+	// Check if actual URI.
+	else if (uri != NULL)
+	{
+		*image = gfx_gltf_include_image_(loader->inc, loader->incLock, uri,
+			loader->heap, loader->sem, flags, loader->usage);
+
+		if (*image == NULL)
+			return 0;
+	}
+
+	// Check if a buffer view.
+	else if (cview != NULL)
+	{
+		const GFXGltfBuffer* buffer = (cview->buffer != NULL) ?
+			loader->buffers + (cview->buffer - data->buffers) : NULL;
+
+		// Load the image.
+		if (buffer == NULL || buffer->bin == NULL)
+		{
+			gfx_log_error("Image buffer view has no data.");
+			return 0;
+		}
+
+		if (
+			cview->offset > buffer->size ||
+			cview->size > buffer->size - cview->offset)
+		{
+			gfx_log_error("Image buffer view is out of range.");
+			return 0;
+		}
 
-	// Release the stream & output.
-	gfx_io_release(inc, src);
+		GFXBinReader reader;
+		*image = gfx_load_image(
+			loader->heap, loader->sem, flags, loader->usage,
+			gfx_bin_reader(
+				&reader, cview->size,
+				((uint8_t*)buffer->bin) + cview->offset));
 
-	return image;
+		if (*image == NULL)
+		{
+			gfx_log_error("Failed to load image data from buffer.");
+			return 0;
+		}
+	}
+
+	return 1;
 }
 
 /****************************
- * TODO: This will allocate the ENTIRE buffer, even if e.g. images are stored in it!
- * Allocates a buffer from the data already in a GFXGltfBuffer object.
- * @param buffer May be NULL, on which it will fail (same if size is 0).
- * @return Non-zero on success.
+ * Loads a single glTF image into loader->images,
+ * unless it is only used as fallback of KHR_texture_basisu sources.
+ * @see gfx_gltf_load_image_.
+ *
+ * Failing to load a KHR_texture_basisu source with a fallback (e.g. due to
+ * an unsupported format) is not an error.
  */
-static bool gfx_gltf_buffer_alloc_(GFXHeap* heap, GFXSemaphore* sem,
-                                   GFXGltfBuffer* buffer)
+static bool gfx_gltf_load_source_(GFXGltfLoader_* loader, size_t i)
 {
-	assert(heap != NULL);
-	assert(sem != NULL);
+	assert(loader != NULL);
 
-	// Nothing to allocate.
-	if (buffer == NULL || buffer->size == 0 || buffer->bin == NULL)
-		return 0;
+	const GFXGltfImageUse_ use = gfx_gltf_image_use_(loader->data, i);
 
-	// Already done.
-	if (buffer->buffer != NULL)
+	if (!(use & (GFX_GLTF_IMAGE_REQUIRED_ | GFX_GLTF_IMAGE_BASISU_)))
 		return 1;
 
-	// Allocate.
-	buffer->buffer = gfx_alloc_buffer(heap,
-		GFX_MEMORY_WRITE,
-		GFX_BUFFER_VERTEX | GFX_BUFFER_INDEX,
-		buffer->size);
+	if (gfx_gltf_load_image_(loader, i))
+		return 1;
 
-	if (buffer->buffer == NULL)
+	if (use & GFX_GLTF_IMAGE_REQUIRED_)
 		return 0;
 
-	// Write data.
-	const GFXRegion region = {
-		.offset = 0,
-		.size = buffer->size
-	};
+	gfx_log_warn(
+		"Could not load KHR_texture_basisu image source, "
+		"falling back to texture image.");
 
-	const GFXInject inject =
-		gfx_sem_sig(sem,
-			GFX_ACCESS_VERTEX_READ | GFX_ACCESS_INDEX_READ, GFX_STAGE_ANY);
+	return 1;
+}
 
-	if (!gfx_write(buffer->bin, gfx_ref_buffer(buffer->buffer),
-		GFX_TRANSFER_ASYNC,
-		1, 1, &region, &region, &inject))
+/****************************
+ * Loads a single glTF image into loader->images if it is the fallback
+ * of a KHR_texture_basisu source that could not be loaded.
+ * All sources must be loaded already!
+ * @see gfx_gltf_load_image_.
+ */
+static bool gfx_gltf_load_fallback_(GFXGltfLoader_* loader, size_t i)
+{
+	assert(loader != NULL);
+
+	const cgltf_data* data = loader->data;
+
+	if (loader->images[i] != NULL)
+		return 1;
+
+	for (size_t t = 0; t < data->textures_count; ++t)
 	{
-		gfx_free_buffer(buffer->buffer);
-		buffer->buffer = NULL;
+		const cgltf_texture* ctex = data->textures + t;
+		const cgltf_image* basisu = ctex->has_basisu ? ctex->basisu_image : NULL;
 
-		return 0;
+		if (
+			ctex->image == data->images + i && basisu != NULL &&
+			loader->images[basisu - data->images] == NULL)
+		{
+			return gfx_gltf_load_image_(loader, i);
+		}
 	}
 
 	return 1;
 }
 
 /****************************
- * Reorders named glTF attributes based on given options.
- * @param cprim       glTF primitive's attributes to reorder, cannot be NULL.
- * @param attribOrder Output array of ordered attribute indices, cannot be NULL.
- * @return Actual number of attributes to consume.
- *
- * attribOrder's size must be cprim->attributes_count.
+ * Performs a range of jobs of a glTF loader until one fails,
+ * for use in gfx_jobs_parallel_.
+ * @param ptr GFXGltfLoader_*, cannot be NULL.
+ * @return Number of successfully performed jobs.
  */
-static size_t gfx_gltf_order_attributes_(const cgltf_primitive* cprim,
-                                         const GFXGltfOptions* options,
-                                         size_t* attribOrder)
+static size_t gfx_gltf_work_(void* ptr, size_t begin, size_t end)
 {
-	assert(cprim != NULL);
-	assert(cprim->attributes_count > 0);
-	assert(attribOrder != NULL);
+	GFXGltfLoader_* loader = ptr;
+	assert(loader != NULL);
 
-	const size_t numAttributes =
-		options != NULL && options->maxAttributes > 0 ?
-			GFX_MIN(options->maxAttributes, cprim->attributes_count) :
-			cprim->attributes_count;
+	size_t j;
+	for (j = begin; j < end; ++j)
+		if (!loader->job(loader, j)) break;
 
-	if (options == NULL || options->orderSize == 0)
-		// Keep order if no options are given.
-		for (size_t a = 0; a < numAttributes; ++a)
-			attribOrder[a] = a;
-	else
-	{
-		// Keep track of used glTF attributes.
-		bool attribUsed[cprim->attributes_count];
-		for (size_t ca = 0; ca < cprim->attributes_count; ++ca)
-			attribUsed[ca] = 0;
+	return j - begin;
+}
 
-		// Go over all given attribute order names (in order).
-		size_t a = 0;
-		for (size_t o = 0;
-			o < options->orderSize && a < numAttributes; ++o)
-		{
-			// See if they match any glTF attributes.
-			for (size_t ca = 0; ca < cprim->attributes_count; ++ca)
-				if (!attribUsed[ca] && gfx_gltf_cmp_attributes_(
-					options->attributeOrder[o],
-					cprim->attributes[ca].name))
-				{
-					attribOrder[a++] = ca;
-					attribUsed[ca] = 1;
-					break;
-				}
-		}
+/****************************
+ * Runs jobs of a glTF loader on the shared job scheduler, blocks until done.
+ * @param loader     Cannot be NULL.
+ * @param numThreads Maximum #threads (including the calling thread), > 0.
+ * @param count      Number of jobs, each is given its index.
+ * @param job        Job to run, cannot be NULL.
+ * @return Zero if any job failed.
+ *
+ * If numThreads is 1, all jobs are run in order and the first failure stops.
+ */
+static bool gfx_gltf_run_(GFXGltfLoader_* loader, unsigned int numThreads,
+                          size_t count, bool (*job)(GFXGltfLoader_*, size_t))
+{
+	assert(loader != NULL);
+	assert(numThreads > 0);
+	assert(job != NULL);
 
-		// Fill in the rest with remaining unused attributes.
-		for (size_t ca = 0;
-			ca < cprim->attributes_count && a < numAttributes; ++ca)
-		{
-			if (!attribUsed[ca])
-				attribOrder[a++] = ca;
-		}
-	}
+	loader->job = job;
 
-	return numAttributes;
+	return gfx_jobs_parallel_(count, numThreads, gfx_gltf_work_, loader) == count;
 }
 
 /****************************/
@@ -696,12 +2269,19 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 	// From this point onwards we need to clean on failure.
 	size_t numNodePtrs = 0;
 	GFXGltfNode** nodePtrs = NULL; // Scene/node children-pointers
+	GFXGltfView_* views = NULL;    // Referenced buffer view ranges.
+	GFXBuffer* packed = NULL;      // Packed vertex & index data.
+	GFXBuffer* meshlets = NULL;    // Packed meshlet data.
+	size_t numPrims = 0;
+	GFXGltfProcessed_* processed = NULL; // Processed primitive data.
 
 	GFXVec buffers;
 	GFXVec images;
 	GFXVec samplers;
 	GFXVec materials;
 	GFXVec primitives;
+	GFXVec attributes;
+	GFXVec lods;
 	GFXVec meshes;
 	GFXVec nodes;
 	GFXVec scenes;
@@ -710,6 +2290,8 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 	gfx_vec_init(&samplers, sizeof(GFXGltfSampler));
 	gfx_vec_init(&materials, sizeof(GFXGltfMaterial));
 	gfx_vec_init(&primitives, sizeof(GFXGltfPrimitive));
+	gfx_vec_init(&attributes, sizeof(GFXAttribute));
+	gfx_vec_init(&lods, sizeof(GFXGltfLod));
 	gfx_vec_init(&meshes, sizeof(GFXGltfMesh));
 	gfx_vec_init(&nodes, sizeof(GFXGltfNode));
 	gfx_vec_init(&scenes, sizeof(GFXGltfScene));
@@ -721,129 +2303,111 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 	gfx_vec_reserve(&nodes, data->nodes_count);
 	gfx_vec_reserve(&scenes, data->scenes_count);
 
-	// Create all buffers.
-	for (size_t b = 0; b < data->buffers_count; ++b)
-	{
-		GFXGltfBuffer buffer = {
-			.size = data->buffers[b].size,
-			.bin = NULL,
-			.buffer = NULL
-		};
+	// Setup the loader to create buffers & images with.
+	// If loading in parallel, the includer must be locked.
+	unsigned int numThreads = 1;
+	GFXMutex_ incLock;
+
+	GFXGltfLoader_ loader = {
+		.data = data,
+		.inc = inc,
+		.incLock = NULL,
+		.heap = heap,
+		.sem = sem,
+		.flags = flags,
+		.usage = usage
+	};
 
-		const char* uri = data->buffers[b].uri;
+	if (options != NULL && options->parallel)
+	{
+		numThreads = options->numThreads > 0 ?
+			options->numThreads : gfx_thread_count_();
 
-		// Check if data URI.
-		if (uri != NULL && strncmp(uri, "data:", 5) == 0)
+		if (numThreads > 1)
 		{
-			// Decode as base64.
-			const char* base64 = gfx_gltf_get_base64_(uri);
-			if (base64 == NULL)
+			if (gfx_mutex_init_(&incLock))
+				loader.incLock = &incLock;
+			else
 			{
-				gfx_log_error("Buffer data URIs can only be base64.");
-				goto clean;
-			}
-
-			buffer.bin = gfx_gltf_decode_base64_(buffer.size, base64);
-			if (buffer.bin == NULL)
-			{
-				gfx_log_error("Failed to decode base64 buffer data URI.");
-				goto clean;
+				gfx_log_warn("Could not load glTF in parallel, loading serially.");
+				numThreads = 1;
 			}
 		}
+	}
 
-		// Check if actual URI.
-		else if (uri != NULL)
-		{
-			buffer.bin = gfx_gltf_include_buffer_(inc, uri, &buffer.size);
-			if (buffer.bin == NULL) goto clean;
-		}
-
-		// Check if it references the GLB-stored BIN chunk.
-		// Only the first buffer can reference it, according to the specs!
-		else if (b == 0 && data->bin_size >= buffer.size && buffer.size > 0)
-		{
-			buffer.bin = malloc(buffer.size);
-			if (buffer.bin == NULL) goto clean;
+	// Create all buffers & images.
+	// Their slots are pushed first so they can be loaded in any order,
+	// which keeps the result ordering independent of the #threads.
+	if (data->buffers_count > 0)
+	{
+		if (!gfx_vec_push(&buffers, data->buffers_count, NULL))
+			goto clean;
 
-			memcpy(buffer.bin, data->bin, buffer.size);
-		}
+		for (size_t b = 0; b < data->buffers_count; ++b)
+			*(GFXGltfBuffer*)gfx_vec_at(&buffers, b) = (GFXGltfBuffer){
+				.size = 0,
+				.bin = NULL
+			};
+	}
 
-		// Insert buffer.
-		if (!gfx_vec_push(&buffers, 1, &buffer))
-		{
-			free(buffer.bin);
+	if (data->images_count > 0)
+	{
+		if (!gfx_vec_push(&images, data->images_count, NULL))
 			goto clean;
-		}
+
+		for (size_t i = 0; i < data->images_count; ++i)
+			*(GFXImage**)gfx_vec_at(&images, i) = NULL;
 	}
 
-	// Create all images.
-	for (size_t i = 0; i < data->images_count; ++i)
+	loader.buffers = gfx_vec_at(&buffers, 0);
+	loader.images = gfx_vec_at(&images, 0);
+
+	// Buffers first, as images may be stored in buffers.
+	if (!gfx_gltf_run_(&loader, numThreads,
+		data->buffers_count, gfx_gltf_load_buffer_))
 	{
-		GFXImage* image = NULL;
+		goto clean;
+	}
 
-		const char* uri = data->images[i].uri;
-		const cgltf_buffer_view* cview = data->images[i].buffer_view;
+	// Then decode EXT_meshopt_compression buffer views in-place,
+	// before anything reads from them.
+	const int64_t decStart = gfx_time();
 
-		// Check if data URI.
-		if (uri != NULL && strncmp(uri, "data:", 5) == 0)
-		{
-			// Decode as base64.
-			const char* base64 = gfx_gltf_get_base64_(uri);
-			if (base64 == NULL)
-			{
-				gfx_log_error("Image data URIs can only be base64.");
-				goto clean;
-			}
+	if (!gfx_gltf_run_(&loader, numThreads,
+		data->buffer_views_count, gfx_gltf_decode_view_))
+	{
+		goto clean;
+	}
 
-			image = gfx_gltf_decode_image_(base64, heap, sem, flags, usage);
-			if (image == NULL) goto clean;
-		}
+	size_t numDecoded = 0, bytesEncoded = 0, bytesDecoded = 0;
 
-		// Check if actual URI.
-		else if (uri != NULL)
+	for (size_t v = 0; v < data->buffer_views_count; ++v)
+		if (data->buffer_views[v].has_meshopt_compression)
 		{
-			image = gfx_gltf_include_image_(inc, uri, heap, sem, flags, usage);
-			if (image == NULL) goto clean;
+			++numDecoded;
+			bytesEncoded += data->buffer_views[v].meshopt_compression.size;
+			bytesDecoded += data->buffer_views[v].size;
 		}
 
-		// Check if a buffer view.
-		else if (cview != NULL)
-		{
-			GFXGltfBuffer* buffer =
-				GFX_FROM_GLTF_(buffers, data->buffers, cview->buffer);
-
-			// Load the image.
-			if (buffer == NULL || buffer->bin == NULL)
-			{
-				gfx_log_error("Image buffer view has no data.");
-				goto clean;
-			}
-
-			if (cview->offset + cview->size > buffer->size)
-			{
-				gfx_log_error("Image buffer view is out of range.");
-				goto clean;
-			}
-
-			GFXBinReader reader;
-			image = gfx_load_image(heap, sem, flags, usage,
-				gfx_bin_reader(
-					&reader, cview->size,
-					((uint8_t*)buffer->bin) + cview->offset));
-
-			if (image == NULL)
-			{
-				gfx_log_error("Failed to load image data from buffer.");
-				goto clean;
-			}
-		}
+	if (numDecoded > 0)
+		gfx_log_info(
+			"Decoded %"GFX_PRIs" compressed glTF buffer views in %.2f ms, "
+			"%"GFX_PRIs" -> %"GFX_PRIs" bytes.",
+			numDecoded,
+			(double)(gfx_time() - decStart) * 1000.0 / (double)gfx_time_frequency(),
+			bytesEncoded, bytesDecoded);
+
+	// Then KHR_texture_basisu fallbacks, only if their source failed.
+	if (!gfx_gltf_run_(&loader, numThreads,
+		data->images_count, gfx_gltf_load_source_))
+	{
+		goto clean;
+	}
 
-		// Insert image.
-		if (!gfx_vec_push(&images, 1, &image))
-		{
-			gfx_free_image(image);
-			goto clean;
-		}
+	if (!gfx_gltf_run_(&loader, numThreads,
+		data->images_count, gfx_gltf_load_fallback_))
+	{
+		goto clean;
 	}
 
 	// Create all samplers.
@@ -1017,21 +2581,182 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 			goto clean;
 	}
 
-	// Create all primitives.
+	// Compute the referenced ranges of all buffer views,
+	// so only those are uploaded, packed into a single buffer.
+	views = malloc(sizeof(GFXGltfView_) * GFX_MAX(1, data->buffer_views_count));
+	if (views == NULL) goto clean;
+
+	for (size_t v = 0; v < data->buffer_views_count; ++v)
+		views[v] = (GFXGltfView_){ .begin = SIZE_MAX, .end = 0, .offset = 0 };
+
 	for (size_t m = 0; m < data->meshes_count; ++m)
+		numPrims += data->meshes[m].primitives_count;
+
+	processed = calloc(GFX_MAX(1, numPrims), sizeof(GFXGltfProcessed_));
+	if (processed == NULL) goto clean;
+
+	// Process primitives, which are not uploaded from their buffer views.
+	const bool optimize = options != NULL && options->optimize;
+	const GFXGltfQuantizeFlags quantize =
+		options != NULL ? options->quantize : GFX_GLTF_QUANTIZE_NONE;
+	const bool buildMeshlets = options != NULL && options->meshlets;
+	const bool buildLods = options != NULL && options->numLods > 0;
+
+	const int64_t optStart = gfx_time();
+	size_t numOptimized = 0, numQuantized = 0;
+	size_t numClustered = 0, numMeshlets = 0;
+	size_t numSimplified = 0, numLods = 0;
+	size_t bytesBefore = 0, bytesAfter = 0;
+	double numTris = 0.0, missesBefore = 0.0, missesAfter = 0.0;
+
+	for (size_t m = 0, o = 0; m < data->meshes_count; ++m)
+	{
+		// Positions are only quantized if possible for the entire mesh,
+		// so all its primitives share the same dequantization transform.
+		float dequant[4];
+		const bool quantPos =
+			(quantize & GFX_GLTF_QUANTIZE_POSITIONS) &&
+			gfx_gltf_dequant_(
+				data, gfx_vec_at(&buffers, 0), options,
+				data->meshes + m, dequant);
+
+		for (size_t p = 0; p < data->meshes[m].primitives_count; ++p, ++o)
+		{
+			const cgltf_primitive* cprim = &data->meshes[m].primitives[p];
+			if (cprim->attributes_count == 0)
+				continue; // Errors below.
+
+			size_t attribOrder[cprim->attributes_count];
+			size_t numAttributes =
+				gfx_gltf_order_attributes_(cprim, options, attribOrder);
+
+			if (
+				optimize || quantize != GFX_GLTF_QUANTIZE_NONE ||
+				buildMeshlets || buildLods)
+			{
+				float acmr[2] = { 0.0f, 0.0f };
+				size_t bytes[2];
+
+				if (!gfx_gltf_process_(
+					data, gfx_vec_at(&buffers, 0), gfx_heap_get_device(heap),
+					options, cprim, numAttributes, attribOrder,
+					quantPos ? dequant : NULL,
+					processed + o, acmr, bytes))
+				{
+					goto clean;
+				}
+
+				if (processed[o].bin != NULL)
+				{
+					if (acmr[0] > 0.0f)
+					{
+						const double tris = (double)(cprim->indices->count / 3);
+						++numOptimized;
+						numTris += tris;
+						missesBefore += acmr[0] * tris;
+						missesAfter += acmr[1] * tris;
+					}
+
+					if (bytes[1] < bytes[0])
+					{
+						++numQuantized;
+						bytesBefore += bytes[0];
+						bytesAfter += bytes[1];
+					}
+
+					if (processed[o].meshlets != NULL)
+					{
+						++numClustered;
+						numMeshlets += processed[o].numMeshlets;
+					}
+
+					if (processed[o].numLods > 0)
+					{
+						++numSimplified;
+						numLods += processed[o].numLods;
+					}
+
+					continue;
+				}
+			}
+
+			if (
+				cprim->indices != NULL && cprim->indices->count > 0 &&
+				!gfx_gltf_view_ref_(data, views, cprim->indices))
+			{
+				gfx_log_error("Index accessors must have a buffer view.");
+				goto clean;
+			}
+
+			for (size_t a = 0; a < numAttributes; ++a)
+				if (!gfx_gltf_view_ref_(data, views,
+					cprim->attributes[attribOrder[a]].data))
+				{
+					gfx_log_error("Vertex accessors must have a buffer view.");
+					goto clean;
+				}
+		}
+	}
+
+	if (numOptimized > 0)
+		gfx_log_info(
+			"Optimized %"GFX_PRIs" glTF primitives in %.2f ms, "
+			"ACMR %.3f -> %.3f.",
+			numOptimized,
+			(double)(gfx_time() - optStart) * 1000.0 / (double)gfx_time_frequency(),
+			missesBefore / numTris, missesAfter / numTris);
+
+	if (numQuantized > 0)
+		gfx_log_info(
+			"Quantized %"GFX_PRIs" glTF primitives, "
+			"vertex data %"GFX_PRIs" -> %"GFX_PRIs" bytes.",
+			numQuantized, bytesBefore, bytesAfter);
+
+	if (numClustered > 0)
+		gfx_log_info(
+			"Built %"GFX_PRIs" meshlets for %"GFX_PRIs" glTF primitives.",
+			numMeshlets, numClustered);
+
+	if (numSimplified > 0)
+		gfx_log_info(
+			"Generated %"GFX_PRIs" levels of detail for "
+			"%"GFX_PRIs" glTF primitives.",
+			numLods, numSimplified);
+
+	if (!gfx_gltf_pack_(
+		heap, sem, data, gfx_vec_at(&buffers, 0), views,
+		numPrims, processed, flags & GFX_IMAGE_READABLE, &packed))
+	{
+		gfx_log_error("Failed to allocate vertex & index buffer.");
+		goto clean;
+	}
+
+	if (!gfx_gltf_pack_meshlets_(
+		heap, sem,
+		numPrims, processed, flags & GFX_IMAGE_READABLE, &meshlets))
+	{
+		gfx_log_error("Failed to allocate meshlet buffer.");
+		goto clean;
+	}
+
+	// Create all primitives.
+	for (size_t m = 0, o = 0; m < data->meshes_count; ++m)
 	{
-		for (size_t p = 0; p < data->meshes[m].primitives_count; ++p)
+		for (size_t p = 0; p < data->meshes[m].primitives_count; ++p, ++o)
 		{
 			// Gather all primitive data.
+			// Processed primitives are tightly packed, indices first.
 			const cgltf_primitive* cprim = &data->meshes[m].primitives[p];
+			const GFXGltfProcessed_* opt = processed + o;
 
 			const size_t numIndices =
 				cprim->indices != NULL ? cprim->indices->count : 0;
 			const char indexSize =
 				cprim->indices != NULL ?
 				GFX_GLTF_INDEX_SIZE_(cprim->indices->component_type) : 0;
-			GFXGltfBuffer* indexBuffer =
-				GFX_FROM_GLTF_ACCESSOR_(cprim->indices);
+			const GFXGltfView_* indexView =
+				numIndices > 0 ?
+				views + (cprim->indices->buffer_view - data->buffer_views) : NULL;
 
 			if (cprim->attributes_count == 0)
 			{
@@ -1045,12 +2770,6 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 				goto clean;
 			}
 
-			if (numIndices > 0 && !gfx_gltf_buffer_alloc_(heap, sem, indexBuffer))
-			{
-				gfx_log_error("Failed to allocate index buffer.");
-				goto clean;
-			}
-
 			// Here we consider that attributes are named in glTF,
 			// and they may not always appear in the same order in a file.
 			// Calculate the actual order to consume the attributes in.
@@ -1059,7 +2778,14 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 				gfx_gltf_order_attributes_(cprim, options, attribOrder);
 
 			size_t numVertices = SIZE_MAX;
-			GFXAttribute attributes[numAttributes];
+			GFXAttribute* attribs = gfx_vec_push(&attributes, numAttributes, NULL) ?
+				gfx_vec_at(&attributes, attributes.size - numAttributes) : NULL;
+
+			if (attribs == NULL)
+				goto clean;
+
+			uint64_t optOffset = opt->offset +
+				GFX_ALIGN_UP(numIndices * (size_t)indexSize, GFX_GLTF_PACK_ALIGN_);
 
 			// Fill attribute data.
 			for (size_t a = 0; a < numAttributes; ++a)
@@ -1067,37 +2793,43 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 				const cgltf_attribute* cattr =
 					&cprim->attributes[attribOrder[a]];
 
-				numVertices = GFX_MIN(
-					numVertices, cattr->data->count);
-
-				GFXGltfBuffer* buffer =
-					GFX_FROM_GLTF_ACCESSOR_(cattr->data);
-
-				if (!gfx_gltf_buffer_alloc_(heap, sem, buffer))
-				{
-					gfx_log_error("Failed to allocate vertex buffer.");
-					goto clean;
-				}
-
-				attributes[a] = (GFXAttribute){
-					.offset = (uint32_t)cattr->data->offset,
+				attribs[a] = (GFXAttribute){
 					.rate = GFX_RATE_VERTEX,
-
 					.format = gfx_gltf_attribute_fmt_(
 						cattr->data->component_type,
 						cattr->data->type,
-						cattr->data->normalized),
+						cattr->data->normalized)
+				};
+
+				if (opt->bin != NULL)
+				{
+					const size_t elemSize =
+						GFX_FORMAT_BLOCK_SIZE(opt->formats[a]) / CHAR_BIT;
 
-					.stride = (uint32_t)(
-						(cattr->data->buffer_view == NULL ||
-						cattr->data->buffer_view->stride == 0) ?
-							cattr->data->stride :
-							cattr->data->buffer_view->stride),
+					numVertices = opt->numVertices;
+					attribs[a].format = opt->formats[a];
+					attribs[a].offset = 0;
+					attribs[a].stride = (uint32_t)elemSize;
+					attribs[a].buffer = gfx_ref_buffer_at(packed, optOffset);
 
-					.buffer = gfx_ref_buffer_at(
-						buffer->buffer,
-						cattr->data->buffer_view->offset)
-				};
+					optOffset += GFX_ALIGN_UP(
+						opt->numVertices * elemSize, GFX_GLTF_PACK_ALIGN_);
+				}
+				else
+				{
+					const GFXGltfView_* view =
+						views + (cattr->data->buffer_view - data->buffer_views);
+
+					numVertices = GFX_MIN(
+						numVertices, cattr->data->count);
+
+					attribs[a].offset =
+						(uint32_t)(cattr->data->offset - view->begin);
+					attribs[a].stride =
+						(uint32_t)GFX_GLTF_STRIDE_(cattr->data);
+					attribs[a].buffer =
+						gfx_ref_buffer_at(packed, view->offset);
+				}
 			}
 
 			if (numVertices == 0)
@@ -1106,23 +2838,92 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 				goto clean;
 			}
 
+			// Get the position bounds from its accessor.
+			float min[3] = { INFINITY, INFINITY, INFINITY };
+			float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+			for (size_t a = 0; a < cprim->attributes_count; ++a)
+			{
+				const cgltf_accessor* cacc = cprim->attributes[a].data;
+
+				if (
+					cprim->attributes[a].type == cgltf_attribute_type_position &&
+					cacc->type == cgltf_type_vec3 &&
+					cacc->has_min && cacc->has_max)
+				{
+					memcpy(min, cacc->min, sizeof(min));
+					memcpy(max, cacc->max, sizeof(max));
+					break;
+				}
+			}
+
 			// Allocate primitive.
+			const GFXBufferRef indices =
+				opt->bin != NULL ? gfx_ref_buffer_at(packed, opt->offset) :
+				numIndices > 0 ? gfx_ref_buffer_at(packed,
+					indexView->offset +
+					(cprim->indices->offset - indexView->begin)) : GFX_REF_NULL;
+
 			GFXPrimitive* prim = gfx_alloc_prim(heap,
 				0, 0, GFX_GLTF_TOPOLOGY_(cprim->type),
 				(uint32_t)numIndices, indexSize,
 				(uint32_t)numVertices,
-				numIndices > 0 ? gfx_ref_buffer_at(
-					indexBuffer->buffer,
-					cprim->indices->buffer_view->offset) : GFX_REF_NULL,
-				numAttributes, attributes);
+				indices,
+				numAttributes, attribs);
 
 			if (prim == NULL) goto clean;
 
+			// Gather levels of detail, sharing the vertex input.
+			for (size_t l = 0; l < opt->numLods; ++l)
+			{
+				const GFXGltfLod lod = {
+					.indices = gfx_ref_buffer_at(packed,
+						opt->offset + opt->lods[l].offset),
+					.numIndices = opt->lods[l].numIndices,
+					.error = opt->lods[l].error
+				};
+
+				if (!gfx_vec_push(&lods, 1, &lod))
+				{
+					gfx_free_prim(prim);
+					goto clean;
+				}
+			}
+
 			// Insert primitive.
+			// Attribute & level pointers are set after all are inserted.
 			GFXGltfPrimitive primitive = {
 				.primitive = prim,
 				.material = GFX_FROM_GLTF_(
-					materials, data->materials, cprim->material)
+					materials, data->materials, cprim->material),
+
+				.indices = numIndices > 0 ? indices : GFX_REF_NULL,
+
+				.numAttributes = numAttributes,
+				.attributes = NULL,
+
+				.posScale = opt->bin != NULL ? opt->posScale : 1.0f,
+				.posOffset = {
+					opt->bin != NULL ? opt->posOffset[0] : 0.0f,
+					opt->bin != NULL ? opt->posOffset[1] : 0.0f,
+					opt->bin != NULL ? opt->posOffset[2] : 0.0f
+				},
+
+				.min = { min[0], min[1], min[2] },
+				.max = { max[0], max[1], max[2] },
+
+				.numLods = opt->numLods,
+				.lods = NULL,
+
+				.numMeshlets = opt->numMeshlets,
+				.meshlets = opt->meshlets == NULL ? GFX_REF_NULL :
+					gfx_ref_buffer_at(meshlets, opt->meshletsOffset),
+				.vertices = opt->meshlets == NULL ? GFX_REF_NULL :
+					gfx_ref_buffer_at(meshlets,
+						opt->meshletsOffset + opt->verticesOffset),
+				.triangles = opt->meshlets == NULL ? GFX_REF_NULL :
+					gfx_ref_buffer_at(meshlets,
+						opt->meshletsOffset + opt->trianglesOffset)
 			};
 
 			if (!gfx_vec_push(&primitives, 1, &primitive))
@@ -1133,6 +2934,16 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 		}
 	}
 
+	// Set attribute & level pointers of all primitives.
+	for (size_t p = 0, a = 0, l = 0; p < primitives.size; ++p)
+	{
+		GFXGltfPrimitive* prim = gfx_vec_at(&primitives, p);
+		prim->attributes = gfx_vec_at(&attributes, a);
+		prim->lods = gfx_vec_at(&lods, l);
+		a += prim->numAttributes;
+		l += prim->numLods;
+	}
+
 	// Create all meshes.
 	for (size_t m = 0, p = 0; m < data->meshes_count; ++m)
 	{
@@ -1181,7 +2992,7 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 		if (cnode->has_matrix)
 			memcpy(node.matrix, cnode->matrix, sizeof(node.matrix));
 		else
-			gfx_gltf_to_mat_(node.matrix, node.translation, node.rotation, node.scale);
+			gfx_scene_compose(node.matrix, node.translation, node.rotation, node.scale);
 
 		if (!gfx_vec_push(&nodes, 1, &node))
 			goto clean;
@@ -1247,12 +3058,26 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 	result->scene = GFX_FROM_GLTF_(scenes, data->scenes, data->scene);
 
 	// We are done building groufix objects, free gltf things.
+	if (loader.incLock != NULL)
+		gfx_mutex_clear_(loader.incLock);
+
 	cgltf_free(data);
 	gfx_io_raw_clear(&source, src);
 
+	for (size_t o = 0; o < numPrims; ++o)
+		free(processed[o].bin),
+		free(processed[o].formats),
+		free(processed[o].meshlets),
+		free(processed[o].lods);
+
+	free(views);
+	free(processed);
+
 	// Claim all data and return.
 	result->numBuffers = buffers.size;
 	result->buffers = gfx_vec_claim(&buffers);
+	result->buffer = packed;
+	result->meshlets = meshlets;
 
 	result->numImages = images.size;
 	result->images = gfx_vec_claim(&images);
@@ -1266,6 +3091,10 @@ GFX_API bool gfx_load_gltf(GFXHeap* heap, GFXSemaphore* sem,
 	result->numPrimitives = primitives.size;
 	result->primitives = gfx_vec_claim(&primitives);
 
+	// Attributes & levels are claimed through the first primitive.
+	gfx_vec_claim(&attributes);
+	gfx_vec_claim(&lods);
+
 	result->numMeshes = meshes.size;
 	result->meshes = gfx_vec_claim(&meshes);
 
@@ -1286,11 +3115,10 @@ clean:
 	gfx_heap_block(heap);
 
 	for (size_t b = 0; b < buffers.size; ++b)
-	{
-		GFXGltfBuffer* buffer = gfx_vec_at(&buffers, b);
-		free(buffer->bin);
-		gfx_free_buffer(buffer->buffer);
-	}
+		free(((GFXGltfBuffer*)gfx_vec_at(&buffers, b))->bin);
+
+	gfx_free_buffer(packed);
+	gfx_free_buffer(meshlets);
 
 	for (size_t i = 0; i < images.size; ++i)
 		gfx_free_image(*(GFXImage**)gfx_vec_at(&images, i));
@@ -1298,16 +3126,30 @@ clean:
 	for (size_t p = 0; p < primitives.size; ++p)
 		gfx_free_prim(((GFXGltfPrimitive*)gfx_vec_at(&primitives, p))->primitive);
 
+	if (processed != NULL)
+		for (size_t o = 0; o < numPrims; ++o)
+			free(processed[o].bin),
+			free(processed[o].formats),
+			free(processed[o].meshlets),
+			free(processed[o].lods);
+
 	free(nodePtrs);
+	free(views);
+	free(processed);
 	gfx_vec_clear(&buffers);
 	gfx_vec_clear(&images);
 	gfx_vec_clear(&samplers);
 	gfx_vec_clear(&materials);
 	gfx_vec_clear(&primitives);
+	gfx_vec_clear(&attributes);
+	gfx_vec_clear(&lods);
 	gfx_vec_clear(&meshes);
 	gfx_vec_clear(&nodes);
 	gfx_vec_clear(&scenes);
 
+	if (loader.incLock != NULL)
+		gfx_mutex_clear_(loader.incLock);
+
 	cgltf_free(data);
 	gfx_io_raw_clear(&source, src);
 
@@ -1325,6 +3167,11 @@ GFX_API void gfx_release_gltf(GFXGltfResult* result)
 	if (result->numNodes > 0)
 		free(result->nodes[0].children);
 
+	// And all primitive attributes & levels of detail.
+	if (result->numPrimitives > 0)
+		free(result->primitives[0].attributes),
+		free(result->primitives[0].lods);
+
 	// And all non-GPU buffers.
 	for (size_t b = 0; b < result->numBuffers; ++b)
 		free(result->buffers[b].bin);
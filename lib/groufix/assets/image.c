@@ -6,8 +6,12 @@
  * www     : <www.vuzzel.nl>
  */
 
+#include "groufix/assets/common.h"
 #include "groufix/assets/image.h"
 #include "groufix/core/log.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_FAILURE_USERMSG
@@ -17,29 +21,62 @@
 #define STBI_NO_PNM
 #include "stb_image.h"
 
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define GFX_STB_SSE2_
+#endif
 
-// Checks if the format has features to support the requested usage.
-#define GFX_STB_FMT_SUPPORTED_(usage, feats) \
-	((feats & GFX_FORMAT_IMAGE_WRITE) && \
-	((feats & GFX_FORMAT_SAMPLED_IMAGE) || !(usage & GFX_IMAGE_SAMPLED)) && \
-	((feats & GFX_FORMAT_SAMPLED_IMAGE_LINEAR) || !(usage & GFX_IMAGE_SAMPLED_LINEAR)) && \
-	((feats & GFX_FORMAT_SAMPLED_IMAGE_MINMAX) || !(usage & GFX_IMAGE_SAMPLED_MINMAX)) && \
-	((feats & GFX_FORMAT_STORAGE_IMAGE) || !(usage & GFX_IMAGE_STORAGE)) && \
-	((feats & GFX_FORMAT_ATTACHMENT_BLEND) || !(usage & GFX_IMAGE_BLEND)) && \
-	((feats & GFX_FORMAT_ATTACHMENT) || \
-		!((GFX_IMAGE_INPUT | GFX_IMAGE_OUTPUT | GFX_IMAGE_TRANSIENT) & usage)))
+#if defined (GFX_STB_SSE2_) && defined (__SSSE3__)
+	#include <tmmintrin.h>
+	#define GFX_STB_SSSE3_
+#endif
+
+
+// Number of texels to convert at a time when converting in chunks.
+#define GFX_STB_CHUNK_SIZE_ 256
+
+
+/****************************
+ * Component type of loaded/converted texels.
+ */
+typedef enum GFXStbType_
+{
+	GFX_STB_U8_,
+	GFX_STB_U16_,
+	GFX_STB_F16_,
+	GFX_STB_F32_
+
+} GFXStbType_;
+
+
+// Byte size of each component type.
+static const size_t gfx_stb_type_sizes_[] = { 1, 2, 2, 4 };
+
+// Maximum (or one) of each component type, i.e. opaque alpha.
+static const uint8_t gfx_stb_max_u8_ = UINT8_MAX;
+static const uint16_t gfx_stb_max_u16_ = UINT16_MAX;
+static const uint16_t gfx_stb_max_f16_ = 0x3c00;
+static const float gfx_stb_max_f32_ = 1.0f;
+
+static const void* const gfx_stb_type_max_[] = {
+	&gfx_stb_max_u8_,
+	&gfx_stb_max_u16_,
+	&gfx_stb_max_f16_,
+	&gfx_stb_max_f32_
+};
 
 
 /****************************
  * Constructs an image format based on:
  *  - If it is HDR (float).
  *  - If it is unsigned 16 bits integers.
+ *  - If HDR should be 16 bits floats.
  *  - How many components per pixel it has.
  */
-static GFXFormat gfx_stb_image_fmt_(bool ishdr, bool is16, int comps)
+static GFXFormat gfx_stb_image_fmt_(bool ishdr, bool is16, bool half, int comps)
 {
 	const unsigned char depth =
-		ishdr ? 32 : is16 ? 16 : 8;
+		ishdr ? (half ? 16 : 32) : is16 ? 16 : 8;
 
 	const GFXFormatType type =
 		ishdr ? GFX_SFLOAT : GFX_UNORM;
@@ -62,6 +99,403 @@ static GFXFormat gfx_stb_image_fmt_(bool ishdr, bool is16, int comps)
 	};
 }
 
+/****************************
+ * Constructs a block-compressed format to encode an 8-bit image into.
+ */
+static GFXFormat gfx_stb_image_bcn_(GFXImageFlags flags, int comps)
+{
+	const bool hq = (flags & GFX_IMAGE_COMPRESS_HQ) == GFX_IMAGE_COMPRESS_HQ;
+
+	return
+		(comps == 1) ? GFX_FORMAT_BC4_UNORM :
+		(comps == 2) ? GFX_FORMAT_BC5_UNORM :
+		hq ? GFX_FORMAT_BC7_UNORM :
+		(comps == 3) ? GFX_FORMAT_BC1_RGB_UNORM :
+		GFX_FORMAT_BC3_UNORM;
+}
+
+#if defined (GFX_STB_SSE2_)
+
+/****************************
+ * Converts 32-bit floats to 16-bit half floats, SSE2 version.
+ * @see gfx_half_, 8 at a time, with a scalar tail.
+ */
+static void gfx_stb_halves_(size_t count, const float* src, uint16_t* dst)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128i f16max = _mm_set1_epi32(0x47800000);
+	const __m128i minNormal = _mm_set1_epi32(0x38800000);
+	const __m128i subMagic = _mm_set1_epi32(0x3f000000);
+	const __m128i normalBias = _mm_set1_epi32((int)0xc8000fffu);
+	const __m128i infinity = _mm_set1_epi32(0x7c00);
+	const __m128i nanBit = _mm_set1_epi32(0x200);
+
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i h[2];
+
+		for (size_t k = 0; k < 2; ++k)
+		{
+			const __m128 f = _mm_loadu_ps(src + i + k * 4);
+			const __m128 sign = _mm_and_ps(f, signMask);
+			const __m128 absf = _mm_xor_ps(f, sign);
+			const __m128i absi = _mm_castps_si128(absf);
+
+			// Special values.
+			const __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+			const __m128i isRegular = _mm_cmpgt_epi32(f16max, absi);
+			const __m128i special = _mm_or_si128(infinity, _mm_and_si128(isNan, nanBit));
+
+			// Subnormal, let the FPU round.
+			const __m128i isSub = _mm_cmpgt_epi32(minNormal, absi);
+			const __m128i sub = _mm_sub_epi32(
+				_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subMagic))),
+				subMagic);
+
+			// Normal, rebias & round to nearest even.
+			const __m128i odd = _mm_and_si128(_mm_srli_epi32(absi, 13), _mm_set1_epi32(1));
+			const __m128i normal = _mm_srli_epi32(
+				_mm_add_epi32(_mm_add_epi32(absi, normalBias), odd), 13);
+
+			__m128i r = _mm_or_si128(
+				_mm_and_si128(isSub, sub), _mm_andnot_si128(isSub, normal));
+			r = _mm_or_si128(
+				_mm_and_si128(isRegular, r), _mm_andnot_si128(isRegular, special));
+			r = _mm_or_si128(r, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+
+			// Sign extend the low 16 bits, so they survive a signed pack.
+			h[k] = _mm_srai_epi32(_mm_slli_epi32(r, 16), 16);
+		}
+
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(h[0], h[1]));
+	}
+
+	for (; i < count; ++i)
+		dst[i] = gfx_half_(src[i]);
+}
+
+/****************************
+ * Narrows 16-bit unsigned integers to 8 bits, SSE2 version.
+ * 16 at a time, with a scalar tail.
+ */
+static void gfx_stb_narrow_(size_t count, const uint16_t* src, uint8_t* dst)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i a = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(src + i)), 8);
+		const __m128i b = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(src + i + 8)), 8);
+
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(a, b));
+	}
+
+	for (; i < count; ++i)
+		dst[i] = (uint8_t)(src[i] >> 8);
+}
+
+#else
+
+/****************************
+ * Converts 32-bit floats to 16-bit half floats, scalar version.
+ * @see the SSE2 version.
+ */
+static void gfx_stb_halves_(size_t count, const float* src, uint16_t* dst)
+{
+	for (size_t i = 0; i < count; ++i)
+		dst[i] = gfx_half_(src[i]);
+}
+
+/****************************
+ * Narrows 16-bit unsigned integers to 8 bits, scalar version.
+ * @see the SSE2 version.
+ */
+static void gfx_stb_narrow_(size_t count, const uint16_t* src, uint8_t* dst)
+{
+	for (size_t i = 0; i < count; ++i)
+		dst[i] = (uint8_t)(src[i] >> 8);
+}
+
+#endif
+
+/****************************
+ * Expands the components of 8-bit RGB texels to RGBA, with alpha = max.
+ * Uses SSSE3 if enabled, 4 at a time, with a scalar tail.
+ */
+static void gfx_stb_rgba_(size_t count, const uint8_t* src, uint8_t* dst)
+{
+	size_t i = 0;
+
+#if defined (GFX_STB_SSSE3_)
+	// 16 bytes are loaded for 4 texels (12 bytes), stop early.
+	const __m128i shuffle = _mm_setr_epi8(
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000u);
+
+	for (; i + 6 <= count; i += 4)
+	{
+		const __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 3));
+		_mm_storeu_si128((__m128i*)(dst + i * 4),
+			_mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+	}
+#endif
+
+	for (; i < count; ++i)
+		dst[i * 4 + 0] = src[i * 3 + 0],
+		dst[i * 4 + 1] = src[i * 3 + 1],
+		dst[i * 4 + 2] = src[i * 3 + 2],
+		dst[i * 4 + 3] = UINT8_MAX;
+}
+
+/****************************
+ * Expands the components of texels, following stb_image:
+ * grey is replicated to RGB and a missing alpha is max.
+ * @param type  Component type of both src and dst.
+ * @param comps Must be >= sComps.
+ */
+static void gfx_stb_expand_(GFXStbType_ type, int sComps, int comps,
+                            size_t count, const void* src, void* dst)
+{
+	assert(comps >= sComps);
+
+	if (sComps == comps)
+	{
+		memcpy(dst, src, count * (size_t)comps * gfx_stb_type_sizes_[type]);
+		return;
+	}
+
+	if (type == GFX_STB_U8_ && sComps == 3 && comps == 4)
+	{
+		gfx_stb_rgba_(count, src, dst);
+		return;
+	}
+
+	// Source component of each output component, -1 for max.
+	static const signed char swizzles[4][4][4] = {
+		[0] = { [1] = { 0, -1 }, [2] = { 0, 0, 0 }, [3] = { 0, 0, 0, -1 } },
+		[1] = { [2] = { 0, 0, 0 }, [3] = { 0, 0, 0, 1 } },
+		[2] = { [3] = { 0, 1, 2, -1 } }
+	};
+
+	const signed char* swizzle = swizzles[sComps - 1][comps - 1];
+	const size_t size = gfx_stb_type_sizes_[type];
+	const unsigned char* s = src;
+	unsigned char* d = dst;
+
+	for (size_t i = 0; i < count; ++i, s += (size_t)sComps * size)
+		for (int c = 0; c < comps; ++c, d += size)
+			memcpy(d,
+				swizzle[c] < 0 ? gfx_stb_type_max_[type] : s + (size_t)swizzle[c] * size,
+				size);
+}
+
+/****************************
+ * Converts texels from one component type & count to another.
+ * @param sType Must equal type or convert to it (F32 -> F16 or U16 -> U8).
+ * @param comps Must be >= sComps.
+ *
+ * Converts in chunks through a small stack buffer,
+ * so dst is written in a single pass.
+ */
+static void gfx_stb_convert_(GFXStbType_ sType, GFXStbType_ type,
+                             int sComps, int comps,
+                             size_t count, const void* src, void* dst)
+{
+	assert(sType == type ||
+		(sType == GFX_STB_F32_ && type == GFX_STB_F16_) ||
+		(sType == GFX_STB_U16_ && type == GFX_STB_U8_));
+
+	if (sType == type)
+	{
+		gfx_stb_expand_(type, sComps, comps, count, src, dst);
+		return;
+	}
+
+	const size_t sSize = gfx_stb_type_sizes_[sType] * (size_t)sComps;
+	const size_t size = gfx_stb_type_sizes_[type];
+	const size_t dSize = size * (size_t)comps;
+
+	uint16_t chunk[GFX_STB_CHUNK_SIZE_ * 4];
+
+	for (size_t i = 0; i < count; i += GFX_STB_CHUNK_SIZE_)
+	{
+		const size_t n = GFX_MIN(count - i, (size_t)GFX_STB_CHUNK_SIZE_);
+		const void* s = (const unsigned char*)src + i * sSize;
+		void* d = (unsigned char*)dst + i * dSize;
+		void* out = sComps == comps ? d : chunk;
+
+		if (type == GFX_STB_F16_)
+			gfx_stb_halves_(n * (size_t)sComps, s, out);
+		else
+			gfx_stb_narrow_(n * (size_t)sComps, s, out);
+
+		if (sComps != comps)
+			gfx_stb_expand_(type, sComps, comps, n, chunk, d);
+	}
+}
+
+/****************************
+ * Loads an 8-bit image, encodes it (and its mipmaps) into a
+ * block-compressed format on the CPU and uploads all mipmaps.
+ * @param fmt Block-compressed format, must be supported.
+ */
+static GFXImage* gfx_stb_load_bcn_(GFXHeap* heap, GFXSemaphore* sem,
+                                   GFXImageFlags flags, GFXImageUsage usage,
+                                   GFXFormat fmt,
+                                   const void* source, long long len)
+{
+	int x, y, comps;
+	unsigned char* img =
+		stbi_load_from_memory(source, (int)len, &x, &y, &comps, 0);
+
+	if (img == NULL)
+	{
+		gfx_log_error(
+			"Failed to load image from stream: %s.",
+			stbi_failure_reason());
+
+		return NULL;
+	}
+
+	// Compute the number of mipmaps.
+	const size_t blockSize = GFX_FORMAT_BLOCK_SIZE(fmt) / CHAR_BIT;
+
+	uint32_t mipmaps = 1;
+
+	if (flags & GFX_IMAGE_MIPMAPS)
+		for (int m = GFX_MAX(x, y); m > 1; m >>= 1)
+			++mipmaps;
+
+	// Level buffer holds mipmap 1 and is reused for all the next ones.
+	unsigned char* level = (mipmaps > 1) ?
+		malloc(
+			(size_t)GFX_MAX(x >> 1, 1) *
+			(size_t)GFX_MAX(y >> 1, 1) * (size_t)comps) : NULL;
+	GFXRegion* regions = malloc(sizeof(GFXRegion) * mipmaps * 2);
+	GFXImage* image = NULL;
+
+	if ((mipmaps > 1 && level == NULL) || regions == NULL)
+		goto clean;
+
+	// Compute the regions of all encoded mipmaps.
+	size_t offset = 0;
+
+	for (uint32_t m = 0; m < mipmaps; ++m)
+	{
+		const uint32_t width = GFX_MAX((uint32_t)x >> m, 1);
+		const uint32_t height = GFX_MAX((uint32_t)y >> m, 1);
+
+		regions[m] = (GFXRegion){
+			.offset = offset,
+			.rowSize = 0,
+			.numRows = 0
+		};
+
+		regions[mipmaps + m] = (GFXRegion){
+			.aspect = GFX_IMAGE_COLOR,
+			.mipmap = m,
+			.layer = 0,
+			.numLayers = 1,
+			.x = 0,
+			.y = 0,
+			.z = 0,
+			.width = width,
+			.height = height,
+			.depth = 1
+		};
+
+		offset += blockSize * ((width + 3) / 4) * ((height + 3) / 4);
+	}
+
+	// Allocate image & map staging memory to encode into.
+	image = gfx_alloc_image(heap,
+		GFX_IMAGE_2D,
+		(flags & GFX_IMAGE_READABLE) ? GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+		usage, fmt, mipmaps, 1, (uint32_t)x, (uint32_t)y, 1);
+
+	if (image == NULL) goto clean;
+
+	GFXMappedWrite write;
+	unsigned char* data = gfx_map_write(&write,
+		gfx_ref_image(image), mipmaps, regions, regions + mipmaps);
+
+	if (data == NULL)
+	{
+		gfx_free_image(image);
+		image = NULL;
+		goto clean;
+	}
+
+	// Encode all mipmaps, each next mipmap is box-filtered from the
+	// previous one; mipmap 1 from the image, the rest in-place in the
+	// level buffer (texels are never written before they are read).
+	for (uint32_t m = 0; m < mipmaps; ++m)
+	{
+		const uint32_t width = GFX_MAX((uint32_t)x >> m, 1);
+		const uint32_t height = GFX_MAX((uint32_t)y >> m, 1);
+
+		if (m > 0)
+		{
+			const uint32_t pWidth = GFX_MAX((uint32_t)x >> (m-1), 1);
+			const uint32_t pHeight = GFX_MAX((uint32_t)y >> (m-1), 1);
+			const unsigned char* prev = (m == 1) ? img : level;
+
+			for (uint32_t ty = 0; ty < height; ++ty)
+				for (uint32_t tx = 0; tx < width; ++tx)
+					for (int c = 0; c < comps; ++c)
+					{
+						const uint32_t x0 = tx * 2, x1 = GFX_MIN(x0 + 1, pWidth - 1);
+						const uint32_t y0 = ty * 2, y1 = GFX_MIN(y0 + 1, pHeight - 1);
+						const size_t s = (size_t)comps;
+
+						level[((size_t)ty * width + tx) * s + (size_t)c] =
+							(unsigned char)((
+								prev[((size_t)y0 * pWidth + x0) * s + (size_t)c] +
+								prev[((size_t)y0 * pWidth + x1) * s + (size_t)c] +
+								prev[((size_t)y1 * pWidth + x0) * s + (size_t)c] +
+								prev[((size_t)y1 * pWidth + x1) * s + (size_t)c] + 2) / 4);
+					}
+		}
+
+		// Encoded on the shared job scheduler, which does not start any
+		// threads per level, even if we are a glTF loading job ourselves.
+		if (!gfx_encode_bcn(fmt, width, height, (unsigned char)comps,
+			m > 0 ? level : img, data + regions[m].offset, 0, NULL))
+		{
+			gfx_cancel_write(&write);
+			gfx_free_image(image);
+			image = NULL;
+			goto clean;
+		}
+	}
+
+	// Write data.
+	const GFXInject inject =
+		gfx_sem_sig(sem, gfx_image_mask_(image->usage), GFX_STAGE_ANY);
+
+	if (!gfx_unmap_write(&write,
+		GFX_TRANSFER_ASYNC,
+		mipmaps, 1, regions, regions + mipmaps, &inject))
+	{
+		gfx_free_image(image);
+		image = NULL;
+	}
+
+
+	// Cleanup.
+clean:
+	stbi_image_free(img);
+	free(level);
+	free(regions);
+
+	if (image == NULL)
+		gfx_log_error("Failed to load compressed image from stream.");
+
+	return image;
+}
+
 /****************************/
 GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
                                  GFXImageFlags flags, GFXImageUsage usage,
@@ -81,6 +515,21 @@ GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
 		return NULL;
 	}
 
+	// Forward KTX2 streams, recognized by their identifier.
+	static const unsigned char ktx2[12] = {
+		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+	};
+
+	if (len >= (long long)sizeof(ktx2) && memcmp(source, ktx2, sizeof(ktx2)) == 0)
+	{
+		GFXBinReader reader;
+		GFXImage* image = gfx_load_ktx2(heap, sem, flags, usage,
+			gfx_bin_reader(&reader, (size_t)len, source));
+
+		gfx_io_raw_clear(&source, src);
+		return image;
+	}
+
 	// Get image properties.
 	int x, y, sComps;
 	const bool sIshdr = stbi_is_hdr_from_memory(source, (int)len);
@@ -106,20 +555,43 @@ GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
 		return NULL;
 	}
 
+	// If requested, encode 8-bit images into a compressed format.
+	GFXDevice* device = gfx_heap_get_device(heap);
+
+	if ((flags & GFX_IMAGE_COMPRESS) && !sIshdr && !sIs16)
+	{
+		const GFXFormat bcn = gfx_stb_image_bcn_(flags, sComps);
+		const GFXFormatFeatures bcnFeats = gfx_format_support(bcn, device);
+
+		if (GFX_IMAGE_FMT_SUPPORTED_(usage, bcnFeats))
+		{
+			GFXImage* image = gfx_stb_load_bcn_(
+				heap, sem, flags, usage, bcn, source, len);
+
+			gfx_io_raw_clear(&source, src);
+			return image;
+		}
+
+		gfx_log_warn(
+			"Compressed image format not supported, "
+			"loading image from stream uncompressed.");
+	}
+
 	// Get appropriate format from properties.
 	// We check if it is supported, if not we;
 	// firstly try out bigger orders and secondly try out smaller types.
 	// This will eventually result in an 8-bit format with 4 components,
 	// which is required to be supported by Vulkan!
-	GFXDevice* device = gfx_heap_get_device(heap);
-	GFXFormat fmt = gfx_stb_image_fmt_(sIshdr, sIs16, sComps);
+	const bool half = sIshdr && (flags & GFX_IMAGE_HALF);
+
+	GFXFormat fmt = gfx_stb_image_fmt_(sIshdr, sIs16, half, sComps);
 	GFXFormatFeatures feats = gfx_format_support(fmt, device);
 
 	int comps = sComps;
 	bool ishdr = sIshdr;
 	bool is16 = sIs16;
 
-	while (!GFX_STB_FMT_SUPPORTED_(usage, feats))
+	while (!GFX_IMAGE_FMT_SUPPORTED_(usage, feats))
 	{
 		// Try smaller type first, then bigger order.
 		if (flags & GFX_IMAGE_TYPE_BEFORE_ORDER)
@@ -156,12 +628,12 @@ GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
 			else break; // None found.
 		}
 
-		fmt = gfx_stb_image_fmt_(ishdr, is16, comps);
+		fmt = gfx_stb_image_fmt_(ishdr, is16, half, comps);
 		feats = gfx_format_support(fmt, device);
 	}
 
 	// Uh oh.
-	if (!GFX_STB_FMT_SUPPORTED_(usage, feats))
+	if (!GFX_IMAGE_FMT_SUPPORTED_(usage, feats))
 	{
 		gfx_log_error(
 			"No suitable supported format to load image from stream.");
@@ -171,14 +643,27 @@ GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
 	}
 
 	// Load/parse the image from memory.
+	// HDR to integer conversion is left to stb_image (it applies gamma),
+	// otherwise the image is loaded as-is and converted below.
+	const GFXStbType_ type =
+		ishdr ? (half ? GFX_STB_F16_ : GFX_STB_F32_) :
+		is16 ? GFX_STB_U16_ : GFX_STB_U8_;
+
+	const bool stbConvert = sIshdr && !ishdr;
+
+	const GFXStbType_ sType =
+		stbConvert ? type :
+		sIshdr ? GFX_STB_F32_ : sIs16 ? GFX_STB_U16_ : GFX_STB_U8_;
+
+	const int lComps = stbConvert ? comps : sComps;
 	void* img;
 
-	if (ishdr)
-		img = stbi_loadf_from_memory(source, (int)len, &x, &y, &comps, comps);
-	else if (is16)
-		img = stbi_load_16_from_memory(source, (int)len, &x, &y, &comps, comps);
+	if (sType == GFX_STB_F32_)
+		img = stbi_loadf_from_memory(source, (int)len, &x, &y, &sComps, lComps);
+	else if (sType == GFX_STB_U16_)
+		img = stbi_load_16_from_memory(source, (int)len, &x, &y, &sComps, lComps);
 	else
-		img = stbi_load_from_memory(source, (int)len, &x, &y, &comps, comps);
+		img = stbi_load_from_memory(source, (int)len, &x, &y, &sComps, lComps);
 
 	gfx_io_raw_clear(&source, src); // Immediately clear source buffer.
 
@@ -191,10 +676,27 @@ GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
 		return NULL;
 	}
 
+	// Compute the number of mipmaps to generate.
+	// If the format does not support (linear) blitting, don't generate any.
+	uint32_t mipmaps = 1;
+
+	if (flags & GFX_IMAGE_MIPMAPS)
+	{
+		if (GFX_IMAGE_FMT_MIPMAPS_(feats))
+			for (int m = GFX_MAX(x, y); m > 1; m >>= 1)
+				++mipmaps;
+		else
+			gfx_log_warn(
+				"Image format does not support (linear) blitting, "
+				"loading image from stream without mipmaps.");
+	}
+
 	// Allocate image.
 	GFXImage* image = gfx_alloc_image(heap,
-		GFX_IMAGE_2D, GFX_MEMORY_WRITE,
-		usage, fmt, 1, 1, (uint32_t)x, (uint32_t)y, 1);
+		GFX_IMAGE_2D,
+		mipmaps > 1 || (flags & GFX_IMAGE_READABLE) ?
+			GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+		usage, fmt, mipmaps, 1, (uint32_t)x, (uint32_t)y, 1);
 
 	if (image == NULL) goto clean;
 
@@ -218,28 +720,37 @@ GFX_API GFXImage* gfx_load_image(GFXHeap* heap, GFXSemaphore* sem,
 		.depth = 1
 	};
 
-	const GFXAccessMask mask =
-		((image->usage & GFX_IMAGE_SAMPLED) ||
-		(image->usage & GFX_IMAGE_SAMPLED_LINEAR) ||
-		(image->usage & GFX_IMAGE_SAMPLED_MINMAX) ?
-			GFX_ACCESS_SAMPLED_READ : 0) |
-		((image->usage & GFX_IMAGE_STORAGE) ?
-			GFX_ACCESS_STORAGE_READ_WRITE : 0);
-
 	const GFXInject inject =
-		gfx_sem_sig(sem, mask, GFX_STAGE_ANY);
+		gfx_sem_sig(sem, gfx_image_mask_(image->usage), GFX_STAGE_ANY);
 
-	if (!gfx_write(img, gfx_ref_image(image),
-		GFX_TRANSFER_ASYNC,
-		1, 1, &srcRegion, &dstRegion, &inject))
+	// Convert (or copy) the parsed data straight into staging memory,
+	// so we never hold another full copy of the image on the host.
+	GFXMappedWrite write;
+	void* ptr = gfx_map_write(&write,
+		gfx_ref_image(image), 1, &srcRegion, &dstRegion);
+
+	if (ptr == NULL)
 	{
 		gfx_free_image(image);
 		goto clean;
 	}
 
-	// Free the parsed data and return.
+	gfx_stb_convert_(sType, type, lComps, comps,
+		(size_t)x * (size_t)y, img, ptr);
+
 	stbi_image_free(img);
 
+	// Generating mipmaps requires a graphics queue, so not async.
+	if (!gfx_unmap_write(&write,
+		mipmaps > 1 ? GFX_TRANSFER_MIPMAPS : GFX_TRANSFER_ASYNC,
+		1, 1, &srcRegion, &dstRegion, &inject))
+	{
+		gfx_free_image(image);
+		gfx_log_error("Failed to load image from stream.");
+
+		return NULL;
+	}
+
 	return image;
 
 
@@ -0,0 +1,407 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/assets/common.h"
+#include "groufix/assets/image.h"
+#include "groufix/core/log.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// KTX2 header sizes (in bytes).
+#define GFX_KTX2_HEADER_SIZE_ 80
+#define GFX_KTX2_LEVEL_SIZE_  24
+
+
+// Checks if the format has features to generate mipmaps (by blitting).
+#define GFX_KTX2_FMT_MIPMAPS_(fmt, feats) \
+	(!GFX_FORMAT_IS_COMPRESSED(fmt) && GFX_IMAGE_FMT_MIPMAPS_(feats))
+
+
+/****************************
+ * KTX2 file identifier.
+ */
+static const unsigned char gfx_ktx2_identifier_[12] = {
+	0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+
+/****************************
+ * Reads a little-endian 32 bits unsigned integer.
+ */
+static uint32_t gfx_ktx2_u32_(const unsigned char* src)
+{
+	return
+		(uint32_t)src[0] |
+		(uint32_t)src[1] << 8 |
+		(uint32_t)src[2] << 16 |
+		(uint32_t)src[3] << 24;
+}
+
+/****************************
+ * Reads a little-endian 64 bits unsigned integer.
+ */
+static uint64_t gfx_ktx2_u64_(const unsigned char* src)
+{
+	return
+		(uint64_t)gfx_ktx2_u32_(src) |
+		(uint64_t)gfx_ktx2_u32_(src + 4) << 32;
+}
+
+/****************************
+ * Parses a Vulkan format (as stored in a KTX2 header) into a groufix format.
+ * Only formats that can be uploaded without conversion are recognized.
+ * @return GFX_FORMAT_EMPTY if not recognized.
+ */
+static GFXFormat gfx_ktx2_format_(uint32_t vkFormat)
+{
+	switch (vkFormat)
+	{
+	case 9:   return GFX_FORMAT_R8_UNORM;
+	case 10:  return GFX_FORMAT_R8_SNORM;
+	case 15:  return GFX_FORMAT_R8_SRGB;
+	case 16:  return GFX_FORMAT_R8G8_UNORM;
+	case 17:  return GFX_FORMAT_R8G8_SNORM;
+	case 22:  return GFX_FORMAT_R8G8_SRGB;
+	case 23:  return GFX_FORMAT_R8G8B8_UNORM;
+	case 29:  return GFX_FORMAT_R8G8B8_SRGB;
+	case 30:  return GFX_FORMAT_B8G8R8_UNORM;
+	case 36:  return GFX_FORMAT_B8G8R8_SRGB;
+	case 37:  return GFX_FORMAT_R8G8B8A8_UNORM;
+	case 38:  return GFX_FORMAT_R8G8B8A8_SNORM;
+	case 43:  return GFX_FORMAT_R8G8B8A8_SRGB;
+	case 44:  return GFX_FORMAT_B8G8R8A8_UNORM;
+	case 50:  return GFX_FORMAT_B8G8R8A8_SRGB;
+	case 70:  return GFX_FORMAT_R16_UNORM;
+	case 76:  return GFX_FORMAT_R16_SFLOAT;
+	case 77:  return GFX_FORMAT_R16G16_UNORM;
+	case 83:  return GFX_FORMAT_R16G16_SFLOAT;
+	case 91:  return GFX_FORMAT_R16G16B16A16_UNORM;
+	case 97:  return GFX_FORMAT_R16G16B16A16_SFLOAT;
+	case 100: return GFX_FORMAT_R32_SFLOAT;
+	case 103: return GFX_FORMAT_R32G32_SFLOAT;
+	case 106: return GFX_FORMAT_R32G32B32_SFLOAT;
+	case 109: return GFX_FORMAT_R32G32B32A32_SFLOAT;
+	case 122: return GFX_FORMAT_B10G11R11_UFLOAT;
+	case 123: return GFX_FORMAT_E5B9G9R9_UFLOAT;
+
+	case 131: return GFX_FORMAT_BC1_RGB_UNORM;
+	case 132: return GFX_FORMAT_BC1_RGB_SRGB;
+	case 133: return GFX_FORMAT_BC1_RGBA_UNORM;
+	case 134: return GFX_FORMAT_BC1_RGBA_SRGB;
+	case 135: return GFX_FORMAT_BC2_UNORM;
+	case 136: return GFX_FORMAT_BC2_SRGB;
+	case 137: return GFX_FORMAT_BC3_UNORM;
+	case 138: return GFX_FORMAT_BC3_SRGB;
+	case 139: return GFX_FORMAT_BC4_UNORM;
+	case 140: return GFX_FORMAT_BC4_SNORM;
+	case 141: return GFX_FORMAT_BC5_UNORM;
+	case 142: return GFX_FORMAT_BC5_SNORM;
+	case 143: return GFX_FORMAT_BC6_UFLOAT;
+	case 144: return GFX_FORMAT_BC6_SFLOAT;
+	case 145: return GFX_FORMAT_BC7_UNORM;
+	case 146: return GFX_FORMAT_BC7_SRGB;
+
+	case 147: return GFX_FORMAT_ETC2_R8G8B8_UNORM;
+	case 148: return GFX_FORMAT_ETC2_R8G8B8_SRGB;
+	case 149: return GFX_FORMAT_ETC2_R8G8B8A1_UNORM;
+	case 150: return GFX_FORMAT_ETC2_R8G8B8A1_SRGB;
+	case 151: return GFX_FORMAT_ETC2_R8G8B8A8_UNORM;
+	case 152: return GFX_FORMAT_ETC2_R8G8B8A8_SRGB;
+	case 153: return GFX_FORMAT_EAC_R11_UNORM;
+	case 154: return GFX_FORMAT_EAC_R11_SNORM;
+	case 155: return GFX_FORMAT_EAC_R11G11_UNORM;
+	case 156: return GFX_FORMAT_EAC_R11G11_SNORM;
+
+	case 157: return GFX_FORMAT_ASTC_4x4_UNORM;
+	case 158: return GFX_FORMAT_ASTC_4x4_SRGB;
+	case 159: return GFX_FORMAT_ASTC_5x4_UNORM;
+	case 160: return GFX_FORMAT_ASTC_5x4_SRGB;
+	case 161: return GFX_FORMAT_ASTC_5x5_UNORM;
+	case 162: return GFX_FORMAT_ASTC_5x5_SRGB;
+	case 163: return GFX_FORMAT_ASTC_6x5_UNORM;
+	case 164: return GFX_FORMAT_ASTC_6x5_SRGB;
+	case 165: return GFX_FORMAT_ASTC_6x6_UNORM;
+	case 166: return GFX_FORMAT_ASTC_6x6_SRGB;
+	case 167: return GFX_FORMAT_ASTC_8x5_UNORM;
+	case 168: return GFX_FORMAT_ASTC_8x5_SRGB;
+	case 169: return GFX_FORMAT_ASTC_8x6_UNORM;
+	case 170: return GFX_FORMAT_ASTC_8x6_SRGB;
+	case 171: return GFX_FORMAT_ASTC_8x8_UNORM;
+	case 172: return GFX_FORMAT_ASTC_8x8_SRGB;
+	case 173: return GFX_FORMAT_ASTC_10x5_UNORM;
+	case 174: return GFX_FORMAT_ASTC_10x5_SRGB;
+	case 175: return GFX_FORMAT_ASTC_10x6_UNORM;
+	case 176: return GFX_FORMAT_ASTC_10x6_SRGB;
+	case 177: return GFX_FORMAT_ASTC_10x8_UNORM;
+	case 178: return GFX_FORMAT_ASTC_10x8_SRGB;
+	case 179: return GFX_FORMAT_ASTC_10x10_UNORM;
+	case 180: return GFX_FORMAT_ASTC_10x10_SRGB;
+	case 181: return GFX_FORMAT_ASTC_12x10_UNORM;
+	case 182: return GFX_FORMAT_ASTC_12x10_SRGB;
+	case 183: return GFX_FORMAT_ASTC_12x12_UNORM;
+	case 184: return GFX_FORMAT_ASTC_12x12_SRGB;
+
+	default:
+		return GFX_FORMAT_EMPTY;
+	}
+}
+
+/****************************/
+GFX_API GFXImage* gfx_load_ktx2(GFXHeap* heap, GFXSemaphore* sem,
+                                GFXImageFlags flags, GFXImageUsage usage,
+                                const GFXReader* src)
+{
+	assert(heap != NULL);
+	assert(sem != NULL);
+	assert(src != NULL);
+
+	// Read source.
+	// If it is already in memory, this does not copy anything.
+	const void* source;
+	long long len = gfx_io_raw_init(&source, src);
+
+	if (len <= 0)
+	{
+		gfx_log_error("Could not read KTX2 source from stream.");
+		return NULL;
+	}
+
+	const unsigned char* bytes = source;
+	GFXRegion* regions = NULL;
+
+	// Validate & parse the header.
+	if (
+		len < GFX_KTX2_HEADER_SIZE_ ||
+		memcmp(bytes, gfx_ktx2_identifier_, sizeof(gfx_ktx2_identifier_)) != 0)
+	{
+		gfx_log_error("Cannot load KTX2 from stream, invalid identifier.");
+		goto clean;
+	}
+
+	const uint32_t vkFormat    = gfx_ktx2_u32_(bytes + 12);
+	const uint32_t width       = gfx_ktx2_u32_(bytes + 20);
+	const uint32_t height      = gfx_ktx2_u32_(bytes + 24);
+	const uint32_t depth       = gfx_ktx2_u32_(bytes + 28);
+	const uint32_t layerCount  = gfx_ktx2_u32_(bytes + 32);
+	const uint32_t faceCount   = gfx_ktx2_u32_(bytes + 36);
+	const uint32_t levelCount  = gfx_ktx2_u32_(bytes + 40);
+	const uint32_t superScheme = gfx_ktx2_u32_(bytes + 44);
+
+	// We do not transcode (e.g. Basis Universal) nor decompress,
+	// all data is uploaded as-is.
+	if (superScheme != 0)
+	{
+		gfx_log_error(
+			"Cannot load KTX2 from stream, "
+			"supercompression scheme %u is not supported.",
+			(unsigned int)superScheme);
+
+		goto clean;
+	}
+
+	const GFXFormat fmt = gfx_ktx2_format_(vkFormat);
+	if (GFX_FORMAT_IS_EMPTY(fmt))
+	{
+		gfx_log_error(
+			"Cannot load KTX2 from stream, "
+			"format %u is not supported.",
+			(unsigned int)vkFormat);
+
+		goto clean;
+	}
+
+	if (
+		width == 0 ||
+		(faceCount != 1 && faceCount != 6) ||
+		(faceCount == 6 && (width != height || depth > 0)) ||
+		(depth > 0 && (height == 0 || layerCount > 0)))
+	{
+		gfx_log_error(
+			"Cannot load KTX2 from stream, invalid dimensions: %ux%ux%u",
+			(unsigned int)width, (unsigned int)height, (unsigned int)depth);
+
+		goto clean;
+	}
+
+	// Check if the device supports the format as-is.
+	// Compressed formats cannot be converted, so fail if not,
+	// this allows the caller to pick another source.
+	GFXDevice* device = gfx_heap_get_device(heap);
+	GFXFormatFeatures feats = gfx_format_support(fmt, device);
+
+	if (!GFX_IMAGE_FMT_SUPPORTED_(usage, feats))
+	{
+		gfx_log_error(
+			"Cannot load KTX2 from stream, "
+			"format %u is not supported by the device.",
+			(unsigned int)vkFormat);
+
+		goto clean;
+	}
+
+	// Get the level index & validate it.
+	// A full mipmap chain has floor(log2(max dimension)) + 1 levels.
+	uint32_t maxLevels = 0;
+	for (
+		uint32_t dim = GFX_MAX(width, GFX_MAX(height, depth));
+		dim > 0; dim >>= 1)
+	{
+		++maxLevels;
+	}
+
+	if (levelCount > maxLevels)
+	{
+		gfx_log_error(
+			"Cannot load KTX2 from stream, too many levels: %u",
+			(unsigned int)levelCount);
+
+		goto clean;
+	}
+
+	const uint32_t levels = GFX_MAX(1, levelCount);
+
+	if ((uint64_t)len <
+		GFX_KTX2_HEADER_SIZE_ + (uint64_t)levels * GFX_KTX2_LEVEL_SIZE_)
+	{
+		gfx_log_error("Cannot load KTX2 from stream, level index is missing.");
+		goto clean;
+	}
+
+	const GFXImageType type =
+		faceCount == 6 ? GFX_IMAGE_CUBE :
+		depth > 0 ? GFX_IMAGE_3D :
+		height == 0 ? GFX_IMAGE_1D : GFX_IMAGE_2D;
+
+	const uint32_t layers = GFX_MAX(1, layerCount) * faceCount;
+	const uint32_t blockSize = GFX_FORMAT_BLOCK_SIZE(fmt) / CHAR_BIT;
+	const uint32_t blockWidth = GFX_FORMAT_BLOCK_WIDTH(fmt);
+	const uint32_t blockHeight = GFX_FORMAT_BLOCK_HEIGHT(fmt);
+
+	// Source regions followed by destination regions.
+	regions = malloc(sizeof(GFXRegion) * levels * 2);
+	if (regions == NULL) goto clean;
+
+	GFXRegion* srcRegions = regions;
+	GFXRegion* dstRegions = regions + levels;
+
+	for (uint32_t l = 0; l < levels; ++l)
+	{
+		const unsigned char* level =
+			bytes + GFX_KTX2_HEADER_SIZE_ + l * GFX_KTX2_LEVEL_SIZE_;
+
+		const uint64_t offset = gfx_ktx2_u64_(level);
+		const uint64_t size = gfx_ktx2_u64_(level + 8);
+
+		const uint32_t w = GFX_MAX(1, width >> l);
+		const uint32_t h = GFX_MAX(1, GFX_MAX(1, height) >> l);
+		const uint32_t d = GFX_MAX(1, GFX_MAX(1, depth) >> l);
+
+		// Levels are tightly packed, validate they are in range,
+		// as the data is copied straight from the stream.
+		// Compute the expected size without overflowing.
+		const uint64_t factors[] = {
+			layers, d,
+			(w + blockWidth - 1) / blockWidth,
+			(h + blockHeight - 1) / blockHeight
+		};
+
+		uint64_t expected = blockSize;
+		bool overflow = 0;
+
+		for (size_t f = 0; f < sizeof(factors) / sizeof(*factors); ++f)
+		{
+			overflow = overflow ||
+				(factors[f] > 0 && expected > UINT64_MAX / factors[f]);
+
+			if (!overflow) expected *= factors[f];
+		}
+
+		if (
+			overflow ||
+			size < expected || size > (uint64_t)len ||
+			expected > (uint64_t)len || offset > (uint64_t)len - expected)
+		{
+			gfx_log_error(
+				"Cannot load KTX2 from stream, level %u is out of range.",
+				(unsigned int)l);
+
+			goto clean;
+		}
+
+		srcRegions[l] = (GFXRegion){
+			.offset = offset,
+			.rowSize = 0,
+			.numRows = 0
+		};
+
+		dstRegions[l] = (GFXRegion){
+			.aspect = GFX_IMAGE_COLOR,
+			.mipmap = l,
+			.layer = 0,
+			.numLayers = layers,
+			.x = 0,
+			.y = 0,
+			.z = 0,
+			.width = w,
+			.height = h,
+			.depth = d
+		};
+	}
+
+	// A level count of 0 means mipmaps should be generated.
+	uint32_t mipmaps = levels;
+
+	if (levelCount == 0 && (flags & GFX_IMAGE_MIPMAPS))
+	{
+		if (GFX_KTX2_FMT_MIPMAPS_(fmt, feats))
+			for (uint32_t m = GFX_MAX(width, GFX_MAX(height, depth)); m > 1; m >>= 1)
+				++mipmaps;
+		else
+			gfx_log_warn(
+				"KTX2 format does not support (linear) blitting, "
+				"loading image from stream without mipmaps.");
+	}
+
+	// Allocate image.
+	GFXImage* image = gfx_alloc_image(heap,
+		type,
+		mipmaps > levels || (flags & GFX_IMAGE_READABLE) ?
+			GFX_MEMORY_READ_WRITE : GFX_MEMORY_WRITE,
+		usage, fmt, mipmaps, layers,
+		width, GFX_MAX(1, height), GFX_MAX(1, depth));
+
+	if (image == NULL) goto clean;
+
+	// Write all levels at once, straight from the source.
+	const GFXInject inject =
+		gfx_sem_sig(sem, gfx_image_mask_(image->usage), GFX_STAGE_ANY);
+
+	if (!gfx_write(bytes, gfx_ref_image(image),
+		mipmaps > levels ? GFX_TRANSFER_MIPMAPS : GFX_TRANSFER_ASYNC,
+		levels, 1, srcRegions, dstRegions, &inject))
+	{
+		gfx_free_image(image);
+		goto clean;
+	}
+
+	gfx_io_raw_clear(&source, src);
+	free(regions);
+
+	return image;
+
+
+	// Cleanup on failure.
+clean:
+	gfx_io_raw_clear(&source, src);
+	free(regions);
+	gfx_log_error("Failed to load KTX2 from stream.");
+
+	return NULL;
+}
@@ -0,0 +1,1188 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/assets/mesh.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/****************************
+ * Triangle cluster to sort by, for overdraw optimization.
+ */
+typedef struct GFXMeshCluster_
+{
+	size_t begin; // First triangle.
+	size_t end;   // Last triangle (exclusive).
+
+	float centroid[3]; // Area-weighted.
+	float normal[3];   // Normalized.
+	float key;
+
+} GFXMeshCluster_;
+
+
+/****************************
+ * Symmetric quadric error matrix (Garland & Heckbert 1997),
+ * area-weighted, so the error is a mean squared distance.
+ */
+typedef struct GFXMeshQuadric_
+{
+	double a00, a11, a22, a01, a02, a12; // Upper triangle.
+	double b0, b1, b2;
+	double c;
+	double w; // Total weight.
+
+} GFXMeshQuadric_;
+
+
+/****************************
+ * Edge collapse candidate, for simplification.
+ */
+typedef struct GFXMeshCollapse_
+{
+	uint32_t from;
+	uint32_t to;
+	double cost;
+
+} GFXMeshCollapse_;
+
+
+/****************************
+ * Simplification vertex flags & directed edge key.
+ */
+#define GFX_MESH_LOCKED_  0x01
+#define GFX_MESH_TOUCHED_ 0x02
+
+#define GFX_MESH_EDGE_KEY_(a, b) \
+	(((uint64_t)(a) << 32) | (uint64_t)(b))
+
+
+/****************************
+ * Updates a simulated FIFO cache with a single triangle.
+ * @param cache Timestamp for each vertex of when it entered the cache.
+ * @param time  Current timestamp, incremented for each miss.
+ * @return Number of cache misses.
+ */
+static unsigned int gfx_mesh_cache_(const uint32_t* tri,
+                                    size_t* cache, size_t* time,
+                                    unsigned int cacheSize)
+{
+	unsigned int misses = 0;
+
+	for (size_t v = 0; v < 3; ++v)
+		if (*time - cache[tri[v]] > cacheSize)
+			cache[tri[v]] = (*time)++,
+			++misses;
+
+	return misses;
+}
+
+/****************************
+ * Compares two clusters by their sort key (descending),
+ * keeping their original order if equal.
+ */
+static int gfx_mesh_cmp_clusters_(const void* l, const void* r)
+{
+	const GFXMeshCluster_* cl = l;
+	const GFXMeshCluster_* cr = r;
+
+	return
+		(cl->key > cr->key) ? -1 : (cl->key < cr->key) ? 1 :
+		(cl->begin < cr->begin) ? -1 : (cl->begin > cr->begin) ? 1 : 0;
+}
+
+/****************************
+ * Retrieves the position of a vertex.
+ */
+static inline const float* gfx_mesh_pos_(const void* positions, size_t stride,
+                                         uint32_t v)
+{
+	return (const float*)((const char*)positions + stride * v);
+}
+
+/****************************
+ * Computes the unit normal of a meshlet triangle, zero if degenerate.
+ * @param tri Local vertex indices of the triangle.
+ */
+static void gfx_mesh_normal_(const uint32_t* verts, const uint8_t* tri,
+                             const void* positions, size_t stride,
+                             float n[3])
+{
+	const float* a = gfx_mesh_pos_(positions, stride, verts[tri[0]]);
+	const float* b = gfx_mesh_pos_(positions, stride, verts[tri[1]]);
+	const float* c = gfx_mesh_pos_(positions, stride, verts[tri[2]]);
+
+	const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+	const float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+
+	for (size_t k = 0; k < 3; ++k)
+		n[k] *= inv;
+}
+
+/****************************
+ * Computes the bounding sphere & normal cone of a meshlet.
+ * @param meshlet Meshlet to compute the bounds of, cannot be NULL.
+ */
+static void gfx_mesh_meshlet_bounds_(GFXMeshlet* meshlet,
+                                     const uint32_t* vertices,
+                                     const uint8_t* triangles,
+                                     const void* positions, size_t stride)
+{
+	const uint32_t* verts = vertices + meshlet->vertexOffset;
+	const uint8_t* tris = triangles + meshlet->triangleOffset * 3;
+
+	// Bounding sphere (Ritter), start with the most distant pair of
+	// axis-aligned extremes, then grow to include all vertices.
+	uint32_t ext[6] = { 0, 0, 0, 0, 0, 0 };
+
+	for (uint32_t v = 1; v < meshlet->numVertices; ++v)
+	{
+		const float* p = gfx_mesh_pos_(positions, stride, verts[v]);
+
+		for (size_t c = 0; c < 3; ++c)
+		{
+			if (p[c] < gfx_mesh_pos_(positions, stride, verts[ext[c]])[c])
+				ext[c] = v;
+			if (p[c] > gfx_mesh_pos_(positions, stride, verts[ext[c + 3]])[c])
+				ext[c + 3] = v;
+		}
+	}
+
+	float center[3] = { 0.0f, 0.0f, 0.0f };
+	float radius = -1.0f;
+
+	for (size_t c = 0; c < 3; ++c)
+	{
+		const float* l = gfx_mesh_pos_(positions, stride, verts[ext[c]]);
+		const float* r = gfx_mesh_pos_(positions, stride, verts[ext[c + 3]]);
+		const float d[3] = { r[0] - l[0], r[1] - l[1], r[2] - l[2] };
+		const float dist = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+		if (dist * 0.5f > radius)
+		{
+			radius = dist * 0.5f;
+			for (size_t k = 0; k < 3; ++k)
+				center[k] = (l[k] + r[k]) * 0.5f;
+		}
+	}
+
+	for (uint32_t v = 0; v < meshlet->numVertices; ++v)
+	{
+		const float* p = gfx_mesh_pos_(positions, stride, verts[v]);
+		const float d[3] = { p[0] - center[0], p[1] - center[1], p[2] - center[2] };
+		const float dist = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+		if (dist > radius)
+		{
+			const float grow = (dist - radius) * 0.5f;
+			for (size_t k = 0; k < 3; ++k)
+				center[k] += d[k] * (grow / dist);
+
+			radius += grow;
+		}
+	}
+
+	memcpy(meshlet->center, center, sizeof(center));
+	meshlet->radius = radius;
+
+	// Normal cone, its axis is the average of all triangle normals.
+	// Normals are recomputed when needed, as meshlets can be of any size.
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+
+	for (uint32_t t = 0; t < meshlet->numTriangles; ++t)
+	{
+		// Degenerate triangles do not contribute.
+		float n[3];
+		gfx_mesh_normal_(verts, tris + t * 3, positions, stride, n);
+
+		for (size_t k = 0; k < 3; ++k)
+			axis[k] += n[k];
+	}
+
+	const float len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	float minDot = 1.0f;
+
+	if (len > 0.0f)
+	{
+		for (size_t k = 0; k < 3; ++k)
+			axis[k] /= len;
+
+		for (uint32_t t = 0; t < meshlet->numTriangles; ++t)
+		{
+			float n[3];
+			gfx_mesh_normal_(verts, tris + t * 3, positions, stride, n);
+
+			if (n[0] != 0.0f || n[1] != 0.0f || n[2] != 0.0f)
+				minDot = GFX_MIN(minDot,
+					n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+		}
+	}
+
+	// Cones spanning (nearly) a hemisphere or more can never be culled.
+	if (len <= 0.0f || minDot <= 0.1f)
+	{
+		meshlet->coneAxis[0] = 0.0f;
+		meshlet->coneAxis[1] = 0.0f;
+		meshlet->coneAxis[2] = 0.0f;
+		meshlet->coneCutoff = 1.0f;
+	}
+	else
+	{
+		memcpy(meshlet->coneAxis, axis, sizeof(axis));
+		meshlet->coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
+
+/****************************
+ * Computes the area-weighted plane quadric of a triangle.
+ * @param q Output quadric, cannot be NULL.
+ */
+static void gfx_mesh_quadric_(GFXMeshQuadric_* q,
+                              const float* p0, const float* p1, const float* p2)
+{
+	const double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+	double n[3] = {
+		e1[1] * e2[2] - e1[2] * e2[1],
+		e1[2] * e2[0] - e1[0] * e2[2],
+		e1[0] * e2[1] - e1[1] * e2[0]
+	};
+
+	// Length of the cross product is twice the area.
+	const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	const double area = len * 0.5;
+
+	if (len > 0.0)
+		n[0] /= len, n[1] /= len, n[2] /= len;
+
+	const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+	q->a00 = area * n[0] * n[0];
+	q->a11 = area * n[1] * n[1];
+	q->a22 = area * n[2] * n[2];
+	q->a01 = area * n[0] * n[1];
+	q->a02 = area * n[0] * n[2];
+	q->a12 = area * n[1] * n[2];
+	q->b0 = area * n[0] * d;
+	q->b1 = area * n[1] * d;
+	q->b2 = area * n[2] * d;
+	q->c = area * d * d;
+	q->w = area;
+}
+
+/****************************
+ * Adds quadric r to quadric q.
+ */
+static inline void gfx_mesh_quadric_add_(GFXMeshQuadric_* q,
+                                         const GFXMeshQuadric_* r)
+{
+	q->a00 += r->a00; q->a11 += r->a11; q->a22 += r->a22;
+	q->a01 += r->a01; q->a02 += r->a02; q->a12 += r->a12;
+	q->b0 += r->b0; q->b1 += r->b1; q->b2 += r->b2;
+	q->c += r->c;
+	q->w += r->w;
+}
+
+/****************************
+ * Evaluates a quadric at a point.
+ * @return Mean squared distance to all planes of q.
+ */
+static double gfx_mesh_quadric_error_(const GFXMeshQuadric_* q, const float* p)
+{
+	const double x = p[0], y = p[1], z = p[2];
+
+	const double e =
+		q->a00 * x * x + q->a11 * y * y + q->a22 * z * z +
+		2.0 * (q->a01 * x * y + q->a02 * x * z + q->a12 * y * z) +
+		2.0 * (q->b0 * x + q->b1 * y + q->b2 * z) +
+		q->c;
+
+	return (q->w > 0.0 && e > 0.0) ? e / q->w : 0.0;
+}
+
+/****************************
+ * Finds the slot of a directed edge in a hash table (linear probing).
+ * @param edges Table of edge keys, UINT64_MAX for empty slots.
+ * @param cap   Capacity of the table, must be a power of two.
+ * @return Slot holding the edge, or the empty slot it should go in.
+ */
+static size_t gfx_mesh_edge_(const uint64_t* edges, size_t cap,
+                             uint32_t a, uint32_t b)
+{
+	const uint64_t key = GFX_MESH_EDGE_KEY_(a, b);
+
+	// 64-bit mix (splitmix64 finalizer).
+	uint64_t h = key;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+	h = h ^ (h >> 31);
+
+	size_t s = (size_t)h & (cap - 1);
+	while (edges[s] != UINT64_MAX && edges[s] != key)
+		s = (s + 1) & (cap - 1);
+
+	return s;
+}
+
+/****************************
+ * Compares two edge collapses by cost (ascending),
+ * keeping vertex order if equal.
+ */
+static int gfx_mesh_cmp_collapses_(const void* l, const void* r)
+{
+	const GFXMeshCollapse_* cl = l;
+	const GFXMeshCollapse_* cr = r;
+
+	return
+		(cl->cost < cr->cost) ? -1 : (cl->cost > cr->cost) ? 1 :
+		(cl->from < cr->from) ? -1 : (cl->from > cr->from) ? 1 : 0;
+}
+
+/****************************
+ * Checks whether collapsing vertex from onto vertex to flips
+ * (or degenerates) any triangle around from that remains.
+ * @param offsets   Vertex -> triangle adjacency offsets.
+ * @param triangles Vertex -> triangle adjacency.
+ */
+static bool gfx_mesh_flips_(const uint32_t* indices,
+                            const size_t* offsets, const size_t* triangles,
+                            const float* pos, uint32_t from, uint32_t to)
+{
+	for (size_t t = offsets[from]; t < offsets[from + 1]; ++t)
+	{
+		const uint32_t* tri = indices + triangles[t] * 3;
+
+		// Triangles containing both are removed.
+		if (tri[0] == to || tri[1] == to || tri[2] == to)
+			continue;
+
+		const float* p[3];
+		const float* q[3];
+
+		for (size_t v = 0; v < 3; ++v)
+			p[v] = pos + tri[v] * 3,
+			q[v] = pos + (tri[v] == from ? to : tri[v]) * 3;
+
+		float n[2][3];
+		for (size_t k = 0; k < 2; ++k)
+		{
+			const float* const* r = k ? q : p;
+			const float e1[3] = { r[1][0] - r[0][0], r[1][1] - r[0][1], r[1][2] - r[0][2] };
+			const float e2[3] = { r[2][0] - r[0][0], r[2][1] - r[0][1], r[2][2] - r[0][2] };
+
+			n[k][0] = e1[1] * e2[2] - e1[2] * e2[1];
+			n[k][1] = e1[2] * e2[0] - e1[0] * e2[2];
+			n[k][2] = e1[0] * e2[1] - e1[1] * e2[0];
+		}
+
+		const float d = n[0][0] * n[1][0] + n[0][1] * n[1][1] + n[0][2] * n[1][2];
+		const float l = n[0][0] * n[0][0] + n[0][1] * n[0][1] + n[0][2] * n[0][2];
+
+		if (l > 0.0f && d <= 0.0f)
+			return 1;
+	}
+
+	return 0;
+}
+
+/****************************/
+GFX_API float gfx_mesh_acmr(size_t numIndices, const uint32_t* indices,
+                            size_t numVertices, unsigned int cacheSize)
+{
+	assert(numIndices % 3 == 0);
+	assert(numIndices == 0 || indices != NULL);
+	assert(cacheSize > 0);
+
+	if (numIndices == 0)
+		return 0.0f;
+
+	size_t* cache = calloc(numVertices, sizeof(size_t));
+	if (cache == NULL) return 0.0f;
+
+	size_t time = cacheSize + 1;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < numIndices; i += 3)
+		misses += gfx_mesh_cache_(indices + i, cache, &time, cacheSize);
+
+	free(cache);
+
+	return (float)misses / (float)(numIndices / 3);
+}
+
+/****************************/
+GFX_API bool gfx_mesh_optimize_cache(size_t numIndices,
+                                     const uint32_t* src, uint32_t* dst,
+                                     size_t numVertices, unsigned int cacheSize)
+{
+	assert(numIndices % 3 == 0);
+	assert(numIndices == 0 || (src != NULL && dst != NULL));
+	assert(cacheSize > 0);
+
+	if (numIndices == 0 || numVertices == 0)
+		return 1;
+
+	const size_t numTris = numIndices / 3;
+
+	// Allocate all the things.
+	// Adjacency is stored as a list of triangles for each vertex,
+	// the dead-end stack can never contain more than all indices.
+	size_t* offsets = calloc(numVertices + 1, sizeof(size_t));
+	size_t* live = calloc(numVertices, sizeof(size_t));
+	size_t* cache = calloc(numVertices, sizeof(size_t));
+	size_t* adjacency = malloc(sizeof(size_t) * numIndices);
+	uint32_t* deadEnd = malloc(sizeof(uint32_t) * numIndices);
+	bool* emitted = calloc(numTris, sizeof(bool));
+	uint32_t* candidates = NULL;
+
+	if (
+		offsets == NULL || live == NULL || cache == NULL ||
+		adjacency == NULL || deadEnd == NULL || emitted == NULL)
+	{
+		goto clean;
+	}
+
+	// Build adjacency.
+	size_t maxLive = 0;
+
+	for (size_t i = 0; i < numIndices; ++i)
+		++live[src[i]];
+
+	for (size_t v = 0; v < numVertices; ++v)
+		offsets[v + 1] = offsets[v] + live[v],
+		maxLive = GFX_MAX(maxLive, live[v]);
+
+	for (size_t i = 0; i < numIndices; ++i)
+		adjacency[offsets[src[i] + 1] - (live[src[i]]--)] = i / 3;
+
+	for (size_t v = 0; v < numVertices; ++v)
+		live[v] = offsets[v + 1] - offsets[v];
+
+	// Each fanned vertex yields at most 3 candidates per triangle.
+	candidates = malloc(sizeof(uint32_t) * 3 * maxLive);
+	if (candidates == NULL) goto clean;
+
+	// Tipsify, fan around a vertex, emitting all its triangles.
+	// Then pick the next vertex from the emitted ones, preferring
+	// the one that will stay in the cache the longest.
+	size_t time = cacheSize + 1;
+	size_t numDead = 0;
+	size_t out = 0;
+	size_t cursor = 1;
+	uint32_t fan = 0;
+
+	while (1)
+	{
+		size_t numCandidates = 0;
+
+		for (size_t a = offsets[fan]; a < offsets[fan + 1]; ++a)
+		{
+			const size_t t = adjacency[a];
+			if (emitted[t]) continue;
+
+			for (size_t c = 0; c < 3; ++c)
+			{
+				const uint32_t v = src[t * 3 + c];
+
+				dst[out++] = v;
+				deadEnd[numDead++] = v;
+				candidates[numCandidates++] = v;
+				--live[v];
+
+				if (time - cache[v] > cacheSize)
+					cache[v] = time++;
+			}
+
+			emitted[t] = 1;
+		}
+
+		// Get the next fanning vertex from the candidates.
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+
+		for (size_t c = 0; c < numCandidates; ++c)
+		{
+			const uint32_t v = candidates[c];
+			if (live[v] == 0) continue;
+
+			// Vertices that stay in cache after fanning them are best,
+			// prefer the oldest of those.
+			int64_t priority = 0;
+			if (time - cache[v] + 2 * live[v] <= cacheSize)
+				priority = (int64_t)(time - cache[v]);
+
+			if (priority > bestPriority)
+				bestPriority = priority,
+				best = v;
+		}
+
+		// Dead-end, pop from the stack, then fall back to the cursor.
+		while (best < 0 && numDead > 0)
+			if (live[deadEnd[--numDead]] > 0)
+				best = deadEnd[numDead];
+
+		while (best < 0 && cursor < numVertices)
+			if (live[cursor++] > 0)
+				best = (int64_t)(cursor - 1);
+
+		if (best < 0)
+			break;
+
+		fan = (uint32_t)best;
+	}
+
+	assert(out == numIndices);
+
+	free(offsets);
+	free(live);
+	free(cache);
+	free(adjacency);
+	free(deadEnd);
+	free(emitted);
+	free(candidates);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(offsets);
+	free(live);
+	free(cache);
+	free(adjacency);
+	free(deadEnd);
+	free(emitted);
+	free(candidates);
+
+	return 0;
+}
+
+/****************************/
+GFX_API bool gfx_mesh_optimize_overdraw(size_t numIndices, uint32_t* indices,
+                                        size_t numVertices,
+                                        const void* positions, size_t stride,
+                                        unsigned int cacheSize, float threshold)
+{
+	assert(numIndices % 3 == 0);
+	assert(numIndices == 0 || indices != NULL);
+	assert(positions != NULL);
+	assert(cacheSize > 0);
+	assert(threshold >= 1.0f);
+
+	if (numIndices == 0 || numVertices == 0)
+		return 1;
+
+	const size_t numTris = numIndices / 3;
+
+	size_t* cache = calloc(numVertices, sizeof(size_t));
+	GFXMeshCluster_* clusters = malloc(sizeof(GFXMeshCluster_) * numTris);
+	uint32_t* sorted = malloc(sizeof(uint32_t) * numIndices);
+
+	if (cache == NULL || clusters == NULL || sorted == NULL)
+	{
+		free(cache);
+		free(clusters);
+		free(sorted);
+
+		return 0;
+	}
+
+	// Split into hard clusters where the cache is entirely missed,
+	// which Tipsify causes when it hits a dead-end.
+	// Then split each hard cluster into soft clusters as soon as their
+	// own ACMR is within the threshold of the hard cluster's ACMR.
+	size_t numClusters = 0;
+	size_t time = cacheSize + 1;
+
+	for (size_t t = 0; t < numTris; )
+	{
+		size_t end = t + 1;
+		gfx_mesh_cache_(indices + t * 3, cache, &time, cacheSize);
+
+		while (end < numTris &&
+			gfx_mesh_cache_(indices + end * 3, cache, &time, cacheSize) < 3)
+		{
+			++end;
+		}
+
+		// Simulate the hard cluster from an empty cache.
+		size_t misses = 0;
+		time += cacheSize + 1;
+
+		for (size_t s = t; s < end; ++s)
+			misses += gfx_mesh_cache_(indices + s * 3, cache, &time, cacheSize);
+
+		const float target = threshold * (float)misses / (float)(end - t);
+
+		size_t begin = t;
+		misses = 0;
+		time += cacheSize + 1;
+
+		for (size_t s = t; s < end; ++s)
+		{
+			misses += gfx_mesh_cache_(indices + s * 3, cache, &time, cacheSize);
+
+			if ((float)misses / (float)(s + 1 - begin) <= target || s + 1 == end)
+			{
+				clusters[numClusters++] = (GFXMeshCluster_){
+					.begin = begin,
+					.end = s + 1,
+					.key = 0.0f
+				};
+
+				begin = s + 1;
+				misses = 0;
+				time += cacheSize + 1;
+			}
+		}
+
+		// Continue with the triangle that ended the hard cluster,
+		// re-simulating it at the start of the next.
+		t = end;
+		time += cacheSize + 1;
+	}
+
+	// Compute the area-weighted centroid & normal of each cluster,
+	// as well as the centroid of the whole mesh.
+	float center[3] = { 0.0f, 0.0f, 0.0f };
+	float totalArea = 0.0f;
+
+	for (size_t c = 0; c < numClusters; ++c)
+	{
+		GFXMeshCluster_* cluster = clusters + c;
+		float area = 0.0f;
+
+		for (size_t i = 0; i < 3; ++i)
+			cluster->centroid[i] = 0.0f,
+			cluster->normal[i] = 0.0f;
+
+		for (size_t t = cluster->begin; t < cluster->end; ++t)
+		{
+			const float* p0 = gfx_mesh_pos_(positions, stride, indices[t * 3 + 0]);
+			const float* p1 = gfx_mesh_pos_(positions, stride, indices[t * 3 + 1]);
+			const float* p2 = gfx_mesh_pos_(positions, stride, indices[t * 3 + 2]);
+
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float n[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0]
+			};
+
+			// Length of the cross product is twice the area.
+			const float a = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (size_t i = 0; i < 3; ++i)
+				cluster->centroid[i] += a * (p0[i] + p1[i] + p2[i]) / 3.0f,
+				cluster->normal[i] += n[i];
+
+			area += a;
+		}
+
+		for (size_t i = 0; i < 3; ++i)
+			center[i] += cluster->centroid[i];
+
+		totalArea += area;
+
+		const float len = sqrtf(
+			cluster->normal[0] * cluster->normal[0] +
+			cluster->normal[1] * cluster->normal[1] +
+			cluster->normal[2] * cluster->normal[2]);
+
+		for (size_t i = 0; i < 3; ++i)
+			cluster->centroid[i] *= (area > 0.0f) ? 1.0f / area : 0.0f,
+			cluster->normal[i] *= (len > 0.0f) ? 1.0f / len : 0.0f;
+	}
+
+	for (size_t i = 0; i < 3; ++i)
+		center[i] *= (totalArea > 0.0f) ? 1.0f / totalArea : 0.0f;
+
+	// Sort clusters that face outwards the most first,
+	// they are most likely to occlude the others.
+	for (size_t c = 0; c < numClusters; ++c)
+	{
+		GFXMeshCluster_* cluster = clusters + c;
+		cluster->key = 0.0f;
+
+		for (size_t i = 0; i < 3; ++i)
+			cluster->key +=
+				(cluster->centroid[i] - center[i]) * cluster->normal[i];
+	}
+
+	qsort(clusters, numClusters, sizeof(GFXMeshCluster_),
+		gfx_mesh_cmp_clusters_);
+
+	size_t out = 0;
+	for (size_t c = 0; c < numClusters; ++c)
+	{
+		const size_t size = (clusters[c].end - clusters[c].begin) * 3;
+		memcpy(sorted + out,
+			indices + clusters[c].begin * 3, sizeof(uint32_t) * size);
+
+		out += size;
+	}
+
+	memcpy(indices, sorted, sizeof(uint32_t) * numIndices);
+
+	free(cache);
+	free(clusters);
+	free(sorted);
+
+	return 1;
+}
+
+/****************************/
+GFX_API size_t gfx_mesh_optimize_fetch(size_t numIndices, uint32_t* indices,
+                                       size_t numVertices, uint32_t* remap)
+{
+	assert(numIndices == 0 || indices != NULL);
+	assert(remap != NULL);
+
+	for (size_t v = 0; v < numVertices; ++v)
+		remap[v] = UINT32_MAX;
+
+	// Assign new vertices in order of first reference.
+	uint32_t next = 0;
+
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		assert(indices[i] < numVertices);
+
+		if (remap[indices[i]] == UINT32_MAX)
+			remap[indices[i]] = next++;
+
+		indices[i] = remap[indices[i]];
+	}
+
+	return next;
+}
+
+/****************************/
+GFX_API size_t gfx_mesh_meshlets_bound(size_t numIndices,
+                                       unsigned int maxVertices,
+                                       unsigned int maxTriangles)
+{
+	assert(numIndices % 3 == 0);
+	assert(maxVertices >= 3);
+	assert(maxTriangles > 0);
+
+	// A meshlet is only closed when it cannot fit one more triangle,
+	// i.e. it has > maxVertices - 3 vertices or maxTriangles triangles,
+	// so all but the last have at least this many triangles.
+	const size_t numTriangles = numIndices / 3;
+	const size_t minTriangles = GFX_MIN(maxTriangles, maxVertices / 3);
+
+	return numTriangles > 0 ? (numTriangles - 1) / minTriangles + 1 : 0;
+}
+
+/****************************/
+GFX_API size_t gfx_mesh_build_meshlets(size_t numIndices, const uint32_t* indices,
+                                       size_t numVertices,
+                                       const void* positions, size_t stride,
+                                       unsigned int maxVertices,
+                                       unsigned int maxTriangles,
+                                       GFXMeshlet* meshlets,
+                                       uint32_t* vertices, uint8_t* triangles)
+{
+	assert(numIndices % 3 == 0);
+	assert(numIndices == 0 || indices != NULL);
+	assert(positions != NULL);
+	assert(maxVertices >= 3 && maxVertices <= UINT8_MAX);
+	assert(maxTriangles > 0);
+	assert(meshlets != NULL);
+	assert(vertices != NULL);
+	assert(triangles != NULL);
+
+	if (numIndices == 0)
+		return 0;
+
+	// Local index of each vertex in the current meshlet.
+	uint8_t* local = malloc(numVertices);
+	if (local == NULL) return 0;
+
+	memset(local, UINT8_MAX, numVertices);
+
+	GFXMeshlet meshlet = {
+		.vertexOffset = 0, .triangleOffset = 0,
+		.numVertices = 0, .numTriangles = 0
+	};
+
+	size_t numMeshlets = 0;
+
+	for (size_t i = 0; i <= numIndices; i += 3)
+	{
+		const uint32_t* tri = indices + i;
+		unsigned int newVertices = 0;
+
+		if (i < numIndices)
+			for (size_t v = 0; v < 3; ++v)
+				newVertices +=
+					local[tri[v]] == UINT8_MAX &&
+					(v < 1 || tri[v] != tri[0]) &&
+					(v < 2 || tri[v] != tri[1]);
+
+		// Close the current meshlet if full or at the end.
+		if (meshlet.numTriangles > 0 && (
+			i == numIndices ||
+			meshlet.numVertices + newVertices > maxVertices ||
+			meshlet.numTriangles >= maxTriangles))
+		{
+			gfx_mesh_meshlet_bounds_(
+				&meshlet, vertices, triangles, positions, stride);
+
+			for (uint32_t v = 0; v < meshlet.numVertices; ++v)
+				local[vertices[meshlet.vertexOffset + v]] = UINT8_MAX;
+
+			meshlets[numMeshlets++] = meshlet;
+			meshlet.vertexOffset += meshlet.numVertices;
+			meshlet.triangleOffset += meshlet.numTriangles;
+			meshlet.numVertices = 0;
+			meshlet.numTriangles = 0;
+		}
+
+		if (i == numIndices)
+			break;
+
+		// Add the triangle.
+		for (size_t v = 0; v < 3; ++v)
+		{
+			assert(tri[v] < numVertices);
+
+			if (local[tri[v]] == UINT8_MAX)
+				local[tri[v]] = (uint8_t)meshlet.numVertices,
+				vertices[meshlet.vertexOffset + meshlet.numVertices++] = tri[v];
+
+			triangles[(meshlet.triangleOffset + meshlet.numTriangles) * 3 + v] =
+				local[tri[v]];
+		}
+
+		++meshlet.numTriangles;
+	}
+
+	free(local);
+
+	return numMeshlets;
+}
+
+/****************************/
+GFX_API size_t gfx_mesh_simplify(size_t numIndices, const uint32_t* indices,
+                                 size_t numVertices,
+                                 const void* positions, size_t stride,
+                                 size_t targetIndices, float targetError,
+                                 uint32_t* dst, float* error)
+{
+	assert(numIndices % 3 == 0);
+	assert(numIndices == 0 || indices != NULL);
+	assert(positions != NULL);
+	assert(numIndices == 0 || dst != NULL);
+
+	if (error != NULL) *error = 0.0f;
+	if (numIndices > 0) memmove(dst, indices, sizeof(uint32_t) * numIndices);
+
+	if (numIndices <= targetIndices || numVertices == 0)
+		return numIndices;
+
+	// Allocate all scratch memory at once.
+	size_t edgeCap = 1;
+	while (edgeCap < numIndices * 2) edgeCap <<= 1;
+
+	size_t vertCap = 1;
+	while (vertCap < numVertices * 2) vertCap <<= 1;
+
+	float* pos = malloc(sizeof(float) * 3 * numVertices);
+	GFXMeshQuadric_* quadrics = calloc(numVertices, sizeof(GFXMeshQuadric_));
+	uint32_t* wedges = malloc(sizeof(uint32_t) * numVertices);
+	uint32_t* remap = malloc(sizeof(uint32_t) * numVertices);
+	uint8_t* flags = calloc(numVertices, sizeof(uint8_t));
+	uint32_t* table = malloc(sizeof(uint32_t) * vertCap);
+	uint64_t* edges = malloc(sizeof(uint64_t) * edgeCap);
+	uint8_t* counts = malloc(edgeCap);
+	size_t* adjacency = malloc(sizeof(size_t) * (numVertices + 1 + numIndices));
+	GFXMeshCollapse_* collapses = malloc(sizeof(GFXMeshCollapse_) * numVertices);
+
+	if (
+		pos == NULL || quadrics == NULL || wedges == NULL || remap == NULL ||
+		flags == NULL || table == NULL || edges == NULL || counts == NULL ||
+		adjacency == NULL || collapses == NULL)
+	{
+		goto clean;
+	}
+
+	// Normalize positions to the unit cube, so errors are relative.
+	float min[3] = { INFINITY, INFINITY, INFINITY };
+	float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+	for (size_t v = 0; v < numVertices; ++v)
+	{
+		const float* p = gfx_mesh_pos_(positions, stride, (uint32_t)v);
+		for (size_t c = 0; c < 3; ++c)
+			min[c] = GFX_MIN(min[c], p[c]),
+			max[c] = GFX_MAX(max[c], p[c]);
+	}
+
+	const float extent = GFX_MAX(max[0] - min[0],
+		GFX_MAX(max[1] - min[1], max[2] - min[2]));
+	const float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+	for (size_t v = 0; v < numVertices; ++v)
+	{
+		const float* p = gfx_mesh_pos_(positions, stride, (uint32_t)v);
+		for (size_t c = 0; c < 3; ++c)
+			pos[v * 3 + c] = (p[c] - min[c]) * scale;
+	}
+
+	// Find vertices with equal positions (i.e. attribute seams),
+	// wedges[v] is the first vertex with the same position as v.
+	for (size_t s = 0; s < vertCap; ++s)
+		table[s] = UINT32_MAX;
+
+	for (size_t v = 0; v < numVertices; ++v)
+	{
+		uint32_t bits[3];
+		memcpy(bits, pos + v * 3, sizeof(bits));
+
+		size_t s = (bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u)
+			& (vertCap - 1);
+
+		while (table[s] != UINT32_MAX &&
+			memcmp(pos + table[s] * 3, pos + v * 3, sizeof(float) * 3))
+		{
+			s = (s + 1) & (vertCap - 1);
+		}
+
+		if (table[s] == UINT32_MAX)
+			table[s] = (uint32_t)v;
+		else
+			// Lock all vertices on a seam.
+			flags[table[s]] |= GFX_MESH_LOCKED_,
+			flags[v] |= GFX_MESH_LOCKED_;
+
+		wedges[v] = table[s];
+	}
+
+	// Find border & non-manifold edges using directed edges of wedges,
+	// each interior edge must have exactly one opposite.
+	for (size_t s = 0; s < edgeCap; ++s)
+		edges[s] = UINT64_MAX;
+
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		const size_t e = gfx_mesh_edge_(edges, edgeCap,
+			wedges[indices[i]], wedges[indices[i - i % 3 + (i + 1) % 3]]);
+
+		counts[e] = (uint8_t)(edges[e] == UINT64_MAX ? 1 : GFX_MIN(counts[e] + 1, 2));
+		edges[e] = GFX_MESH_EDGE_KEY_(
+			wedges[indices[i]], wedges[indices[i - i % 3 + (i + 1) % 3]]);
+	}
+
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		const uint32_t a = wedges[indices[i]];
+		const uint32_t b = wedges[indices[i - i % 3 + (i + 1) % 3]];
+
+		if (a == b) continue;
+
+		const size_t e = gfx_mesh_edge_(edges, edgeCap, a, b);
+		const size_t o = gfx_mesh_edge_(edges, edgeCap, b, a);
+
+		if (counts[e] != 1 || edges[o] == UINT64_MAX || counts[o] != 1)
+			flags[a] |= GFX_MESH_LOCKED_,
+			flags[b] |= GFX_MESH_LOCKED_;
+	}
+
+	for (size_t v = 0; v < numVertices; ++v)
+		flags[v] |= flags[wedges[v]] & GFX_MESH_LOCKED_;
+
+	// Accumulate area-weighted plane quadrics.
+	for (size_t i = 0; i < numIndices; i += 3)
+	{
+		GFXMeshQuadric_ q;
+		gfx_mesh_quadric_(&q,
+			pos + indices[i + 0] * 3,
+			pos + indices[i + 1] * 3,
+			pos + indices[i + 2] * 3);
+
+		for (size_t v = 0; v < 3; ++v)
+			gfx_mesh_quadric_add_(quadrics + wedges[indices[i + v]], &q);
+	}
+
+	for (size_t v = 0; v < numVertices; ++v)
+		if (wedges[v] != v)
+			quadrics[v] = quadrics[wedges[v]];
+
+	// Collapse edges in passes, cheapest first.
+	const double maxError = (double)targetError * (double)targetError;
+	double result = 0.0;
+	size_t current = numIndices;
+
+	while (current > targetIndices)
+	{
+		// Build vertex -> triangle adjacency.
+		size_t* offsets = adjacency;
+		size_t* triangles = adjacency + numVertices + 1;
+
+		memset(offsets, 0, sizeof(size_t) * (numVertices + 1));
+
+		for (size_t i = 0; i < current; ++i)
+			++offsets[dst[i] + 1];
+
+		for (size_t v = 0; v < numVertices; ++v)
+			offsets[v + 1] += offsets[v];
+
+		for (size_t i = 0; i < current; ++i)
+			triangles[offsets[dst[i]]++] = i / 3;
+
+		for (size_t v = numVertices; v > 0; --v)
+			offsets[v] = offsets[v - 1];
+
+		offsets[0] = 0;
+
+		// Find the cheapest collapse of each unlocked vertex.
+		size_t numCollapses = 0;
+
+		for (size_t v = 0; v < numVertices; ++v)
+			remap[v] = (uint32_t)v,
+			flags[v] &= (uint8_t)~GFX_MESH_TOUCHED_;
+
+		for (size_t i = 0; i < current; ++i)
+		{
+			const uint32_t a = dst[i];
+			const uint32_t b = dst[i - i % 3 + (i + 1) % 3];
+
+			for (size_t d = 0; d < 2; ++d)
+			{
+				const uint32_t from = d ? b : a;
+				const uint32_t to = d ? a : b;
+
+				if ((flags[from] & GFX_MESH_LOCKED_) || from == to)
+					continue;
+
+				GFXMeshQuadric_ q = quadrics[from];
+				gfx_mesh_quadric_add_(&q, quadrics + to);
+
+				const double cost = gfx_mesh_quadric_error_(&q, pos + to * 3);
+
+				if (cost > maxError)
+					continue;
+
+				if (remap[from] == from)
+					collapses[numCollapses++] = (GFXMeshCollapse_){
+						.from = from, .to = to, .cost = cost
+					},
+					remap[from] = (uint32_t)(numCollapses - 1) | 0x80000000u;
+				else
+				{
+					GFXMeshCollapse_* c = collapses + (remap[from] & 0x7FFFFFFFu);
+					if (cost < c->cost) c->to = to, c->cost = cost;
+				}
+			}
+		}
+
+		if (numCollapses == 0)
+			break;
+
+		qsort(collapses, numCollapses, sizeof(GFXMeshCollapse_),
+			gfx_mesh_cmp_collapses_);
+
+		for (size_t v = 0; v < numVertices; ++v)
+			remap[v] = (uint32_t)v;
+
+		// Perform collapses until the target is (approximately) reached,
+		// touching vertices only once per pass.
+		size_t removed = 0;
+
+		for (size_t c = 0; c < numCollapses; ++c)
+		{
+			const uint32_t from = collapses[c].from;
+			const uint32_t to = collapses[c].to;
+
+			if (current - removed <= targetIndices)
+				break;
+
+			if ((flags[from] | flags[to]) & GFX_MESH_TOUCHED_)
+				continue;
+
+			if (gfx_mesh_flips_(dst, offsets, triangles, pos, from, to))
+				continue;
+
+			remap[from] = to;
+			gfx_mesh_quadric_add_(quadrics + to, quadrics + from);
+			result = GFX_MAX(result, collapses[c].cost);
+
+			// Touch all vertices around from, as their triangles change.
+			for (size_t t = offsets[from]; t < offsets[from + 1]; ++t)
+				for (size_t v = 0; v < 3; ++v)
+					flags[dst[triangles[t] * 3 + v]] |= GFX_MESH_TOUCHED_;
+
+			// Interior edges remove two triangles.
+			removed += 6;
+		}
+
+		// Apply collapses & remove degenerate triangles.
+		size_t out = 0;
+
+		for (size_t i = 0; i < current; i += 3)
+		{
+			const uint32_t a = remap[dst[i + 0]];
+			const uint32_t b = remap[dst[i + 1]];
+			const uint32_t c = remap[dst[i + 2]];
+
+			if (a != b && b != c && c != a)
+				dst[out++] = a,
+				dst[out++] = b,
+				dst[out++] = c;
+		}
+
+		if (out == current)
+			break;
+
+		current = out;
+	}
+
+	if (error != NULL)
+		*error = (float)sqrt(result);
+
+	free(pos);
+	free(quadrics);
+	free(wedges);
+	free(remap);
+	free(flags);
+	free(table);
+	free(edges);
+	free(counts);
+	free(adjacency);
+	free(collapses);
+
+	return current;
+
+
+	// Cleanup on failure.
+clean:
+	free(pos);
+	free(quadrics);
+	free(wedges);
+	free(remap);
+	free(flags);
+	free(table);
+	free(edges);
+	free(counts);
+	free(adjacency);
+	free(collapses);
+
+	return numIndices;
+}
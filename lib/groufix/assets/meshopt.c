@@ -0,0 +1,716 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/assets/mesh.h"
+#include <math.h>
+#include <string.h>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+	(defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define GFX_MESHOPT_SSE2_
+#endif
+
+
+// Codec headers, the low 4 bits hold the version.
+#define GFX_MESHOPT_VERTEX_HEADER_   0xa0
+#define GFX_MESHOPT_INDEX_HEADER_    0xe0
+#define GFX_MESHOPT_SEQUENCE_HEADER_ 0xd0
+
+
+// Vertex codec constants.
+#define GFX_MESHOPT_BLOCK_BYTES_   8192
+#define GFX_MESHOPT_BLOCK_MAX_     256
+#define GFX_MESHOPT_GROUP_SIZE_    16
+#define GFX_MESHOPT_GROUP_LIMIT_   24 // Max #bytes read by a byte group.
+#define GFX_MESHOPT_TAIL_MIN_      32
+
+
+// Undoes zigzag encoding of a byte.
+#define GFX_MESHOPT_UNZIGZAG8_(v) \
+	(unsigned char)((0u - ((v) & 1u)) ^ ((unsigned int)(v) >> 1))
+
+// Undoes zigzag encoding of a 32-bit delta.
+#define GFX_MESHOPT_UNZIGZAG32_(v) \
+	(((v) >> 1) ^ (0u - ((v) & 1u)))
+
+// Rounds a float to the nearest integer, halfway cases away from zero.
+#define GFX_MESHOPT_ROUND_(f) \
+	(int)((f) + ((f) >= 0.0f ? 0.5f : -0.5f))
+
+
+/****************************
+ * Reads a variable length (7 bits per byte) integer.
+ * The caller must guarantee there are at least 5 bytes to read.
+ */
+static uint32_t gfx_meshopt_vbyte_(const unsigned char** data)
+{
+	const unsigned char* d = *data;
+	uint32_t result = *(d++);
+
+	if (result >= 128)
+	{
+		result &= 127;
+
+		for (unsigned int shift = 7; shift < 35; shift += 7)
+		{
+			const unsigned char group = *(d++);
+			result |= (uint32_t)(group & 127) << shift;
+
+			if (group < 128) break;
+		}
+	}
+
+	*data = d;
+	return result;
+}
+
+/****************************
+ * Reads a zigzag encoded delta to the last index.
+ */
+static inline uint32_t gfx_meshopt_index_(const unsigned char** data,
+                                          uint32_t last)
+{
+	const uint32_t v = gfx_meshopt_vbyte_(data);
+	return last + GFX_MESHOPT_UNZIGZAG32_(v);
+}
+
+/****************************
+ * Decodes a single group of 16 bytes.
+ * @param bits Log2 of the #bits per byte (0 = all zero, 3 = raw).
+ * @return Past the end of the group's data.
+ *
+ * The caller must guarantee GFX_MESHOPT_GROUP_LIMIT_ bytes can be read.
+ */
+static const unsigned char* gfx_meshopt_group_(const unsigned char* data,
+                                               unsigned char* out,
+                                               unsigned int bits)
+{
+	switch (bits)
+	{
+	case 0:
+		memset(out, 0, GFX_MESHOPT_GROUP_SIZE_);
+		return data;
+
+	case 3:
+		memcpy(out, data, GFX_MESHOPT_GROUP_SIZE_);
+		return data + GFX_MESHOPT_GROUP_SIZE_;
+
+	default:
+	{
+		// 2 or 4 bits per value, the all-ones value means an extra byte.
+		// The extra bytes follow the packed values.
+		const unsigned int b = 1u << bits;
+		const unsigned int sentinel = (1u << b) - 1;
+		const unsigned char* extra = data + GFX_MESHOPT_GROUP_SIZE_ * b / 8;
+
+		for (size_t i = 0; i < GFX_MESHOPT_GROUP_SIZE_; ++i)
+		{
+			const unsigned int shift = 8 - b - (unsigned int)(i * b % 8);
+			const unsigned int enc = (data[i * b / 8] >> shift) & sentinel;
+
+			out[i] = (enc == sentinel) ? *extra : (unsigned char)enc;
+			extra += (enc == sentinel);
+		}
+
+		return extra;
+	}
+	}
+}
+
+/****************************
+ * Decodes a stream of byte groups.
+ * @param size Number of bytes to decode, must be a multiple of 16.
+ * @return Past the end of the decoded data, NULL if out of bounds.
+ */
+static const unsigned char* gfx_meshopt_bytes_(const unsigned char* data,
+                                               const unsigned char* end,
+                                               unsigned char* out, size_t size)
+{
+	// 2 bits of header for each group.
+	const unsigned char* header = data;
+	const size_t numGroups = size / GFX_MESHOPT_GROUP_SIZE_;
+	const size_t headerSize = (numGroups + 3) / 4;
+
+	if ((size_t)(end - data) < headerSize)
+		return NULL;
+
+	data += headerSize;
+
+	for (size_t g = 0; g < numGroups; ++g)
+	{
+		if ((size_t)(end - data) < GFX_MESHOPT_GROUP_LIMIT_)
+			return NULL;
+
+		const unsigned int bits = (header[g / 4] >> ((g % 4) * 2)) & 3u;
+		data = gfx_meshopt_group_(data, out + g * GFX_MESHOPT_GROUP_SIZE_, bits);
+	}
+
+	return data;
+}
+
+#if defined (GFX_MESHOPT_SSE2_)
+
+/****************************
+ * Unzigzags & prefix sums 16 deltas, SSE2 version.
+ * @param p Value preceding the first delta.
+ * @return The last decoded value.
+ */
+static unsigned char gfx_meshopt_deltas_(unsigned char* bytes, unsigned char p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)bytes);
+
+	// Unzigzag.
+	const __m128i odd = _mm_and_si128(v, _mm_set1_epi8(1));
+	const __m128i half = _mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7f));
+	v = _mm_xor_si128(half, _mm_sub_epi8(_mm_setzero_si128(), odd));
+
+	// Inclusive prefix sum in log2(16) steps.
+	v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+	v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+	v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+	v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+	v = _mm_add_epi8(v, _mm_set1_epi8((char)p));
+
+	_mm_storeu_si128((__m128i*)bytes, v);
+
+	return bytes[GFX_MESHOPT_GROUP_SIZE_ - 1];
+}
+
+#else
+
+/****************************
+ * Unzigzags & prefix sums 16 deltas, scalar version.
+ * @see the SSE2 version.
+ */
+static unsigned char gfx_meshopt_deltas_(unsigned char* bytes, unsigned char p)
+{
+	for (size_t i = 0; i < GFX_MESHOPT_GROUP_SIZE_; ++i)
+		p = bytes[i] = (unsigned char)(GFX_MESHOPT_UNZIGZAG8_(bytes[i]) + p);
+
+	return p;
+}
+
+#endif
+
+/****************************
+ * Decodes a single block of vertices.
+ * @param last Last decoded vertex, updated to the last vertex of the block.
+ * @return Past the end of the block's data, NULL if out of bounds.
+ */
+static const unsigned char* gfx_meshopt_block_(const unsigned char* data,
+                                               const unsigned char* end,
+                                               unsigned char* vertices,
+                                               size_t numVertices, size_t stride,
+                                               unsigned char* last)
+{
+	unsigned char bytes[GFX_MESHOPT_BLOCK_MAX_];
+
+	const size_t aligned =
+		GFX_ALIGN_UP(numVertices, (size_t)GFX_MESHOPT_GROUP_SIZE_);
+
+	// Each byte of the vertex is stored as a separate stream of deltas.
+	for (size_t k = 0; k < stride; ++k)
+	{
+		data = gfx_meshopt_bytes_(data, end, bytes, aligned);
+		if (data == NULL) return NULL;
+
+		unsigned char p = last[k];
+
+		for (size_t i = 0; i < aligned; i += GFX_MESHOPT_GROUP_SIZE_)
+			p = gfx_meshopt_deltas_(bytes + i, p);
+
+		for (size_t v = 0; v < numVertices; ++v)
+			vertices[v * stride + k] = bytes[v];
+	}
+
+	memcpy(last, vertices + (numVertices - 1) * stride, stride);
+
+	return data;
+}
+
+/****************************/
+GFX_API bool gfx_mesh_decode_vertices(size_t numVertices, size_t stride,
+                                      size_t size, const void* src, void* dst)
+{
+	assert(stride > 0 && stride <= 256 && stride % 4 == 0);
+	assert(src != NULL);
+	assert(dst != NULL);
+
+	const unsigned char* data = src;
+	const unsigned char* end = data + size;
+	const size_t tail = GFX_MAX(stride, (size_t)GFX_MESHOPT_TAIL_MIN_);
+
+	if (
+		size < 1 + tail ||
+		(data[0] & 0xf0) != GFX_MESHOPT_VERTEX_HEADER_ ||
+		(data[0] & 0x0f) > 0)
+	{
+		return 0;
+	}
+
+	++data;
+
+	// The first vertex is stored at the end of the tail.
+	unsigned char last[256];
+	memcpy(last, end - stride, stride);
+
+	// Blocks span at most 8KiB of vertex data.
+	const size_t blockSize = GFX_MIN(
+		(size_t)GFX_MESHOPT_BLOCK_MAX_,
+		(GFX_MESHOPT_BLOCK_BYTES_ / stride) & ~(size_t)(GFX_MESHOPT_GROUP_SIZE_ - 1));
+
+	for (size_t v = 0; v < numVertices; v += blockSize)
+	{
+		data = gfx_meshopt_block_(data, end,
+			(unsigned char*)dst + v * stride,
+			GFX_MIN(blockSize, numVertices - v), stride, last);
+
+		if (data == NULL)
+			return 0;
+	}
+
+	return (size_t)(end - data) == tail;
+}
+
+/****************************
+ * Writes a single triangle to the output indices.
+ */
+static inline void gfx_meshopt_tri_(void* dst, size_t i, size_t indexSize,
+                                    uint32_t a, uint32_t b, uint32_t c)
+{
+	if (indexSize == sizeof(uint16_t))
+		((uint16_t*)dst)[i + 0] = (uint16_t)a,
+		((uint16_t*)dst)[i + 1] = (uint16_t)b,
+		((uint16_t*)dst)[i + 2] = (uint16_t)c;
+	else
+		((uint32_t*)dst)[i + 0] = a,
+		((uint32_t*)dst)[i + 1] = b,
+		((uint32_t*)dst)[i + 2] = c;
+}
+
+/****************************/
+GFX_API bool gfx_mesh_decode_triangles(size_t numIndices, size_t indexSize,
+                                       size_t size, const void* src, void* dst)
+{
+	assert(numIndices % 3 == 0);
+	assert(indexSize == sizeof(uint16_t) || indexSize == sizeof(uint32_t));
+	assert(src != NULL);
+	assert(dst != NULL);
+
+	const unsigned char* buff = src;
+
+	// At least a header, one code per triangle & the auxiliary code table.
+	if (
+		size < 1 + numIndices / 3 + 16 ||
+		(buff[0] & 0xf0) != GFX_MESHOPT_INDEX_HEADER_ ||
+		(buff[0] & 0x0f) > 1)
+	{
+		return 0;
+	}
+
+	const unsigned int fecMax = (buff[0] & 0x0f) >= 1 ? 13 : 15;
+
+	// Edge & vertex FIFOs, both 16 entries.
+	uint32_t edges[16][2];
+	uint32_t verts[16];
+	unsigned int edgeOffset = 0;
+	unsigned int vertOffset = 0;
+
+	memset(edges, 0xff, sizeof(edges));
+	memset(verts, 0xff, sizeof(verts));
+
+#define GFX_PUSH_EDGE_(a, b) \
+	(edges[edgeOffset][0] = (a), edges[edgeOffset][1] = (b), \
+	edgeOffset = (edgeOffset + 1) & 15)
+
+#define GFX_PUSH_VERT_(v, cond) \
+	(verts[vertOffset] = (v), vertOffset = (vertOffset + (cond)) & 15)
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+
+	const unsigned char* code = buff + 1;
+	const unsigned char* data = code + numIndices / 3;
+	const unsigned char* safe = buff + size - 16;
+	const unsigned char* aux = safe;
+
+	for (size_t i = 0; i < numIndices; i += 3)
+	{
+		// A triangle reads at most 16 bytes, the aux table is 16 bytes.
+		if (data > safe)
+			return 0;
+
+		const unsigned char codeTri = *(code++);
+
+		if (codeTri < 0xf0)
+		{
+			// Reuse an edge from the FIFO.
+			const unsigned int fe = codeTri >> 4u;
+			const uint32_t a = edges[(edgeOffset - 1 - fe) & 15][0];
+			const uint32_t b = edges[(edgeOffset - 1 - fe) & 15][1];
+			const unsigned int fec = codeTri & 15u;
+			uint32_t c;
+
+			if (fec < fecMax)
+			{
+				// New vertex or from the FIFO.
+				c = (fec == 0) ? next : verts[(vertOffset - 1 - fec) & 15];
+				next += (fec == 0);
+				GFX_PUSH_VERT_(c, fec == 0);
+			}
+			else
+			{
+				// Explicit index, 13 and 14 decode as -1 and 1.
+				last = c = (fec != 15) ?
+					last + (uint32_t)((int)fec - (int)(fec ^ 3)) :
+					gfx_meshopt_index_(&data, last);
+
+				GFX_PUSH_VERT_(c, 1);
+			}
+
+			gfx_meshopt_tri_(dst, i, indexSize, a, b, c);
+			GFX_PUSH_EDGE_(c, b);
+			GFX_PUSH_EDGE_(a, c);
+		}
+		else
+		{
+			// No shared edge, codes for b & c are in the aux table or data.
+			const unsigned char codeAux =
+				(codeTri < 0xfe) ? aux[codeTri & 15] : *(data++);
+
+			const unsigned int fea = (codeTri == 0xff) ? 15 : 0;
+			const unsigned int feb = codeAux >> 4u;
+			const unsigned int fec = codeAux & 15u;
+
+			if (codeTri >= 0xfe && codeAux == 0)
+				next = 0; // Reset.
+
+			uint32_t a = (fea == 0) ? next++ : 0;
+			uint32_t b = (feb == 0) ? next++ : verts[(vertOffset - feb) & 15];
+			uint32_t c = (fec == 0) ? next++ : verts[(vertOffset - fec) & 15];
+
+			if (codeTri >= 0xfe)
+			{
+				if (fea == 15) last = a = gfx_meshopt_index_(&data, last);
+				if (feb == 15) last = b = gfx_meshopt_index_(&data, last);
+				if (fec == 15) last = c = gfx_meshopt_index_(&data, last);
+			}
+
+			gfx_meshopt_tri_(dst, i, indexSize, a, b, c);
+
+			const bool full = codeTri >= 0xfe;
+
+			GFX_PUSH_VERT_(a, 1);
+			GFX_PUSH_VERT_(b, feb == 0 || (full && feb == 15));
+			GFX_PUSH_VERT_(c, fec == 0 || (full && fec == 15));
+
+			GFX_PUSH_EDGE_(b, a);
+			GFX_PUSH_EDGE_(c, b);
+			GFX_PUSH_EDGE_(a, c);
+		}
+	}
+
+#undef GFX_PUSH_EDGE_
+#undef GFX_PUSH_VERT_
+
+	// All data must be consumed, up to the aux table.
+	return data == safe;
+}
+
+/****************************/
+GFX_API bool gfx_mesh_decode_indices(size_t numIndices, size_t indexSize,
+                                     size_t size, const void* src, void* dst)
+{
+	assert(indexSize == sizeof(uint16_t) || indexSize == sizeof(uint32_t));
+	assert(src != NULL);
+	assert(dst != NULL);
+
+	const unsigned char* buff = src;
+
+	// At least a header, one byte per index & a 4 byte tail.
+	if (
+		size < 1 + numIndices + 4 ||
+		(buff[0] & 0xf0) != GFX_MESHOPT_SEQUENCE_HEADER_ ||
+		(buff[0] & 0x0f) > 1)
+	{
+		return 0;
+	}
+
+	const unsigned char* data = buff + 1;
+	const unsigned char* safe = buff + size - 4;
+	uint32_t last[2] = { 0, 0 };
+
+	for (size_t i = 0; i < numIndices; ++i)
+	{
+		// An index reads at most 5 bytes, the tail is 4 bytes.
+		if (data >= safe)
+			return 0;
+
+		// The lowest bit selects the baseline, the rest is the delta.
+		const uint32_t v = gfx_meshopt_vbyte_(&data);
+		const uint32_t base = v & 1;
+		const uint32_t index =
+			last[base] + GFX_MESHOPT_UNZIGZAG32_(v >> 1);
+
+		last[base] = index;
+
+		if (indexSize == sizeof(uint16_t))
+			((uint16_t*)dst)[i] = (uint16_t)index;
+		else
+			((uint32_t*)dst)[i] = index;
+	}
+
+	return data == safe;
+}
+
+#if defined (GFX_MESHOPT_SSE2_)
+
+/****************************
+ * Octahedral filter of 4 int16 vectors, SSE2 version.
+ * @param a    First 2 vectors, updated in-place.
+ * @param b    Last 2 vectors, updated in-place.
+ * @param max  Maximum value of a component.
+ */
+static void gfx_meshopt_oct4_(__m128i* a, __m128i* b, float max)
+{
+	// Deinterleave into xxxxyyyy and zzzzwwww.
+	const __m128i t0 = _mm_unpacklo_epi16(*a, *b);
+	const __m128i t1 = _mm_unpackhi_epi16(*a, *b);
+	const __m128i xy = _mm_unpacklo_epi16(t0, t1);
+	const __m128i zw = _mm_unpackhi_epi16(t0, t1);
+
+	// Sign extend to floats.
+	__m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(xy, xy), 16));
+	__m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(xy, xy), 16));
+	__m128 z = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(zw, zw), 16));
+
+	// Reconstruct z & fixup for z < 0.
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	z = _mm_sub_ps(z,
+		_mm_add_ps(_mm_andnot_ps(sign, x), _mm_andnot_ps(sign, y)));
+
+	const __m128 t = _mm_min_ps(z, _mm_setzero_ps());
+	const __m128 xs = _mm_cmplt_ps(x, _mm_setzero_ps());
+	const __m128 ys = _mm_cmplt_ps(y, _mm_setzero_ps());
+
+	x = _mm_add_ps(x, _mm_xor_ps(t, _mm_and_ps(xs, sign)));
+	y = _mm_add_ps(y, _mm_xor_ps(t, _mm_and_ps(ys, sign)));
+
+	// Normalize & round halfway cases away from zero.
+	const __m128 l = _mm_sqrt_ps(_mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+	const __m128 s = _mm_div_ps(_mm_set1_ps(max), l);
+
+	x = _mm_mul_ps(x, s);
+	y = _mm_mul_ps(y, s);
+	z = _mm_mul_ps(z, s);
+
+	x = _mm_add_ps(x, _mm_or_ps(half, _mm_and_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), sign)));
+	y = _mm_add_ps(y, _mm_or_ps(half, _mm_and_ps(_mm_cmplt_ps(y, _mm_setzero_ps()), sign)));
+	z = _mm_add_ps(z, _mm_or_ps(half, _mm_and_ps(_mm_cmplt_ps(z, _mm_setzero_ps()), sign)));
+
+	// Pack (keeping w) & interleave again.
+	const __m128i xy2 = _mm_packs_epi32(_mm_cvttps_epi32(x), _mm_cvttps_epi32(y));
+	const __m128i zw2 = _mm_packs_epi32(_mm_cvttps_epi32(z),
+		_mm_srai_epi32(_mm_unpackhi_epi16(zw, zw), 16));
+
+	const __m128i u0 = _mm_unpacklo_epi16(xy2, zw2);
+	const __m128i u1 = _mm_unpackhi_epi16(xy2, zw2);
+
+	*a = _mm_unpacklo_epi16(u0, u1);
+	*b = _mm_unpackhi_epi16(u0, u1);
+}
+
+#endif
+
+/****************************
+ * Octahedral filter of a single vector.
+ * @param v   Input/output xyz.
+ * @param max Maximum value of a component.
+ */
+static void gfx_meshopt_oct_(int* v, float max)
+{
+	float x = (float)v[0];
+	float y = (float)v[1];
+	float z = (float)v[2] - fabsf(x) - fabsf(y);
+
+	const float t = (z >= 0.0f) ? 0.0f : z;
+	x += (x >= 0.0f) ? t : -t;
+	y += (y >= 0.0f) ? t : -t;
+
+	const float s = max / sqrtf(x * x + y * y + z * z);
+	v[0] = GFX_MESHOPT_ROUND_(x * s);
+	v[1] = GFX_MESHOPT_ROUND_(y * s);
+	v[2] = GFX_MESHOPT_ROUND_(z * s);
+}
+
+/****************************
+ * Applies the octahedral filter to 4x int8 or 4x int16 vectors.
+ */
+static void gfx_meshopt_filter_oct_(size_t count, size_t stride, void* data)
+{
+	size_t i = 0;
+
+#if defined (GFX_MESHOPT_SSE2_)
+	// 4 vectors at a time.
+	if (stride == sizeof(int8_t) * 4)
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i* p = (__m128i*)((int8_t*)data + i * 4);
+			const __m128i v = _mm_loadu_si128(p);
+
+			// Sign extend to int16 & pack back after.
+			__m128i a = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+			__m128i b = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+
+			gfx_meshopt_oct4_(&a, &b, 127.0f);
+			_mm_storeu_si128(p, _mm_packs_epi16(a, b));
+		}
+	else
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i* p = (__m128i*)((int16_t*)data + i * 4);
+			__m128i a = _mm_loadu_si128(p);
+			__m128i b = _mm_loadu_si128(p + 1);
+
+			gfx_meshopt_oct4_(&a, &b, 32767.0f);
+			_mm_storeu_si128(p, a);
+			_mm_storeu_si128(p + 1, b);
+		}
+#endif
+
+	// Remaining vectors.
+	for (; i < count; ++i)
+		if (stride == sizeof(int8_t) * 4)
+		{
+			int8_t* e = (int8_t*)data + i * 4;
+			int v[3] = { e[0], e[1], e[2] };
+			gfx_meshopt_oct_(v, 127.0f);
+
+			e[0] = (int8_t)v[0];
+			e[1] = (int8_t)v[1];
+			e[2] = (int8_t)v[2];
+		}
+		else
+		{
+			int16_t* e = (int16_t*)data + i * 4;
+			int v[3] = { e[0], e[1], e[2] };
+			gfx_meshopt_oct_(v, 32767.0f);
+
+			e[0] = (int16_t)v[0];
+			e[1] = (int16_t)v[1];
+			e[2] = (int16_t)v[2];
+		}
+}
+
+/****************************
+ * Applies the quaternion filter to 4x int16 quaternions.
+ */
+static void gfx_meshopt_filter_quat_(size_t count, int16_t* data)
+{
+	const float scale = 1.0f / sqrtf(2.0f);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		int16_t* q = data + i * 4;
+
+		// The scale is stored in the high bits of the 4th component,
+		// the index of the largest (omitted) component in the low 2 bits.
+		const float ss = scale / (float)(q[3] | 3);
+		const unsigned int qc = (unsigned int)q[3] & 3;
+
+		const float x = (float)q[0] * ss;
+		const float y = (float)q[1] * ss;
+		const float z = (float)q[2] * ss;
+		const float ww = 1.0f - x * x - y * y - z * z;
+		const float w = sqrtf(ww >= 0.0f ? ww : 0.0f);
+
+		q[(qc + 1) & 3] = (int16_t)GFX_MESHOPT_ROUND_(x * 32767.0f);
+		q[(qc + 2) & 3] = (int16_t)GFX_MESHOPT_ROUND_(y * 32767.0f);
+		q[(qc + 3) & 3] = (int16_t)GFX_MESHOPT_ROUND_(z * 32767.0f);
+		q[(qc + 0) & 3] = (int16_t)(int)(w * 32767.0f + 0.5f);
+	}
+}
+
+/****************************
+ * Applies the exponential filter to 32-bit values.
+ * Each value holds a 24-bit signed mantissa and an 8-bit signed exponent.
+ */
+static void gfx_meshopt_filter_exp_(size_t count, uint32_t* data)
+{
+	size_t i = 0;
+
+#if defined (GFX_MESHOPT_SSE2_)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i* p = (__m128i*)(data + i);
+		const __m128i v = _mm_loadu_si128(p);
+
+		const __m128i m = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+		const __m128i e = _mm_srai_epi32(v, 24);
+		const __m128 s = _mm_castsi128_ps(
+			_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23));
+
+		_mm_storeu_si128(p,
+			_mm_castps_si128(_mm_mul_ps(s, _mm_cvtepi32_ps(m))));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const int32_t m = (int32_t)(data[i] << 8) >> 8;
+		const int32_t e = (int32_t)data[i] >> 24;
+
+		// ldexpf(m, e) by constructing 2^e directly.
+		uint32_t u = (uint32_t)(e + 127) << 23;
+		float f;
+		memcpy(&f, &u, sizeof(f));
+
+		f *= (float)m;
+		memcpy(data + i, &f, sizeof(f));
+	}
+}
+
+/****************************/
+GFX_API bool gfx_mesh_decode_filter(GFXMeshFilter filter,
+                                    size_t count, size_t stride, void* data)
+{
+	assert(data != NULL || count == 0);
+
+	switch (filter)
+	{
+	case GFX_MESH_FILTER_NONE:
+		return 1;
+
+	case GFX_MESH_FILTER_OCTAHEDRAL:
+		if (stride != sizeof(int8_t) * 4 && stride != sizeof(int16_t) * 4)
+			return 0;
+
+		gfx_meshopt_filter_oct_(count, stride, data);
+		return 1;
+
+	case GFX_MESH_FILTER_QUATERNION:
+		if (stride != sizeof(int16_t) * 4)
+			return 0;
+
+		gfx_meshopt_filter_quat_(count, data);
+		return 1;
+
+	case GFX_MESH_FILTER_EXPONENTIAL:
+		if (stride == 0 || stride % sizeof(uint32_t) != 0)
+			return 0;
+
+		gfx_meshopt_filter_exp_(count * (stride / sizeof(uint32_t)), data);
+		return 1;
+	}
+
+	return 0;
+}
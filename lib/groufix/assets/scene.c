@@ -0,0 +1,422 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/assets/scene.h"
+#include "groufix/core/log.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+	(defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define GFX_SCENE_SSE2_
+#endif
+
+
+// Floats per matrix & per bounding box.
+#define GFX_SCENE_MAT_SIZE_    16
+#define GFX_SCENE_BOUNDS_SIZE_ 8
+
+
+// Identity matrix.
+static const float gfx_scene_identity_[GFX_SCENE_MAT_SIZE_] = {
+	1.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 1.0f
+};
+
+
+/****************************
+ * Writes empty bounds (min > max).
+ */
+static void gfx_scene_empty_(float* bounds)
+{
+	for (size_t c = 0; c < 3; ++c)
+		bounds[c] = INFINITY,
+		bounds[c + 4] = -INFINITY;
+
+	bounds[3] = 1.0f;
+	bounds[7] = 1.0f;
+}
+
+#if defined (GFX_SCENE_SSE2_)
+
+/****************************
+ * Computes the world matrix & bounds of a single node, SSE2 version.
+ * @param world  Output world matrix.
+ * @param bounds Output world-space bounds.
+ * @param parent World matrix of the parent.
+ * @param local  Local matrix of the node.
+ * @param mesh   Object-space bounds of the node, may be empty.
+ */
+static void gfx_scene_node_(float* world, float* bounds,
+                            const float* parent, const float* local,
+                            const float* mesh)
+{
+	// world = parent * local, one column at a time.
+	const __m128 p0 = _mm_loadu_ps(parent + 0);
+	const __m128 p1 = _mm_loadu_ps(parent + 4);
+	const __m128 p2 = _mm_loadu_ps(parent + 8);
+	const __m128 p3 = _mm_loadu_ps(parent + 12);
+
+	__m128 w[4];
+
+	for (size_t c = 0; c < 4; ++c)
+	{
+		const float* l = local + c * 4;
+
+		w[c] = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps(p0, _mm_set1_ps(l[0])),
+				_mm_mul_ps(p1, _mm_set1_ps(l[1]))),
+			_mm_add_ps(
+				_mm_mul_ps(p2, _mm_set1_ps(l[2])),
+				_mm_mul_ps(p3, _mm_set1_ps(l[3]))));
+
+		_mm_storeu_ps(world + c * 4, w[c]);
+	}
+
+	if (mesh[0] > mesh[4])
+	{
+		gfx_scene_empty_(bounds);
+		return;
+	}
+
+	// Transform center & extents (Arvo 1990).
+	const __m128 lo = _mm_loadu_ps(mesh);
+	const __m128 hi = _mm_loadu_ps(mesh + 4);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 center = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+	const __m128 extent = _mm_mul_ps(_mm_sub_ps(hi, lo), half);
+
+	float c[4], e[4];
+	_mm_storeu_ps(c, center);
+	_mm_storeu_ps(e, extent);
+
+	const __m128 sign = _mm_set1_ps(-0.0f);
+
+	const __m128 wc = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(w[0], _mm_set1_ps(c[0])),
+			_mm_mul_ps(w[1], _mm_set1_ps(c[1]))),
+		_mm_add_ps(
+			_mm_mul_ps(w[2], _mm_set1_ps(c[2])),
+			w[3]));
+
+	const __m128 we = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_andnot_ps(sign, w[0]), _mm_set1_ps(e[0])),
+			_mm_mul_ps(_mm_andnot_ps(sign, w[1]), _mm_set1_ps(e[1]))),
+		_mm_mul_ps(_mm_andnot_ps(sign, w[2]), _mm_set1_ps(e[2])));
+
+	_mm_storeu_ps(bounds + 0, _mm_sub_ps(wc, we));
+	_mm_storeu_ps(bounds + 4, _mm_add_ps(wc, we));
+}
+
+#else
+
+/****************************
+ * Computes the world matrix & bounds of a single node, scalar version.
+ * @see the SSE2 version.
+ */
+static void gfx_scene_node_(float* world, float* bounds,
+                            const float* parent, const float* local,
+                            const float* mesh)
+{
+	// world = parent * local.
+	for (size_t c = 0; c < 4; ++c)
+		for (size_t r = 0; r < 4; ++r)
+			world[c * 4 + r] =
+				parent[0 + r] * local[c * 4 + 0] +
+				parent[4 + r] * local[c * 4 + 1] +
+				parent[8 + r] * local[c * 4 + 2] +
+				parent[12 + r] * local[c * 4 + 3];
+
+	if (mesh[0] > mesh[4])
+	{
+		gfx_scene_empty_(bounds);
+		return;
+	}
+
+	// Transform center & extents (Arvo 1990).
+	for (size_t r = 0; r < 4; ++r)
+	{
+		float wc = world[12 + r];
+		float we = 0.0f;
+
+		for (size_t c = 0; c < 3; ++c)
+			wc += world[c * 4 + r] * (mesh[c] + mesh[c + 4]) * 0.5f,
+			we += fabsf(world[c * 4 + r]) * (mesh[c + 4] - mesh[c]) * 0.5f;
+
+		bounds[r] = wc - we;
+		bounds[r + 4] = wc + we;
+	}
+}
+
+#endif
+
+/****************************/
+GFX_API void gfx_scene_compose(float* m,
+                               const float* t, const float* r, const float* s)
+{
+	assert(m != NULL);
+	assert(t != NULL);
+	assert(r != NULL);
+	assert(s != NULL);
+
+	// Quaternion -> matrix, normalizing it as we go.
+	const float sq0 = r[0] * r[0];
+	const float sq1 = r[1] * r[1];
+	const float sq2 = r[2] * r[2];
+	const float sq3 = r[3] * r[3];
+	const float len = sq0 + sq1 + sq2 + sq3;
+	const float l = len > 0.0f ? 2.0f / len : 0.0f;
+
+	// Scale it as we go.
+	m[0] = s[0] * (1.0f - l * (sq1 + sq2));
+	m[1] = s[0] * l * (r[0] * r[1] + r[2] * r[3]);
+	m[2] = s[0] * l * (r[0] * r[2] - r[1] * r[3]);
+	m[3] = 0.0f;
+
+	m[4] = s[1] * l * (r[0] * r[1] - r[2] * r[3]);
+	m[5] = s[1] * (1.0f - l * (sq0 + sq2));
+	m[6] = s[1] * l * (r[1] * r[2] + r[0] * r[3]);
+	m[7] = 0.0f;
+
+	m[8] = s[2] * l * (r[0] * r[2] + r[1] * r[3]);
+	m[9] = s[2] * l * (r[1] * r[2] - r[0] * r[3]);
+	m[10] = s[2] * (1.0f - l * (sq0 + sq1));
+	m[11] = 0.0f;
+
+	// Stick in translation.
+	m[12] = t[0];
+	m[13] = t[1];
+	m[14] = t[2];
+	m[15] = 1.0f;
+}
+
+/****************************/
+GFX_API bool gfx_scene_graph_init(GFXSceneGraph* graph, const GFXGltfResult* gltf)
+{
+	assert(graph != NULL);
+	assert(gltf != NULL);
+
+	const size_t numNodes = gltf->numNodes;
+
+	if (numNodes >= UINT32_MAX)
+	{
+		gfx_log_error("Cannot build a scene graph of %"GFX_PRIs" nodes.", numNodes);
+		return 0;
+	}
+
+	*graph = (GFXSceneGraph){
+		.numNodes = numNodes,
+		.nodes = malloc(sizeof(GFXGltfNode*) * GFX_MAX(1, numNodes)),
+		.parents = malloc(sizeof(uint32_t) * GFX_MAX(1, numNodes)),
+		.locals = malloc(sizeof(float) * GFX_SCENE_MAT_SIZE_ * GFX_MAX(1, numNodes)),
+		.worlds = malloc(sizeof(float) * GFX_SCENE_MAT_SIZE_ * GFX_MAX(1, numNodes)),
+		.bounds = malloc(sizeof(float) * GFX_SCENE_BOUNDS_SIZE_ * GFX_MAX(1, numNodes)),
+		.meshBounds = malloc(sizeof(float) * GFX_SCENE_BOUNDS_SIZE_ * GFX_MAX(1, numNodes)),
+		.dirty = malloc(GFX_MAX(1, numNodes)),
+		.map = malloc(sizeof(uint32_t) * GFX_MAX(1, numNodes)),
+		.base = gltf->nodes
+	};
+
+	// Depth of each source node & #nodes at each depth (+1).
+	uint32_t* depths = malloc(sizeof(uint32_t) * GFX_MAX(1, numNodes));
+	size_t* counts = calloc(numNodes + 1, sizeof(size_t));
+
+	if (
+		graph->nodes == NULL || graph->parents == NULL ||
+		graph->locals == NULL || graph->worlds == NULL ||
+		graph->bounds == NULL || graph->meshBounds == NULL ||
+		graph->dirty == NULL || graph->map == NULL ||
+		depths == NULL || counts == NULL)
+	{
+		goto clean;
+	}
+
+	// Compute the depth of all nodes, walking up each chain of unknown
+	// depths only once, so this is linear in the number of nodes.
+	for (size_t n = 0; n < numNodes; ++n)
+		depths[n] = UINT32_MAX;
+
+	for (size_t n = 0; n < numNodes; ++n)
+	{
+		size_t len = 0;
+		const GFXGltfNode* node = gltf->nodes + n;
+
+		while (node != NULL && depths[node - gltf->nodes] == UINT32_MAX)
+		{
+			if (len >= numNodes)
+			{
+				gfx_log_error("Cannot build a scene graph with cycles.");
+				goto clean;
+			}
+
+			node = node->parent;
+			++len;
+		}
+
+		const size_t top =
+			node != NULL ? (size_t)depths[node - gltf->nodes] + 1 : 0;
+
+		node = gltf->nodes + n;
+		for (size_t l = len; l > 0; --l, node = node->parent)
+			depths[node - gltf->nodes] = (uint32_t)(top + l - 1);
+
+		++counts[depths[n] + 1];
+	}
+
+	// Counting sort by depth, keeping the source order within a depth.
+	for (size_t d = 0; d < numNodes; ++d)
+		counts[d + 1] += counts[d];
+
+	for (size_t n = 0; n < numNodes; ++n)
+		graph->map[n] = (uint32_t)counts[depths[n]]++;
+
+	// Fill in all node data.
+	for (size_t n = 0; n < numNodes; ++n)
+	{
+		const GFXGltfNode* node = gltf->nodes + n;
+		const size_t i = graph->map[n];
+
+		graph->nodes[i] = node;
+		graph->parents[i] = node->parent != NULL ?
+			graph->map[node->parent - gltf->nodes] : UINT32_MAX;
+		graph->dirty[i] = 1;
+
+		memcpy(graph->locals + i * GFX_SCENE_MAT_SIZE_,
+			node->matrix, sizeof(float) * GFX_SCENE_MAT_SIZE_);
+
+		// Union of the bounds of all primitives.
+		float* mesh = graph->meshBounds + i * GFX_SCENE_BOUNDS_SIZE_;
+		gfx_scene_empty_(mesh);
+
+		if (node->mesh != NULL)
+			for (size_t p = 0; p < node->mesh->numPrimitives; ++p)
+			{
+				const GFXGltfPrimitive* prim = node->mesh->primitives + p;
+				if (prim->min[0] > prim->max[0])
+					continue;
+
+				for (size_t c = 0; c < 3; ++c)
+					mesh[c] = GFX_MIN(mesh[c], prim->min[c]),
+					mesh[c + 4] = GFX_MAX(mesh[c + 4], prim->max[c]);
+			}
+
+		gfx_scene_empty_(graph->bounds + i * GFX_SCENE_BOUNDS_SIZE_);
+	}
+
+	free(depths);
+	free(counts);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	free(depths);
+	free(counts);
+	gfx_scene_graph_clear(graph);
+
+	return 0;
+}
+
+/****************************/
+GFX_API void gfx_scene_graph_clear(GFXSceneGraph* graph)
+{
+	assert(graph != NULL);
+
+	free(graph->nodes);
+	free(graph->parents);
+	free(graph->locals);
+	free(graph->worlds);
+	free(graph->bounds);
+	free(graph->meshBounds);
+	free(graph->dirty);
+	free(graph->map);
+
+	// Leave all values, graph is invalidated.
+}
+
+/****************************/
+GFX_API size_t gfx_scene_graph_find(const GFXSceneGraph* graph,
+                                    const GFXGltfNode* node)
+{
+	assert(graph != NULL);
+	assert(node != NULL);
+	assert(node >= graph->base && node < graph->base + graph->numNodes);
+
+	return graph->map[node - graph->base];
+}
+
+/****************************/
+GFX_API void gfx_scene_graph_set(GFXSceneGraph* graph, size_t node,
+                                 const float* t, const float* r, const float* s)
+{
+	assert(graph != NULL);
+	assert(node < graph->numNodes);
+
+	gfx_scene_compose(graph->locals + node * GFX_SCENE_MAT_SIZE_, t, r, s);
+	graph->dirty[node] = 1;
+}
+
+/****************************/
+GFX_API void gfx_scene_graph_set_matrix(GFXSceneGraph* graph, size_t node,
+                                        const float* matrix)
+{
+	assert(graph != NULL);
+	assert(node < graph->numNodes);
+	assert(matrix != NULL);
+
+	memcpy(graph->locals + node * GFX_SCENE_MAT_SIZE_,
+		matrix, sizeof(float) * GFX_SCENE_MAT_SIZE_);
+
+	graph->dirty[node] = 1;
+}
+
+/****************************/
+GFX_API size_t gfx_scene_graph_update(GFXSceneGraph* graph)
+{
+	assert(graph != NULL);
+
+	size_t updated = 0;
+
+	// Parents come first, so dirtiness propagates down in a single pass.
+	// Clean nodes are skipped entirely.
+	for (size_t i = 0; i < graph->numNodes; ++i)
+	{
+		const uint32_t parent = graph->parents[i];
+
+		if (parent != UINT32_MAX && graph->dirty[parent])
+			graph->dirty[i] = 1;
+
+		if (!graph->dirty[i])
+			continue;
+
+		gfx_scene_node_(
+			graph->worlds + i * GFX_SCENE_MAT_SIZE_,
+			graph->bounds + i * GFX_SCENE_BOUNDS_SIZE_,
+			parent != UINT32_MAX ?
+				graph->worlds + parent * GFX_SCENE_MAT_SIZE_ :
+				gfx_scene_identity_,
+			graph->locals + i * GFX_SCENE_MAT_SIZE_,
+			graph->meshBounds + i * GFX_SCENE_BOUNDS_SIZE_);
+
+		++updated;
+	}
+
+	// Reset all dirty flags afterwards, as children read their parent's.
+	if (updated > 0)
+		memset(graph->dirty, 0, graph->numNodes);
+
+	return updated;
+}
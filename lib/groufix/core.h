@@ -67,6 +67,21 @@
 	} while (0)
 
 
+/**
+ * Thread local scratch memory block.
+ */
+typedef struct GFXScratchBlock_
+{
+	struct GFXScratchBlock_* prev;
+
+	size_t size; // In bytes.
+	size_t used; // In bytes.
+
+	max_align_t data[];
+
+} GFXScratchBlock_;
+
+
 /**
  * Thread local data.
  */
@@ -75,6 +90,15 @@ typedef struct GFXThreadState_
 	uintmax_t id;
 
 
+	// Scratch memory (stack of blocks).
+	struct
+	{
+		GFXScratchBlock_* top;
+		GFXScratchBlock_* spare; // Largest popped block, kept for reuse.
+
+	} scratch;
+
+
 	// Logging data.
 	struct
 	{
@@ -124,6 +148,15 @@ typedef struct GFXState_
 	} thread;
 
 
+	// Shared job scheduler, created on first use.
+	struct
+	{
+		GFXMutex_ lock;
+		GFXJobs*  jobs;
+
+	} jobs;
+
+
 	// Vulkan fields.
 	struct
 	{
@@ -224,7 +257,8 @@ typedef struct GFXContext_
 	enum
 	{
 		GFX_SUPPORT_GEOMETRY_SHADER_     = 0x0001,
-		GFX_SUPPORT_TESSELLATION_SHADER_ = 0x0002
+		GFX_SUPPORT_TESSELLATION_SHADER_ = 0x0002,
+		GFX_SUPPORT_DYNAMIC_STATE_       = 0x0004 // Extended dynamic state.
 
 	} features;
 
@@ -279,8 +313,19 @@ typedef struct GFXContext_
 		GFX_VK_PFN_(CmdPipelineBarrier);
 		GFX_VK_PFN_(CmdPushConstants);
 		GFX_VK_PFN_(CmdResolveImage);
+		GFX_VK_PFN_(CmdSetCullMode);
+		GFX_VK_PFN_(CmdSetDepthCompareOp);
+		GFX_VK_PFN_(CmdSetDepthTestEnable);
+		GFX_VK_PFN_(CmdSetDepthWriteEnable);
+		GFX_VK_PFN_(CmdSetFrontFace);
 		GFX_VK_PFN_(CmdSetLineWidth);
+		GFX_VK_PFN_(CmdSetPrimitiveTopology);
 		GFX_VK_PFN_(CmdSetScissor);
+		GFX_VK_PFN_(CmdSetStencilCompareMask);
+		GFX_VK_PFN_(CmdSetStencilOp);
+		GFX_VK_PFN_(CmdSetStencilReference);
+		GFX_VK_PFN_(CmdSetStencilTestEnable);
+		GFX_VK_PFN_(CmdSetStencilWriteMask);
 		GFX_VK_PFN_(CmdSetViewport);
 		GFX_VK_PFN_(CreateBuffer);
 		GFX_VK_PFN_(CreateBufferView);
@@ -528,6 +573,31 @@ void gfx_destroy_local_(void);
  */
 GFXThreadState_* gfx_get_local_(void);
 
+/**
+ * Allocates temporary memory from the scratch memory of the calling thread.
+ * Falls back to malloc if no thread local state was allocated.
+ * @param size Must be > 0.
+ * @return NULL on failure, aligned for any type.
+ *
+ * Memory is allocated stack-like, it must be freed with gfx_scratch_pop_
+ * in reverse order of allocation.
+ * Meant as replacement of VLAs and mallocs for temporary arrays.
+ */
+void* gfx_scratch_push_(size_t size);
+
+/**
+ * Frees scratch memory of the calling thread.
+ * @param ptr Must be the last non-NULL pointer returned by gfx_scratch_push_
+ *            that is not yet freed.
+ */
+void gfx_scratch_pop_(void* ptr);
+
+/**
+ * Destroys the shared job scheduler, if it was created.
+ * Must be called before gfx_terminate_, no jobs may be running.
+ */
+void gfx_jobs_terminate_(void);
+
 
 /****************************
  * Devices, monitors, gamepads and Vulkan contexts.
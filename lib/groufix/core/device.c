@@ -22,6 +22,16 @@
 		} \
 	} while (0)
 
+#define GFX_GET_DEVICE_PROC_ADDR_EXT_(pName) \
+	do { \
+		context->vk.pName = (PFN_vk##pName)groufix_.vk.GetDeviceProcAddr( \
+			context->vk.device, "vk"#pName"EXT"); \
+		if (context->vk.pName == NULL) { \
+			gfx_log_error("Could not load vk"#pName"EXT."); \
+			goto clean; \
+		} \
+	} while (0)
+
 #define GFX_GET_DEVICE_TYPE_(vType) \
 	((vType) == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? \
 		GFX_DEVICE_DISCRETE_GPU : \
@@ -118,15 +128,13 @@ static bool gfx_contains_substr_(const char* str, const char* substr)
 }
 
 
-#if defined (GFX_USE_VK_SUBSET_DEVICES)
-
 /****************************
- * Checks whether a given physical Vulkan device exposes the
- * VK_KHR_portability_subset extension.
+ * Checks whether a given physical Vulkan device exposes an extension.
+ * @param name Cannot be NULL, must be NULL-terminated.
  */
-static bool gfx_device_is_subset_(VkPhysicalDevice device)
+static bool gfx_device_has_extension_(VkPhysicalDevice device, const char* name)
 {
-	bool subset = 0;
+	bool found = 0;
 
 	uint32_t extCount;
 	GFX_VK_CHECK_(groufix_.vk.EnumerateDeviceExtensionProperties(
@@ -144,11 +152,9 @@ static bool gfx_device_is_subset_(VkPhysicalDevice device)
 				device, NULL, &extCount, extProps), extCount = 0);
 
 			for (uint32_t e = 0; e < extCount; ++e)
-				if (strcmp(
-					extProps[e].extensionName,
-					"VK_KHR_portability_subset") == 0)
+				if (strcmp(extProps[e].extensionName, name) == 0)
 				{
-					subset = 1;
+					found = 1;
 					break;
 				}
 
@@ -156,12 +162,64 @@ static bool gfx_device_is_subset_(VkPhysicalDevice device)
 		}
 	}
 
-	return subset;
+	return found;
+}
+
+
+#if defined (GFX_USE_VK_SUBSET_DEVICES)
+
+/****************************
+ * Checks whether a given physical Vulkan device exposes the
+ * VK_KHR_portability_subset extension.
+ */
+static inline bool gfx_device_is_subset_(VkPhysicalDevice device)
+{
+	return gfx_device_has_extension_(device, "VK_KHR_portability_subset");
 }
 
 #endif
 
 
+/****************************
+ * Checks whether a given device supports extended dynamic state,
+ * either as part of Vulkan 1.3 or through VK_EXT_extended_dynamic_state.
+ * @param device Cannot be NULL, only device->{ api, vk.device } need to be set.
+ * @param ext    Output, non-zero if the extension must be enabled.
+ */
+static bool gfx_device_has_dynamic_state_(GFXDevice_* device, bool* ext)
+{
+	assert(device != NULL);
+	assert(ext != NULL);
+
+	*ext = 0;
+
+	// Core in Vulkan 1.3, no feature bit to check.
+	if (device->api >= VK_MAKE_API_VERSION(0,1,3,0))
+		return 1;
+
+	if (!gfx_device_has_extension_(
+		device->vk.device, "VK_EXT_extended_dynamic_state"))
+	{
+		return 0;
+	}
+
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT pdedsf = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+		.pNext = NULL
+	};
+
+	VkPhysicalDeviceFeatures2 pdf2 = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+		.pNext = &pdedsf
+	};
+
+	groufix_.vk.GetPhysicalDeviceFeatures2(device->vk.device, &pdf2);
+	*ext = pdedsf.extendedDynamicState;
+
+	return *ext;
+}
+
+
 /****************************
  * Fills a VkPhysicalDeviceFeatures struct with features to enable,
  * in other words; it disables feature we don't want.
@@ -810,11 +868,16 @@ static void gfx_create_context_(GFXDevice_* device)
 		goto error;
 
 	// Get supported feature flags.
+	bool dynamicExt;
+	const bool dynamic = gfx_device_has_dynamic_state_(device, &dynamicExt);
+
 	context->features =
 		(device->base.features.geometryShader ?
 			GFX_SUPPORT_GEOMETRY_SHADER_ : 0) |
 		(device->base.features.tessellationShader ?
-			GFX_SUPPORT_TESSELLATION_SHADER_ : 0);
+			GFX_SUPPORT_TESSELLATION_SHADER_ : 0) |
+		(dynamic ?
+			GFX_SUPPORT_DYNAMIC_STATE_ : 0);
 
 	{
 		// Get allocation limits in a scope so pdp gets freed :)
@@ -874,22 +937,21 @@ static void gfx_create_context_(GFXDevice_* device)
 		pdf, pdv11f, pdv12f, pdv13f, pdv14f);
 
 	// Enable VK_KHR_swapchain so we can interact with surfaces from GLFW.
-	const char* extensions[] = {
-		"VK_KHR_swapchain",
+	const char* extensions[3];
+	uint32_t extensionCount = 0;
 
-		// If a portability subset device, add VK_KHR_portability_subset.
-#if defined (GFX_USE_VK_SUBSET_DEVICES)
-		"VK_KHR_portability_subset"
-#endif
-	};
+	extensions[extensionCount++] = "VK_KHR_swapchain";
 
-	const uint32_t extensionCount =
+	// If a portability subset device, add VK_KHR_portability_subset.
 #if defined (GFX_USE_VK_SUBSET_DEVICES)
-		sizeof(extensions)/sizeof(char*) - (device->subset ? 0 : 1);
-#else
-		sizeof(extensions)/sizeof(char*);
+	if (device->subset)
+		extensions[extensionCount++] = "VK_KHR_portability_subset";
 #endif
 
+	// If extended dynamic state is not core, add its extension.
+	if (dynamicExt)
+		extensions[extensionCount++] = "VK_EXT_extended_dynamic_state";
+
 	// Enable VK_LAYER_KHRONOS_validation,
 	// this is deprecated by now, but for older Vulkan versions.
 #if !defined (NDEBUG)
@@ -906,6 +968,15 @@ static void gfx_create_context_(GFXDevice_* device)
 		.pPhysicalDevices    = context->devices
 	};
 
+	VkPhysicalDeviceExtendedDynamicStateFeaturesEXT pdedsf = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+
+		.pNext                = dgdci.pNext,
+		.extendedDynamicState = VK_TRUE
+	};
+
+	if (dynamicExt) dgdci.pNext = &pdedsf;
+
 	VkDeviceCreateInfo dci = {
 		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
 
@@ -1025,6 +1096,9 @@ static void gfx_create_context_(GFXDevice_* device)
 	GFX_GET_DEVICE_PROC_ADDR_(CmdResolveImage);
 	GFX_GET_DEVICE_PROC_ADDR_(CmdSetLineWidth);
 	GFX_GET_DEVICE_PROC_ADDR_(CmdSetScissor);
+	GFX_GET_DEVICE_PROC_ADDR_(CmdSetStencilCompareMask);
+	GFX_GET_DEVICE_PROC_ADDR_(CmdSetStencilReference);
+	GFX_GET_DEVICE_PROC_ADDR_(CmdSetStencilWriteMask);
 	GFX_GET_DEVICE_PROC_ADDR_(CmdSetViewport);
 	GFX_GET_DEVICE_PROC_ADDR_(CreateBuffer);
 	GFX_GET_DEVICE_PROC_ADDR_(CreateBufferView);
@@ -1085,6 +1159,31 @@ static void gfx_create_context_(GFXDevice_* device)
 	GFX_GET_DEVICE_PROC_ADDR_(UpdateDescriptorSetWithTemplate);
 	GFX_GET_DEVICE_PROC_ADDR_(WaitForFences);
 
+	// Load extended dynamic state functions, core or extension.
+	if (dynamic && !dynamicExt)
+	{
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetCullMode);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetDepthCompareOp);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetDepthTestEnable);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetDepthWriteEnable);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetFrontFace);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetPrimitiveTopology);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetStencilOp);
+		GFX_GET_DEVICE_PROC_ADDR_(CmdSetStencilTestEnable);
+	}
+
+	else if (dynamic)
+	{
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetCullMode);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetDepthCompareOp);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetDepthTestEnable);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetDepthWriteEnable);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetFrontFace);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetPrimitiveTopology);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetStencilOp);
+		GFX_GET_DEVICE_PROC_ADDR_EXT_(CmdSetStencilTestEnable);
+	}
+
 
 	// Set device's reference to this context.
 	device->context = context;
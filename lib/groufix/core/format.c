@@ -52,7 +52,11 @@ static_assert(CHAR_BIT == 8, "Format block bytes must be 8 bits.");
 	((vkProps).optimalTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_SRC_BIT ? \
 		GFX_FORMAT_IMAGE_READ : (GFXFormatFeatures)0) | \
 	((vkProps).optimalTilingFeatures & VK_FORMAT_FEATURE_TRANSFER_DST_BIT ? \
-		GFX_FORMAT_IMAGE_WRITE : (GFXFormatFeatures)0))
+		GFX_FORMAT_IMAGE_WRITE : (GFXFormatFeatures)0) | \
+	((vkProps).optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT ? \
+		GFX_FORMAT_IMAGE_BLIT_SRC : (GFXFormatFeatures)0) | \
+	((vkProps).optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT ? \
+		GFX_FORMAT_IMAGE_BLIT_DST : (GFXFormatFeatures)0))
 
 
 /****************************
@@ -207,6 +207,31 @@ static uint64_t gfx_stage_compact_(const GFXUnpackRef_* ref, size_t numRegions,
 	return size;
 }
 
+/****************************
+ * Computes a list of staging regions that mirror the regions associated
+ * with the host pointer as-is, so the staging buffer can be written to
+ * as if it were the host pointer.
+ * @see gfx_stage_compact_.
+ */
+static uint64_t gfx_stage_mirror_(const GFXUnpackRef_* ref, size_t numRegions,
+                                  const GFXRegion* ptrRegions,
+                                  const GFXRegion* refRegions,
+                                  GFXStageRegion_* stage)
+{
+	// Compacting gets us all sizes, then undo all displacements.
+	gfx_stage_compact_(ref, numRegions, ptrRegions, refRegions, stage);
+
+	uint64_t size = 0;
+
+	for (size_t r = 0; r < numRegions; ++r)
+	{
+		stage[r].offset = ptrRegions[r].offset;
+		size = GFX_MAX(size, stage[r].offset + stage[r].size);
+	}
+
+	return size;
+}
+
 /****************************
  * Claims (creates) the current injection metadata object of a pool.
  * @param pool  Cannot be NULL.
@@ -552,6 +577,112 @@ static void gfx_copy_host_(void* ptr, void* ref,
 	}
 }
 
+/****************************
+ * Records commands to generate mipmaps of an image by a chain of blits.
+ * @param context    Cannot be NULL.
+ * @param image      Cannot be NULL, must be in the transfer destination layout.
+ * @param numRegions Must be > 0.
+ * @param regions    Cannot be NULL, all mipmaps following each are generated.
+ *
+ * The entire image is left in the transfer destination layout.
+ */
+static void gfx_record_mipmaps_(GFXContext_* context, VkCommandBuffer cmd,
+                                const GFXImage_* image,
+                                size_t numRegions, const GFXRegion* regions)
+{
+	assert(context != NULL);
+	assert(cmd != VK_NULL_HANDLE);
+	assert(image != NULL);
+	assert(numRegions > 0);
+	assert(regions != NULL);
+
+	const uint32_t mipmaps = image->base.mipmaps;
+
+	for (size_t r = 0; r < numRegions; ++r)
+	{
+		const uint32_t base = regions[r].mipmap;
+		if (base + 1 >= mipmaps) continue;
+
+		VkImageMemoryBarrier imb = {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+
+			.pNext               = NULL,
+			.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
+			.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image               = image->vk.image,
+			.subresourceRange = {
+				.aspectMask     = GFX_GET_VK_IMAGE_ASPECT_(regions[r].aspect),
+				.baseMipLevel   = base,
+				.levelCount     = 1,
+				.baseArrayLayer = regions[r].layer,
+				.layerCount     = regions[r].numLayers
+			}
+		};
+
+		VkImageBlit blit = {
+			.srcSubresource = {
+				.aspectMask     = imb.subresourceRange.aspectMask,
+				.baseArrayLayer = regions[r].layer,
+				.layerCount     = regions[r].numLayers
+			},
+			.dstSubresource = {
+				.aspectMask     = imb.subresourceRange.aspectMask,
+				.baseArrayLayer = regions[r].layer,
+				.layerCount     = regions[r].numLayers
+			}
+		};
+
+		// Each mipmap is blitted from the previous one,
+		// which must be transitioned to a transfer source first.
+		for (uint32_t m = base + 1; m < mipmaps; ++m)
+		{
+			imb.subresourceRange.baseMipLevel = m - 1;
+
+			context->vk.CmdPipelineBarrier(cmd,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 0, NULL, 0, NULL, 1, &imb);
+
+			blit.srcSubresource.mipLevel = m - 1;
+			blit.srcOffsets[1] = (VkOffset3D){
+				.x = (int32_t)GFX_MAX(1, image->base.width >> (m - 1)),
+				.y = (int32_t)GFX_MAX(1, image->base.height >> (m - 1)),
+				.z = (int32_t)GFX_MAX(1, image->base.depth >> (m - 1))
+			};
+
+			blit.dstSubresource.mipLevel = m;
+			blit.dstOffsets[1] = (VkOffset3D){
+				.x = (int32_t)GFX_MAX(1, image->base.width >> m),
+				.y = (int32_t)GFX_MAX(1, image->base.height >> m),
+				.z = (int32_t)GFX_MAX(1, image->base.depth >> m)
+			};
+
+			context->vk.CmdBlitImage(cmd,
+				image->vk.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image->vk.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit, VK_FILTER_LINEAR);
+		}
+
+		// Transition all source mipmaps back,
+		// the injections expect the entire image to be a destination.
+		imb.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imb.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		imb.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imb.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		imb.subresourceRange.baseMipLevel = base;
+		imb.subresourceRange.levelCount = mipmaps - 1 - base;
+
+		context->vk.CmdPipelineBarrier(cmd,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, NULL, 0, NULL, 1, &imb);
+	}
+}
+
 /****************************
  * Copies data from a resource or staging buffer to another resource.
  * @param heap       Cannot be NULL.
@@ -670,6 +801,27 @@ static int gfx_copy_device_(GFXHeap* heap, GFXTransferFlags flags,
 		return 0;
 	}
 
+	// Mipmaps can only be generated for non-attachment images.
+	// Blitting requires a graphics queue, so never transfer async.
+	const bool mipmaps =
+		(flags & GFX_TRANSFER_MIPMAPS) && !rev && dst->obj.image != NULL;
+
+	if (mipmaps)
+	{
+		flags &= ~(GFXTransferFlags)GFX_TRANSFER_ASYNC;
+
+#if !defined (NDEBUG)
+		if (!(dst->obj.image->base.flags & GFX_MEMORY_READ))
+			gfx_log_warn(
+				"Not allowed to generate mipmaps of an image that was "
+				"not created with GFX_MEMORY_READ_WRITE.");
+#endif
+	}
+	else if ((flags & GFX_TRANSFER_MIPMAPS) && !rev)
+		gfx_log_warn(
+			"Attempted to generate mipmaps of a memory resource "
+			"that is not an image, ignored.");
+
 	// Now get us transfer operation resources.
 	// Note that this will lock `pool->lock` for us,
 	// we use this lock for recording as well!
@@ -917,6 +1069,11 @@ static int gfx_copy_device_(GFXHeap* heap, GFXTransferFlags flags,
 				(uint32_t)numRegions, cRegions);
 	}
 
+	// Generate mipmaps of the destination image if asked.
+	if (mipmaps)
+		gfx_record_mipmaps_(context, transfer->vk.cmd,
+			dst->obj.image, numRegions, dstRegions);
+
 	// Inject signal commands.
 	if (!gfx_sems_prepare_(
 		context, transfer->vk.cmd,
@@ -973,6 +1130,37 @@ unlock:
 	return 0;
 }
 
+#if !defined (NDEBUG)
+
+/****************************
+ * Validates the memory flags of a resource to write to.
+ * @param ref Unpacked reference to validate.
+ */
+static void gfx_validate_write_(const GFXUnpackRef_* ref, GFXTransferFlags flags)
+{
+	GFXMemoryFlags mFlags = GFX_UNPACK_REF_FLAGS_(*ref);
+
+	// Validate memory flags.
+	if (!(mFlags & (GFX_MEMORY_HOST_VISIBLE | GFX_MEMORY_WRITE)))
+	{
+		gfx_log_warn(
+			"Not allowed to write to a memory resource that was not "
+			"created with GFX_MEMORY_HOST_VISIBLE or GFX_MEMORY_WRITE.");
+	}
+
+	// Validate async flag.
+	if ((flags & GFX_TRANSFER_ASYNC) &&
+		(mFlags & GFX_MEMORY_COMPUTE_CONCURRENT) &&
+		!(mFlags & GFX_MEMORY_TRANSFER_CONCURRENT))
+	{
+		gfx_log_warn(
+			"Not allowed to perform asynchronous write to a memory resource "
+			"with concurrent memory flags excluding transfer operations.");
+	}
+}
+
+#endif
+
 /****************************/
 GFX_API bool gfx_read(GFXReference src, void* dst,
                       GFXTransferFlags flags,
@@ -1111,25 +1299,7 @@ GFX_API bool gfx_write(const void* src, GFXReference dst,
 	GFXHeap* heap = GFX_UNPACK_REF_HEAP_(unp);
 
 #if !defined (NDEBUG)
-	GFXMemoryFlags mFlags = GFX_UNPACK_REF_FLAGS_(unp);
-
-	// Validate memory flags.
-	if (!(mFlags & (GFX_MEMORY_HOST_VISIBLE | GFX_MEMORY_WRITE)))
-	{
-		gfx_log_warn(
-			"Not allowed to write to a memory resource that was not "
-			"created with GFX_MEMORY_HOST_VISIBLE or GFX_MEMORY_WRITE.");
-	}
-
-	// Validate async flag.
-	if ((flags & GFX_TRANSFER_ASYNC) &&
-		(mFlags & GFX_MEMORY_COMPUTE_CONCURRENT) &&
-		!(mFlags & GFX_MEMORY_TRANSFER_CONCURRENT))
-	{
-		gfx_log_warn(
-			"Not allowed to perform asynchronous write to a memory resource "
-			"with concurrent memory flags excluding transfer operations.");
-	}
+	gfx_validate_write_(&unp, flags);
 #endif
 
 	// We either map or stage, staging may remain NULL.
@@ -1208,6 +1378,142 @@ error:
 	return 0;
 }
 
+/****************************/
+GFX_API void* gfx_map_write(GFXMappedWrite* write, GFXReference dst,
+                            size_t numRegions,
+                            const GFXRegion* srcRegions, const GFXRegion* dstRegions)
+{
+	assert(write != NULL);
+	assert(!GFX_REF_IS_NULL(dst));
+	assert(numRegions > 0);
+	assert(srcRegions != NULL);
+	assert(dstRegions != NULL);
+
+	// Unpack reference.
+	GFXUnpackRef_ unp = gfx_ref_unpack_(dst);
+	GFXHeap* heap = GFX_UNPACK_REF_HEAP_(unp);
+
+	GFXStageRegion_ stage[numRegions];
+	const uint64_t size = gfx_stage_mirror_(
+		&unp, numRegions, srcRegions, dstRegions, stage);
+
+	write->ref = dst;
+	write->staging = NULL;
+	write->host = NULL;
+
+	// If it is a host visible buffer, gfx_write will map it for us,
+	// we cannot give out the mapped buffer as the host regions may not
+	// match the buffer regions, so just use plain host memory.
+	// Otherwise, allocate a staging buffer to write into directly.
+	if (unp.obj.buffer != NULL &&
+		(unp.obj.buffer->base.flags & GFX_MEMORY_HOST_VISIBLE))
+	{
+		write->host = malloc((size_t)size);
+		if (write->host == NULL) goto error;
+
+		return write->host;
+	}
+	else
+	{
+		GFXStaging_* staging = gfx_alloc_staging_(
+			heap, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
+
+		if (staging == NULL) goto error;
+		write->staging = staging;
+
+		return staging->vk.ptr;
+	}
+
+
+	// Error on failure.
+error:
+	gfx_log_error("Map write operation failed.");
+
+	return NULL;
+}
+
+/****************************/
+GFX_API bool gfx_unmap_write(GFXMappedWrite* write,
+                             GFXTransferFlags flags,
+                             size_t numRegions, size_t numInjs,
+                             const GFXRegion* srcRegions, const GFXRegion* dstRegions,
+                             const GFXInject* injs)
+{
+	assert(write != NULL);
+	assert(write->staging != NULL || write->host != NULL);
+	assert(numRegions > 0);
+	assert(srcRegions != NULL);
+	assert(dstRegions != NULL);
+	assert(numInjs == 0 || injs != NULL);
+
+	// Plain host memory, just write it.
+	if (write->host != NULL)
+	{
+		const bool success = gfx_write(
+			write->host, write->ref, flags,
+			numRegions, numInjs, srcRegions, dstRegions, injs);
+
+		free(write->host);
+		write->host = NULL;
+
+		return success;
+	}
+
+	// Unpack reference.
+	GFXUnpackRef_ unp = gfx_ref_unpack_(write->ref);
+	GFXHeap* heap = GFX_UNPACK_REF_HEAP_(unp);
+	GFXStaging_* staging = write->staging;
+
+	write->staging = NULL;
+
+#if !defined (NDEBUG)
+	gfx_validate_write_(&unp, flags);
+#endif
+
+	// Recompute the staging regions, as mapped.
+	GFXStageRegion_ stage[numRegions];
+	gfx_stage_mirror_(&unp, numRegions, srcRegions, dstRegions, stage);
+
+	// Do the staging -> resource copy.
+	const GFXAccessMask rMask = GFX_ACCESS_TRANSFER_WRITE;
+	const uint64_t rSize = gfx_ref_size_(write->ref);
+
+	if (!gfx_copy_device_(
+		heap, flags, 0, GFX_FILTER_NEAREST,
+		1, numRegions, numInjs,
+		staging, &unp, &rMask, &rSize,
+		stage, srcRegions, dstRegions, injs))
+	{
+		gfx_free_staging_(heap, staging);
+		gfx_log_error("Write operation failed.");
+
+		return 0;
+	}
+
+	// Free staging buffer IFF blocking.
+	if (flags & GFX_TRANSFER_BLOCK)
+		gfx_free_staging_(heap, staging);
+
+	return 1;
+}
+
+/****************************/
+GFX_API void gfx_cancel_write(GFXMappedWrite* write)
+{
+	assert(write != NULL);
+	assert(write->staging != NULL || write->host != NULL);
+
+	if (write->staging != NULL)
+	{
+		GFXUnpackRef_ unp = gfx_ref_unpack_(write->ref);
+		gfx_free_staging_(GFX_UNPACK_REF_HEAP_(unp), write->staging);
+	}
+
+	free(write->host);
+	write->staging = NULL;
+	write->host = NULL;
+}
+
 /****************************
  * Stand-in function for gfx_(copy|blit|resolve), wrapper for gfx_copy_device_.
  * @param cpFlags Internal copy flags that specifies the type of call.
@@ -10,6 +10,10 @@
 #include <stdlib.h>
 
 
+// Minimum size of a scratch memory block.
+#define GFX_SCRATCH_BLOCK_SIZE_ ((size_t)1 << 14)
+
+
 /****************************/
 GFXState_ groufix_ =
 {
@@ -18,13 +22,58 @@ GFXState_ groufix_ =
 };
 
 
+/****************************
+ * Thread local state of the calling thread, for fast access.
+ * The key in groufix_.thread is only used to clean up on thread exit.
+ */
+static GFX_THREAD_LOCAL_ GFXThreadState_* gfx_local_ = NULL;
+
+
+/****************************
+ * Frees a thread local state and all its scratch memory.
+ * @param ptr Cannot be NULL, must be a GFXThreadState_*.
+ */
+static void gfx_free_local_(void* ptr)
+{
+	GFXThreadState_* state = ptr;
+
+	while (state->scratch.top != NULL)
+	{
+		GFXScratchBlock_* prev = state->scratch.top->prev;
+		free(state->scratch.top);
+		state->scratch.top = prev;
+	}
+
+	free(state->scratch.spare);
+	free(state);
+}
+
+/****************************
+ * Keeps a popped scratch memory block as spare if it is the largest,
+ * frees it (or the previous spare) otherwise.
+ */
+static void gfx_scratch_keep_(GFXThreadState_* state, GFXScratchBlock_* block)
+{
+	if (state->scratch.spare == NULL)
+		state->scratch.spare = block;
+
+	else if (state->scratch.spare->size < block->size)
+	{
+		free(state->scratch.spare);
+		state->scratch.spare = block;
+	}
+	else
+		free(block);
+}
+
+
 /****************************/
 bool gfx_init_(void)
 {
 	assert(!atomic_load(&groufix_.initialized));
 
 	// Initialize thread local data.
-	if (!gfx_thread_key_init_(&groufix_.thread.key))
+	if (!gfx_thread_key_init_(&groufix_.thread.key, gfx_free_local_))
 		return 0;
 
 	if (!gfx_mutex_init_(&groufix_.thread.ioLock))
@@ -36,6 +85,11 @@ bool gfx_init_(void)
 	if (!gfx_mutex_init_(&groufix_.contextLock))
 		goto clean_io;
 
+	if (!gfx_mutex_init_(&groufix_.jobs.lock))
+		goto clean_context;
+
+	groufix_.jobs.jobs = NULL;
+
 	gfx_vec_init(&groufix_.devices, sizeof(GFXDevice_));
 	gfx_list_init(&groufix_.contexts);
 	gfx_vec_init(&groufix_.monitors, sizeof(GFXMonitor_*));
@@ -59,6 +113,8 @@ bool gfx_init_(void)
 
 
 	// Cleanup on failure.
+clean_context:
+	gfx_mutex_clear_(&groufix_.contextLock);
 clean_io:
 	gfx_mutex_clear_(&groufix_.thread.ioLock);
 clean_key:
@@ -80,6 +136,12 @@ void gfx_terminate_(void)
 	gfx_thread_key_clear_(groufix_.thread.key);
 	gfx_mutex_clear_(&groufix_.thread.ioLock);
 	gfx_mutex_clear_(&groufix_.contextLock);
+	gfx_mutex_clear_(&groufix_.jobs.lock);
+
+#if defined (GFX_LOCK_STATS)
+	// Start counting from scratch if initialized again.
+	gfx_lock_stats_reset_();
+#endif
 
 	// Signal that termination is done.
 	atomic_store(&groufix_.initialized, 0);
@@ -89,9 +151,10 @@ void gfx_terminate_(void)
 bool gfx_create_local_(void)
 {
 	assert(atomic_load(&groufix_.initialized));
-	assert(!gfx_thread_key_get_(groufix_.thread.key));
+	assert(gfx_local_ == NULL);
 
 	// Allocate and set state.
+	// Also store it in the key so it gets freed on thread exit.
 	GFXThreadState_* state = malloc(sizeof(GFXThreadState_));
 	if (state == NULL) return 0;
 
@@ -101,10 +164,16 @@ bool gfx_create_local_(void)
 		return 0;
 	}
 
+	gfx_local_ = state;
+
 	// Give it a unique id.
 	state->id =
 		atomic_fetch_add_explicit(&groufix_.thread.id, 1, memory_order_relaxed);
 
+	// Initialize the scratch memory.
+	state->scratch.top = NULL;
+	state->scratch.spare = NULL;
+
 	// Initialize the logging stuff.
 	state->log.level = groufix_.logDef;
 	gfx_buf_writer(&state->log.out, gfx_io_buf_def_.dest);
@@ -116,13 +185,14 @@ bool gfx_create_local_(void)
 void gfx_destroy_local_(void)
 {
 	assert(atomic_load(&groufix_.initialized));
-	assert(gfx_thread_key_get_(groufix_.thread.key));
-
-	// Get key and free it.
-	free(gfx_thread_key_get_(groufix_.thread.key));
+	assert(gfx_local_ != NULL);
 
 	// I mean this better not fail...
 	gfx_thread_key_set_(groufix_.thread.key, NULL);
+
+	// Free it.
+	gfx_free_local_(gfx_local_);
+	gfx_local_ = NULL;
 }
 
 /****************************/
@@ -131,5 +201,83 @@ GFXThreadState_* gfx_get_local_(void)
 	assert(atomic_load(&groufix_.initialized));
 
 	// Just return stored data.
-	return gfx_thread_key_get_(groufix_.thread.key);
+	return gfx_local_;
+}
+
+/****************************/
+void* gfx_scratch_push_(size_t size)
+{
+	assert(size > 0);
+
+	GFXThreadState_* state = gfx_local_;
+	if (state == NULL) return malloc(size);
+
+	// Keep all allocations aligned for any type.
+	size = GFX_ALIGN_UP(size, alignof(max_align_t));
+
+	GFXScratchBlock_* top = state->scratch.top;
+
+	if (top == NULL || top->size - top->used < size)
+	{
+		// Reuse the spare block if it fits,
+		// otherwise allocate a new block of at least twice the size.
+		GFXScratchBlock_* block = state->scratch.spare;
+
+		if (block != NULL && block->size >= size)
+			state->scratch.spare = NULL;
+		else
+		{
+			size_t bSize = GFX_MAX(GFX_SCRATCH_BLOCK_SIZE_, size);
+			if (top != NULL) bSize = GFX_MAX(bSize, top->size << 1);
+
+			block = malloc(sizeof(GFXScratchBlock_) + bSize);
+			if (block == NULL) return NULL;
+
+			block->size = bSize;
+		}
+
+		block->prev = top;
+		block->used = 0;
+		state->scratch.top = top = block;
+	}
+
+	void* ptr = (char*)top->data + top->used;
+	top->used += size;
+
+	return ptr;
+}
+
+/****************************/
+void gfx_scratch_pop_(void* ptr)
+{
+	assert(ptr != NULL);
+
+	GFXThreadState_* state = gfx_local_;
+	if (state == NULL)
+	{
+		free(ptr);
+		return;
+	}
+
+	// Pop all blocks that were pushed after ptr.
+	const uintptr_t p = (uintptr_t)ptr;
+	GFXScratchBlock_* top = state->scratch.top;
+
+	while (p < (uintptr_t)top->data || p >= (uintptr_t)top->data + top->used)
+	{
+		assert(top->prev != NULL);
+
+		state->scratch.top = top->prev;
+		gfx_scratch_keep_(state, top);
+		top = state->scratch.top;
+	}
+
+	// Then pop ptr itself, pop its block too if it is now empty.
+	top->used = (size_t)(p - (uintptr_t)top->data);
+
+	if (top->used == 0)
+	{
+		state->scratch.top = top->prev;
+		gfx_scratch_keep_(state, top);
+	}
 }
@@ -0,0 +1,761 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/core/jobs.h"
+#include "groufix/containers/deque.h"
+#include "groufix/core.h"
+#include <stdlib.h>
+
+
+// Capacity of the deque of each worker, must be a power of two.
+#define GFX_JOBS_DEQUE_SIZE_ 1024
+
+// Number of failed attempts to find a job before a worker goes to sleep.
+#define GFX_JOBS_SPIN_COUNT_ 64
+
+// Byte size to pad shared data to, so it does not share cache lines.
+#define GFX_JOBS_CACHE_LINE_ 64
+
+
+// Retrieves the argument of the j-th job of a fork.
+#define GFX_JOBS_ARG_(args, stride, j) \
+	((stride) == 0 ? (args) : (void*)((char*)(args) + (j) * (stride)))
+
+
+/****************************
+ * Job definition.
+ */
+typedef struct GFXJob_
+{
+	GFXJobFunc     func;
+	void*          arg;
+	GFXJobCounter* counter;
+
+} GFXJob_;
+
+
+/****************************
+ * Job slot in the deque of a worker.
+ * Thieves may read a slot while it is overwritten (and then discard it),
+ * so all fields are atomic.
+ */
+typedef struct GFXJobSlot_
+{
+	_Atomic(GFXJobFunc)     func;
+	_Atomic(void*)          arg;
+	_Atomic(GFXJobCounter*) counter;
+
+} GFXJobSlot_;
+
+
+/****************************
+ * Worker thread, owns a Chase-Lev work-stealing deque
+ * (Chase & Lev 2005, with the C11 orderings of Lê et al. 2013).
+ * The owner pushes & takes at the bottom, thieves steal from the top.
+ */
+typedef struct GFXJobWorker_
+{
+	atomic_llong top;
+	char         pad0[GFX_JOBS_CACHE_LINE_ - sizeof(atomic_llong)];
+	atomic_llong bottom;
+	char         pad1[GFX_JOBS_CACHE_LINE_ - sizeof(atomic_llong)];
+
+	GFXJobSlot_  slots[GFX_JOBS_DEQUE_SIZE_];
+
+	GFXJobs*     jobs;
+	GFXThread_   thread;
+	uint32_t     seed; // Random state to pick victims with, owner only.
+
+} GFXJobWorker_;
+
+
+/****************************
+ * Job scheduler definition.
+ */
+struct GFXJobs
+{
+	unsigned int   numWorkers; // Number of deques, constant while running.
+	unsigned int   numThreads; // Number of started workers, <= numWorkers.
+	GFXJobWorker_* workers;
+	GFXThreadKey_  key; // Stores the GFXJobWorker_* of a worker thread.
+
+	// Jobs forked from outside of the workers.
+	GFXMutex_     lock;
+	GFXDeque      injected; // Stores GFXJob_.
+	atomic_size_t numInjected;
+	atomic_uint   next; // Next victim to steal from for non-workers.
+
+	// Sleeping workers.
+	GFXMutex_     sleepLock;
+	GFXCond_      cond;
+	atomic_uint   sleeping;
+	atomic_size_t pushes; // Incremented on every fork.
+	atomic_bool   quit;
+
+	// Non-workers blocking in a join.
+	GFXMutex_     joinLock;
+	GFXCond_      joinCond;
+	atomic_uint   joining;
+
+	// Logging state of the creating thread, to inherit.
+	GFXLogLevel      level;
+	const GFXWriter* log;
+};
+
+
+/****************************
+ * Jobs run by gfx_jobs_parallel_, all share this as argument.
+ */
+typedef struct GFXJobsParallel_
+{
+	size_t (*func)(void*, size_t, size_t);
+	void*  arg;
+	size_t count;
+	size_t numJobs;
+
+	atomic_size_t next;   // Next sub-range to hand out.
+	atomic_size_t result; // Sum of all return values of func.
+
+	// Logging state of the forking thread, to inherit.
+	GFXLogLevel      level;
+	const GFXWriter* log;
+
+} GFXJobsParallel_;
+
+
+/****************************
+ * Executes a job and decreases its counter,
+ * wakes up blocked joins if the counter reaches zero.
+ */
+static void gfx_jobs_run_(GFXJobs* jobs, const GFXJob_* job)
+{
+	job->func(job->arg);
+
+	// The sequentially consistent order of these and the operations in
+	// gfx_jobs_join guarantees that either we see it blocking,
+	// or it sees the counter reach zero.
+	if (
+		job->counter != NULL &&
+		atomic_fetch_sub(&job->counter->pending, 1) == 1 &&
+		atomic_load(&jobs->joining) > 0)
+	{
+		gfx_mutex_lock_(&jobs->joinLock);
+		gfx_cond_broadcast_(&jobs->joinCond);
+		gfx_mutex_unlock_(&jobs->joinLock);
+	}
+}
+
+/****************************
+ * Pushes a job to the bottom of the deque of a worker.
+ * Can only be called by the owning worker thread.
+ * @return Zero if the deque is full.
+ */
+static bool gfx_jobs_push_(GFXJobWorker_* worker, const GFXJob_* job)
+{
+	const long long b =
+		atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+	const long long t =
+		atomic_load_explicit(&worker->top, memory_order_acquire);
+
+	if (b - t >= GFX_JOBS_DEQUE_SIZE_)
+		return 0;
+
+	GFXJobSlot_* slot = &worker->slots[b & (GFX_JOBS_DEQUE_SIZE_ - 1)];
+	atomic_store_explicit(&slot->func, job->func, memory_order_relaxed);
+	atomic_store_explicit(&slot->arg, job->arg, memory_order_relaxed);
+	atomic_store_explicit(&slot->counter, job->counter, memory_order_relaxed);
+
+	// Release so thieves see the slot contents.
+	atomic_store_explicit(&worker->bottom, b + 1, memory_order_release);
+
+	return 1;
+}
+
+/****************************
+ * Reads a job from a slot.
+ */
+static void gfx_jobs_read_(GFXJobSlot_* slot, GFXJob_* job)
+{
+	job->func = atomic_load_explicit(&slot->func, memory_order_relaxed);
+	job->arg = atomic_load_explicit(&slot->arg, memory_order_relaxed);
+	job->counter = atomic_load_explicit(&slot->counter, memory_order_relaxed);
+}
+
+/****************************
+ * Takes a job from the bottom of the deque of a worker (i.e. LIFO).
+ * Can only be called by the owning worker thread.
+ * @return Zero if the deque is empty.
+ */
+static bool gfx_jobs_take_(GFXJobWorker_* worker, GFXJob_* job)
+{
+	const long long b =
+		atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+
+	atomic_store_explicit(&worker->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	long long t =
+		atomic_load_explicit(&worker->top, memory_order_relaxed);
+
+	// Empty.
+	if (t > b)
+	{
+		atomic_store_explicit(&worker->bottom, b + 1, memory_order_relaxed);
+		return 0;
+	}
+
+	gfx_jobs_read_(&worker->slots[b & (GFX_JOBS_DEQUE_SIZE_ - 1)], job);
+
+	// Last job, race against thieves.
+	if (t == b)
+	{
+		const bool won = atomic_compare_exchange_strong_explicit(
+			&worker->top, &t, t + 1,
+			memory_order_seq_cst, memory_order_relaxed);
+
+		atomic_store_explicit(&worker->bottom, b + 1, memory_order_relaxed);
+		return won;
+	}
+
+	return 1;
+}
+
+/****************************
+ * Steals a job from the top of the deque of a worker (i.e. FIFO).
+ * Can be called from any thread.
+ * @return Zero if the deque is empty or another thread won the job.
+ */
+static bool gfx_jobs_steal_(GFXJobWorker_* worker, GFXJob_* job)
+{
+	long long t =
+		atomic_load_explicit(&worker->top, memory_order_acquire);
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	const long long b =
+		atomic_load_explicit(&worker->bottom, memory_order_acquire);
+
+	if (t >= b)
+		return 0;
+
+	gfx_jobs_read_(&worker->slots[t & (GFX_JOBS_DEQUE_SIZE_ - 1)], job);
+
+	return atomic_compare_exchange_strong_explicit(
+		&worker->top, &t, t + 1,
+		memory_order_seq_cst, memory_order_relaxed);
+}
+
+/****************************
+ * Finds a job to execute, in order of preference:
+ * the own deque, the injected jobs and lastly the deques of other workers.
+ * @param self Worker of the calling thread, NULL if not a worker.
+ * @return Zero if no job was found.
+ */
+static bool gfx_jobs_find_(GFXJobs* jobs, GFXJobWorker_* self, GFXJob_* job)
+{
+	if (self != NULL && gfx_jobs_take_(self, job))
+		return 1;
+
+	// Check for injected jobs without locking first.
+	if (atomic_load_explicit(&jobs->numInjected, memory_order_relaxed) > 0)
+	{
+		bool found = 0;
+		gfx_mutex_lock_(&jobs->lock);
+
+		if (jobs->injected.size > 0)
+		{
+			*job = *(GFXJob_*)gfx_deque_at(&jobs->injected, 0);
+			gfx_deque_pop_front(&jobs->injected, 1);
+			atomic_fetch_sub_explicit(&jobs->numInjected, 1, memory_order_relaxed);
+			found = 1;
+		}
+
+		gfx_mutex_unlock_(&jobs->lock);
+		if (found) return 1;
+	}
+
+	// Steal from all other workers, starting at a random one.
+	unsigned int victim;
+
+	if (self != NULL)
+	{
+		// Xorshift32.
+		self->seed ^= self->seed << 13;
+		self->seed ^= self->seed >> 17;
+		self->seed ^= self->seed << 5;
+		victim = self->seed % jobs->numWorkers;
+	}
+	else
+	{
+		victim = atomic_fetch_add_explicit(
+			&jobs->next, 1, memory_order_relaxed) % jobs->numWorkers;
+	}
+
+	for (unsigned int w = 0; w < jobs->numWorkers; ++w)
+	{
+		GFXJobWorker_* worker =
+			jobs->workers + (victim + w) % jobs->numWorkers;
+
+		if (worker != self && gfx_jobs_steal_(worker, job))
+			return 1;
+	}
+
+	return 0;
+}
+
+/****************************
+ * Signals that jobs were forked, waking up sleeping workers.
+ */
+static void gfx_jobs_wake_(GFXJobs* jobs)
+{
+	// The sequentially consistent order of these and the operations in
+	// gfx_jobs_thread_ guarantees that either the worker sees the new
+	// pushes count, or we see it sleeping (and it holds the lock).
+	atomic_fetch_add(&jobs->pushes, 1);
+
+	if (atomic_load(&jobs->sleeping) > 0)
+	{
+		gfx_mutex_lock_(&jobs->sleepLock);
+		gfx_cond_broadcast_(&jobs->cond);
+		gfx_mutex_unlock_(&jobs->sleepLock);
+	}
+}
+
+/****************************
+ * Thread entry point of a worker.
+ */
+static void gfx_jobs_thread_(void* ptr)
+{
+	GFXJobWorker_* worker = ptr;
+	GFXJobs* jobs = worker->jobs;
+
+	// Attach to groufix & inherit the logging state.
+	// If attaching fails we can still do work, logging will use defaults.
+	const bool attached = gfx_create_local_();
+	if (attached)
+	{
+		GFXThreadState_* state = gfx_get_local_();
+		state->log.level = jobs->level;
+		gfx_buf_writer(&state->log.out, jobs->log);
+	}
+
+	gfx_thread_key_set_(jobs->key, worker);
+
+	// Keep executing jobs, spin for a bit when there are none,
+	// then sleep until new jobs are forked.
+	unsigned int spins = 0;
+
+	while (1)
+	{
+		const size_t pushes = atomic_load(&jobs->pushes);
+		GFXJob_ job;
+
+		if (gfx_jobs_find_(jobs, worker, &job))
+		{
+			gfx_jobs_run_(jobs, &job);
+			spins = 0;
+			continue;
+		}
+
+		// Only quit when there are no jobs left.
+		if (atomic_load(&jobs->quit))
+			break;
+
+		if (++spins < GFX_JOBS_SPIN_COUNT_)
+		{
+			gfx_thread_yield_();
+			continue;
+		}
+
+		gfx_mutex_lock_(&jobs->sleepLock);
+		atomic_fetch_add(&jobs->sleeping, 1);
+
+		while (atomic_load(&jobs->pushes) == pushes && !atomic_load(&jobs->quit))
+			gfx_cond_wait_(&jobs->cond, &jobs->sleepLock);
+
+		atomic_fetch_sub(&jobs->sleeping, 1);
+		gfx_mutex_unlock_(&jobs->sleepLock);
+
+		spins = 0;
+	}
+
+	gfx_thread_key_set_(jobs->key, NULL);
+
+	if (attached)
+		gfx_destroy_local_();
+}
+
+/****************************/
+GFX_API GFXJobs* gfx_create_jobs(unsigned int numWorkers)
+{
+	assert(atomic_load(&groufix_.initialized));
+
+	if (numWorkers == 0)
+		numWorkers = gfx_thread_count_();
+
+	// Allocate a new scheduler.
+	GFXJobs* jobs = malloc(sizeof(GFXJobs));
+	if (jobs == NULL) goto clean;
+
+	jobs->workers = malloc(sizeof(GFXJobWorker_) * numWorkers);
+	if (jobs->workers == NULL) goto clean;
+
+	if (!gfx_thread_key_init_(&jobs->key, NULL))
+		goto clean;
+
+	if (!gfx_mutex_init_(&jobs->lock))
+		goto clean_key;
+
+	if (!gfx_mutex_init_(&jobs->sleepLock))
+		goto clean_lock;
+
+	if (!gfx_cond_init_(&jobs->cond))
+		goto clean_sleep_lock;
+
+	if (!gfx_mutex_init_(&jobs->joinLock))
+		goto clean_cond;
+
+	if (!gfx_cond_init_(&jobs->joinCond))
+		goto clean_join_lock;
+
+	gfx_deque_init(&jobs->injected, sizeof(GFXJob_));
+	atomic_store(&jobs->numInjected, 0);
+	atomic_store(&jobs->next, 0);
+	atomic_store(&jobs->sleeping, 0);
+	atomic_store(&jobs->pushes, 0);
+	atomic_store(&jobs->quit, 0);
+	atomic_store(&jobs->joining, 0);
+
+	GFXThreadState_* state = gfx_get_local_();
+	jobs->level = state != NULL ? state->log.level : groufix_.logDef;
+	jobs->log = state != NULL ? state->log.out.dest : gfx_io_buf_def_.dest;
+
+	// Initialize all deques before starting any worker, so the number of
+	// deques to steal from never changes while running.
+	// The workers array cannot be moved from here on!
+	jobs->numWorkers = numWorkers;
+	jobs->numThreads = 0;
+
+	for (unsigned int w = 0; w < numWorkers; ++w)
+	{
+		GFXJobWorker_* worker = jobs->workers + w;
+		atomic_store(&worker->top, 0);
+		atomic_store(&worker->bottom, 0);
+
+		worker->jobs = jobs;
+		worker->seed = (w + 1) * 0x9e3779b9u; // Must be non-zero.
+	}
+
+	// Start all workers, deques of workers that could not be started
+	// simply remain empty.
+	for (unsigned int w = 0; w < numWorkers; ++w)
+	{
+		GFXJobWorker_* worker = jobs->workers + w;
+		if (!gfx_thread_init_(&worker->thread, gfx_jobs_thread_, worker))
+			break;
+
+		++jobs->numThreads;
+	}
+
+	if (jobs->numThreads == 0)
+		goto clean_join_cond;
+
+	if (jobs->numThreads < numWorkers)
+		gfx_log_warn(
+			"Could only start %u out of %u worker threads of job scheduler.",
+			jobs->numThreads, numWorkers);
+
+	gfx_log_info(
+		"Created job scheduler with %u worker thread(s).",
+		jobs->numThreads);
+
+	return jobs;
+
+
+	// Cleanup on failure.
+clean_join_cond:
+	gfx_deque_clear(&jobs->injected);
+	gfx_cond_clear_(&jobs->joinCond);
+clean_join_lock:
+	gfx_mutex_clear_(&jobs->joinLock);
+clean_cond:
+	gfx_cond_clear_(&jobs->cond);
+clean_sleep_lock:
+	gfx_mutex_clear_(&jobs->sleepLock);
+clean_lock:
+	gfx_mutex_clear_(&jobs->lock);
+clean_key:
+	gfx_thread_key_clear_(jobs->key);
+clean:
+	gfx_log_error("Could not create a new job scheduler.");
+
+	if (jobs != NULL) free(jobs->workers);
+	free(jobs);
+
+	return NULL;
+}
+
+/****************************/
+GFX_API void gfx_destroy_jobs(GFXJobs* jobs)
+{
+	if (jobs == NULL)
+		return;
+
+	assert(gfx_thread_key_get_(jobs->key) == NULL);
+
+	// Signal all workers to quit, they will first finish all jobs.
+	// Lock so no worker can be in between checking & waiting.
+	atomic_store(&jobs->quit, 1);
+
+	gfx_mutex_lock_(&jobs->sleepLock);
+	gfx_cond_broadcast_(&jobs->cond);
+	gfx_mutex_unlock_(&jobs->sleepLock);
+
+	for (unsigned int w = 0; w < jobs->numThreads; ++w)
+		gfx_thread_join_(&jobs->workers[w].thread);
+
+	// Then free all the things.
+	gfx_deque_clear(&jobs->injected);
+	gfx_cond_clear_(&jobs->joinCond);
+	gfx_mutex_clear_(&jobs->joinLock);
+	gfx_cond_clear_(&jobs->cond);
+	gfx_mutex_clear_(&jobs->sleepLock);
+	gfx_mutex_clear_(&jobs->lock);
+	gfx_thread_key_clear_(jobs->key);
+
+	free(jobs->workers);
+	free(jobs);
+}
+
+/****************************/
+GFX_API unsigned int gfx_jobs_get_num_workers(GFXJobs* jobs)
+{
+	assert(jobs != NULL);
+
+	return jobs->numThreads;
+}
+
+/****************************/
+GFX_API void gfx_jobs_fork(GFXJobs* jobs, GFXJobCounter* counter,
+                           size_t numJobs, GFXJobFunc func,
+                           void* args, size_t stride)
+{
+	assert(jobs != NULL);
+	assert(func != NULL);
+
+	if (numJobs == 0)
+		return;
+
+	// Count all jobs before any of them can finish.
+	if (counter != NULL)
+		atomic_fetch_add_explicit(
+			&counter->pending, numJobs, memory_order_relaxed);
+
+	// Workers push to their own deque.
+	GFXJobWorker_* self = gfx_thread_key_get_(jobs->key);
+	size_t j = 0;
+
+	if (self != NULL)
+		for (; j < numJobs; ++j)
+		{
+			const GFXJob_ job = {
+				.func = func,
+				.arg = GFX_JOBS_ARG_(args, stride, j),
+				.counter = counter
+			};
+
+			if (!gfx_jobs_push_(self, &job))
+				break;
+		}
+
+	// Other threads (or if the deque is full) inject them.
+	if (j < numJobs)
+	{
+		gfx_mutex_lock_(&jobs->lock);
+
+		const bool reserved = gfx_deque_reserve(
+			&jobs->injected, jobs->injected.size + (numJobs - j));
+
+		if (reserved)
+		{
+			for (size_t k = j; k < numJobs; ++k)
+				gfx_deque_push(&jobs->injected, 1, &(GFXJob_){
+					.func = func,
+					.arg = GFX_JOBS_ARG_(args, stride, k),
+					.counter = counter
+				});
+
+			atomic_fetch_add_explicit(
+				&jobs->numInjected, numJobs - j, memory_order_relaxed);
+		}
+
+		gfx_mutex_unlock_(&jobs->lock);
+
+		// If out of memory, just execute them right here.
+		if (!reserved)
+			for (; j < numJobs; ++j)
+				gfx_jobs_run_(jobs, &(GFXJob_){
+					.func = func,
+					.arg = GFX_JOBS_ARG_(args, stride, j),
+					.counter = counter
+				});
+	}
+
+	gfx_jobs_wake_(jobs);
+}
+
+/****************************/
+GFX_API void gfx_jobs_join(GFXJobs* jobs, GFXJobCounter* counter)
+{
+	assert(jobs != NULL);
+	assert(counter != NULL);
+
+	GFXJobWorker_* self = gfx_thread_key_get_(jobs->key);
+
+	// Help out while waiting.
+	unsigned int spins = 0;
+
+	while (atomic_load_explicit(&counter->pending, memory_order_acquire) > 0)
+	{
+		GFXJob_ job;
+
+		if (gfx_jobs_find_(jobs, self, &job))
+		{
+			gfx_jobs_run_(jobs, &job);
+			spins = 0;
+			continue;
+		}
+
+		// Workers keep looking for jobs, as they may need to execute
+		// jobs forked from within the jobs we are waiting on.
+		if (self != NULL || ++spins < GFX_JOBS_SPIN_COUNT_)
+		{
+			gfx_thread_yield_();
+			continue;
+		}
+
+		// Other threads block until the counter reaches zero.
+		gfx_mutex_lock_(&jobs->joinLock);
+		atomic_fetch_add(&jobs->joining, 1);
+
+		while (atomic_load(&counter->pending) > 0)
+			gfx_cond_wait_(&jobs->joinCond, &jobs->joinLock);
+
+		atomic_fetch_sub(&jobs->joining, 1);
+		gfx_mutex_unlock_(&jobs->joinLock);
+	}
+}
+
+/****************************
+ * Retrieves the shared job scheduler, creates it if there is none yet.
+ * @return NULL if groufix is not initialized or it could not be created.
+ */
+static GFXJobs* gfx_jobs_shared_(void)
+{
+	if (!atomic_load(&groufix_.initialized))
+		return NULL;
+
+	gfx_mutex_lock_(&groufix_.jobs.lock);
+
+	if (groufix_.jobs.jobs == NULL)
+		groufix_.jobs.jobs = gfx_create_jobs(0);
+
+	GFXJobs* jobs = groufix_.jobs.jobs;
+	gfx_mutex_unlock_(&groufix_.jobs.lock);
+
+	return jobs;
+}
+
+/****************************
+ * Job entry point of gfx_jobs_parallel_, runs a single sub-range.
+ */
+static void gfx_jobs_parallel_run_(void* ptr)
+{
+	GFXJobsParallel_* par = ptr;
+	const size_t j = atomic_fetch_add_explicit(
+		&par->next, 1, memory_order_relaxed);
+
+	// Spread the remainder over the first jobs.
+	const size_t size = par->count / par->numJobs;
+	const size_t rem = par->count % par->numJobs;
+	const size_t begin = j * size + GFX_MIN(j, rem);
+	const size_t end = begin + size + (j < rem ? 1 : 0);
+
+	// Temporarily take on the logging state of the forking thread.
+	GFXThreadState_* state = gfx_get_local_();
+	GFXLogLevel level = GFX_LOG_NONE;
+	const GFXWriter* log = NULL;
+
+	if (state != NULL)
+	{
+		level = state->log.level;
+		log = state->log.out.dest;
+		state->log.level = par->level;
+		gfx_buf_writer(&state->log.out, par->log);
+	}
+
+	atomic_fetch_add_explicit(
+		&par->result, par->func(par->arg, begin, end), memory_order_relaxed);
+
+	if (state != NULL)
+	{
+		state->log.level = level;
+		gfx_buf_writer(&state->log.out, log);
+	}
+}
+
+/****************************/
+size_t gfx_jobs_parallel_(size_t count, unsigned int numJobs,
+                          size_t (*func)(void*, size_t, size_t), void* arg)
+{
+	assert(func != NULL);
+
+	if (count == 0)
+		return 0;
+
+	// Split into at most one job per index.
+	if (numJobs == 0)
+		numJobs = gfx_thread_count_();
+
+	if (numJobs > count)
+		numJobs = (unsigned int)count;
+
+	// No need or no scheduler, run everything right here.
+	GFXJobs* jobs = numJobs > 1 ? gfx_jobs_shared_() : NULL;
+	if (jobs == NULL)
+		return func(arg, 0, count);
+
+	GFXThreadState_* state = gfx_get_local_();
+
+	GFXJobsParallel_ par = {
+		.func = func,
+		.arg = arg,
+		.count = count,
+		.numJobs = numJobs,
+		.level = state != NULL ? state->log.level : groufix_.logDef,
+		.log = state != NULL ? state->log.out.dest : gfx_io_buf_def_.dest
+	};
+
+	atomic_init(&par.next, 0);
+	atomic_init(&par.result, 0);
+
+	GFXJobCounter counter = {0};
+	gfx_jobs_fork(jobs, &counter, numJobs, gfx_jobs_parallel_run_, &par, 0);
+	gfx_jobs_join(jobs, &counter);
+
+	return atomic_load_explicit(&par.result, memory_order_relaxed);
+}
+
+/****************************/
+void gfx_jobs_terminate_(void)
+{
+	assert(atomic_load(&groufix_.initialized));
+
+	gfx_destroy_jobs(groufix_.jobs.jobs);
+	groufix_.jobs.jobs = NULL;
+}
@@ -0,0 +1,201 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/core.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+#if defined (GFX_LOCK_STATS)
+
+// Nanoseconds to milliseconds & microseconds.
+#define GFX_NS_TO_MS_(ns) ((double)(ns) / 1000000.0)
+#define GFX_NS_TO_US_(ns) ((double)(ns) / 1000.0)
+
+
+/****************************
+ * All lock statistics, protected by a spinlock,
+ * as the locks of groufix cannot be used to protect themselves.
+ * Never freed, locks may hold on to them for the lifetime of the process.
+ */
+static atomic_flag gfx_lock_sites_lock_ = ATOMIC_FLAG_INIT;
+static GFXLockStats_* gfx_lock_sites_ = NULL;
+
+
+/****************************
+ * Locks the lock statistics.
+ */
+static void gfx_lock_sites_acquire_(void)
+{
+	while (atomic_flag_test_and_set_explicit(
+		&gfx_lock_sites_lock_, memory_order_acquire))
+	{
+		gfx_thread_yield_();
+	}
+}
+
+/****************************
+ * Unlocks the lock statistics.
+ */
+static void gfx_lock_sites_release_(void)
+{
+	atomic_flag_clear_explicit(&gfx_lock_sites_lock_, memory_order_release);
+}
+
+/****************************
+ * Compares two GFXLockStats_* by total wait time, descending.
+ */
+static int gfx_lock_stats_cmp_(const void* l, const void* r)
+{
+	const unsigned long long lw = atomic_load_explicit(
+		&(*(GFXLockStats_* const*)l)->waitTotal, memory_order_relaxed);
+	const unsigned long long rw = atomic_load_explicit(
+		&(*(GFXLockStats_* const*)r)->waitTotal, memory_order_relaxed);
+
+	return (lw < rw) - (lw > rw);
+}
+
+/****************************/
+GFXLockStats_* gfx_lock_stats_get_(const char* name,
+                                   const char* file, unsigned int line)
+{
+	assert(name != NULL);
+	assert(file != NULL);
+
+	gfx_lock_sites_acquire_();
+
+	// Find the initialization site.
+	GFXLockStats_* stats = gfx_lock_sites_;
+	while (
+		stats != NULL &&
+		(stats->line != line || strcmp(stats->file, file) != 0))
+	{
+		stats = stats->next;
+	}
+
+	// Or insert a new one.
+	if (stats == NULL && (stats = malloc(sizeof(GFXLockStats_))) != NULL)
+	{
+		stats->next = gfx_lock_sites_;
+		stats->name = name;
+		stats->file = file;
+		stats->line = line;
+
+		atomic_init(&stats->acquired, 0);
+		atomic_init(&stats->contended, 0);
+		atomic_init(&stats->waitTotal, 0);
+		atomic_init(&stats->waitMax, 0);
+		atomic_init(&stats->held, 0);
+		atomic_init(&stats->holdTotal, 0);
+		atomic_init(&stats->holdMax, 0);
+
+		gfx_lock_sites_ = stats;
+	}
+
+	gfx_lock_sites_release_();
+
+	return stats;
+}
+
+/****************************/
+void gfx_lock_stats_reset_(void)
+{
+	gfx_lock_sites_acquire_();
+
+	for (GFXLockStats_* s = gfx_lock_sites_; s != NULL; s = s->next)
+	{
+		atomic_store_explicit(&s->acquired, 0, memory_order_relaxed);
+		atomic_store_explicit(&s->contended, 0, memory_order_relaxed);
+		atomic_store_explicit(&s->waitTotal, 0, memory_order_relaxed);
+		atomic_store_explicit(&s->waitMax, 0, memory_order_relaxed);
+		atomic_store_explicit(&s->held, 0, memory_order_relaxed);
+		atomic_store_explicit(&s->holdTotal, 0, memory_order_relaxed);
+		atomic_store_explicit(&s->holdMax, 0, memory_order_relaxed);
+	}
+
+	gfx_lock_sites_release_();
+}
+
+#endif
+
+
+/****************************/
+GFX_API void gfx_debug_lock_stats(void)
+{
+#if defined (GFX_LOCK_STATS)
+	// Get the logger first, its lock is instrumented as well.
+	GFXBufWriter* logger = gfx_logger_info();
+	if (logger == NULL) return;
+
+	gfx_lock_sites_acquire_();
+
+	// Sort all sites by total wait time, most contended first.
+	size_t numSites = 0;
+	for (GFXLockStats_* s = gfx_lock_sites_; s != NULL; s = s->next)
+		++numSites;
+
+	GFXLockStats_** sites = malloc(sizeof(GFXLockStats_*) * numSites);
+
+	if (sites == NULL)
+		gfx_io_writef(logger,
+			"Could not allocate lock statistics.");
+	else
+	{
+		numSites = 0;
+		for (GFXLockStats_* s = gfx_lock_sites_; s != NULL; s = s->next)
+			sites[numSites++] = s;
+
+		qsort(sites, numSites, sizeof(GFXLockStats_*), gfx_lock_stats_cmp_);
+
+		gfx_io_writef(logger,
+			"Lock statistics of %"GFX_PRIs" initialization site(s):",
+			numSites);
+
+		for (size_t i = 0; i < numSites; ++i)
+		{
+			GFXLockStats_* s = sites[i];
+
+			const unsigned long long acquired =
+				atomic_load_explicit(&s->acquired, memory_order_relaxed);
+			const unsigned long long contended =
+				atomic_load_explicit(&s->contended, memory_order_relaxed);
+			const unsigned long long held =
+				atomic_load_explicit(&s->held, memory_order_relaxed);
+
+			gfx_io_writef(logger,
+				"\n    %s (%s:%u):\n"
+				"        Acquisitions: %llu, contended: %llu (%.2f%%).\n"
+				"        Wait: %.3f ms total, %.3f us max.\n"
+				"        Hold: %.3f us average, %.3f us max.",
+				s->name, s->file, s->line,
+				acquired, contended,
+				acquired > 0 ?
+					100.0 * (double)contended / (double)acquired : 0.0,
+				GFX_NS_TO_MS_(atomic_load_explicit(
+					&s->waitTotal, memory_order_relaxed)),
+				GFX_NS_TO_US_(atomic_load_explicit(
+					&s->waitMax, memory_order_relaxed)),
+				held > 0 ? GFX_NS_TO_US_(atomic_load_explicit(
+					&s->holdTotal, memory_order_relaxed)) / (double)held : 0.0,
+				GFX_NS_TO_US_(atomic_load_explicit(
+					&s->holdMax, memory_order_relaxed)));
+		}
+
+		free(sites);
+	}
+
+	gfx_lock_sites_release_();
+	gfx_logger_end(logger);
+
+#else
+	gfx_log_warn(
+		"Lock statistics are not available, "
+		"groufix was not built with GFX_LOCK_STATS.");
+
+#endif
+}
@@ -72,6 +72,12 @@ int gfx_hash_cmp_(const void* l, const void* r);
  */
 uint64_t gfx_hash_murmur3_(const void* key);
 
+/**
+ * MurmurHash3 (32 bits) implementation for arbitrary data.
+ * @param bytes Cannot be NULL if len > 0, does not need to be aligned.
+ */
+uint64_t gfx_hash_murmur3_bytes_(size_t len, const void* bytes);
+
 /**
  * Initializes a hash key builder.
  * Needs to eventually be 'cleared' with a call to gfx_hash_builder_get_().
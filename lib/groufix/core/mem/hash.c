@@ -44,7 +44,13 @@ int gfx_hash_cmp_(const void* l, const void* r)
 uint64_t gfx_hash_murmur3_(const void* key)
 {
 	const GFXHashKey_* cKey = key;
-	const size_t nblocks = cKey->len / sizeof(uint32_t);
+	return gfx_hash_murmur3_bytes_(cKey->len, cKey->bytes);
+}
+
+/****************************/
+uint64_t gfx_hash_murmur3_bytes_(size_t len, const void* bytes)
+{
+	const size_t nblocks = len / sizeof(uint32_t);
 
 	uint32_t h = GFX_HASH_SEED_;
 
@@ -52,11 +58,13 @@ uint64_t gfx_hash_murmur3_(const void* key)
 	const uint32_t c2 = 0x1b873593;
 
 	// Process the body in blocks of 4 bytes.
-	const uint32_t* body = (const uint32_t*)cKey->bytes + nblocks;
+	// Use memcpy, bytes is not necessarily aligned.
+	const uint8_t* body = (const uint8_t*)bytes;
 
-	for (size_t i = nblocks; i; --i)
+	for (size_t i = 0; i < nblocks; ++i)
 	{
-		uint32_t k = *(body - i);
+		uint32_t k;
+		memcpy(&k, body + i * sizeof(uint32_t), sizeof(uint32_t));
 
 		k *= c1;
 		k = GFX_ROTL32_(k, 15);
@@ -68,11 +76,11 @@ uint64_t gfx_hash_murmur3_(const void* key)
 	}
 
 	// Process the tail bytes.
-	const uint8_t* tail = (const uint8_t*)body;
+	const uint8_t* tail = body + nblocks * sizeof(uint32_t);
 
 	uint32_t k = 0;
 
-	switch (cKey->len & 3)
+	switch (len & 3)
 	{
 	case 3:
 		k ^= (uint32_t)tail[2] << 16;
@@ -89,7 +97,7 @@ uint64_t gfx_hash_murmur3_(const void* key)
 	}
 
 	// Finalize.
-	h ^= (uint32_t)cKey->len;
+	h ^= (uint32_t)len;
 
 	h ^= h >> 16;
 	h *= 0x85ebca6b;
@@ -661,7 +661,7 @@ GFXPoolElem_* gfx_pool_get_(GFXPool_* pool, GFXPoolSub_* sub,
 		// We need to lock for this again.
 		if (sub->block == NULL)
 		{
-			gfx_mutex_lock_(&pool->subLock);
+			gfx_mutex_lock_spin_(&pool->subLock);
 
 			sub->block = (GFXPoolBlock_*)pool->free.head;
 			if (sub->block != NULL)
@@ -702,7 +702,7 @@ GFXPoolElem_* gfx_pool_get_(GFXPool_* pool, GFXPoolSub_* sub,
 			result == VK_ERROR_FRAGMENTED_POOL ||
 			result == VK_ERROR_OUT_OF_POOL_MEMORY)
 		{
-			gfx_mutex_lock_(&pool->subLock);
+			gfx_mutex_lock_spin_(&pool->subLock);
 
 			// Don't forget to set the full flag!
 			sub->block->full = 1;
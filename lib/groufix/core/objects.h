@@ -490,6 +490,15 @@ struct GFXShader
 	} reflect;
 
 
+	// SPIR-V bytecode (kept for gfx_shader_store), may be NULL.
+	struct
+	{
+		size_t    size; // In bytes.
+		uint32_t* code;
+
+	} spirv;
+
+
 	// Vulkan fields.
 	struct
 	{
@@ -499,6 +508,78 @@ struct GFXShader
 };
 
 
+/**
+ * Shader cache element (i.e. cached SPIR-V bytecode).
+ */
+typedef struct GFXShaderCacheElem_
+{
+	uint64_t stamp; // Last use, for eviction.
+	size_t   size;  // SPIR-V size in bytes.
+	size_t   incs;  // Include table size in bytes.
+
+	// SPIR-V bytecode, followed by the include table.
+	// The include table stores records of a resolved #include directive:
+	//  { uint32_t nameLen, uint32_t len, uint64_t hash, char name[nameLen] }
+	// Where nameLen includes the NULL-terminator.
+	uint32_t* code;
+
+} GFXShaderCacheElem_;
+
+
+/**
+ * Internal shader cache.
+ */
+struct GFXShaderCache
+{
+	GFXMap    entries; // Stores GFXHashKey_ : GFXShaderCacheElem_.
+	GFXMutex_ lock;
+
+	size_t   size;    // Total size of all entries (including keys).
+	size_t   maxSize; // 0 = unbounded.
+	uint64_t stamp;   // Next stamp to hand out.
+
+
+	// Statistics.
+	struct
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+
+	} stats;
+};
+
+
+/**
+ * Include cache data (i.e. the contents of a resolved URI).
+ */
+typedef struct GFXIncludeData_
+{
+	size_t refs; // #references (cache + handed out streams), under lock.
+	size_t len;
+	char   bytes[];
+
+} GFXIncludeData_;
+
+
+/**
+ * Internal include cache.
+ */
+struct GFXIncludeCache
+{
+	GFXIncluder        includer;
+	const GFXIncluder* inc;
+	GFXMutex_          incLock; // Only held while accessing inc.
+
+	// Stores GFXHashKey_ (normalized URI) : GFXIncludeData_*,
+	// where NULL data means the URI could not be resolved.
+	// Entries being read are pending, cond is signaled when they're done.
+	GFXMap    entries;
+	GFXMutex_ lock;
+	GFXCond_  cond;
+};
+
+
 /****************************
  * Memory objects.
  ****************************/
@@ -841,6 +922,23 @@ typedef struct GFXRecorderPool_
 } GFXRecorderPool_;
 
 
+/**
+ * Dynamic graphics pipeline state (if supported, see GFXContext_).
+ */
+typedef struct GFXDynamicState_
+{
+	VkCullModeFlags     cull;
+	VkFrontFace         front;
+	VkPrimitiveTopology topo;
+	VkBool32            depthTest;
+	VkBool32            depthWrite;
+	VkCompareOp         depthCmp;
+	VkBool32            stencilTest;
+	VkStencilOpState    stencil[2]; // { front, back }.
+
+} GFXDynamicState_;
+
+
 /**
  * Internal recorder.
  */
@@ -870,6 +968,9 @@ struct GFXRecorder
 		GFXCacheElem_* pipeline;
 		GFXPrimitive_* primitive;
 
+		GFXDynamicState_ dynamic;
+		bool             dynamicSet; // Non-zero if dynamic is set.
+
 	} state;
 
 
@@ -1264,6 +1365,36 @@ struct GFXTechnique
 };
 
 
+/**
+ * Technique permutations warmup target.
+ */
+typedef struct GFXPermTarget_
+{
+	GFXPass*              pass;
+	GFXPrimitive*         primitive; // May be NULL.
+	const GFXRenderState* state;     // May be NULL.
+
+} GFXPermTarget_;
+
+
+/**
+ * Internal technique permutations.
+ */
+struct GFXPermutations
+{
+	GFXTechnique* base;   // Never locked, holds the configuration to copy.
+	size_t        budget; // Maximum #variants, 0 = unbounded.
+
+	// Domains of all permuted constants, values are deduplicated.
+	size_t             numDomains;
+	GFXConstantDomain* domains;
+
+	GFXMap    variants; // Stores GFXHashKey_ (values) : GFXTechnique*.
+	GFXVec    targets;  // Stores GFXPermTarget_.
+	GFXMutex_ lock;
+};
+
+
 /**
  * Set update entry (i.e. descriptor info).
  */
@@ -1734,6 +1865,54 @@ void gfx_sems_finish_(size_t numInjs, const GFXInject* injs,
                       GFXInjection_* injection);
 
 
+/****************************
+ * Shader caching.
+ ****************************/
+
+/**
+ * Appends a resolved #include directive to an include table.
+ * @param incs    Cannot be NULL, must store bytes (element size of 1).
+ * @param name    Cannot be NULL, must be NULL-terminated.
+ * @param content Cannot be NULL if len > 0.
+ * @return Zero on failure.
+ */
+bool gfx_shader_cache_include_(GFXVec* incs, const char* name,
+                               size_t len, const void* content);
+
+/**
+ * Finds cached SPIR-V bytecode by key and validates its include table.
+ * @param cache Cannot be NULL.
+ * @param key   Cannot be NULL.
+ * @param inc   Includer to resolve includes with, may be NULL.
+ * @param size  Outputs the SPIR-V size in bytes, cannot be NULL.
+ * @return Allocated SPIR-V bytecode (must call free()), NULL if not found.
+ *
+ * Thread-safe with respect to the cache!
+ * Updates cache statistics, an invalid include table counts as a miss.
+ */
+uint32_t* gfx_shader_cache_find_(GFXShaderCache* cache,
+                                 const GFXHashKey_* key, const GFXIncluder* inc,
+                                 size_t* size);
+
+/**
+ * Inserts SPIR-V bytecode into the cache, replacing any existing entry.
+ * @param cache Cannot be NULL.
+ * @param key   Cannot be NULL.
+ * @param incs  Include table size in bytes.
+ * @param table Cannot be NULL if incs > 0.
+ * @param size  SPIR-V size in bytes, must be a multiple of sizeof(uint32_t).
+ * @param code  Cannot be NULL.
+ * @return Zero on failure.
+ *
+ * Thread-safe with respect to the cache!
+ * Evicts the least recently used entries to stay within bounds.
+ */
+bool gfx_shader_cache_insert_(GFXShaderCache* cache,
+                              const GFXHashKey_* key,
+                              size_t incs, const void* table,
+                              size_t size, const uint32_t* code);
+
+
 /****************************
  * Heap allocation & transfer flushing.
  ****************************/
@@ -1820,6 +1999,17 @@ bool gfx_flush_transfer_(GFXHeap* heap, GFXTransferPool_* pool);
 bool gfx_renderable_pipeline_(GFXRenderable* renderable,
                               GFXCacheElem_** elem, bool warmup);
 
+/**
+ * Retrieves the dynamic state to record alongside a graphics pipeline.
+ * Only relevant if the context supports GFX_SUPPORT_DYNAMIC_STATE_.
+ * @param renderable Cannot be NULL.
+ * @param state      Output dynamic state, cannot be NULL.
+ *
+ * Completely thread-safe with respect to the renderable!
+ */
+void gfx_renderable_dynamic_(GFXRenderable* renderable,
+                             GFXDynamicState_* state);
+
 /**
  * Retrieves a compute pipeline from the renderer's cache (or warms it up).
  * Essentially a wrapper for gfx_cache_(get|warmup)_.
@@ -2172,6 +2362,15 @@ void gfx_tech_get_set_size_(GFXTechnique* technique,
 bool gfx_tech_get_set_binding_(GFXTechnique* technique,
                                size_t set, size_t binding, GFXSetBinding_* out);
 
+/**
+ * Copies all configuration (constants, samplers, immutable & dynamic
+ * bindings) of a technique into another.
+ * @param dst Cannot be NULL, cannot be locked, must hold the same shaders.
+ * @param src Cannot be NULL, cannot be locked.
+ * @return Zero on failure, dst may be partially copied.
+ */
+bool gfx_tech_copy_(GFXTechnique* dst, GFXTechnique* src);
+
 /**
  * Retrieves, allocates or recycles a Vulkan descriptor set of the given set.
  * @param set Cannot be NULL.
@@ -1101,6 +1101,7 @@ bool gfx_frame_submit_(GFXRenderer* renderer, GFXFrame* frame)
 	const size_t culledCompute = renderer->graph.culledCompute;
 
 	GFXInjection_ injection;
+	GFXWindow_** windows = NULL;
 
 	// Record & submit to the graphics queue.
 	if (culledGraphics < numGraphics)
@@ -1129,14 +1130,21 @@ bool gfx_frame_submit_(GFXRenderer* renderer, GFXFrame* frame)
 		}
 
 		// Get all the available Vulkan semaphores & metadata.
-		// If there are no sync objects, make VLAs of size 1 for legality.
+		// If there are no sync objects, allocate 1 of each for legality.
 		// Then we count the presentable swapchains and go off of that.
-		const size_t vlaSyncs = GFX_MAX(1, frame->syncs.size);
+		const size_t numSyncs = GFX_MAX(1, frame->syncs.size);
 		size_t presentable = 0;
 
-		GFXWindow_* windows[vlaSyncs];
-		uint32_t indices[vlaSyncs];
-		GFXRecreateFlags_ flags[vlaSyncs];
+		windows = gfx_scratch_push_(numSyncs * (
+			sizeof(GFXWindow_*) +
+			sizeof(GFXRecreateFlags_) +
+			sizeof(uint32_t)));
+
+		if (windows == NULL)
+			goto clean_graphics;
+
+		GFXRecreateFlags_* flags = (GFXRecreateFlags_*)(windows + numSyncs);
+		uint32_t* indices = (uint32_t*)(flags + numSyncs);
 
 		// Append available semaphores and stages to the injection output.
 		if (frame->syncs.size > 0)
@@ -1243,6 +1251,9 @@ bool gfx_frame_submit_(GFXRenderer* renderer, GFXFrame* frame)
 				attachs, sync->backing))->window.flags = fl;
 		}
 
+		gfx_scratch_pop_(windows);
+		windows = NULL;
+
 		// Lastly, make all commands visible for future operations.
 		gfx_frame_finalize_(renderer, 1,
 			renderer->graph.out.first, renderer->graph.firstCompute,
@@ -1329,6 +1340,9 @@ bool gfx_frame_submit_(GFXRenderer* renderer, GFXFrame* frame)
 
 	// Cleanup on failure.
 clean_graphics:
+	if (windows != NULL)
+		gfx_scratch_pop_(windows);
+
 	gfx_frame_finalize_(renderer, 0,
 		renderer->graph.out.first, renderer->graph.firstCompute,
 		&injection);
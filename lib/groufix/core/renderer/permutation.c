@@ -0,0 +1,520 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/core/objects.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/****************************
+ * Permutations warmup state.
+ */
+typedef struct GFXPermWarmup_
+{
+	size_t          numVariants;
+	GFXTechnique**  variants;
+	size_t          numTargets; // 0 for compute techniques.
+	GFXPermTarget_* targets;
+
+} GFXPermWarmup_;
+
+
+/****************************
+ * Retrieves (or creates) the variant for a combination of values.
+ * perms->lock must be locked.
+ * @param values    Must all be in their domains.
+ * @param exhausted Set to non-zero if not created because of the budget.
+ * @return NULL on failure.
+ */
+static GFXTechnique* gfx_permutations_variant_(GFXPermutations* perms,
+                                               const GFXConstant* values,
+                                               bool* exhausted)
+{
+	*exhausted = 0;
+
+	// Build a key from all values.
+	GFXHashKey_* key = malloc(
+		sizeof(GFXHashKey_) + sizeof(uint32_t) * perms->numDomains);
+
+	if (key == NULL)
+		goto error;
+
+	key->len = sizeof(uint32_t) * perms->numDomains;
+	for (size_t d = 0; d < perms->numDomains; ++d)
+		memcpy(
+			key->bytes + sizeof(uint32_t) * d,
+			&values[d].u32, sizeof(uint32_t));
+
+	// Check if we already have this variant.
+	GFXTechnique** elem = gfx_map_search(&perms->variants, key);
+	if (elem != NULL)
+	{
+		free(key);
+		return *elem;
+	}
+
+	// Check the budget.
+	if (perms->budget > 0 && perms->variants.size >= perms->budget)
+	{
+		*exhausted = 1;
+		free(key);
+		return NULL;
+	}
+
+	// Create a new technique with the same shaders & configuration.
+	GFXTechnique* base = perms->base;
+	GFXShader* shaders[GFX_NUM_SHADER_STAGES_];
+	size_t numShaders = 0;
+
+	for (size_t s = 0; s < GFX_NUM_SHADER_STAGES_; ++s)
+		if (base->shaders[s] != NULL)
+			shaders[numShaders++] = base->shaders[s];
+
+	GFXTechnique* tech =
+		gfx_renderer_add_tech(base->renderer, numShaders, shaders);
+
+	if (tech == NULL)
+		goto clean_key;
+
+	if (!gfx_tech_copy_(tech, base))
+		goto clean_tech;
+
+	// Then override all permuted constants & lock it.
+	for (size_t d = 0; d < perms->numDomains; ++d)
+	{
+		const GFXConstantDomain* dom = perms->domains + d;
+		if (!gfx_tech_constant(tech, dom->id, dom->stage, dom->size, values[d]))
+			goto clean_tech;
+	}
+
+	if (!gfx_tech_lock(tech))
+		goto clean_tech;
+
+	if (!gfx_map_insert(&perms->variants, &tech, gfx_hash_size_(key), key))
+		goto clean_tech;
+
+	free(key);
+
+	return tech;
+
+
+	// Cleanup on failure.
+clean_tech:
+	gfx_erase_tech(tech);
+clean_key:
+	free(key);
+error:
+	gfx_log_error("Could not create a new technique variant.");
+
+	return NULL;
+}
+
+/****************************
+ * Warms up a range of pipelines (variant/target pairs) of a warmup,
+ * for use in gfx_jobs_parallel_.
+ * @return Number of successfully warmed up pipelines.
+ */
+static size_t gfx_permutations_warm_(void* ptr, size_t begin, size_t end)
+{
+	GFXPermWarmup_* warmup = ptr;
+	size_t warmed = 0;
+
+	for (size_t j = begin; j < end; ++j)
+	{
+		if (warmup->numTargets == 0)
+		{
+			GFXComputable computable;
+			if (
+				gfx_computable(&computable, warmup->variants[j]) &&
+				gfx_computable_pipeline_(&computable, NULL, 1))
+			{
+				++warmed;
+			}
+		}
+		else
+		{
+			const GFXPermTarget_* target =
+				warmup->targets + (j % warmup->numTargets);
+
+			GFXRenderable renderable;
+			if (
+				gfx_renderable(&renderable,
+					target->pass, warmup->variants[j / warmup->numTargets],
+					target->primitive, target->state) &&
+				gfx_renderable_pipeline_(&renderable, NULL, 1))
+			{
+				++warmed;
+			}
+		}
+	}
+
+	return warmed;
+}
+
+/****************************/
+GFX_API GFXPermutations* gfx_tech_create_permutations(GFXTechnique* technique,
+                                                      size_t numDomains,
+                                                      const GFXConstantDomain* domains,
+                                                      size_t budget)
+{
+	assert(technique != NULL);
+	assert(numDomains > 0);
+	assert(domains != NULL);
+
+	// Cannot copy the configuration of a locked technique.
+	if (technique->layout != NULL)
+	{
+		gfx_log_error(
+			"Could not create technique permutations; "
+			"technique is already locked.");
+
+		return NULL;
+	}
+
+	// Allocate permutations, all domains & their values in one go.
+	size_t numValues = 0;
+	for (size_t d = 0; d < numDomains; ++d)
+	{
+		assert(domains[d].stage != 0);
+		assert(domains[d].numValues > 0);
+		assert(domains[d].values != NULL);
+
+		numValues += domains[d].numValues;
+	}
+
+	GFXPermutations* perms = malloc(
+		sizeof(GFXPermutations) +
+		sizeof(GFXConstantDomain) * numDomains +
+		sizeof(GFXConstant) * numValues);
+
+	if (perms == NULL)
+		goto clean;
+
+	// Copy all domains, deduplicating their values.
+	GFXConstant* values = (GFXConstant*)(
+		(char*)perms + sizeof(GFXPermutations) +
+		sizeof(GFXConstantDomain) * numDomains);
+
+	perms->budget = budget;
+	perms->numDomains = numDomains;
+	perms->domains = (GFXConstantDomain*)(perms + 1);
+
+	for (size_t d = 0; d < numDomains; ++d)
+	{
+		GFXConstant* domValues = values;
+		size_t domNumValues = 0;
+
+		for (size_t v = 0; v < domains[d].numValues; ++v)
+		{
+			size_t u;
+			for (u = 0; u < domNumValues; ++u)
+				if (domValues[u].u32 == domains[d].values[v].u32) break;
+
+			if (u == domNumValues)
+				domValues[domNumValues++] = domains[d].values[v];
+		}
+
+		perms->domains[d] = domains[d];
+		perms->domains[d].numValues = domNumValues;
+		perms->domains[d].values = domValues;
+
+		values += domNumValues;
+	}
+
+	// Copy the technique into a base technique that is never locked.
+	GFXShader* shaders[GFX_NUM_SHADER_STAGES_];
+	size_t numShaders = 0;
+
+	for (size_t s = 0; s < GFX_NUM_SHADER_STAGES_; ++s)
+		if (technique->shaders[s] != NULL)
+			shaders[numShaders++] = technique->shaders[s];
+
+	perms->base =
+		gfx_renderer_add_tech(technique->renderer, numShaders, shaders);
+
+	if (perms->base == NULL)
+		goto clean;
+
+	if (!gfx_tech_copy_(perms->base, technique))
+		goto clean_base;
+
+	if (!gfx_mutex_init_(&perms->lock))
+		goto clean_base;
+
+	gfx_map_init(&perms->variants,
+		sizeof(GFXTechnique*), gfx_hash_murmur3_, gfx_hash_cmp_);
+	gfx_vec_init(&perms->targets,
+		sizeof(GFXPermTarget_));
+
+	return perms;
+
+
+	// Cleanup on failure.
+clean_base:
+	gfx_erase_tech(perms->base);
+clean:
+	gfx_log_error("Could not create technique permutations.");
+	free(perms);
+
+	return NULL;
+}
+
+/****************************/
+GFX_API void gfx_destroy_permutations(GFXPermutations* perms)
+{
+	if (perms == NULL)
+		return;
+
+	// Erase all variants & the base technique.
+	for (
+		GFXTechnique** elem = gfx_map_first(&perms->variants);
+		elem != NULL;
+		elem = gfx_map_next(&perms->variants, elem))
+	{
+		gfx_erase_tech(*elem);
+	}
+
+	gfx_erase_tech(perms->base);
+
+	gfx_map_clear(&perms->variants);
+	gfx_vec_clear(&perms->targets);
+	gfx_mutex_clear_(&perms->lock);
+
+	free(perms);
+}
+
+/****************************/
+GFX_API size_t gfx_permutations_get_count(GFXPermutations* perms)
+{
+	assert(perms != NULL);
+
+	size_t count = 1;
+	for (size_t d = 0; d < perms->numDomains; ++d)
+	{
+		const size_t numValues = perms->domains[d].numValues;
+		if (count > SIZE_MAX / numValues)
+			return SIZE_MAX;
+
+		count *= numValues;
+	}
+
+	return count;
+}
+
+/****************************/
+GFX_API GFXTechnique* gfx_permutations_get(GFXPermutations* perms,
+                                           const GFXConstant* values)
+{
+	assert(perms != NULL);
+	assert(values != NULL);
+
+	// Validate that all values are in their domains.
+	for (size_t d = 0; d < perms->numDomains; ++d)
+	{
+		const GFXConstantDomain* dom = perms->domains + d;
+
+		size_t v;
+		for (v = 0; v < dom->numValues; ++v)
+			if (dom->values[v].u32 == values[d].u32) break;
+
+		if (v == dom->numValues)
+		{
+			gfx_log_error(
+				"Could not get technique variant; value of specialization "
+				"constant (id=%"PRIu32") is not in its domain.",
+				dom->id);
+
+			return NULL;
+		}
+	}
+
+	// Get the variant.
+	bool exhausted;
+	gfx_mutex_lock_(&perms->lock);
+	GFXTechnique* tech = gfx_permutations_variant_(perms, values, &exhausted);
+	gfx_mutex_unlock_(&perms->lock);
+
+	if (exhausted)
+		gfx_log_warn(
+			"Could not get technique variant; "
+			"budget of %"GFX_PRIs" variants exhausted.",
+			perms->budget);
+
+	return tech;
+}
+
+/****************************/
+GFX_API bool gfx_permutations_register(GFXPermutations* perms,
+                                       GFXPass* pass, GFXPrimitive* prim,
+                                       const GFXRenderState* state)
+{
+	assert(perms != NULL);
+	assert(pass != NULL);
+
+	// Same checks as gfx_renderable, but upfront.
+	if (
+		pass->renderer != perms->base->renderer ||
+		pass->type != GFX_PASS_RENDER)
+	{
+		gfx_log_error(
+			"Could not register parameters to technique permutations; "
+			"pass must be a render pass of the same renderer.");
+
+		return 0;
+	}
+
+	const GFXPermTarget_ target = {
+		.pass = pass,
+		.primitive = prim,
+		.state = state
+	};
+
+	gfx_mutex_lock_(&perms->lock);
+
+	// Deduplicate.
+	for (size_t t = 0; t < perms->targets.size; ++t)
+	{
+		const GFXPermTarget_* other = gfx_vec_at(&perms->targets, t);
+		if (
+			other->pass == pass &&
+			other->primitive == prim &&
+			other->state == state)
+		{
+			gfx_mutex_unlock_(&perms->lock);
+			return 1;
+		}
+	}
+
+	const bool success = gfx_vec_push(&perms->targets, 1, &target);
+	gfx_mutex_unlock_(&perms->lock);
+
+	if (!success)
+		gfx_log_error(
+			"Could not register parameters to technique permutations.");
+
+	return success;
+}
+
+/****************************/
+GFX_API size_t gfx_permutations_warmup(GFXPermutations* perms,
+                                       unsigned int numThreads)
+{
+	assert(perms != NULL);
+
+	GFXRenderer* renderer = perms->base->renderer;
+	const bool compute = perms->base->shaders[
+		GFX_GET_SHADER_STAGE_INDEX_(GFX_STAGE_COMPUTE)] != NULL;
+
+	// Only warm up the variants that are registered (i.e. reachable),
+	// enumerating all combinations would explode with #domains.
+	// Copy them & all targets so more can be registered during the warmup.
+	bool failed = 0;
+	gfx_mutex_lock_(&perms->lock);
+
+	size_t numVariants = perms->variants.size;
+	GFXTechnique** variants = NULL;
+
+	if (numVariants > 0)
+	{
+		variants = malloc(sizeof(GFXTechnique*) * numVariants);
+		if (variants == NULL)
+		{
+			numVariants = 0;
+			failed = 1;
+		}
+		else
+		{
+			size_t v = 0;
+			for (
+				GFXTechnique** elem = gfx_map_first(&perms->variants);
+				elem != NULL;
+				elem = gfx_map_next(&perms->variants, elem))
+			{
+				variants[v++] = *elem;
+			}
+		}
+	}
+
+	GFXPermTarget_* targets = NULL;
+	size_t numTargets = compute ? 0 : perms->targets.size;
+
+	if (numTargets > 0)
+	{
+		targets = malloc(sizeof(GFXPermTarget_) * numTargets);
+		if (targets == NULL)
+		{
+			numTargets = 0;
+			failed = 1;
+		}
+		else memcpy(targets,
+			gfx_vec_at(&perms->targets, 0),
+			sizeof(GFXPermTarget_) * numTargets);
+	}
+
+	gfx_mutex_unlock_(&perms->lock);
+
+	if (failed)
+		gfx_log_error(
+			"Could not copy registered technique permutations for warmup.");
+
+	// Nothing to do.
+	if (numVariants == 0 || (!compute && numTargets == 0))
+	{
+		free(variants);
+		free(targets);
+
+		return 0;
+	}
+
+	// To build graphics pipelines, we need the Vulkan render passes.
+	// @see gfx_renderable_warmup.
+	if (!compute)
+	{
+		gfx_mutex_lock_(&renderer->reentrantLock);
+		const bool success = gfx_render_graph_warmup_(renderer);
+		gfx_mutex_unlock_(&renderer->reentrantLock);
+
+		if (!success)
+		{
+			gfx_log_error(
+				"Could not warm technique permutations; "
+				"graph warmup failed.");
+
+			free(variants);
+			free(targets);
+
+			return 0;
+		}
+	}
+
+	// Warm up on the shared job scheduler.
+	GFXPermWarmup_ warmup = {
+		.numVariants = numVariants,
+		.variants = variants,
+		.numTargets = numTargets,
+		.targets = targets
+	};
+
+	const size_t numJobs = compute ?
+		numVariants : numVariants * numTargets;
+
+	const size_t warmed = gfx_jobs_parallel_(
+		numJobs, numThreads, gfx_permutations_warm_, &warmup);
+
+	gfx_log_info(
+		"Warmed up technique permutations:\n"
+		"    #variants: %"GFX_PRIs".\n"
+		"    #pipelines: %"GFX_PRIs".\n"
+		"    #failed: %"GFX_PRIs".\n",
+		numVariants, numJobs, numJobs - warmed);
+
+	free(variants);
+	free(targets);
+
+	return warmed;
+}
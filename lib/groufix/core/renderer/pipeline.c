@@ -9,6 +9,46 @@
 #include "groufix/core/objects.h"
 
 
+// Gets the topology that represents an entire topology class,
+// with dynamic topology, pipelines only need to match the class.
+// Adjacency is kept separate, as geometry shaders depend on it.
+#define GFX_GET_VK_TOPOLOGY_CLASS_(vkTopo) \
+	((vkTopo) == VK_PRIMITIVE_TOPOLOGY_LINE_STRIP ? \
+		VK_PRIMITIVE_TOPOLOGY_LINE_LIST : \
+	(vkTopo) == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP ? \
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : \
+	(vkTopo) == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN ? \
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : \
+	(vkTopo) == VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY ? \
+		VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY : \
+	(vkTopo) == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP_WITH_ADJACENCY ? \
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST_WITH_ADJACENCY : \
+		(vkTopo))
+
+
+/****************************
+ * All states that are dynamic if GFX_SUPPORT_DYNAMIC_STATE_ is supported,
+ * the first three are always dynamic.
+ */
+static const VkDynamicState gfx_vk_dynamic_states_[] = {
+	VK_DYNAMIC_STATE_VIEWPORT,
+	VK_DYNAMIC_STATE_SCISSOR,
+	VK_DYNAMIC_STATE_LINE_WIDTH,
+
+	VK_DYNAMIC_STATE_CULL_MODE,
+	VK_DYNAMIC_STATE_FRONT_FACE,
+	VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+	VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+	VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+	VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+	VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE,
+	VK_DYNAMIC_STATE_STENCIL_OP,
+	VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK,
+	VK_DYNAMIC_STATE_STENCIL_WRITE_MASK,
+	VK_DYNAMIC_STATE_STENCIL_REFERENCE
+};
+
+
 /****************************
  * Spin-locks a renderable for pipeline retrieval.
  */
@@ -39,6 +79,114 @@ static inline void gfx_renderable_unlock_(GFXRenderable* renderable)
 	atomic_store_explicit(&renderable->lock, 0, memory_order_release);
 }
 
+/****************************
+ * Computes the (possibly dynamic) state of a renderable.
+ * @param renderable Cannot be NULL.
+ * @param dynamic    Non-zero to leave the dynamic state at constants.
+ * @param state      Output dynamic state, cannot be NULL.
+ * @param raster     Output raster state, cannot be NULL.
+ * @param blend      Output blend state, cannot be NULL.
+ * @param depth      Output depth state, cannot be NULL.
+ * @param stencil    Output stencil state, cannot be NULL.
+ */
+static void gfx_renderable_states_(GFXRenderable* renderable, bool dynamic,
+                                   GFXDynamicState_* state,
+                                   const GFXRasterState** raster,
+                                   const GFXBlendState** blend,
+                                   const GFXDepthState** depth,
+                                   const GFXStencilState** stencil)
+{
+	GFXRenderPass_* rPass = (GFXRenderPass_*)renderable->pass;
+	GFXPrimitive_* prim = (GFXPrimitive_*)renderable->primitive;
+
+	// Gather appropriate state data.
+	*raster =
+		(renderable->state != NULL && renderable->state->raster != NULL) ?
+		renderable->state->raster : &rPass->state.raster;
+
+	*blend =
+		(renderable->state != NULL && renderable->state->blend != NULL) ?
+		renderable->state->blend : &rPass->state.blend;
+
+	*depth =
+		(renderable->state != NULL && renderable->state->depth != NULL) ?
+		renderable->state->depth : &rPass->state.depth;
+
+	*stencil =
+		(renderable->state != NULL && renderable->state->stencil != NULL) ?
+		renderable->state->stencil : &rPass->state.stencil;
+
+	// Compute the state that could be dynamic.
+	const bool noRaster = ((*raster)->mode == GFX_RASTER_DISCARD);
+
+	const VkStencilOpState sos = {
+		.failOp      = VK_STENCIL_OP_KEEP,
+		.passOp      = VK_STENCIL_OP_KEEP,
+		.depthFailOp = VK_STENCIL_OP_KEEP,
+		.compareOp   = VK_COMPARE_OP_NEVER,
+		.compareMask = 0,
+		.writeMask   = 0,
+		.reference   = 0
+	};
+
+	*state = (GFXDynamicState_){
+		.cull        = VK_CULL_MODE_NONE,
+		.front       = VK_FRONT_FACE_CLOCKWISE,
+		.depthTest   = VK_FALSE,
+		.depthWrite  = VK_FALSE,
+		.depthCmp    = VK_COMPARE_OP_ALWAYS,
+		.stencilTest = VK_FALSE,
+		.stencil     = { sos, sos },
+
+		.topo =
+			GFX_GET_VK_PRIMITIVE_TOPOLOGY_(prim != NULL ?
+				prim->base.topology :
+				(*raster)->topo)
+	};
+
+	// Pipelines only need to match the topology class.
+	if (dynamic)
+	{
+		state->topo = GFX_GET_VK_TOPOLOGY_CLASS_(state->topo);
+		return;
+	}
+
+	if (noRaster)
+		return;
+
+	state->cull = GFX_GET_VK_CULL_MODE_((*raster)->cull);
+	state->front = GFX_GET_VK_FRONT_FACE_((*raster)->front);
+
+	if (rPass->state.enabled & GFX_PASS_DEPTH_)
+	{
+		state->depthTest = VK_TRUE;
+		state->depthCmp = GFX_GET_VK_COMPARE_OP_((*depth)->cmp);
+
+		if ((*depth)->flags & GFX_DEPTH_WRITE)
+			state->depthWrite = VK_TRUE;
+	}
+
+	if (rPass->state.enabled & GFX_PASS_STENCIL_)
+	{
+		const GFXStencilOpState* ops[2] = {
+			&(*stencil)->front, &(*stencil)->back
+		};
+
+		state->stencilTest = VK_TRUE;
+
+		for (size_t f = 0; f < 2; ++f)
+			state->stencil[f] = (VkStencilOpState){
+				.failOp = GFX_GET_VK_STENCIL_OP_(ops[f]->fail),
+				.passOp = GFX_GET_VK_STENCIL_OP_(ops[f]->pass),
+				.depthFailOp = GFX_GET_VK_STENCIL_OP_(ops[f]->depthFail),
+				.compareOp = GFX_GET_VK_COMPARE_OP_(ops[f]->cmp),
+				.compareMask = ops[f]->cmpMask,
+				.writeMask = ops[f]->writeMask,
+				.reference = ops[f]->reference
+			};
+	}
+}
+
 /****************************/
 bool gfx_renderable_pipeline_(GFXRenderable* renderable,
                               GFXCacheElem_** elem, bool warmup)
@@ -95,21 +243,19 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 	handles[numShaders+1] = rPass->build.pass;
 
 	// Gather appropriate state data.
-	const GFXRasterState* raster =
-		(renderable->state != NULL && renderable->state->raster != NULL) ?
-		renderable->state->raster : &rPass->state.raster;
-
-	const GFXBlendState* blend =
-		(renderable->state != NULL && renderable->state->blend != NULL) ?
-		renderable->state->blend : &rPass->state.blend;
+	// If the context supports it, part of the state is dynamic,
+	// which is left at constants so it does not affect the pipeline key.
+	const bool dynamic =
+		tech->renderer->cache.context->features & GFX_SUPPORT_DYNAMIC_STATE_;
 
-	const GFXDepthState* depth =
-		(renderable->state != NULL && renderable->state->depth != NULL) ?
-		renderable->state->depth : &rPass->state.depth;
+	GFXDynamicState_ dyn;
+	const GFXRasterState* raster;
+	const GFXBlendState* blend;
+	const GFXDepthState* depth;
+	const GFXStencilState* stencil;
 
-	const GFXStencilState* stencil =
-		(renderable->state != NULL && renderable->state->stencil != NULL) ?
-		renderable->state->stencil : &rPass->state.stencil;
+	gfx_renderable_states_(renderable, dynamic,
+		&dyn, &raster, &blend, &depth, &stencil);
 
 	// Build rasterization info.
 	const bool noRaster = (raster->mode == GFX_RASTER_DISCARD);
@@ -122,8 +268,8 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 		.depthClampEnable        = VK_FALSE,
 		.rasterizerDiscardEnable = VK_TRUE,
 		.polygonMode             = VK_POLYGON_MODE_FILL,
-		.cullMode                = VK_CULL_MODE_NONE,
-		.frontFace               = VK_FRONT_FACE_CLOCKWISE,
+		.cullMode                = dyn.cull,
+		.frontFace               = dyn.front,
 		.depthBiasEnable         = VK_FALSE,
 		.depthBiasConstantFactor = 0.0f,
 		.depthBiasClamp          = 0.0f,
@@ -134,10 +280,7 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 	if (!noRaster)
 	{
 		prsci.rasterizerDiscardEnable = VK_FALSE;
-
 		prsci.polygonMode = GFX_GET_VK_POLYGON_MODE_(raster->mode);
-		prsci.cullMode = GFX_GET_VK_CULL_MODE_(raster->cull);
-		prsci.frontFace = GFX_GET_VK_FRONT_FACE_(raster->front);
 	}
 
 	// Build blend info.
@@ -218,71 +361,29 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 	}
 
 	// Build depth/stencil info.
-	const VkStencilOpState sos = {
-		.failOp      = VK_STENCIL_OP_KEEP,
-		.passOp      = VK_STENCIL_OP_KEEP,
-		.depthFailOp = VK_STENCIL_OP_KEEP,
-		.compareOp   = VK_COMPARE_OP_NEVER,
-		.compareMask = 0,
-		.writeMask   = 0,
-		.reference   = 0
-	};
-
 	VkPipelineDepthStencilStateCreateInfo pdssci = {
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
 
 		.pNext                 = NULL,
 		.flags                 = 0,
-		.depthTestEnable       = VK_FALSE,
-		.depthWriteEnable      = VK_FALSE,
-		.depthCompareOp        = VK_COMPARE_OP_ALWAYS,
+		.depthTestEnable       = dyn.depthTest,
+		.depthWriteEnable      = dyn.depthWrite,
+		.depthCompareOp        = dyn.depthCmp,
 		.depthBoundsTestEnable = VK_FALSE,
-		.stencilTestEnable     = VK_FALSE,
-		.front                 = sos,
-		.back                  = sos,
+		.stencilTestEnable     = dyn.stencilTest,
+		.front                 = dyn.stencil[0],
+		.back                  = dyn.stencil[1],
 		.minDepthBounds        = 0.0f,
 		.maxDepthBounds        = 1.0f
 	};
 
-	if (!noRaster && (rPass->state.enabled & GFX_PASS_DEPTH_))
+	if (
+		!noRaster && (rPass->state.enabled & GFX_PASS_DEPTH_) &&
+		(depth->flags & GFX_DEPTH_BOUNDED))
 	{
-		pdssci.depthTestEnable = VK_TRUE;
-		pdssci.depthCompareOp = GFX_GET_VK_COMPARE_OP_(depth->cmp);
-
-		if (depth->flags & GFX_DEPTH_WRITE)
-			pdssci.depthWriteEnable = VK_TRUE;
-
-		if (depth->flags & GFX_DEPTH_BOUNDED)
-		{
-			pdssci.depthBoundsTestEnable = VK_TRUE;
-			pdssci.minDepthBounds = depth->minDepth;
-			pdssci.maxDepthBounds = depth->maxDepth;
-		}
-	}
-
-	if (!noRaster && (rPass->state.enabled & GFX_PASS_STENCIL_))
-	{
-		pdssci.stencilTestEnable = VK_TRUE;
-
-		pdssci.front = (VkStencilOpState){
-			.failOp = GFX_GET_VK_STENCIL_OP_(stencil->front.fail),
-			.passOp = GFX_GET_VK_STENCIL_OP_(stencil->front.pass),
-			.depthFailOp = GFX_GET_VK_STENCIL_OP_(stencil->front.depthFail),
-			.compareOp = GFX_GET_VK_COMPARE_OP_(stencil->front.cmp),
-			.compareMask = stencil->front.cmpMask,
-			.writeMask = stencil->front.writeMask,
-			.reference = stencil->front.reference
-		};
-
-		pdssci.back = (VkStencilOpState){
-			.failOp = GFX_GET_VK_STENCIL_OP_(stencil->back.fail),
-			.passOp = GFX_GET_VK_STENCIL_OP_(stencil->back.pass),
-			.depthFailOp = GFX_GET_VK_STENCIL_OP_(stencil->back.depthFail),
-			.compareOp = GFX_GET_VK_COMPARE_OP_(stencil->back.cmp),
-			.compareMask = stencil->back.cmpMask,
-			.writeMask = stencil->back.writeMask,
-			.reference = stencil->back.reference
-		};
+		pdssci.depthBoundsTestEnable = VK_TRUE;
+		pdssci.minDepthBounds = depth->minDepth;
+		pdssci.maxDepthBounds = depth->maxDepth;
 	}
 
 	// Build shader info.
@@ -372,13 +473,9 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 		.pInputAssemblyState = (VkPipelineInputAssemblyStateCreateInfo[]){{
 			.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
 
-			.pNext    = NULL,
-			.flags    = 0,
-			.topology =
-				GFX_GET_VK_PRIMITIVE_TOPOLOGY_(prim != NULL ?
-					prim->base.topology :
-					raster->topo),
-
+			.pNext                  = NULL,
+			.flags                  = 0,
+			.topology               = dyn.topo,
 			.primitiveRestartEnable = VK_FALSE
 		}},
 
@@ -414,12 +511,10 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 
 			.pNext             = NULL,
 			.flags             = 0,
-			.dynamicStateCount = 3,
-			.pDynamicStates    = (VkDynamicState[]){
-				VK_DYNAMIC_STATE_VIEWPORT,
-				VK_DYNAMIC_STATE_SCISSOR,
-				VK_DYNAMIC_STATE_LINE_WIDTH
-			}
+			.pDynamicStates    = gfx_vk_dynamic_states_,
+			.dynamicStateCount = dynamic ?
+				(uint32_t)(sizeof(gfx_vk_dynamic_states_) /
+					sizeof(VkDynamicState)) : 3
 		}}
 	};
 
@@ -446,6 +541,22 @@ bool gfx_renderable_pipeline_(GFXRenderable* renderable,
 	}
 }
 
+/****************************/
+void gfx_renderable_dynamic_(GFXRenderable* renderable,
+                             GFXDynamicState_* state)
+{
+	assert(renderable != NULL);
+	assert(state != NULL);
+
+	const GFXRasterState* raster;
+	const GFXBlendState* blend;
+	const GFXDepthState* depth;
+	const GFXStencilState* stencil;
+
+	gfx_renderable_states_(renderable, 0,
+		state, &raster, &blend, &depth, &stencil);
+}
+
 /****************************/
 bool gfx_computable_pipeline_(GFXComputable* computable,
                               GFXCacheElem_** elem, bool warmup)
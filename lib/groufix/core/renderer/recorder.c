@@ -153,6 +153,80 @@ static inline VkRect2D gfx_get_scissor_(const GFXScissor* scissor,
 	return vkScissor;
 }
 
+/****************************
+ * Sets the dynamic state of the current recording, only what changed.
+ * @param recorder Cannot be NULL, assumed to be in a callback.
+ * @param state    Cannot be NULL.
+ */
+static void gfx_recorder_set_dynamic_(GFXRecorder* recorder,
+                                      const GFXDynamicState_* state)
+{
+	assert(recorder != NULL);
+	assert(state != NULL);
+
+	GFXContext_* context = recorder->context;
+	GFXDynamicState_* curr = &recorder->state.dynamic;
+	VkCommandBuffer cmd = recorder->inp.cmd;
+
+	// If nothing is set yet, set everything.
+	const bool all = !recorder->state.dynamicSet;
+	recorder->state.dynamicSet = 1;
+
+	if (all || curr->cull != state->cull)
+		context->vk.CmdSetCullMode(cmd, state->cull);
+
+	if (all || curr->front != state->front)
+		context->vk.CmdSetFrontFace(cmd, state->front);
+
+	if (all || curr->topo != state->topo)
+		context->vk.CmdSetPrimitiveTopology(cmd, state->topo);
+
+	if (all || curr->depthTest != state->depthTest)
+		context->vk.CmdSetDepthTestEnable(cmd, state->depthTest);
+
+	if (all || curr->depthWrite != state->depthWrite)
+		context->vk.CmdSetDepthWriteEnable(cmd, state->depthWrite);
+
+	if (all || curr->depthCmp != state->depthCmp)
+		context->vk.CmdSetDepthCompareOp(cmd, state->depthCmp);
+
+	if (all || curr->stencilTest != state->stencilTest)
+		context->vk.CmdSetStencilTestEnable(cmd, state->stencilTest);
+
+	// Stencil state is set per face.
+	const VkStencilFaceFlags faces[2] = {
+		VK_STENCIL_FACE_FRONT_BIT, VK_STENCIL_FACE_BACK_BIT
+	};
+
+	for (size_t f = 0; f < 2; ++f)
+	{
+		const VkStencilOpState* cs = &curr->stencil[f];
+		const VkStencilOpState* ss = &state->stencil[f];
+
+		if (
+			all ||
+			cs->failOp != ss->failOp ||
+			cs->passOp != ss->passOp ||
+			cs->depthFailOp != ss->depthFailOp ||
+			cs->compareOp != ss->compareOp)
+		{
+			context->vk.CmdSetStencilOp(cmd, faces[f],
+				ss->failOp, ss->passOp, ss->depthFailOp, ss->compareOp);
+		}
+
+		if (all || cs->compareMask != ss->compareMask)
+			context->vk.CmdSetStencilCompareMask(cmd, faces[f], ss->compareMask);
+
+		if (all || cs->writeMask != ss->writeMask)
+			context->vk.CmdSetStencilWriteMask(cmd, faces[f], ss->writeMask);
+
+		if (all || cs->reference != ss->reference)
+			context->vk.CmdSetStencilReference(cmd, faces[f], ss->reference);
+	}
+
+	*curr = *state;
+}
+
 /****************************
  * Binds a graphics pipeline to the current recording.
  * @param recorder   Cannot be NULL, assumed to be in a callback.
@@ -180,6 +254,14 @@ static bool gfx_recorder_bind_renderable_(GFXRecorder* recorder,
 			VK_PIPELINE_BIND_POINT_GRAPHICS, elem->vk.pipeline);
 	}
 
+	// Set dynamic state, if supported it is not part of the pipeline.
+	if (context->features & GFX_SUPPORT_DYNAMIC_STATE_)
+	{
+		GFXDynamicState_ state;
+		gfx_renderable_dynamic_(renderable, &state);
+		gfx_recorder_set_dynamic_(recorder, &state);
+	}
+
 	return 1;
 }
 
@@ -231,16 +313,35 @@ static void gfx_recorder_bind_primitive_(GFXRecorder* recorder,
 	if (recorder->state.primitive != prim)
 	{
 		recorder->state.primitive = prim;
-		VkBuffer vertexBuffs[prim->numBindings];
-		VkDeviceSize vertexOffsets[prim->numBindings];
 
-		for (size_t i = 0; i < prim->numBindings; ++i)
-			vertexBuffs[i] = prim->bindings[i].buffer->vk.buffer,
-			vertexOffsets[i] = prim->bindings[i].offset;
+		// Offsets first, as VkDeviceSize has the largest alignment.
+		VkDeviceSize* vertexOffsets = gfx_scratch_push_(
+			prim->numBindings * (sizeof(VkDeviceSize) + sizeof(VkBuffer)));
+
+		if (vertexOffsets != NULL)
+		{
+			VkBuffer* vertexBuffs =
+				(VkBuffer*)(vertexOffsets + prim->numBindings);
+
+			for (size_t i = 0; i < prim->numBindings; ++i)
+				vertexBuffs[i] = prim->bindings[i].buffer->vk.buffer,
+				vertexOffsets[i] = prim->bindings[i].offset;
 
-		context->vk.CmdBindVertexBuffers(recorder->inp.cmd,
-			0, (uint32_t)prim->numBindings,
-			vertexBuffs, vertexOffsets);
+			context->vk.CmdBindVertexBuffers(recorder->inp.cmd,
+				0, (uint32_t)prim->numBindings,
+				vertexBuffs, vertexOffsets);
+
+			gfx_scratch_pop_(vertexOffsets);
+		}
+		else
+		{
+			// Out of scratch memory, bind one by one.
+			for (size_t i = 0; i < prim->numBindings; ++i)
+				context->vk.CmdBindVertexBuffers(recorder->inp.cmd,
+					(uint32_t)i, 1,
+					&prim->bindings[i].buffer->vk.buffer,
+					&prim->bindings[i].offset);
+		}
 
 		if (primitive->numIndices > 0)
 		{
@@ -412,11 +513,24 @@ void gfx_recorder_record_(GFXRecorder* recorder,
 	// Finally record them all into the given command buffer.
 	if (r > l)
 	{
-		VkCommandBuffer buffs[r-l];
-		for (size_t i = l; i < r; ++i) buffs[i-l] =
-			((GFXCmdElem_*)gfx_vec_at(&recorder->out.cmds, i))->cmd;
+		VkCommandBuffer* buffs =
+			gfx_scratch_push_(sizeof(VkCommandBuffer) * (r-l));
 
-		context->vk.CmdExecuteCommands(cmd, (uint32_t)(r-l), buffs);
+		if (buffs != NULL)
+		{
+			for (size_t i = l; i < r; ++i) buffs[i-l] =
+				((GFXCmdElem_*)gfx_vec_at(&recorder->out.cmds, i))->cmd;
+
+			context->vk.CmdExecuteCommands(cmd, (uint32_t)(r-l), buffs);
+			gfx_scratch_pop_(buffs);
+		}
+		else
+		{
+			// Out of scratch memory, execute one by one.
+			for (size_t i = l; i < r; ++i)
+				context->vk.CmdExecuteCommands(cmd, 1,
+					&((GFXCmdElem_*)gfx_vec_at(&recorder->out.cmds, i))->cmd);
+		}
 	}
 }
 
@@ -656,6 +770,7 @@ GFX_API void gfx_recorder_render(GFXRecorder* recorder, GFXPass* pass,
 	recorder->inp.cmd = cmd;
 	recorder->state.pipeline = NULL;
 	recorder->state.primitive = NULL;
+	recorder->state.dynamicSet = 0;
 
 	cb(recorder, ptr);
 
@@ -888,9 +1003,19 @@ GFX_API void gfx_cmd_bind(GFXRecorder* recorder, GFXTechnique* technique,
 
 	// Get all the Vulkan descriptor sets.
 	// And count the number of dynamic offsets.
-	VkDescriptorSet dSets[numSets];
+	VkDescriptorSet* dSets =
+		gfx_scratch_push_(sizeof(VkDescriptorSet) * numSets);
 	size_t numOffsets = 0;
 
+	if (dSets == NULL)
+	{
+		gfx_log_error(
+			"Failed to allocate descriptor sets during bind command; "
+			"command not recorded.");
+
+		return;
+	}
+
 	for (size_t s = 0; s < numSets; ++s)
 	{
 		GFXPoolElem_* elem = gfx_set_get_(sets[s], &recorder->sub);
@@ -900,6 +1025,7 @@ GFX_API void gfx_cmd_bind(GFXRecorder* recorder, GFXTechnique* technique,
 				"Failed to get Vulkan descriptor set during bind command; "
 				"command not recorded.");
 
+			gfx_scratch_pop_(dSets);
 			return;
 		}
 
@@ -925,7 +1051,18 @@ GFX_API void gfx_cmd_bind(GFXRecorder* recorder, GFXTechnique* technique,
 	{
 		// If not, create a new array,
 		// set all trailing 'empty' offsets to 0.
-		uint32_t offs[GFX_MAX(1, numOffsets)];
+		// Note: numOffsets > numDynamics >= 0.
+		uint32_t* offs = gfx_scratch_push_(sizeof(uint32_t) * numOffsets);
+
+		if (offs == NULL)
+		{
+			gfx_log_error(
+				"Failed to allocate dynamic offsets during bind command; "
+				"command not recorded.");
+
+			gfx_scratch_pop_(dSets);
+			return;
+		}
 
 		for (size_t d = 0; d < numOffsets; ++d)
 			offs[d] = d < numDynamics ? offsets[d] : 0;
@@ -934,7 +1071,11 @@ GFX_API void gfx_cmd_bind(GFXRecorder* recorder, GFXTechnique* technique,
 			bindPoint, technique->vk.layout,
 			(uint32_t)firstSet, (uint32_t)numSets, dSets,
 			(uint32_t)numOffsets, offs);
+
+		gfx_scratch_pop_(offs);
 	}
+
+	gfx_scratch_pop_(dSets);
 }
 
 /****************************/
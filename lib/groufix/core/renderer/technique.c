@@ -393,6 +393,36 @@ bool gfx_tech_get_set_binding_(GFXTechnique* technique,
 	return !isImmutable || res->type != GFX_SHADER_SAMPLER_;
 }
 
+/****************************/
+bool gfx_tech_copy_(GFXTechnique* dst, GFXTechnique* src)
+{
+	assert(dst != NULL);
+	assert(src != NULL);
+	assert(dst->layout == NULL); // Cannot be locked.
+	assert(src->layout == NULL); // Cannot be locked.
+
+	// Replace all configuration vectors.
+	gfx_vec_release(&dst->constants);
+	gfx_vec_release(&dst->samplers);
+	gfx_vec_release(&dst->immutable);
+	gfx_vec_release(&dst->dynamic);
+
+	if (
+		(src->constants.size > 0 && !gfx_vec_push(&dst->constants,
+			src->constants.size, src->constants.data)) ||
+		(src->samplers.size > 0 && !gfx_vec_push(&dst->samplers,
+			src->samplers.size, src->samplers.data)) ||
+		(src->immutable.size > 0 && !gfx_vec_push(&dst->immutable,
+			src->immutable.size, src->immutable.data)) ||
+		(src->dynamic.size > 0 && !gfx_vec_push(&dst->dynamic,
+			src->dynamic.size, src->dynamic.data)))
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
 /****************************/
 GFX_API GFXTechnique* gfx_renderer_add_tech(GFXRenderer* renderer,
                                             size_t numShaders, GFXShader** shaders)
@@ -17,6 +17,23 @@
 static_assert(sizeof(uint32_t) == 4, "SPIR-V words must be 4 bytes.");
 
 
+// 'Randomized' magic number of the groufix shader format
+// (changes if the data layout changes), never equal to SpvMagicNumber.
+#define GFX_SHADER_MAGIC_ ((uint32_t)0x9c2e4d7b)
+
+// Size of the packed groufix shader header.
+#define GFX_SHADER_HEADER_SIZE_ \
+	(sizeof(uint32_t) * 2 + sizeof(uint64_t) + sizeof(uint32_t) * 7)
+
+// Offset of the hashed data (i.e. everything after `dataHash`).
+#define GFX_SHADER_HASH_OFFSET_ \
+	(sizeof(uint32_t) * 2 + sizeof(uint64_t))
+
+// Size of a packed shader resource.
+#define GFX_SHADER_RESOURCE_SIZE_ \
+	(sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2)
+
+
 #define GFX_GET_LANGUAGE_STRING_(language) \
 	((language) == GFX_GLSL ? "glsl" : \
 	(language) == GFX_HLSL ? "hlsl" : "*")
@@ -77,6 +94,13 @@ static_assert(sizeof(uint32_t) == 4, "SPIR-V words must be 4 bytes.");
 	do { \
 		shaderc_compile_options_set_limit(options, \
 			shaderc_limit_##shc, (int)pdp.limits.vk); \
+		GFX_KEY_PUSH_(pdp.limits.vk); \
+	} while (0)
+
+#define GFX_KEY_PUSH_(value) \
+	do { \
+		keyed = keyed && gfx_hash_builder_push_( \
+			&builder, sizeof(value), &(value)) != NULL; \
 	} while (0)
 
 
@@ -93,6 +117,18 @@ const static shaderc_include_result gfx_shaderc_def_error_ = {
 };
 
 
+/****************************
+ * Includer as passed to the shaderc callbacks.
+ */
+typedef struct GFXShadercIncluder_
+{
+	const GFXIncluder* inc;
+	GFXVec*            incs; // Include table to record to, may be NULL.
+	bool               failed; // Non-zero if recording failed.
+
+} GFXShadercIncluder_;
+
+
 /****************************
  * Callback for SPIRV-Cross errors.
  */
@@ -109,7 +145,8 @@ static shaderc_include_result* gfx_shaderc_resolve_(void* ptr, const char* req,
                                                     int type, const char* src,
                                                     size_t depth)
 {
-	const GFXIncluder* inc = ptr;
+	GFXShadercIncluder_* includer = ptr;
+	const GFXIncluder* inc = includer->inc;
 
 	// Allocate new source name so we can return it.
 	const size_t sourceLen = strlen(req);
@@ -158,6 +195,11 @@ static shaderc_include_result* gfx_shaderc_resolve_(void* ptr, const char* req,
 	// Release the stream & output.
 	gfx_io_release(inc, str);
 
+	// Record the include for the shader cache.
+	if (includer->incs != NULL && !includer->failed)
+		includer->failed = !gfx_shader_cache_include_(
+			includer->incs, req, (size_t)len, content);
+
 	result->source_name = sourceName;
 	result->source_name_length = sourceLen;
 	result->content = content;
@@ -561,22 +603,36 @@ error:
 /****************************
  * Creates a new shader module & metadata to actually use.
  * shader->vk.module must be NULL, no prior shader module must be created.
- * @param shader Cannot be NULL.
- * @param size   Must be a multiple of sizeof(uint32_t).
+ * @param shader  Cannot be NULL.
+ * @param size    Must be a multiple of sizeof(uint32_t).
+ * @param reflect Non-zero to perform reflection, otherwise the reflection
+ *                metadata must already be set (and is freed on failure).
+ * @param keep    Non-zero to keep the bytecode around for gfx_shader_store.
  * @return Zero on failure.
  */
 static bool gfx_shader_build_(GFXShader* shader,
-                              size_t size, const uint32_t* code)
+                              size_t size, const void* code,
+                              bool reflect, bool keep)
 {
 	assert(shader != NULL);
 	assert(shader->vk.module == VK_NULL_HANDLE);
+	assert(shader->spirv.code == NULL);
 	assert(size % sizeof(uint32_t) == 0);
 
 	GFXContext_* context = shader->context;
 
-	// First perform reflection.
-	if (!gfx_shader_reflect_(shader, size, code))
-		goto clean_reflect;
+	// First copy the bytecode, this guarantees it is properly aligned.
+	// Only kept around afterwards if it may be stored.
+	shader->spirv.code = size > 0 ? malloc(size) : NULL;
+	if (shader->spirv.code == NULL)
+		goto clean;
+
+	shader->spirv.size = size;
+	memcpy(shader->spirv.code, code, size);
+
+	// Then perform reflection.
+	if (reflect && !gfx_shader_reflect_(shader, size, shader->spirv.code))
+		goto clean;
 
 	// Then create the Vulkan shader module.
 	VkShaderModuleCreateInfo smci = {
@@ -585,7 +641,7 @@ static bool gfx_shader_build_(GFXShader* shader,
 		.pNext    = NULL,
 		.flags    = 0,
 		.codeSize = size,
-		.pCode    = code
+		.pCode    = shader->spirv.code
 	};
 
 	GFX_VK_CHECK_(
@@ -594,7 +650,7 @@ static bool gfx_shader_build_(GFXShader* shader,
 		{
 			// Explicitly set module so we can call compile() or load() again.
 			shader->vk.module = VK_NULL_HANDLE;
-			goto clean_reflect;
+			goto clean;
 		});
 
 	// Victory log!
@@ -614,13 +670,24 @@ static bool gfx_shader_build_(GFXShader* shader,
 		shader->reflect.bindings,
 		shader->reflect.constants);
 
+	if (!keep)
+	{
+		free(shader->spirv.code);
+		shader->spirv.size = 0;
+		shader->spirv.code = NULL;
+	}
+
 	return 1;
 
 
 	// Cleanup on failure.
-clean_reflect:
+clean:
+	free(shader->spirv.code);
 	free(shader->reflect.resources);
 
+	shader->spirv.size = 0;
+	shader->spirv.code = NULL;
+
 	shader->reflect.push = 0;
 	shader->reflect.locations = 0;
 	shader->reflect.sets = 0;
@@ -632,88 +699,172 @@ clean_reflect:
 }
 
 /****************************
- * Generates a unique-ish 'ID' for the shader to use as hashable cache handles.
+ * Loads groufix shader data, i.e. SPIR-V bytecode with all of its reflection
+ * metadata, no reflection is performed.
+ * shader->vk.module must be NULL, no prior shader module must be created.
+ * @param shader Cannot be NULL.
+ * @param data   Must start with GFX_SHADER_MAGIC_.
+ * @return Zero on failure.
  */
-static inline uintptr_t gfx_shader_handle_(GFXContext_* context)
+static bool gfx_shader_unpack_(GFXShader* shader, size_t len, const char* data)
 {
-	uintptr_t handle = atomic_fetch_add_explicit(
-		&context->limits.shaders, 1, memory_order_relaxed);
-
-	if (handle == UINTPTR_MAX) gfx_log_warn(
-		"Shader handle generation reached maximum (%"PRIuPTR") and "
-		"overflowed; may cause new shaders to be swapped with old shaders.",
-		UINTPTR_MAX);
+	assert(shader != NULL);
+	assert(shader->reflect.resources == NULL);
+	assert(data != NULL);
+
+	// Unpack the groufix header.
+	// Layout: { magic, dataSize, dataHash, stage, push,
+	//   locations, sets, bindings, constants, codeSize }.
+	if (len < GFX_SHADER_HEADER_SIZE_)
+		goto invalid;
+
+	uint32_t head[2];
+	uint64_t dataHash;
+	uint32_t meta[7];
+
+	memcpy(head, data, sizeof(head));
+	data += sizeof(head);
+	memcpy(&dataHash, data, sizeof(dataHash));
+	data += sizeof(dataHash);
+	memcpy(meta, data, sizeof(meta));
+	data += sizeof(meta);
+
+	// Validate the received data.
+	// The hash covers everything after `dataHash`.
+	const size_t numRes = (size_t)meta[2] + (size_t)meta[4] + (size_t)meta[5];
+	const size_t bodySize = len - GFX_SHADER_HEADER_SIZE_;
 
-	return handle;
-}
+	if (
+		head[1] != len ||
+		dataHash != gfx_hash_murmur3_bytes_(
+			len - GFX_SHADER_HASH_OFFSET_,
+			data - (GFX_SHADER_HEADER_SIZE_ - GFX_SHADER_HASH_OFFSET_)) ||
+		meta[0] != (uint32_t)shader->stage ||
+		meta[6] == 0 ||
+		meta[6] % sizeof(uint32_t) != 0 ||
+		numRes > bodySize / GFX_SHADER_RESOURCE_SIZE_ ||
+		bodySize != numRes * GFX_SHADER_RESOURCE_SIZE_ + meta[6])
+	{
+		goto invalid;
+	}
 
-/****************************/
-GFX_API GFXShader* gfx_create_shader(GFXShaderStage stage, GFXDevice* device)
-{
-	assert(stage != GFX_STAGE_ANY);
-	assert(GFX_IS_POWER_OF_TWO(stage)); // Only 1 stage can be set.
+	// Unpack all resources.
+	GFXShaderResource_* rList = NULL;
+	size_t sets = 0;
 
-	// Allocate a new shader.
-	GFXShader* shader = malloc(sizeof(GFXShader));
-	if (shader == NULL) goto clean;
+	if (numRes > 0)
+	{
+		rList = malloc(sizeof(GFXShaderResource_) * numRes);
+		if (rList == NULL) goto error;
 
-	// Get context associated with the device.
-	// We need the device to set the compiler's target environment.
-	GFX_GET_DEVICE_(shader->device, device);
-	GFX_GET_CONTEXT_(shader->context, device, goto clean);
+		for (size_t r = 0; r < numRes; ++r)
+		{
+			// Layout: { location/set/id, binding, count, size,
+			//   viewType, type }.
+			uint32_t ids[2];
+			uint64_t sizes[2];
+			uint32_t types[2];
+
+			memcpy(ids, data, sizeof(ids));
+			data += sizeof(ids);
+			memcpy(sizes, data, sizeof(sizes));
+			data += sizeof(sizes);
+			memcpy(types, data, sizeof(types));
+			data += sizeof(types);
+
+			if (
+				sizes[0] > SIZE_MAX || sizes[1] > SIZE_MAX ||
+				types[0] > GFX_VIEW_3D || types[1] > GFX_SHADER_CONSTANT_)
+			{
+				free(rList);
+				goto invalid;
+			}
 
-	shader->handle = gfx_shader_handle_(shader->context);
-	shader->stage = stage;
-	shader->vk.module = VK_NULL_HANDLE;
+			rList[r].location = ids[0];
+			rList[r].binding = ids[1];
+			rList[r].count = (size_t)sizes[0];
+			rList[r].size = (size_t)sizes[1];
+			rList[r].viewType = (GFXViewType)types[0];
+			rList[r].type = types[1];
+		}
 
-	shader->reflect.push = 0;
-	shader->reflect.locations = 0;
-	shader->reflect.sets = 0;
-	shader->reflect.bindings = 0;
-	shader->reflect.constants = 0;
-	shader->reflect.resources = NULL;
+		// Check that the number of descriptor sets is still valid.
+		uint32_t curSet = UINT32_MAX;
+		for (size_t b = 0; b < meta[4]; ++b)
+		{
+			GFXShaderResource_* res = rList + meta[2] + b;
+			if (curSet == UINT32_MAX || res->set > curSet)
+			{
+				++sets;
+				curSet = res->set;
+			}
+		}
+	}
 
-	return shader;
+	if (sets != meta[3])
+	{
+		free(rList);
+		goto invalid;
+	}
 
+	// Set the reflection metadata & build the shader module.
+	shader->reflect.push = meta[1];
+	shader->reflect.locations = meta[2];
+	shader->reflect.sets = meta[3];
+	shader->reflect.bindings = meta[4];
+	shader->reflect.constants = meta[5];
+	shader->reflect.resources = rList;
 
-	// Cleanup on failure.
-clean:
-	gfx_log_error("Could not create a new shader.");
-	free(shader);
+	// The data is already stored, don't keep another copy of it.
+	if (!gfx_shader_build_(shader, meta[6], data, 0, 0))
+		goto error;
 
-	return NULL;
-}
+	return 1;
 
-/****************************/
-GFX_API void gfx_destroy_shader(GFXShader* shader)
-{
-	if (shader == NULL)
-		return;
 
-	GFXContext_* context = shader->context;
+	// Error on invalid data.
+invalid:
+	gfx_log_error(
+		"Could not load groufix %s shader; "
+		"data is invalid or incompatible.",
+		GFX_GET_STAGE_STRING_(shader->stage));
 
-	// Free reflection metadata.
-	free(shader->reflect.resources);
+	return 0;
 
-	// Destroy the shader module.
-	context->vk.DestroyShaderModule(
-		context->vk.device, shader->vk.module, NULL);
+	// Error on failure.
+error:
+	gfx_log_error(
+		"Failed to load groufix %s shader.",
+		GFX_GET_STAGE_STRING_(shader->stage));
 
-	free(shader);
+	return 0;
 }
 
-/****************************/
-GFX_API GFXDevice* gfx_shader_get_device(GFXShader* shader)
+/****************************
+ * Generates a unique-ish 'ID' for the shader to use as hashable cache handles.
+ */
+static inline uintptr_t gfx_shader_handle_(GFXContext_* context)
 {
-	if (shader == NULL)
-		return NULL;
+	uintptr_t handle = atomic_fetch_add_explicit(
+		&context->limits.shaders, 1, memory_order_relaxed);
 
-	return (GFXDevice*)shader->device;
+	if (handle == UINTPTR_MAX) gfx_log_warn(
+		"Shader handle generation reached maximum (%"PRIuPTR") and "
+		"overflowed; may cause new shaders to be swapped with old shaders.",
+		UINTPTR_MAX);
+
+	return handle;
 }
 
-/****************************/
-GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
-                                bool optimize,
+/****************************
+ * Compiles a shader, optionally consulting a shader cache.
+ * @param compiler Pointer to a (lazily initialized) shaderc compiler,
+ *                 the caller must release it, NULL to use a temporary one.
+ * @see gfx_shader_compile_cached.
+ */
+static bool gfx_shader_compile_(GFXShader* shader, shaderc_compiler_t* compiler,
+                                GFXShaderCache* cache,
+                                GFXShaderLanguage language, bool optimize,
                                 const GFXReader* src, const GFXIncluder* inc,
                                 const GFXWriter* out, const GFXWriter* err)
 {
@@ -739,22 +890,38 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 		return 0;
 	}
 
-	// Create compiler and compile options.
-	// We create new resources for every shader,
+	// Create compile options.
+	// We create new options for every shader,
 	// this presumably makes it pretty much thread-safe.
-	shaderc_compiler_t compiler =
-		shaderc_compiler_initialize();
+	shaderc_compiler_t temp = NULL;
 	shaderc_compile_options_t options =
 		shaderc_compile_options_initialize();
 
-	if (compiler == NULL || options == NULL)
-	{
-		gfx_log_error(
-			"Could not initialize resources to compile %s shader.",
-			GFX_GET_STAGE_STRING_(shader->stage));
+	if (options == NULL)
+		goto clean_init;
+
+	// If caching, build a key while setting all options.
+	// This way the key describes exactly what is passed to shaderc.
+	GFXHashBuilder_ builder;
+	const bool building = cache != NULL && gfx_hash_builder_(&builder);
+	bool keyed = building;
+
+	const uint32_t keyStage = (uint32_t)shader->stage;
+	const uint32_t keyLanguage = (uint32_t)language;
+	const uint32_t keyAPI = VK_MAKE_API_VERSION(0,
+		VK_API_VERSION_MAJOR(device->api),
+		VK_API_VERSION_MINOR(device->api), 0);
+
+#if defined (NDEBUG)
+	const uint32_t keyFlags = optimize ? 1 : 0;
+#else
+	const uint32_t keyFlags = optimize ? 3 : 2; // Debug info is generated.
+#endif
 
-		goto clean_compiler;
-	}
+	GFX_KEY_PUSH_(keyStage);
+	GFX_KEY_PUSH_(keyLanguage);
+	GFX_KEY_PUSH_(keyAPI);
+	GFX_KEY_PUSH_(keyFlags);
 
 	// Set source language.
 	shaderc_compile_options_set_source_language(
@@ -763,10 +930,7 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 	// Set target environment.
 	// Omits patch version (Shaderc doesn't understand it).
 	shaderc_compile_options_set_target_env(
-		options, shaderc_target_env_vulkan,
-		VK_MAKE_API_VERSION(0,
-			VK_API_VERSION_MAJOR(device->api),
-			VK_API_VERSION_MINOR(device->api), 0));
+		options, shaderc_target_env_vulkan, keyAPI);
 
 #if !defined (NDEBUG)
 	// If in debug mode, generate debug info :)
@@ -775,12 +939,22 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 #endif
 
 	// Set includer callbacks if an includer is given.
+	// Resolved includes are recorded if caching.
+	GFXVec incs;
+	gfx_vec_init(&incs, 1);
+
+	GFXShadercIncluder_ includer = {
+		.inc = inc,
+		.incs = building ? &incs : NULL,
+		.failed = 0
+	};
+
 	if (inc != NULL)
 		shaderc_compile_options_set_include_callbacks(
 			options,
 			gfx_shaderc_resolve_,
 			gfx_shaderc_release_,
-			(GFXIncluder*)inc);
+			&includer);
 
 	// Add all these options only if we compile for this specific platform.
 	// This will enable optimization for the target API and GPU limits.
@@ -834,9 +1008,72 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 			maxComputeWorkGroupSize[2]);
 	}
 
+	// Finish the key with the source itself.
+	GFXHashKey_* key = NULL;
+
+	if (building)
+	{
+		keyed = keyed && gfx_hash_builder_push_(
+			&builder, (size_t)len, source) != NULL;
+
+		key = gfx_hash_builder_get_(&builder);
+		if (!keyed)
+		{
+			gfx_log_warn(
+				"Could not build shader cache key, "
+				"compiling %s shader without cache.",
+				GFX_GET_STAGE_STRING_(shader->stage));
+
+			free(key);
+			key = NULL;
+		}
+	}
+
+	// Consult the cache, on a hit we skip shaderc & load the bytecode.
+	if (key != NULL)
+	{
+		size_t size;
+		uint32_t* code = gfx_shader_cache_find_(cache, key, inc, &size);
+
+		if (code != NULL)
+		{
+			gfx_log_debug(
+				"Shader cache hit for %s shader (%"GFX_PRIs" bytes).",
+				GFX_GET_STAGE_STRING_(shader->stage), size);
+
+			// Stream out the cached SPIR-V bytecode.
+			if (out != NULL && gfx_io_write(out, code, size) > 0)
+				gfx_log_info(
+					"Written SPIR-V to stream (%"GFX_PRIs" bytes).",
+					size);
+
+			GFXBinReader bin;
+			const bool loaded =
+				gfx_shader_load(shader, gfx_bin_reader(&bin, size, code));
+
+			free(code);
+			free(key);
+			gfx_vec_clear(&incs);
+			shaderc_compile_options_release(options);
+			gfx_io_raw_clear(&source, src);
+
+			return loaded;
+		}
+	}
+
+	// Create compiler (if not given one).
+	if (compiler == NULL)
+		compiler = &temp;
+
+	if (*compiler == NULL)
+		*compiler = shaderc_compiler_initialize();
+
+	if (*compiler == NULL)
+		goto clean_compiler;
+
 	// Compile the shader.
 	shaderc_compilation_result_t result = shaderc_compile_into_spv(
-		compiler, (const char*)source, (size_t)len,
+		*compiler, (const char*)source, (size_t)len,
 		GFX_GET_SHADERC_KIND_(shader->stage),
 		GFX_GET_LANGUAGE_STRING_(language),
 		"main",
@@ -893,7 +1130,8 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 			size);
 
 	// Lastly, attempt to build the shader module.
-	if (!gfx_shader_build_(shader, wordSize, (const uint32_t*)bytes))
+	// Only keep the bytecode if a cache is attached.
+	if (!gfx_shader_build_(shader, wordSize, bytes, 1, cache != NULL))
 	{
 		gfx_log_error(
 			"Failed to load compiled %s shader.",
@@ -902,11 +1140,23 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 		goto clean_result;
 	}
 
+	// Only cache valid bytecode, including all resolved includes.
+	if (key != NULL && !includer.failed)
+		if (!gfx_shader_cache_insert_(cache, key,
+			incs.size, incs.data, wordSize, (const uint32_t*)bytes))
+		{
+			gfx_log_warn(
+				"Could not insert %s shader into shader cache.",
+				GFX_GET_STAGE_STRING_(shader->stage));
+		}
+
 	// Get rid of the resources and return.
 	shaderc_result_release(result);
-	shaderc_compiler_release(compiler);
+	shaderc_compiler_release(temp);
 	shaderc_compile_options_release(options);
 
+	free(key);
+	gfx_vec_clear(&incs);
 	gfx_io_raw_clear(&source, src);
 
 	return 1;
@@ -916,14 +1166,200 @@ GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
 clean_result:
 	shaderc_result_release(result);
 clean_compiler:
-	shaderc_compiler_release(compiler);
+	shaderc_compiler_release(temp);
+	free(key);
+	gfx_vec_clear(&incs);
+clean_init:
 	shaderc_compile_options_release(options);
 
+	if (compiler == NULL || *compiler == NULL || options == NULL)
+		gfx_log_error(
+			"Could not initialize resources to compile %s shader.",
+			GFX_GET_STAGE_STRING_(shader->stage));
+
 	gfx_io_raw_clear(&source, src);
 
 	return 0;
 }
 
+/****************************
+ * Batch compilation state.
+ */
+typedef struct GFXShaderBatch_
+{
+	GFXShaderSource*   shaders;
+	GFXShaderCache*    cache;
+	const GFXIncluder* inc; // May be NULL.
+
+} GFXShaderBatch_;
+
+
+/****************************
+ * Compiles a range of shaders of a batch, for use in gfx_jobs_parallel_.
+ * @return Number of successfully compiled shaders.
+ */
+static size_t gfx_shader_batch_compile_(void* ptr, size_t begin, size_t end)
+{
+	GFXShaderBatch_* batch = ptr;
+	size_t compiled = 0;
+
+	// One compiler for all shaders of the range,
+	// it is lazily initialized (i.e. not on cache hits).
+	shaderc_compiler_t compiler = NULL;
+
+	for (size_t s = begin; s < end; ++s)
+	{
+		GFXShaderSource* source = batch->shaders + s;
+
+		source->result = gfx_shader_compile_(
+			source->shader, &compiler, batch->cache,
+			source->language, source->optimize,
+			source->src, batch->inc, source->out, source->err);
+
+		if (source->result)
+			++compiled;
+	}
+
+	shaderc_compiler_release(compiler);
+
+	return compiled;
+}
+
+/****************************/
+GFX_API GFXShader* gfx_create_shader(GFXShaderStage stage, GFXDevice* device)
+{
+	assert(stage != GFX_STAGE_ANY);
+	assert(GFX_IS_POWER_OF_TWO(stage)); // Only 1 stage can be set.
+
+	// Allocate a new shader.
+	GFXShader* shader = malloc(sizeof(GFXShader));
+	if (shader == NULL) goto clean;
+
+	// Get context associated with the device.
+	// We need the device to set the compiler's target environment.
+	GFX_GET_DEVICE_(shader->device, device);
+	GFX_GET_CONTEXT_(shader->context, device, goto clean);
+
+	shader->handle = gfx_shader_handle_(shader->context);
+	shader->stage = stage;
+	shader->vk.module = VK_NULL_HANDLE;
+
+	shader->reflect.push = 0;
+	shader->reflect.locations = 0;
+	shader->reflect.sets = 0;
+	shader->reflect.bindings = 0;
+	shader->reflect.constants = 0;
+	shader->reflect.resources = NULL;
+
+	shader->spirv.size = 0;
+	shader->spirv.code = NULL;
+
+	return shader;
+
+
+	// Cleanup on failure.
+clean:
+	gfx_log_error("Could not create a new shader.");
+	free(shader);
+
+	return NULL;
+}
+
+/****************************/
+GFX_API void gfx_destroy_shader(GFXShader* shader)
+{
+	if (shader == NULL)
+		return;
+
+	GFXContext_* context = shader->context;
+
+	// Free reflection metadata & bytecode.
+	free(shader->reflect.resources);
+	free(shader->spirv.code);
+
+	// Destroy the shader module.
+	context->vk.DestroyShaderModule(
+		context->vk.device, shader->vk.module, NULL);
+
+	free(shader);
+}
+
+/****************************/
+GFX_API GFXDevice* gfx_shader_get_device(GFXShader* shader)
+{
+	if (shader == NULL)
+		return NULL;
+
+	return (GFXDevice*)shader->device;
+}
+
+/****************************/
+GFX_API bool gfx_shader_compile(GFXShader* shader, GFXShaderLanguage language,
+                                bool optimize,
+                                const GFXReader* src, const GFXIncluder* inc,
+                                const GFXWriter* out, const GFXWriter* err)
+{
+	return gfx_shader_compile_(
+		shader, NULL, NULL, language, optimize, src, inc, out, err);
+}
+
+/****************************/
+GFX_API bool gfx_shader_compile_cached(GFXShader* shader, GFXShaderCache* cache,
+                                       GFXShaderLanguage language, bool optimize,
+                                       const GFXReader* src, const GFXIncluder* inc,
+                                       const GFXWriter* out, const GFXWriter* err)
+{
+	return gfx_shader_compile_(
+		shader, NULL, cache, language, optimize, src, inc, out, err);
+}
+
+/****************************/
+GFX_API size_t gfx_shader_compile_batch(size_t numShaders,
+                                        GFXShaderSource* shaders,
+                                        GFXShaderCache* cache,
+                                        const GFXIncluder* inc,
+                                        unsigned int numThreads)
+{
+	assert(numShaders == 0 || shaders != NULL);
+
+	if (numShaders == 0)
+		return 0;
+
+	// Setup a shared include cache, so every URI is only resolved once.
+	GFXIncludeCache* includes = NULL;
+
+	if (inc != NULL)
+	{
+		includes = gfx_create_include_cache(inc);
+		if (includes == NULL)
+		{
+			gfx_log_error("Could not initialize a batch of shaders.");
+			return 0;
+		}
+	}
+
+	// Compile on the shared job scheduler.
+	GFXShaderBatch_ batch = {
+		.shaders = shaders,
+		.cache = cache,
+		.inc = gfx_include_cache_get_includer(includes)
+	};
+
+	const size_t compiled = gfx_jobs_parallel_(
+		numShaders, numThreads, gfx_shader_batch_compile_, &batch);
+
+	// Free the include cache.
+	gfx_destroy_include_cache(includes);
+
+	gfx_log_info(
+		"Compiled batch of shaders:\n"
+		"    #shaders: %"GFX_PRIs".\n"
+		"    #failed: %"GFX_PRIs".\n",
+		numShaders, numShaders - compiled);
+
+	return compiled;
+}
+
 /****************************/
 GFX_API bool gfx_shader_load(GFXShader* shader, const GFXReader* src)
 {
@@ -947,18 +1383,142 @@ GFX_API bool gfx_shader_load(GFXShader* shader, const GFXReader* src)
 		return 0;
 	}
 
-	// Attempt to build the shader module.
-	// Round the size to a multiple of 4 just in case it isn't.
-	const size_t wordSize =
-		((size_t)len / sizeof(uint32_t)) * sizeof(uint32_t);
+	// Check if it is groufix shader data, if so, skip reflection.
+	uint32_t magic = 0;
+	if ((size_t)len >= sizeof(magic))
+		memcpy(&magic, source, sizeof(magic));
 
-	bool built = gfx_shader_build_(shader, wordSize, source);
-	if (!built)
-		gfx_log_error(
-			"Failed to load %s shader.",
-			GFX_GET_STAGE_STRING_(shader->stage));
+	bool built;
+
+	if (magic == GFX_SHADER_MAGIC_)
+		built = gfx_shader_unpack_(shader, (size_t)len, source);
+	else
+	{
+		// Attempt to build the shader module.
+		// Round the size to a multiple of 4 just in case it isn't.
+		const size_t wordSize =
+			((size_t)len / sizeof(uint32_t)) * sizeof(uint32_t);
+
+		built = gfx_shader_build_(shader, wordSize, source, 1, 1);
+		if (!built)
+			gfx_log_error(
+				"Failed to load %s shader.",
+				GFX_GET_STAGE_STRING_(shader->stage));
+	}
 
 	gfx_io_raw_clear(&source, src);
 
 	return built;
 }
+
+/****************************/
+GFX_API bool gfx_shader_store(GFXShader* shader, const GFXWriter* dst)
+{
+	assert(shader != NULL);
+	assert(dst != NULL);
+
+	// No (kept) bytecode, nothing to store.
+	if (shader->vk.module == VK_NULL_HANDLE || shader->spirv.code == NULL)
+	{
+		gfx_log_error(
+			"Could not store %s shader; no SPIR-V bytecode present.",
+			GFX_GET_STAGE_STRING_(shader->stage));
+
+		return 0;
+	}
+
+	const size_t numRes =
+		shader->reflect.locations +
+		shader->reflect.bindings +
+		shader->reflect.constants;
+
+	const size_t len =
+		GFX_SHADER_HEADER_SIZE_ +
+		GFX_SHADER_RESOURCE_SIZE_ * numRes +
+		shader->spirv.size;
+
+	if (len > UINT32_MAX)
+	{
+		gfx_log_error(
+			"Could not store %s shader; too large.",
+			GFX_GET_STAGE_STRING_(shader->stage));
+
+		return 0;
+	}
+
+	// Allocate the data & pack a groufix header.
+	char* data = malloc(len);
+	if (data == NULL)
+	{
+		gfx_log_error(
+			"Failed to store %s shader.",
+			GFX_GET_STAGE_STRING_(shader->stage));
+
+		return 0;
+	}
+
+	const uint32_t head[2] = {
+		GFX_SHADER_MAGIC_,
+		(uint32_t)len
+	};
+
+	const uint32_t meta[7] = {
+		(uint32_t)shader->stage,
+		shader->reflect.push,
+		(uint32_t)shader->reflect.locations,
+		(uint32_t)shader->reflect.sets,
+		(uint32_t)shader->reflect.bindings,
+		(uint32_t)shader->reflect.constants,
+		(uint32_t)shader->spirv.size
+	};
+
+	char* ptr = data + GFX_SHADER_HASH_OFFSET_;
+	memcpy(data, head, sizeof(head));
+	memcpy(ptr, meta, sizeof(meta));
+	ptr += sizeof(meta);
+
+	// Pack all resources.
+	for (size_t r = 0; r < numRes; ++r)
+	{
+		const GFXShaderResource_* res = shader->reflect.resources + r;
+
+		const uint32_t ids[2] = { res->location, res->binding };
+		const uint64_t sizes[2] = { res->count, res->size };
+		const uint32_t types[2] = { (uint32_t)res->viewType, res->type };
+
+		memcpy(ptr, ids, sizeof(ids));
+		ptr += sizeof(ids);
+		memcpy(ptr, sizes, sizeof(sizes));
+		ptr += sizeof(sizes);
+		memcpy(ptr, types, sizeof(types));
+		ptr += sizeof(types);
+	}
+
+	// Append the bytecode & hash everything after `dataHash`.
+	memcpy(ptr, shader->spirv.code, shader->spirv.size);
+
+	const uint64_t hash = gfx_hash_murmur3_bytes_(
+		len - GFX_SHADER_HASH_OFFSET_, data + GFX_SHADER_HASH_OFFSET_);
+	memcpy(
+		data + sizeof(head), // Right after `dataSize`.
+		&hash,
+		sizeof(hash));
+
+	// Stream out the data.
+	if (gfx_io_write(dst, data, len) <= 0)
+	{
+		gfx_log_error(
+			"Could not write %s shader to stream.",
+			GFX_GET_STAGE_STRING_(shader->stage));
+
+		free(data);
+		return 0;
+	}
+
+	gfx_log_info(
+		"Written groufix %s shader to stream (%"GFX_PRIs" bytes).",
+		GFX_GET_STAGE_STRING_(shader->stage), len);
+
+	free(data);
+	return 1;
+}
@@ -0,0 +1,765 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/core/objects.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// 'Randomized' magic number (changes if the data layout changes).
+#define GFX_SHADER_CACHE_MAGIC_ ((uint32_t)0x5b3ec2a1)
+
+
+// Size of the packed groufix shader cache header.
+#define GFX_SHADER_CACHE_HEADER_SIZE_ \
+	(sizeof(uint32_t) * 2 + sizeof(uint64_t) + sizeof(uint32_t))
+
+// Size of a packed shader cache entry header.
+#define GFX_SHADER_CACHE_ENTRY_SIZE_ \
+	(sizeof(uint32_t) * 3)
+
+// Size of a packed include record (excluding name).
+#define GFX_SHADER_CACHE_INCLUDE_SIZE_ \
+	(sizeof(uint32_t) * 2 + sizeof(uint64_t))
+
+
+#define GFX_CACHE_ELEM_SIZE_(key, elem) \
+	((key)->len + (elem)->size + (elem)->incs)
+
+#define GFX_KEY_PUSH_(value) \
+	do { \
+		if (gfx_hash_builder_push_( \
+			&builder, sizeof(value), &(value)) == NULL) \
+		{ \
+			goto clean; \
+		} \
+	} while (0)
+
+
+/****************************
+ * Checks if an include table is well-formed, i.e. all records fit within
+ * the table and all names are NULL-terminated.
+ * @return Non-zero if the table can be safely traversed.
+ */
+static bool gfx_shader_cache_check_table_(size_t incs, const char* table)
+{
+	const char* end = table + incs;
+
+	while (table < end)
+	{
+		if ((size_t)(end - table) < GFX_SHADER_CACHE_INCLUDE_SIZE_)
+			return 0;
+
+		uint32_t nameLen;
+		memcpy(&nameLen, table, sizeof(nameLen));
+		table += GFX_SHADER_CACHE_INCLUDE_SIZE_;
+
+		if (
+			nameLen == 0 ||
+			(size_t)(end - table) < nameLen ||
+			table[nameLen - 1] != '\0')
+		{
+			return 0;
+		}
+
+		table += nameLen;
+	}
+
+	return 1;
+}
+
+/****************************
+ * Validates the include table of a cache element, i.e. resolves all
+ * includes and compares their length & hash with the stored ones.
+ * @param inc May be NULL, in which case the table must be empty.
+ * @return Non-zero if all includes are still equal.
+ */
+static bool gfx_shader_cache_validate_(const GFXIncluder* inc,
+                                       size_t incs, const char* table)
+{
+	if (incs > 0 && inc == NULL)
+		return 0;
+
+	const char* end = table + incs;
+
+	while (table < end)
+	{
+		uint32_t nameLen, len;
+		uint64_t hash;
+
+		memcpy(&nameLen, table, sizeof(nameLen));
+		table += sizeof(nameLen);
+		memcpy(&len, table, sizeof(len));
+		table += sizeof(len);
+		memcpy(&hash, table, sizeof(hash));
+		table += sizeof(hash);
+
+		const char* name = table;
+		table += nameLen;
+
+		// Resolve & hash the include.
+		const GFXReader* str = gfx_io_resolve(inc, name);
+		if (str == NULL) return 0;
+
+		const void* content;
+		const long long cLen = gfx_io_raw_init(&content, str);
+
+		const bool equal =
+			cLen == (long long)len &&
+			(cLen <= 0 || gfx_hash_murmur3_bytes_((size_t)cLen, content) == hash);
+
+		if (cLen > 0) gfx_io_raw_clear(&content, str);
+		gfx_io_release(inc, str);
+
+		if (!equal) return 0;
+	}
+
+	return 1;
+}
+
+/****************************
+ * Compares two cache elements by stamp, for use in qsort.
+ */
+static int gfx_shader_cache_cmp_(const void* l, const void* r)
+{
+	const GFXShaderCacheElem_* eL = *(GFXShaderCacheElem_* const*)l;
+	const GFXShaderCacheElem_* eR = *(GFXShaderCacheElem_* const*)r;
+
+	return (eL->stamp > eR->stamp) - (eL->stamp < eR->stamp);
+}
+
+/****************************
+ * Erases a single cache entry, updating the total size.
+ * cache->lock must be locked.
+ */
+static void gfx_shader_cache_erase_(GFXShaderCache* cache,
+                                    GFXShaderCacheElem_* elem)
+{
+	const GFXHashKey_* key = gfx_map_key(&cache->entries, elem);
+	cache->size -= GFX_CACHE_ELEM_SIZE_(key, elem);
+	++cache->stats.evictions;
+
+	free(elem->code);
+	gfx_map_erase(&cache->entries, elem);
+}
+
+/****************************
+ * Evicts the least recently used entries until a given size fits.
+ * cache->lock must be locked.
+ * @param size Size of the entry to make room for.
+ */
+static void gfx_shader_cache_evict_(GFXShaderCache* cache, size_t size)
+{
+	if (
+		cache->maxSize == 0 ||
+		cache->size == 0 ||
+		cache->size + size <= cache->maxSize)
+	{
+		return;
+	}
+
+	// Sort all entries by stamp once, then evict in a single pass.
+	// Map nodes are allocated individually, so erasing an entry does not
+	// invalidate the pointers to the other entries.
+	const size_t numEntries = cache->entries.size;
+	GFXShaderCacheElem_** elems =
+		malloc(sizeof(GFXShaderCacheElem_*) * numEntries);
+
+	if (elems == NULL)
+	{
+		// Cannot sort, evict in arbitrary order so we stay within bounds.
+		while (cache->size > 0 && cache->size + size > cache->maxSize)
+			gfx_shader_cache_erase_(cache, gfx_map_first(&cache->entries));
+
+		return;
+	}
+
+	size_t e = 0;
+	for (
+		GFXShaderCacheElem_* elem = gfx_map_first(&cache->entries);
+		elem != NULL;
+		elem = gfx_map_next(&cache->entries, elem))
+	{
+		elems[e++] = elem;
+	}
+
+	qsort(elems, numEntries,
+		sizeof(GFXShaderCacheElem_*), gfx_shader_cache_cmp_);
+
+	for (e = 0; e < numEntries && cache->size + size > cache->maxSize; ++e)
+		gfx_shader_cache_erase_(cache, elems[e]);
+
+	free(elems);
+}
+
+/****************************
+ * Inserts a new entry into the cache, assumes it does not exist yet.
+ * cache->lock must be locked.
+ * @return Zero on failure (or if it does not fit).
+ */
+static bool gfx_shader_cache_insert_locked_(GFXShaderCache* cache,
+                                            const GFXHashKey_* key,
+                                            size_t incs, const void* table,
+                                            size_t size, const void* code)
+{
+	// Check if it would ever fit.
+	const size_t total = key->len + size + incs;
+	if (cache->maxSize > 0 && total > cache->maxSize)
+		return 0;
+
+	// Allocate & copy data.
+	GFXShaderCacheElem_ elem = {
+		.stamp = cache->stamp++,
+		.size = size,
+		.incs = incs,
+		.code = malloc(size + incs)
+	};
+
+	if (elem.code == NULL)
+		return 0;
+
+	memcpy(elem.code, code, size);
+	if (incs > 0) memcpy((char*)elem.code + size, table, incs);
+
+	// Make room & insert.
+	gfx_shader_cache_evict_(cache, total);
+
+	if (!gfx_map_insert(&cache->entries, &elem, gfx_hash_size_(key), key))
+	{
+		free(elem.code);
+		return 0;
+	}
+
+	cache->size += total;
+	return 1;
+}
+
+/****************************/
+bool gfx_shader_cache_include_(GFXVec* incs, const char* name,
+                               size_t len, const void* content)
+{
+	assert(incs != NULL);
+	assert(incs->elementSize == 1);
+	assert(name != NULL);
+	assert(content != NULL || len == 0);
+
+	const size_t nameSize = strlen(name) + 1;
+	if (nameSize > UINT32_MAX || len > UINT32_MAX)
+		return 0;
+
+	const uint32_t nameLen = (uint32_t)nameSize;
+	const uint32_t cLen = (uint32_t)len;
+	const uint64_t hash = gfx_hash_murmur3_bytes_(len, content);
+
+	const size_t size = incs->size;
+
+	if (
+		!gfx_vec_push(incs, sizeof(nameLen), &nameLen) ||
+		!gfx_vec_push(incs, sizeof(cLen), &cLen) ||
+		!gfx_vec_push(incs, sizeof(hash), &hash) ||
+		!gfx_vec_push(incs, nameSize, name))
+	{
+		// Pop whatever was pushed.
+		gfx_vec_pop(incs, incs->size - size);
+		return 0;
+	}
+
+	return 1;
+}
+
+/****************************/
+uint32_t* gfx_shader_cache_find_(GFXShaderCache* cache,
+                                 const GFXHashKey_* key, const GFXIncluder* inc,
+                                 size_t* size)
+{
+	assert(cache != NULL);
+	assert(key != NULL);
+	assert(size != NULL);
+
+	const uint64_t hash = cache->entries.hash(key);
+
+	// Copy the data out, so we don't have to hold the lock while resolving.
+	// Another thread might evict the entry in the meantime.
+	gfx_mutex_lock_(&cache->lock);
+
+	GFXShaderCacheElem_* elem = gfx_map_hsearch(&cache->entries, key, hash);
+	GFXShaderCacheElem_ copy = { .code = NULL };
+
+	if (elem != NULL)
+	{
+		copy = *elem;
+		copy.code = malloc(elem->size + elem->incs);
+
+		if (copy.code != NULL)
+		{
+			memcpy(copy.code, elem->code, elem->size + elem->incs);
+			elem->stamp = cache->stamp++;
+		}
+	}
+
+	gfx_mutex_unlock_(&cache->lock);
+
+	// Validate its includes.
+	const bool valid = copy.code != NULL && gfx_shader_cache_validate_(
+		inc, copy.incs, (const char*)copy.code + copy.size);
+
+	if (!valid)
+	{
+		free(copy.code);
+		copy.code = NULL;
+	}
+
+	// Update statistics.
+	gfx_mutex_lock_(&cache->lock);
+
+	if (valid) ++cache->stats.hits;
+	else ++cache->stats.misses;
+
+	gfx_mutex_unlock_(&cache->lock);
+
+	*size = copy.size;
+	return copy.code;
+}
+
+/****************************/
+bool gfx_shader_cache_insert_(GFXShaderCache* cache,
+                              const GFXHashKey_* key,
+                              size_t incs, const void* table,
+                              size_t size, const uint32_t* code)
+{
+	assert(cache != NULL);
+	assert(key != NULL);
+	assert(table != NULL || incs == 0);
+	assert(size % sizeof(uint32_t) == 0);
+	assert(code != NULL);
+
+	const uint64_t hash = cache->entries.hash(key);
+
+	gfx_mutex_lock_(&cache->lock);
+
+	// Remove any existing (i.e. outdated) entry first.
+	GFXShaderCacheElem_* elem = gfx_map_hsearch(&cache->entries, key, hash);
+	if (elem != NULL)
+	{
+		cache->size -= GFX_CACHE_ELEM_SIZE_(key, elem);
+		free(elem->code);
+		gfx_map_erase(&cache->entries, elem);
+	}
+
+	const bool success =
+		gfx_shader_cache_insert_locked_(cache, key, incs, table, size, code);
+
+	gfx_mutex_unlock_(&cache->lock);
+
+	return success;
+}
+
+/****************************/
+GFX_API GFXShaderCache* gfx_create_shader_cache(size_t maxSize)
+{
+	// Allocate a new cache.
+	GFXShaderCache* cache = malloc(sizeof(GFXShaderCache));
+	if (cache == NULL) goto clean;
+
+	if (!gfx_mutex_init_(&cache->lock))
+		goto clean;
+
+	gfx_map_init(&cache->entries,
+		sizeof(GFXShaderCacheElem_), gfx_hash_murmur3_, gfx_hash_cmp_);
+
+	cache->size = 0;
+	cache->maxSize = maxSize;
+	cache->stamp = 0;
+
+	cache->stats.hits = 0;
+	cache->stats.misses = 0;
+	cache->stats.evictions = 0;
+
+	return cache;
+
+
+	// Cleanup on failure.
+clean:
+	gfx_log_error("Could not create a new shader cache.");
+	free(cache);
+
+	return NULL;
+}
+
+/****************************/
+GFX_API void gfx_destroy_shader_cache(GFXShaderCache* cache)
+{
+	if (cache == NULL)
+		return;
+
+	// Free all cached bytecode.
+	for (
+		GFXShaderCacheElem_* elem = gfx_map_first(&cache->entries);
+		elem != NULL;
+		elem = gfx_map_next(&cache->entries, elem))
+	{
+		free(elem->code);
+	}
+
+	gfx_map_clear(&cache->entries);
+	gfx_mutex_clear_(&cache->lock);
+
+	free(cache);
+}
+
+/****************************/
+GFX_API GFXShaderCacheStats gfx_shader_cache_get_stats(GFXShaderCache* cache)
+{
+	assert(cache != NULL);
+
+	gfx_mutex_lock_(&cache->lock);
+
+	GFXShaderCacheStats stats = {
+		.entries   = cache->entries.size,
+		.size      = cache->size,
+		.maxSize   = cache->maxSize,
+		.hits      = cache->stats.hits,
+		.misses    = cache->stats.misses,
+		.evictions = cache->stats.evictions
+	};
+
+	gfx_mutex_unlock_(&cache->lock);
+
+	return stats;
+}
+
+/****************************/
+GFX_API bool gfx_shader_cache_dump(GFXShaderCache* cache, const GFXWriter* dst)
+{
+	assert(cache != NULL);
+	assert(dst != NULL);
+
+	GFXBufWriter buf;
+	gfx_buf_writer(&buf, dst);
+
+	gfx_mutex_lock_(&cache->lock);
+
+	bool success = gfx_io_writef(&buf,
+		"groufix shader cache:\n"
+		"    #entries: %"GFX_PRIs".\n"
+		"    Size: %"GFX_PRIs" / %"GFX_PRIs" bytes (0 = unbounded).\n"
+		"    #hits: %"PRIu64", #misses: %"PRIu64", #evictions: %"PRIu64".\n",
+		cache->entries.size, cache->size, cache->maxSize,
+		cache->stats.hits, cache->stats.misses, cache->stats.evictions) >= 0;
+
+	// One line per entry, followed by one line per include.
+	for (
+		GFXShaderCacheElem_* elem = gfx_map_first(&cache->entries);
+		success && elem != NULL;
+		elem = gfx_map_next(&cache->entries, elem))
+	{
+		const GFXHashKey_* key = gfx_map_key(&cache->entries, elem);
+
+		success = gfx_io_writef(&buf,
+			"  %08"PRIx64": %"GFX_PRIs" bytes SPIR-V, "
+			"%"GFX_PRIs" bytes key, last used at %"PRIu64".\n",
+			gfx_hash_murmur3_(key), elem->size, key->len, elem->stamp) >= 0;
+
+		const char* table = (const char*)elem->code + elem->size;
+		const char* end = table + elem->incs;
+
+		while (success && table < end)
+		{
+			uint32_t nameLen, len;
+			memcpy(&nameLen, table, sizeof(nameLen));
+			memcpy(&len, table + sizeof(nameLen), sizeof(len));
+			table += GFX_SHADER_CACHE_INCLUDE_SIZE_;
+
+			success = gfx_io_writef(&buf,
+				"      #include \"%s\" (%"PRIu32" bytes).\n", table, len) >= 0;
+
+			table += nameLen;
+		}
+	}
+
+	gfx_mutex_unlock_(&cache->lock);
+
+	return gfx_io_flush(&buf) >= 0 && success;
+}
+
+/****************************/
+GFX_API bool gfx_shader_cache_load(GFXShaderCache* cache, const GFXReader* src)
+{
+	assert(cache != NULL);
+	assert(src != NULL);
+
+	// We use a hash key builder for the cache data,
+	// so we can easily hash it for validation.
+	GFXHashBuilder_ builder;
+	if (!gfx_hash_builder_(&builder)) return 0;
+
+	long long len = gfx_io_len(src);
+	if (len <= 0) goto clean_builder;
+
+	void* bData = gfx_hash_builder_push_(&builder, (size_t)len, NULL);
+	if (bData == NULL) goto clean_builder;
+
+	// Read cache data.
+	len = gfx_io_read(src, bData, (size_t)len);
+	if (len <= 0) goto clean_builder;
+
+	// Claim builder data & unpack the groufix header.
+	GFXHashKey_* data = gfx_hash_builder_get_(&builder);
+	data->len = (size_t)len; // In case of shorter read.
+
+	if (data->len < GFX_SHADER_CACHE_HEADER_SIZE_)
+		goto clean_invalid;
+
+	uint32_t magic, dataSize, numEntries;
+	uint64_t dataHash;
+
+	const uint64_t emptyHash = 0;
+	char* head = data->bytes;
+
+	memcpy(&magic, head, sizeof(magic));
+	head += sizeof(magic);
+	memcpy(&dataSize, head, sizeof(dataSize));
+	head += sizeof(dataSize);
+	memcpy(&dataHash, head, sizeof(dataHash));
+	// Set dataHash to 0 in the received data so we can hash & compare it :)
+	memcpy(head, &emptyHash, sizeof(dataHash));
+	head += sizeof(dataHash);
+	memcpy(&numEntries, head, sizeof(numEntries));
+	head += sizeof(numEntries);
+
+	if (
+		magic != GFX_SHADER_CACHE_MAGIC_ ||
+		dataSize != data->len ||
+		dataHash != gfx_hash_murmur3_(data))
+	{
+		goto clean_invalid;
+	}
+
+	// Validate all entry bounds before inserting anything.
+	const char* end = data->bytes + data->len;
+	const char* entry = head;
+
+	for (uint32_t e = 0; e < numEntries; ++e)
+	{
+		uint32_t sizes[3]; // { keyLen, size, incs }.
+		if ((size_t)(end - entry) < GFX_SHADER_CACHE_ENTRY_SIZE_)
+			goto clean_invalid;
+
+		memcpy(sizes, entry, sizeof(sizes));
+		entry += GFX_SHADER_CACHE_ENTRY_SIZE_;
+
+		if (
+			sizes[1] % sizeof(uint32_t) != 0 ||
+			(size_t)(end - entry) < (size_t)sizes[0] + sizes[1] + sizes[2] ||
+			!gfx_shader_cache_check_table_(
+				sizes[2], entry + sizes[0] + sizes[1]))
+		{
+			goto clean_invalid;
+		}
+
+		entry += (size_t)sizes[0] + sizes[1] + sizes[2];
+	}
+
+	// Insert all entries, in order (least recently used first).
+	// We need to copy each key so it has a GFXHashKey_ header.
+	size_t loaded = 0;
+	entry = head;
+
+	gfx_mutex_lock_(&cache->lock);
+
+	for (uint32_t e = 0; e < numEntries; ++e)
+	{
+		uint32_t sizes[3];
+		memcpy(sizes, entry, sizeof(sizes));
+		entry += GFX_SHADER_CACHE_ENTRY_SIZE_;
+
+		GFXHashKey_* key = malloc(sizeof(GFXHashKey_) + sizes[0]);
+		if (key != NULL)
+		{
+			key->len = sizes[0];
+			memcpy(key->bytes, entry, sizes[0]);
+
+			// Do not replace already present entries.
+			if (
+				gfx_map_search(&cache->entries, key) == NULL &&
+				gfx_shader_cache_insert_locked_(cache, key,
+					sizes[2], entry + sizes[0] + sizes[1],
+					sizes[1], entry + sizes[0]))
+			{
+				++loaded;
+			}
+
+			free(key);
+		}
+
+		entry += (size_t)sizes[0] + sizes[1] + sizes[2];
+	}
+
+	gfx_mutex_unlock_(&cache->lock);
+
+	// Some victory logs c:
+	gfx_log_info(
+		"Successfully loaded groufix shader cache:\n"
+		"    Input size: %"GFX_PRIs" bytes.\n"
+		"    #entries: %"PRIu32" (%"GFX_PRIs" loaded).\n",
+		data->len, numEntries, loaded);
+
+	free(data);
+	return 1;
+
+
+	// Cleanup on invalid data.
+clean_invalid:
+	gfx_log_error(
+		"Could not load shader cache; "
+		"data is invalid or incompatible.");
+
+	free(data);
+	return 0;
+
+	// Cleanup the builder on failure.
+clean_builder:
+	gfx_log_error("Could not read shader cache from stream.");
+
+	free(gfx_hash_builder_get_(&builder));
+	return 0;
+}
+
+/****************************/
+GFX_API bool gfx_shader_cache_store(GFXShaderCache* cache, const GFXWriter* dst)
+{
+	assert(cache != NULL);
+	assert(dst != NULL);
+
+	GFXHashBuilder_ builder;
+	if (!gfx_hash_builder_(&builder)) return 0;
+
+	gfx_mutex_lock_(&cache->lock);
+
+	// Sort all entries by stamp, so the least recently used is stored first.
+	// This way loading it back in will preserve the eviction order.
+	const size_t numEntries = cache->entries.size;
+	GFXShaderCacheElem_** elems = NULL;
+
+	if (numEntries > UINT32_MAX)
+		goto clean;
+
+	if (numEntries > 0)
+	{
+		elems = malloc(sizeof(GFXShaderCacheElem_*) * numEntries);
+		if (elems == NULL) goto clean;
+
+		size_t e = 0;
+		for (
+			GFXShaderCacheElem_* elem = gfx_map_first(&cache->entries);
+			elem != NULL;
+			elem = gfx_map_next(&cache->entries, elem))
+		{
+			elems[e++] = elem;
+		}
+
+		qsort(elems, numEntries,
+			sizeof(GFXShaderCacheElem_*), gfx_shader_cache_cmp_);
+	}
+
+	// Create & push a groufix header, needs to be packed!
+	const uint32_t magic = GFX_SHADER_CACHE_MAGIC_;
+	const uint32_t emptySize = 0;
+	const uint64_t emptyHash = 0;
+	const uint32_t num = (uint32_t)numEntries;
+
+	GFX_KEY_PUSH_(magic);
+	GFX_KEY_PUSH_(emptySize);
+	GFX_KEY_PUSH_(emptyHash);
+	GFX_KEY_PUSH_(num);
+
+	// Push all entries.
+	for (size_t e = 0; e < numEntries; ++e)
+	{
+		const GFXHashKey_* key = gfx_map_key(&cache->entries, elems[e]);
+
+		// Sizes are stored as 32-bit, do not silently truncate.
+		if (
+			key->len > UINT32_MAX ||
+			elems[e]->size > UINT32_MAX ||
+			elems[e]->incs > UINT32_MAX)
+		{
+			gfx_log_error("Could not store shader cache; entry too large.");
+			goto clean;
+		}
+
+		const uint32_t sizes[3] = {
+			(uint32_t)key->len,
+			(uint32_t)elems[e]->size,
+			(uint32_t)elems[e]->incs
+		};
+
+		GFX_KEY_PUSH_(sizes);
+
+		if (
+			!gfx_hash_builder_push_(&builder, key->len, key->bytes) ||
+			!gfx_hash_builder_push_(&builder,
+				elems[e]->size + elems[e]->incs, elems[e]->code))
+		{
+			goto clean;
+		}
+	}
+
+	gfx_mutex_unlock_(&cache->lock);
+	free(elems);
+
+	// Claim builder data.
+	// Set its `dataSize` so we can hash.
+	GFXHashKey_* data = gfx_hash_builder_get_(&builder);
+
+	if (data->len > UINT32_MAX)
+	{
+		gfx_log_error("Could not store shader cache; too large.");
+		free(data);
+		return 0;
+	}
+
+	memcpy(
+		(uint32_t*)data->bytes + 1, // Right after `magic`.
+		&(uint32_t){ (uint32_t)data->len },
+		sizeof(uint32_t));
+
+	// Then hash while `dataHash` is 0 and set it afterwards.
+	const uint64_t hash = gfx_hash_murmur3_(data);
+	memcpy(
+		(uint32_t*)data->bytes + 2, // Right after `dataSize`.
+		&hash,
+		sizeof(uint64_t));
+
+	// Stream out the data.
+	if (gfx_io_write(dst, data->bytes, data->len) <= 0)
+	{
+		gfx_log_error("Could not write shader cache to stream.");
+		free(data);
+		return 0;
+	}
+
+	// Yey we did it!
+	gfx_log_info(
+		"Written groufix shader cache to stream (%"GFX_PRIs" bytes).",
+		data->len);
+
+	free(data);
+	return 1;
+
+
+	// Cleanup on failure.
+clean:
+	gfx_mutex_unlock_(&cache->lock);
+	free(elems);
+
+	gfx_log_error("Failed to store shader cache.");
+
+	free(gfx_hash_builder_get_(&builder));
+	return 0;
+}
@@ -0,0 +1,385 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include "groufix/core/objects.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+#define GFX_IS_SEPARATOR_(c) \
+	((c) == '/' || (c) == '\\')
+
+#define GFX_INCLUDE_PENDING_ \
+	(&gfx_include_pending_)
+
+
+/****************************
+ * Stream handed out by the include cache.
+ */
+typedef struct GFXIncludeReader_
+{
+	GFXBinReader     bin;
+	GFXIncludeData_* data;
+
+} GFXIncludeReader_;
+
+
+/****************************
+ * Placeholder data of entries that are still being read.
+ */
+static GFXIncludeData_ gfx_include_pending_;
+
+
+/****************************
+ * Builds a key from a normalized URI, i.e. all separators are '/',
+ * duplicate separators, '.' and resolvable '..' segments are removed.
+ * @param uri Cannot be NULL, must be NULL-terminated.
+ * @return NULL on failure, key->bytes is NULL-terminated (excluded in len).
+ */
+static GFXHashKey_* gfx_include_cache_key_(const char* uri)
+{
+	// The normalized URI is never longer than the given URI.
+	GFXHashKey_* key = malloc(sizeof(GFXHashKey_) + strlen(uri) + 1);
+	if (key == NULL) return NULL;
+
+	char* out = key->bytes;
+	size_t len = 0;
+	size_t root = 0; // Length of the output that cannot be popped.
+	size_t segs = 0; // Number of segments that can be popped.
+
+	// Keep absolute URIs absolute.
+	if (GFX_IS_SEPARATOR_(uri[0]))
+	{
+		out[len++] = '/';
+		root = 1;
+	}
+
+	while (*uri != '\0')
+	{
+		// Get the next segment.
+		while (GFX_IS_SEPARATOR_(*uri)) ++uri;
+		const char* end = uri;
+		while (*end != '\0' && !GFX_IS_SEPARATOR_(*end)) ++end;
+
+		const size_t segLen = (size_t)(end - uri);
+		const bool isCur = segLen == 1 && uri[0] == '.';
+		const bool isPar = segLen == 2 && uri[0] == '.' && uri[1] == '.';
+
+		if (segLen == 0 || isCur)
+		{
+			// Skip empty & current directory segments.
+		}
+		else if (isPar && segs > 0)
+		{
+			// Pop the previous segment, including its separator.
+			while (len > root && out[len-1] != '/') --len;
+			if (len > root) --len;
+			--segs;
+		}
+		else
+		{
+			if (len > 0 && out[len-1] != '/')
+				out[len++] = '/';
+
+			memcpy(out + len, uri, segLen);
+			len += segLen;
+
+			// Unresolvable parent directories cannot be popped.
+			if (isPar) root = len;
+			else ++segs;
+		}
+
+		uri = end;
+	}
+
+	out[len] = '\0';
+	key->len = len;
+
+	return key;
+}
+
+/****************************
+ * Resolves & reads a URI from the includer of an include cache,
+ * only holds cache->incLock while resolving & releasing.
+ * @return NULL if it could not be resolved, refs is initialized to 1.
+ */
+static GFXIncludeData_* gfx_include_cache_read_(GFXIncludeCache* cache,
+                                                const char* uri)
+{
+	const GFXIncluder* inc = cache->inc;
+
+	gfx_mutex_lock_(&cache->incLock);
+	const GFXReader* src = gfx_io_resolve(inc, uri);
+	gfx_mutex_unlock_(&cache->incLock);
+
+	if (src == NULL) return NULL;
+
+	GFXIncludeData_* data = NULL;
+	long long len = gfx_io_len(src);
+
+	// Empty sources are valid, only a negative length is a failure.
+	if (len >= 0)
+	{
+		data = malloc(sizeof(GFXIncludeData_) + (size_t)len);
+		if (data != NULL)
+		{
+			if (len > 0)
+				len = gfx_io_read(src, data->bytes, (size_t)len);
+
+			if (len >= 0)
+			{
+				data->refs = 1;
+				data->len = (size_t)len;
+			}
+			else
+			{
+				free(data);
+				data = NULL;
+			}
+		}
+	}
+
+	gfx_mutex_lock_(&cache->incLock);
+	gfx_io_release(inc, src);
+	gfx_mutex_unlock_(&cache->incLock);
+
+	return data;
+}
+
+/****************************
+ * Releases a reference to include cache data, must hold the lock.
+ * @param data May be NULL or pending.
+ */
+static void gfx_include_cache_unref_(GFXIncludeData_* data)
+{
+	if (data != NULL && data != GFX_INCLUDE_PENDING_ && --data->refs == 0)
+		free(data);
+}
+
+/****************************
+ * GFXIncludeCache implementation of the resolve function.
+ */
+static const GFXReader* gfx_include_cache_resolve_(const GFXIncluder* inc,
+                                                   const char* uri)
+{
+	GFXIncludeCache* cache = GFX_IO_OBJ(inc, GFXIncludeCache, includer);
+
+	// Allocate the key & stream to hand out.
+	GFXHashKey_* key = gfx_include_cache_key_(uri);
+	if (key == NULL) return NULL;
+
+	GFXIncludeReader_* str = malloc(sizeof(GFXIncludeReader_));
+	if (str == NULL)
+	{
+		free(key);
+		return NULL;
+	}
+
+	const uint64_t hash = gfx_hash_murmur3_(key);
+
+	// Wait for any other thread already reading this URI.
+	gfx_mutex_lock_(&cache->lock);
+
+	GFXIncludeData_** elem;
+	while (
+		(elem = gfx_map_hsearch(&cache->entries, key, hash)) != NULL &&
+		*elem == GFX_INCLUDE_PENDING_)
+	{
+		gfx_cond_wait_(&cache->cond, &cache->lock);
+	}
+
+	GFXIncludeData_* data;
+
+	if (elem != NULL)
+	{
+		data = *elem;
+		if (data != NULL) ++data->refs;
+	}
+	else
+	{
+		// Insert a pending entry & read without holding the lock.
+		GFXIncludeData_* pending = GFX_INCLUDE_PENDING_;
+		const bool inserted = gfx_map_hinsert(
+			&cache->entries, &pending, gfx_hash_size_(key), key, hash) != NULL;
+
+		gfx_mutex_unlock_(&cache->lock);
+		data = gfx_include_cache_read_(cache, key->bytes);
+		gfx_mutex_lock_(&cache->lock);
+
+		// Remember failures too, so we don't try again.
+		// The entry may have been invalidated in the meantime,
+		// in which case the only reference is the handed out stream.
+		elem = inserted ? gfx_map_hsearch(&cache->entries, key, hash) : NULL;
+
+		if (elem != NULL && *elem == GFX_INCLUDE_PENDING_)
+		{
+			*elem = data;
+			if (data != NULL) ++data->refs;
+		}
+
+		gfx_cond_broadcast_(&cache->cond);
+	}
+
+	gfx_mutex_unlock_(&cache->lock);
+	free(key);
+
+	if (data == NULL)
+	{
+		free(str);
+		return NULL;
+	}
+
+	str->data = data;
+	return gfx_bin_reader(&str->bin, data->len, data->bytes);
+}
+
+/****************************
+ * GFXIncludeCache implementation of the release function.
+ */
+static void gfx_include_cache_release_(const GFXIncluder* inc,
+                                       const GFXReader* str)
+{
+	if (str == NULL)
+		return;
+
+	GFXIncludeCache* cache = GFX_IO_OBJ(inc, GFXIncludeCache, includer);
+	GFXIncludeReader_* reader = GFX_IO_OBJ(str, GFXIncludeReader_, bin.reader);
+
+	// The data may have been invalidated in the meantime,
+	// in which case we might be the last reference.
+	gfx_mutex_lock_(&cache->lock);
+	gfx_include_cache_unref_(reader->data);
+	gfx_mutex_unlock_(&cache->lock);
+
+	free(reader);
+}
+
+/****************************/
+GFX_API GFXIncludeCache* gfx_create_include_cache(const GFXIncluder* inc)
+{
+	assert(inc != NULL);
+
+	// Allocate a new cache.
+	GFXIncludeCache* cache = malloc(sizeof(GFXIncludeCache));
+	if (cache == NULL) goto clean;
+
+	if (!gfx_mutex_init_(&cache->incLock))
+		goto clean;
+
+	if (!gfx_mutex_init_(&cache->lock))
+		goto clean_inc_lock;
+
+	if (!gfx_cond_init_(&cache->cond))
+		goto clean_lock;
+
+	gfx_map_init(&cache->entries,
+		sizeof(GFXIncludeData_*), gfx_hash_murmur3_, gfx_hash_cmp_);
+
+	cache->includer.resolve = gfx_include_cache_resolve_;
+	cache->includer.release = gfx_include_cache_release_;
+	cache->inc = inc;
+
+	return cache;
+
+
+	// Cleanup on failure.
+clean_lock:
+	gfx_mutex_clear_(&cache->lock);
+clean_inc_lock:
+	gfx_mutex_clear_(&cache->incLock);
+clean:
+	gfx_log_error("Could not create a new include cache.");
+	free(cache);
+
+	return NULL;
+}
+
+/****************************/
+GFX_API void gfx_destroy_include_cache(GFXIncludeCache* cache)
+{
+	if (cache == NULL)
+		return;
+
+	// Release all cached data,
+	// all handed out streams must have been released already.
+	for (
+		GFXIncludeData_** elem = gfx_map_first(&cache->entries);
+		elem != NULL;
+		elem = gfx_map_next(&cache->entries, elem))
+	{
+		gfx_include_cache_unref_(*elem);
+	}
+
+	gfx_map_clear(&cache->entries);
+	gfx_cond_clear_(&cache->cond);
+	gfx_mutex_clear_(&cache->lock);
+	gfx_mutex_clear_(&cache->incLock);
+
+	free(cache);
+}
+
+/****************************/
+GFX_API const GFXIncluder* gfx_include_cache_get_includer(GFXIncludeCache* cache)
+{
+	if (cache == NULL)
+		return NULL;
+
+	return &cache->includer;
+}
+
+/****************************/
+GFX_API void gfx_include_cache_invalidate(GFXIncludeCache* cache,
+                                          const char* uri)
+{
+	assert(cache != NULL);
+
+	// Invalidate a single URI.
+	if (uri != NULL)
+	{
+		GFXHashKey_* key = gfx_include_cache_key_(uri);
+		if (key == NULL)
+		{
+			// Cannot find the entry, be safe & invalidate everything.
+			gfx_log_warn(
+				"Could not invalidate '%s' of include cache, "
+				"invalidating all entries instead.",
+				uri);
+
+			gfx_include_cache_invalidate(cache, NULL);
+			return;
+		}
+
+		gfx_mutex_lock_(&cache->lock);
+
+		GFXIncludeData_** elem = gfx_map_search(&cache->entries, key);
+		if (elem != NULL)
+		{
+			gfx_include_cache_unref_(*elem);
+			gfx_map_erase(&cache->entries, elem);
+		}
+
+		gfx_mutex_unlock_(&cache->lock);
+		free(key);
+
+		return;
+	}
+
+	// Invalidate all URIs.
+	gfx_mutex_lock_(&cache->lock);
+
+	for (
+		GFXIncludeData_** elem = gfx_map_first(&cache->entries);
+		elem != NULL;
+		elem = gfx_map_next(&cache->entries, elem))
+	{
+		gfx_include_cache_unref_(*elem);
+	}
+
+	gfx_map_clear(&cache->entries);
+	gfx_mutex_unlock_(&cache->lock);
+}
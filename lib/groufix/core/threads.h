@@ -14,9 +14,57 @@
 
 #if defined (GFX_UNIX)
 	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
 #elif defined (GFX_WIN32)
+	#include <handleapi.h>
 	#include <processthreadsapi.h>
 	#include <synchapi.h>
+	#include <sysinfoapi.h>
+#endif
+
+#if defined (GFX_LOCK_STATS)
+	#if defined (GFX_UNIX)
+		#include <time.h>
+	#elif defined (GFX_WIN32)
+		#include <profileapi.h>
+	#endif
+#endif
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+#endif
+
+
+// Number of times to try a lock before blocking, see gfx_mutex_lock_spin_.
+#define GFX_LOCK_SPIN_COUNT_ 64
+
+
+/**
+ * Thread handle.
+ */
+typedef struct GFXThread_
+{
+#if defined (GFX_UNIX)
+	pthread_t handle;
+#elif defined (GFX_WIN32)
+	HANDLE    handle;
+#endif
+
+	// Entry point & its argument.
+	void (*func)(void*);
+	void* arg;
+
+} GFXThread_;
+
+
+/**
+ * Thread local storage class specifier.
+ */
+#if defined (_MSC_VER) && !defined (__clang__)
+	#define GFX_THREAD_LOCAL_ __declspec(thread)
+#else
+	#define GFX_THREAD_LOCAL_ _Thread_local
 #endif
 
 
@@ -30,10 +78,48 @@
 #endif
 
 
+/**
+ * Lock statistics of all locks initialized at the same site.
+ * Only available when built with GFX_LOCK_STATS, all times in nanoseconds.
+ */
+#if defined (GFX_LOCK_STATS)
+typedef struct GFXLockStats_
+{
+	struct GFXLockStats_* next;
+
+	const char*  name; // Stringified lock expression.
+	const char*  file;
+	unsigned int line;
+
+	atomic_ullong acquired;  // Number of acquisitions.
+	atomic_ullong contended; // Number of acquisitions that had to block.
+	atomic_ullong waitTotal; // Of contended acquisitions.
+	atomic_ullong waitMax;
+	atomic_ullong held;      // Number of exclusive acquisitions released.
+	atomic_ullong holdTotal; // Of exclusive acquisitions.
+	atomic_ullong holdMax;
+
+} GFXLockStats_;
+#endif
+
+
 /**
  * Mutual exclusion lock.
  */
+#if defined (GFX_LOCK_STATS)
+typedef struct GFXMutex_
+{
 #if defined (GFX_UNIX)
+	pthread_mutex_t handle;
+#elif defined (GFX_WIN32)
+	SRWLOCK         handle;
+#endif
+
+	GFXLockStats_* stats; // May be NULL.
+	uint64_t       start; // Acquisition time of the owner.
+
+} GFXMutex_;
+#elif defined (GFX_UNIX)
 	typedef pthread_mutex_t GFXMutex_;
 #elif defined (GFX_WIN32)
 	typedef SRWLOCK         GFXMutex_;
@@ -43,13 +129,152 @@
 /**
  * Readers/Writer lock.
  */
+#if defined (GFX_LOCK_STATS)
+typedef struct GFXRWLock_
+{
 #if defined (GFX_UNIX)
+	pthread_rwlock_t handle;
+#elif defined (GFX_WIN32)
+	SRWLOCK          handle;
+#endif
+
+	GFXLockStats_* stats; // May be NULL.
+	uint64_t       start; // Acquisition time of the writer.
+
+} GFXRWLock_;
+#elif defined (GFX_UNIX)
 	typedef pthread_rwlock_t GFXRWLock_;
 #elif defined (GFX_WIN32)
 	typedef SRWLOCK          GFXRWLock_;
 #endif
 
 
+/**
+ * Platform handle of a mutex or readers/writer lock.
+ */
+#if defined (GFX_LOCK_STATS)
+	#define GFX_LOCK_HANDLE_(lock) (&(lock)->handle)
+#else
+	#define GFX_LOCK_HANDLE_(lock) (lock)
+#endif
+
+
+/**
+ * Condition variable.
+ */
+#if defined (GFX_UNIX)
+	typedef pthread_cond_t     GFXCond_;
+#elif defined (GFX_WIN32)
+	typedef CONDITION_VARIABLE GFXCond_;
+#endif
+
+
+/****************************
+ * Thread handle.
+ ****************************/
+
+/**
+ * Platform entry point of a thread, calls thread->func(thread->arg).
+ */
+#if defined (GFX_UNIX)
+static inline void* gfx_thread_start_(void* thread)
+{
+	((GFXThread_*)thread)->func(((GFXThread_*)thread)->arg);
+	return NULL;
+}
+#elif defined (GFX_WIN32)
+static inline DWORD WINAPI gfx_thread_start_(LPVOID thread)
+{
+	((GFXThread_*)thread)->func(((GFXThread_*)thread)->arg);
+	return 0;
+}
+#endif
+
+/**
+ * Creates (i.e. starts) a new thread.
+ * The object pointed to by thread cannot be moved or copied until joined!
+ * @param func Entry point, cannot be NULL.
+ * @return Non-zero on success.
+ *
+ * The new thread is NOT attached to groufix, call gfx_create_local_()!
+ */
+static inline bool gfx_thread_init_(GFXThread_* thread,
+                                    void (*func)(void*), void* arg)
+{
+	thread->func = func;
+	thread->arg = arg;
+
+#if defined (GFX_UNIX)
+	return !pthread_create(&thread->handle, NULL, gfx_thread_start_, thread);
+
+#elif defined (GFX_WIN32)
+	thread->handle = CreateThread(NULL, 0, gfx_thread_start_, thread, 0, NULL);
+	return thread->handle != NULL;
+
+#endif
+}
+
+/**
+ * Blocks until a thread has terminated and clears its resources.
+ */
+static inline void gfx_thread_join_(GFXThread_* thread)
+{
+#if defined (GFX_UNIX)
+	pthread_join(thread->handle, NULL);
+
+#elif defined (GFX_WIN32)
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+
+#endif
+}
+
+/**
+ * Yields the processor to another thread.
+ */
+static inline void gfx_thread_yield_(void)
+{
+#if defined (GFX_UNIX)
+	sched_yield();
+
+#elif defined (GFX_WIN32)
+	SwitchToThread();
+
+#endif
+}
+
+/**
+ * Hints the processor that the calling thread is spinning.
+ */
+static inline void gfx_thread_relax_(void)
+{
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+	_mm_pause();
+#elif defined (GFX_WIN32)
+	YieldProcessor();
+#endif
+}
+
+/**
+ * Retrieves the number of logical processors that are currently online.
+ * @return Always at least 1.
+ */
+static inline unsigned int gfx_thread_count_(void)
+{
+#if defined (GFX_UNIX)
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count < 1 ? 1 : (unsigned int)count;
+
+#elif defined (GFX_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors < 1 ? 1 :
+		(unsigned int)info.dwNumberOfProcessors;
+
+#endif
+}
+
+
 /****************************
  * Thread local data key.
  ****************************/
@@ -57,14 +282,19 @@
 /**
  * Initializes a thread local data key.
  * The object pointed to by key cannot be moved or copied!
+ * @param destruct Called on non-NULL values of exiting threads, may be NULL.
  * @return Non-zero on success.
+ *
+ * On win32 destruct is ignored, values are never cleaned up automatically.
  */
-static inline bool gfx_thread_key_init_(GFXThreadKey_* key)
+static inline bool gfx_thread_key_init_(GFXThreadKey_* key,
+                                        void (*destruct)(void*))
 {
 #if defined (GFX_UNIX)
-	return !pthread_key_create(key, NULL);
+	return !pthread_key_create(key, destruct);
 
 #elif defined (GFX_WIN32)
+	(void)destruct;
 	*key = TlsAlloc();
 	return *key != TLS_OUT_OF_INDEXES;
 
@@ -116,6 +346,112 @@ static inline void* gfx_thread_key_get_(GFXThreadKey_ key)
 }
 
 
+/****************************
+ * Lock statistics.
+ ****************************/
+
+#if defined (GFX_LOCK_STATS)
+
+/**
+ * Retrieves (or creates) the lock statistics of an initialization site.
+ * @param name Stringified lock expression, cannot be NULL.
+ * @param file Cannot be NULL.
+ * @return NULL on failure.
+ *
+ * Thread-safe, can be called before gfx_init.
+ */
+GFXLockStats_* gfx_lock_stats_get_(const char* name,
+                                   const char* file, unsigned int line);
+
+/**
+ * Resets the counters of all lock statistics.
+ * Statistics are never freed, as locks may outlive gfx_terminate,
+ * they live for as long as the process.
+ */
+void gfx_lock_stats_reset_(void);
+
+/**
+ * Retrieves monotonic time in nanoseconds.
+ */
+static inline uint64_t gfx_lock_time_(void)
+{
+#if defined (GFX_UNIX)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+
+#elif defined (GFX_WIN32)
+	LARGE_INTEGER cnt, freq;
+	QueryPerformanceCounter(&cnt);
+	QueryPerformanceFrequency(&freq);
+
+	const uint64_t c = (uint64_t)cnt.QuadPart;
+	const uint64_t f = (uint64_t)freq.QuadPart;
+
+	return (c / f) * 1000000000 + (c % f) * 1000000000 / f;
+
+#endif
+}
+
+/**
+ * Atomically sets max to value if value is greater.
+ */
+static inline void gfx_lock_max_(atomic_ullong* max, unsigned long long value)
+{
+	unsigned long long curr = atomic_load_explicit(max, memory_order_relaxed);
+
+	while (curr < value && !atomic_compare_exchange_weak_explicit(
+		max, &curr, value, memory_order_relaxed, memory_order_relaxed));
+}
+
+/**
+ * Records a lock acquisition, must be called after acquiring.
+ * @param stats     May be NULL.
+ * @param start     Outputs the acquisition time, NULL for shared acquisitions.
+ * @param t         Time at which blocking started, ignored if not contended.
+ * @param contended Non-zero if the calling thread had to block.
+ */
+static inline void gfx_lock_acquired_(GFXLockStats_* stats, uint64_t* start,
+                                      uint64_t t, bool contended)
+{
+	const uint64_t now = gfx_lock_time_();
+	if (start != NULL) *start = now;
+
+	if (stats == NULL)
+		return;
+
+	atomic_fetch_add_explicit(&stats->acquired, 1, memory_order_relaxed);
+
+	if (contended)
+	{
+		atomic_fetch_add_explicit(&stats->contended, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(
+			&stats->waitTotal, now - t, memory_order_relaxed);
+		gfx_lock_max_(&stats->waitMax, now - t);
+	}
+}
+
+/**
+ * Records an exclusive lock release, must be called before releasing.
+ * @param stats May be NULL.
+ * @param start Acquisition time, as output by gfx_lock_acquired_.
+ */
+static inline void gfx_lock_released_(GFXLockStats_* stats, uint64_t start)
+{
+	if (stats == NULL)
+		return;
+
+	const uint64_t hold = gfx_lock_time_() - start;
+
+	atomic_fetch_add_explicit(&stats->held, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&stats->holdTotal, hold, memory_order_relaxed);
+	gfx_lock_max_(&stats->holdMax, hold);
+}
+
+#endif
+
+
 /****************************
  * Mutual exclusion lock.
  ****************************/
@@ -124,14 +460,40 @@ static inline void* gfx_thread_key_get_(GFXThreadKey_ key)
  * Initializes a mutex.
  * The object pointed to by mutex cannot be moved or copied!
  * @return Non-zero on success.
+ *
+ * When built with GFX_LOCK_STATS, statistics are aggregated over all
+ * mutexes initialized at the same site (i.e. source file and line).
+ */
+#if defined (GFX_LOCK_STATS)
+	#define gfx_mutex_init_(mutex) \
+		gfx_mutex_init_at_(mutex, #mutex, __FILE__, __LINE__)
+#else
+	#define gfx_mutex_init_(mutex) \
+		gfx_mutex_init_at_(mutex, NULL, NULL, 0)
+#endif
+
+/**
+ * Initializes a mutex, recording the site for lock statistics.
+ * @see gfx_mutex_init_.
  */
-static inline bool gfx_mutex_init_(GFXMutex_* mutex)
+static inline bool gfx_mutex_init_at_(GFXMutex_* mutex,
+                                      const char* name,
+                                      const char* file, unsigned int line)
 {
+#if defined (GFX_LOCK_STATS)
+	mutex->stats = gfx_lock_stats_get_(name, file, line);
+	mutex->start = 0;
+#else
+	(void)name;
+	(void)file;
+	(void)line;
+#endif
+
 #if defined (GFX_UNIX)
-	return !pthread_mutex_init(mutex, NULL);
+	return !pthread_mutex_init(GFX_LOCK_HANDLE_(mutex), NULL);
 
 #elif defined (GFX_WIN32)
-	InitializeSRWLock(mutex);
+	InitializeSRWLock(GFX_LOCK_HANDLE_(mutex));
 	return 1;
 
 #endif
@@ -144,7 +506,7 @@ static inline bool gfx_mutex_init_(GFXMutex_* mutex)
 static inline void gfx_mutex_clear_(GFXMutex_* mutex)
 {
 #if defined (GFX_UNIX)
-	pthread_mutex_destroy(mutex);
+	pthread_mutex_destroy(GFX_LOCK_HANDLE_(mutex));
 
 #elif defined (GFX_WIN32)
 	/* No-op */
@@ -153,18 +515,30 @@ static inline void gfx_mutex_clear_(GFXMutex_* mutex)
 }
 
 /**
- * Blocks until the calling thread is granted ownership of the mutex.
- * Locking an already owned mutex is undefined behaviour.
- *
- * Non-recursive!
+ * Platform try-lock of a mutex, does not record any statistics.
+ * @return Non-zero if ownership was granted.
  */
-static inline void gfx_mutex_lock_(GFXMutex_* mutex)
+static inline bool gfx_mutex_try_acquire_(GFXMutex_* mutex)
+{
+#if defined (GFX_UNIX)
+	return !pthread_mutex_trylock(GFX_LOCK_HANDLE_(mutex));
+
+#elif defined (GFX_WIN32)
+	return TryAcquireSRWLockExclusive(GFX_LOCK_HANDLE_(mutex));
+
+#endif
+}
+
+/**
+ * Platform blocking lock of a mutex, does not record any statistics.
+ */
+static inline void gfx_mutex_acquire_(GFXMutex_* mutex)
 {
 #if defined (GFX_UNIX)
-	pthread_mutex_lock(mutex);
+	pthread_mutex_lock(GFX_LOCK_HANDLE_(mutex));
 
 #elif defined (GFX_WIN32)
-	AcquireSRWLockExclusive(mutex);
+	AcquireSRWLockExclusive(GFX_LOCK_HANDLE_(mutex));
 
 #endif
 }
@@ -177,12 +551,66 @@ static inline void gfx_mutex_lock_(GFXMutex_* mutex)
  */
 static inline bool gfx_mutex_try_lock_(GFXMutex_* mutex)
 {
-#if defined (GFX_UNIX)
-	return !pthread_mutex_trylock(mutex);
+	const bool locked = gfx_mutex_try_acquire_(mutex);
 
-#elif defined (GFX_WIN32)
-	return TryAcquireSRWLockExclusive(mutex);
+#if defined (GFX_LOCK_STATS)
+	if (locked) gfx_lock_acquired_(mutex->stats, &mutex->start, 0, 0);
+#endif
 
+	return locked;
+}
+
+/**
+ * Blocks until the calling thread is granted ownership of the mutex.
+ * Locking an already owned mutex is undefined behaviour.
+ *
+ * Non-recursive!
+ */
+static inline void gfx_mutex_lock_(GFXMutex_* mutex)
+{
+#if defined (GFX_LOCK_STATS)
+	// Try first, so we know whether we had to block.
+	const uint64_t t = gfx_lock_time_();
+	if (gfx_mutex_try_lock_(mutex)) return;
+#endif
+
+	gfx_mutex_acquire_(mutex);
+
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_acquired_(mutex->stats, &mutex->start, t, 1);
+#endif
+}
+
+/**
+ * Adaptive version of gfx_mutex_lock_, spins briefly before blocking.
+ * Use for very short critical sections, to avoid syscalls when contended.
+ *
+ * Non-recursive!
+ */
+static inline void gfx_mutex_lock_spin_(GFXMutex_* mutex)
+{
+#if defined (GFX_LOCK_STATS)
+	// Only the first try is uncontended, any spinning counts as waiting.
+	const uint64_t t = gfx_lock_time_();
+#endif
+
+	for (unsigned int s = 0; s < GFX_LOCK_SPIN_COUNT_; ++s)
+	{
+		if (gfx_mutex_try_acquire_(mutex))
+		{
+#if defined (GFX_LOCK_STATS)
+			gfx_lock_acquired_(mutex->stats, &mutex->start, t, s > 0);
+#endif
+			return;
+		}
+
+		gfx_thread_relax_();
+	}
+
+	gfx_mutex_acquire_(mutex);
+
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_acquired_(mutex->stats, &mutex->start, t, 1);
 #endif
 }
 
@@ -192,11 +620,15 @@ static inline bool gfx_mutex_try_lock_(GFXMutex_* mutex)
  */
 static inline void gfx_mutex_unlock_(GFXMutex_* mutex)
 {
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_released_(mutex->stats, mutex->start);
+#endif
+
 #if defined (GFX_UNIX)
-	pthread_mutex_unlock(mutex);
+	pthread_mutex_unlock(GFX_LOCK_HANDLE_(mutex));
 
 #elif defined (GFX_WIN32)
-	ReleaseSRWLockExclusive(mutex);
+	ReleaseSRWLockExclusive(GFX_LOCK_HANDLE_(mutex));
 
 #endif
 }
@@ -210,14 +642,40 @@ static inline void gfx_mutex_unlock_(GFXMutex_* mutex)
  * Initializes a readers/writer lock.
  * The object pointed to by lock cannot be moved or copied!
  * @return Non-zero on success.
+ *
+ * When built with GFX_LOCK_STATS, hold times are only recorded for writers.
+ * @see gfx_mutex_init_.
  */
-static inline bool gfx_rwlock_init_(GFXRWLock_* lock)
+#if defined (GFX_LOCK_STATS)
+	#define gfx_rwlock_init_(lock) \
+		gfx_rwlock_init_at_(lock, #lock, __FILE__, __LINE__)
+#else
+	#define gfx_rwlock_init_(lock) \
+		gfx_rwlock_init_at_(lock, NULL, NULL, 0)
+#endif
+
+/**
+ * Initializes a readers/writer lock, recording the site for lock statistics.
+ * @see gfx_rwlock_init_.
+ */
+static inline bool gfx_rwlock_init_at_(GFXRWLock_* lock,
+                                       const char* name,
+                                       const char* file, unsigned int line)
 {
+#if defined (GFX_LOCK_STATS)
+	lock->stats = gfx_lock_stats_get_(name, file, line);
+	lock->start = 0;
+#else
+	(void)name;
+	(void)file;
+	(void)line;
+#endif
+
 #if defined (GFX_UNIX)
-	return !pthread_rwlock_init(lock, NULL);
+	return !pthread_rwlock_init(GFX_LOCK_HANDLE_(lock), NULL);
 
 #elif defined (GFX_WIN32)
-	InitializeSRWLock(lock);
+	InitializeSRWLock(GFX_LOCK_HANDLE_(lock));
 	return 1;
 
 #endif
@@ -230,7 +688,7 @@ static inline bool gfx_rwlock_init_(GFXRWLock_* lock)
 static inline void gfx_rwlock_clear_(GFXRWLock_* lock)
 {
 #if defined (GFX_UNIX)
-	pthread_rwlock_destroy(lock);
+	pthread_rwlock_destroy(GFX_LOCK_HANDLE_(lock));
 
 #elif defined (GFX_WIN32)
 	/* No-op */
@@ -239,37 +697,53 @@ static inline void gfx_rwlock_clear_(GFXRWLock_* lock)
 }
 
 /**
- * Blocks until the calling thread is granted reader ownership of the lock.
- * Locking an already owned readers/writer lock is undefined behaviour.
+ * Try to get reader ownership of the lock without blocking.
+ * @return Non-zero if ownership was granted.
  *
  * Non-recursive!
  */
-static inline void gfx_rwlock_rlock_(GFXRWLock_* lock)
+static inline bool gfx_rwlock_try_rlock_(GFXRWLock_* lock)
 {
 #if defined (GFX_UNIX)
-	pthread_rwlock_rdlock(lock);
+	const bool locked = !pthread_rwlock_tryrdlock(GFX_LOCK_HANDLE_(lock));
 
 #elif defined (GFX_WIN32)
-	AcquireSRWLockShared(lock);
+	const bool locked = TryAcquireSRWLockShared(GFX_LOCK_HANDLE_(lock));
 
 #endif
+
+#if defined (GFX_LOCK_STATS)
+	if (locked) gfx_lock_acquired_(lock->stats, NULL, 0, 0);
+#endif
+
+	return locked;
 }
 
 /**
- * Try to get reader ownership of the lock without blocking.
- * @return Non-zero if ownership was granted.
+ * Blocks until the calling thread is granted reader ownership of the lock.
+ * Locking an already owned readers/writer lock is undefined behaviour.
  *
  * Non-recursive!
  */
-static inline bool gfx_rwlock_try_rlock_(GFXRWLock_* lock)
+static inline void gfx_rwlock_rlock_(GFXRWLock_* lock)
 {
+#if defined (GFX_LOCK_STATS)
+	// Try first, so we know whether we had to block.
+	const uint64_t t = gfx_lock_time_();
+	if (gfx_rwlock_try_rlock_(lock)) return;
+#endif
+
 #if defined (GFX_UNIX)
-	return !pthread_rwlock_tryrdlock(lock);
+	pthread_rwlock_rdlock(GFX_LOCK_HANDLE_(lock));
 
 #elif defined (GFX_WIN32)
-	return TryAcquireSRWLockShared(lock);
+	AcquireSRWLockShared(GFX_LOCK_HANDLE_(lock));
 
 #endif
+
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_acquired_(lock->stats, NULL, t, 1);
+#endif
 }
 
 /**
@@ -279,45 +753,61 @@ static inline bool gfx_rwlock_try_rlock_(GFXRWLock_* lock)
 static inline void gfx_rwlock_runlock_(GFXRWLock_* lock)
 {
 #if defined (GFX_UNIX)
-	pthread_rwlock_unlock(lock);
+	pthread_rwlock_unlock(GFX_LOCK_HANDLE_(lock));
 
 #elif defined (GFX_WIN32)
-	ReleaseSRWLockShared(lock);
+	ReleaseSRWLockShared(GFX_LOCK_HANDLE_(lock));
 
 #endif
 }
 
 /**
- * Blocks until the calling thread is granted writer ownership of the lock.
- * Locking an already owned readers/writer lock is undefined behaviour.
+ * Try to get writer ownership of the lock without blocking.
+ * @return Non-zero if ownership was granted.
  *
  * Non-recursive!
  */
-static inline void gfx_rwlock_wlock_(GFXRWLock_* lock)
+static inline bool gfx_rwlock_try_wlock_(GFXRWLock_* lock)
 {
 #if defined (GFX_UNIX)
-	pthread_rwlock_wrlock(lock);
+	const bool locked = !pthread_rwlock_trywrlock(GFX_LOCK_HANDLE_(lock));
 
 #elif defined (GFX_WIN32)
-	AcquireSRWLockExclusive(lock);
+	const bool locked = TryAcquireSRWLockExclusive(GFX_LOCK_HANDLE_(lock));
+
+#endif
 
+#if defined (GFX_LOCK_STATS)
+	if (locked) gfx_lock_acquired_(lock->stats, &lock->start, 0, 0);
 #endif
+
+	return locked;
 }
 
 /**
- * Try to get writer ownership of the lock without blocking.
- * @return Non-zero if ownership was granted.
+ * Blocks until the calling thread is granted writer ownership of the lock.
+ * Locking an already owned readers/writer lock is undefined behaviour.
  *
  * Non-recursive!
  */
-static inline bool gfx_rwlock_try_wlock_(GFXRWLock_* lock)
+static inline void gfx_rwlock_wlock_(GFXRWLock_* lock)
 {
+#if defined (GFX_LOCK_STATS)
+	// Try first, so we know whether we had to block.
+	const uint64_t t = gfx_lock_time_();
+	if (gfx_rwlock_try_wlock_(lock)) return;
+#endif
+
 #if defined (GFX_UNIX)
-	return !pthread_rwlock_trywrlock(lock);
+	pthread_rwlock_wrlock(GFX_LOCK_HANDLE_(lock));
 
 #elif defined (GFX_WIN32)
-	return TryAcquireSRWLockExclusive(lock);
+	AcquireSRWLockExclusive(GFX_LOCK_HANDLE_(lock));
+
+#endif
 
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_acquired_(lock->stats, &lock->start, t, 1);
 #endif
 }
 
@@ -327,14 +817,136 @@ static inline bool gfx_rwlock_try_wlock_(GFXRWLock_* lock)
  */
 static inline void gfx_rwlock_wunlock_(GFXRWLock_* lock)
 {
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_released_(lock->stats, lock->start);
+#endif
+
+#if defined (GFX_UNIX)
+	pthread_rwlock_unlock(GFX_LOCK_HANDLE_(lock));
+
+#elif defined (GFX_WIN32)
+	ReleaseSRWLockExclusive(GFX_LOCK_HANDLE_(lock));
+
+#endif
+}
+
+
+
+/****************************
+ * Condition variable.
+ ****************************/
+
+/**
+ * Initializes a condition variable.
+ * The object pointed to by cond cannot be moved or copied!
+ * @return Non-zero on success.
+ */
+static inline bool gfx_cond_init_(GFXCond_* cond)
+{
+#if defined (GFX_UNIX)
+	return !pthread_cond_init(cond, NULL);
+
+#elif defined (GFX_WIN32)
+	InitializeConditionVariable(cond);
+	return 1;
+
+#endif
+}
+
+/**
+ * Clears a condition variable.
+ * Clearing a condition variable that is waited on is undefined behaviour.
+ */
+static inline void gfx_cond_clear_(GFXCond_* cond)
+{
+#if defined (GFX_UNIX)
+	pthread_cond_destroy(cond);
+
+#elif defined (GFX_WIN32)
+	/* No-op */
+
+#endif
+}
+
+/**
+ * Releases the mutex and blocks until the condition variable is signaled,
+ * then reacquires the mutex before returning.
+ * The mutex must be owned by the calling thread.
+ *
+ * May wake up spuriously!
+ */
+static inline void gfx_cond_wait_(GFXCond_* cond, GFXMutex_* mutex)
+{
+#if defined (GFX_LOCK_STATS)
+	// Waiting is not holding, nor contention.
+	gfx_lock_released_(mutex->stats, mutex->start);
+#endif
+
+#if defined (GFX_UNIX)
+	pthread_cond_wait(cond, GFX_LOCK_HANDLE_(mutex));
+
+#elif defined (GFX_WIN32)
+	SleepConditionVariableSRW(cond, GFX_LOCK_HANDLE_(mutex), INFINITE, 0);
+
+#endif
+
+#if defined (GFX_LOCK_STATS)
+	gfx_lock_acquired_(mutex->stats, &mutex->start, 0, 0);
+#endif
+}
+
+/**
+ * Unblocks at least one of the threads waiting on the condition variable.
+ */
+static inline void gfx_cond_signal_(GFXCond_* cond)
+{
 #if defined (GFX_UNIX)
-	pthread_rwlock_unlock(lock);
+	pthread_cond_signal(cond);
 
 #elif defined (GFX_WIN32)
-	ReleaseSRWLockExclusive(lock);
+	WakeConditionVariable(cond);
 
 #endif
 }
 
+/**
+ * Unblocks all threads waiting on the condition variable.
+ */
+static inline void gfx_cond_broadcast_(GFXCond_* cond)
+{
+#if defined (GFX_UNIX)
+	pthread_cond_broadcast(cond);
+
+#elif defined (GFX_WIN32)
+	WakeAllConditionVariable(cond);
+
+#endif
+}
+
+
+/****************************
+ * Shared job scheduler.
+ ****************************/
+
+/**
+ * Runs a function over a range of indices on the shared job scheduler and
+ * waits for all of it, the calling thread helps out while waiting.
+ * groufix_.initialized may be 0, in which case everything runs serially.
+ * @param count   Number of indices, i.e. the range [0, count).
+ * @param numJobs Maximum number of jobs to split the range in, 0 for #CPUs.
+ * @param func    Called with disjoint contiguous sub-ranges [begin, end)
+ *                that together cover the range, cannot be NULL.
+ * @param arg     Passed as first argument to every call of func.
+ * @return Sum of all values returned by func.
+ *
+ * Jobs inherit the logging state of the calling thread.
+ * Can be called from within a job, nested jobs do not start any new threads.
+ * The shared scheduler is created on first use, with a worker per CPU.
+ * If it cannot be created or numJobs is 1, func is called once for the
+ * entire range on the calling thread.
+ */
+size_t gfx_jobs_parallel_(size_t count, unsigned int numJobs,
+                          size_t (*func)(void*, size_t, size_t), void* arg);
+
 
 #endif
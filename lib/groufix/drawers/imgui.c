@@ -8,8 +8,10 @@
 
 #include "groufix/drawers/imgui.h"
 #include "groufix/core/log.h"
+#include "groufix/core/mem.h"
 #include <float.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
@@ -39,11 +41,17 @@ static_assert(
 	} while (0)
 
 
+// Minimum number of vertices/indices (per frame) to allocate.
+#define GFX_IMGUI_MIN_VERTICES_ 1024
+#define GFX_IMGUI_MIN_INDICES_  2048
+
+
 // Clears the contents of a GFXDataElem_, freeing all memory.
 #define GFX_IMGUI_CLEAR_DATA_(elem) \
 	do { \
 		if (elem->data) gfx_unmap(gfx_ref_prim(elem->primitive)); \
 		gfx_free_prim(elem->primitive); \
+		free(elem->hashes); \
 	} while (0);
 
 
@@ -58,6 +66,7 @@ typedef struct GFXDataElem_
 	GFXPrimitive* primitive;
 	GFXRenderable renderable;
 	void*         data;
+	uint64_t*     hashes; // Hash of the data uploaded for each frame, 0 if none.
 
 } GFXDataElem_;
 
@@ -209,6 +218,16 @@ static int gfx_imgui_cmp_(const void* l, const void* r)
 	return *(const GFXImage**)l != *(const GFXImage**)r;
 }
 
+/****************************
+ * Accumulates the MurmurHash3 of some bytes into a 64 bits hash.
+ * @param h Hash to accumulate into.
+ */
+static uint64_t gfx_imgui_hash_bytes_(uint64_t h, size_t len, const void* bytes)
+{
+	const uint64_t k = gfx_hash_murmur3_bytes_(len, bytes);
+	return h ^ (k + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
 /****************************
  * Converts a GFXKey to a ImGuiKey.
  */
@@ -1072,6 +1091,9 @@ error:
  * Purges stale data and makes sure the first element of drawer->data
  * is sufficiently large to hold a given number of vertices and indices.
  * @return Zero on failure.
+ *
+ * The first element is persistently mapped and reused every frame,
+ * it is only replaced when it is too small, growing geometrically.
  */
 static bool gfx_imgui_update_data_(GFXImguiDrawer* drawer,
                                    unsigned int numFrames, unsigned int frame,
@@ -1112,6 +1134,11 @@ static bool gfx_imgui_update_data_(GFXImguiDrawer* drawer,
 			// as clearly this frame won't be using it :)
 			elem->frame = (frame + numFrames - 1) % numFrames;
 
+			// Grow geometrically, so a steadily growing UI
+			// does not reallocate every few frames.
+			vertices = GFX_MAX(vertices, numVertices * 2);
+			indices = GFX_MAX(indices, numIndices * 2);
+
 			goto build_new;
 		}
 
@@ -1124,9 +1151,19 @@ build_new:
 	if (!gfx_deque_push_front(&drawer->data, 1, NULL))
 		return 0;
 
+	vertices = GFX_MAX(vertices, GFX_IMGUI_MIN_VERTICES_);
+	indices = GFX_MAX(indices, GFX_IMGUI_MIN_INDICES_);
+
 	GFXDataElem_* elem = gfx_deque_at(&drawer->data, 0);
 	elem->frame = UINT_MAX; // Not yet purged.
 	elem->data = NULL;
+	elem->hashes = calloc(numFrames, sizeof(uint64_t));
+
+	if (elem->hashes == NULL)
+	{
+		gfx_deque_pop_front(&drawer->data, 1);
+		return 0;
+	}
 
 	// Allocate primitive.
 	elem->primitive = gfx_alloc_prim(drawer->heap,
@@ -1273,35 +1310,61 @@ GFX_API void gfx_cmd_draw_imgui(GFXRecorder* recorder,
 		vertexOffset = frame * (elem->primitive->numVertices / numFrames);
 		indexOffset = frame * (elem->primitive->numIndices / numFrames);
 
-		// Upload all the vertex/index data.
-		ImDrawVert* vertices = (ImDrawVert*)((char*)elem->data +
-			gfx_prim_get_vertices_offset(elem->primitive)) + vertexOffset;
-		ImDrawIdx* indices = (ImDrawIdx*)((char*)elem->data +
-			gfx_prim_get_indices_offset(elem->primitive)) + indexOffset;
+		// Hash all the vertex/index data, if it equals the data that was
+		// last uploaded for this frame, we can skip the upload.
+		// Reading ImGui's data is cheaper than writing to device memory.
+		uint64_t hash = 0;
 
 		for (int l = 0; l < drawData->CmdListsCount; ++l)
 		{
 			const ImDrawList* drawList = drawData->CmdLists.Data[l];
 
-			memcpy(vertices,
-				drawList->VtxBuffer.Data,
-				sizeof(ImDrawVert) * (size_t)drawList->VtxBuffer.Size);
+			hash = gfx_imgui_hash_bytes_(hash,
+				sizeof(ImDrawVert) * (size_t)drawList->VtxBuffer.Size,
+				drawList->VtxBuffer.Data);
+
+			hash = gfx_imgui_hash_bytes_(hash,
+				sizeof(ImDrawIdx) * (size_t)drawList->IdxBuffer.Size,
+				drawList->IdxBuffer.Data);
+		}
+
+		hash = (hash == 0) ? 1 : hash; // 0 means nothing uploaded.
 
-			memcpy(indices,
-				drawList->IdxBuffer.Data,
-				sizeof(ImDrawIdx) * (size_t)drawList->IdxBuffer.Size);
+		// Upload all the vertex/index data.
+		if (elem->hashes[frame] != hash)
+		{
+			ImDrawVert* vertices = (ImDrawVert*)((char*)elem->data +
+				gfx_prim_get_vertices_offset(elem->primitive)) + vertexOffset;
+			ImDrawIdx* indices = (ImDrawIdx*)((char*)elem->data +
+				gfx_prim_get_indices_offset(elem->primitive)) + indexOffset;
+
+			for (int l = 0; l < drawData->CmdListsCount; ++l)
+			{
+				const ImDrawList* drawList = drawData->CmdLists.Data[l];
+
+				memcpy(vertices,
+					drawList->VtxBuffer.Data,
+					sizeof(ImDrawVert) * (size_t)drawList->VtxBuffer.Size);
+
+				memcpy(indices,
+					drawList->IdxBuffer.Data,
+					sizeof(ImDrawIdx) * (size_t)drawList->IdxBuffer.Size);
+
+				vertices += drawList->VtxBuffer.Size;
+				indices += drawList->IdxBuffer.Size;
+			}
 
-			vertices += drawList->VtxBuffer.Size;
-			indices += drawList->IdxBuffer.Size;
+			elem->hashes[frame] = hash;
 		}
 	}
 
 	// Setup some basic recording state.
 	// Remember current viewport/scissor state so we can reset it afterwards.
-	// And keep track of the currently bound set to reduce bind calls.
+	// And keep track of the currently bound set & scissor to reduce calls.
 	GFXViewport oldViewport = gfx_recorder_get_viewport(recorder);
 	GFXScissor oldScissor = gfx_recorder_get_scissor(recorder);
 	GFXSet* currentSet = NULL;
+	ImVec4 currentClip = { 0.0f, 0.0f, -1.0f, -1.0f }; // Empty, never matches.
 
 	gfx_cmd_imgui_state_(recorder, drawer, igDrawData);
 
@@ -1314,6 +1377,7 @@ GFX_API void gfx_cmd_draw_imgui(GFXRecorder* recorder,
 			const ImDrawCmd* drawCmd = &drawList->CmdBuffer.Data[c];
 
 			// Handle user callbacks.
+			// They may record anything, so forget all known state.
 			if (drawCmd->UserCallback != NULL)
 			{
 				if (drawCmd->UserCallback == ImDrawCallback_ResetRenderState)
@@ -1321,6 +1385,9 @@ GFX_API void gfx_cmd_draw_imgui(GFXRecorder* recorder,
 				else
 					drawCmd->UserCallback(drawList, drawCmd);
 
+				currentSet = NULL;
+				currentClip = (ImVec4){ 0.0f, 0.0f, -1.0f, -1.0f };
+
 				continue;
 			}
 
@@ -1328,6 +1395,33 @@ GFX_API void gfx_cmd_draw_imgui(GFXRecorder* recorder,
 			if (elem == NULL)
 				continue;
 
+			// Merge all following commands with the same texture & clipping
+			// rectangle that continue the index range of this command.
+			// ImGui splits commands on e.g. channel or vertex offset changes,
+			// which leaves many of these for large UIs.
+			uint32_t elemCount = (uint32_t)drawCmd->ElemCount;
+
+			while (c + 1 < drawList->CmdBuffer.Size)
+			{
+				const ImDrawCmd* next = &drawList->CmdBuffer.Data[c + 1];
+
+				if (
+					next->UserCallback != NULL ||
+					next->TextureId != drawCmd->TextureId ||
+					next->VtxOffset != drawCmd->VtxOffset ||
+					next->IdxOffset != drawCmd->IdxOffset + elemCount ||
+					next->ClipRect.x != drawCmd->ClipRect.x ||
+					next->ClipRect.y != drawCmd->ClipRect.y ||
+					next->ClipRect.z != drawCmd->ClipRect.z ||
+					next->ClipRect.w != drawCmd->ClipRect.w)
+				{
+					break;
+				}
+
+				elemCount += (uint32_t)next->ElemCount;
+				++c;
+			}
+
 			// Convert clipping rectangle to scissor state.
 			float clipMinX = drawCmd->ClipRect.x - drawData->DisplayPos.x;
 			float clipMinY = drawCmd->ClipRect.y - drawData->DisplayPos.y;
@@ -1342,17 +1436,24 @@ GFX_API void gfx_cmd_draw_imgui(GFXRecorder* recorder,
 			if (clipMaxX <= clipMinX || clipMaxY <= clipMinY)
 				continue;
 
-			GFXScissor scissor = {
-				.size = GFX_SIZE_RELATIVE,
-				.xOffset = clipMinX / drawData->DisplaySize.x,
-				.yOffset = clipMinY / drawData->DisplaySize.y,
-				.xScale = (clipMaxX - clipMinX) / drawData->DisplaySize.x,
-				.yScale = (clipMaxY - clipMinY) / drawData->DisplaySize.y
-			};
-
-			gfx_cmd_set_scissor(recorder, scissor);
+			// Only set the scissor if it changed.
+			if (
+				clipMinX != currentClip.x || clipMinY != currentClip.y ||
+				clipMaxX != currentClip.z || clipMaxY != currentClip.w)
+			{
+				GFXScissor scissor = {
+					.size = GFX_SIZE_RELATIVE,
+					.xOffset = clipMinX / drawData->DisplaySize.x,
+					.yOffset = clipMinY / drawData->DisplaySize.y,
+					.xScale = (clipMaxX - clipMinX) / drawData->DisplaySize.x,
+					.yScale = (clipMaxY - clipMinY) / drawData->DisplaySize.y
+				};
+
+				gfx_cmd_set_scissor(recorder, scissor);
+				currentClip = (ImVec4){ clipMinX, clipMinY, clipMaxX, clipMaxY };
+			}
 
-			// Bind the set given as texture ID.
+			// Bind the set given as texture ID, only if it changed.
 			GFXSet* set = drawCmd->TextureId;
 			if (currentSet != set)
 			{
@@ -1360,9 +1461,9 @@ GFX_API void gfx_cmd_draw_imgui(GFXRecorder* recorder,
 				currentSet = set;
 			}
 
-			// Record the draw command.
+			// Record the (merged) draw command.
 			gfx_cmd_draw_indexed(recorder, &elem->renderable,
-				(uint32_t)drawCmd->ElemCount, 1,
+				elemCount, 1,
 				(uint32_t)drawCmd->IdxOffset + indexOffset,
 				(int32_t)((uint32_t)drawCmd->VtxOffset + vertexOffset), 0);
 		}
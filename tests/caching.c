@@ -0,0 +1,205 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include <groufix/assets/gltf.h>
+#include <stdio.h>
+
+#define TEST_SKIP_CREATE_WINDOW
+#include "test.h"
+
+
+/****************************
+ * Helper to get the elapsed time in milliseconds.
+ */
+static double elapsed_ms(int64_t start)
+{
+	return (double)(gfx_time() - start) * 1000.0 / (double)gfx_time_frequency();
+}
+
+
+/****************************
+ * Helper to load some glTF, readable so it can be cached.
+ */
+static bool load_gltf(const char* path, GFXGltfResult* result)
+{
+	GFXFile file;
+	if (!gfx_file_init(&file, path, "rb"))
+		return 0;
+
+	GFXFileIncluder inc;
+	if (!gfx_file_includer_init(&inc, path, "rb"))
+	{
+		gfx_file_clear(&file);
+		return 0;
+	}
+
+	const float lodErrors[] = { 0.005f, 0.02f, 0.08f };
+
+	const GFXGltfOptions opts = {
+		.parallel = 1,
+		.optimize = 1,
+		.overdraw = 1.05f,
+		.quantize = GFX_GLTF_QUANTIZE_TEXCOORDS,
+		.meshlets = 1,
+		.numLods = sizeof(lodErrors) / sizeof(*lodErrors),
+		.lodErrors = lodErrors
+	};
+
+	const bool success = gfx_load_gltf(
+		TEST_BASE.heap, TEST_BASE.sem, &opts,
+		GFX_IMAGE_ANY_FORMAT | GFX_IMAGE_READABLE, GFX_IMAGE_SAMPLED,
+		&file.reader, &inc.includer, result);
+
+	gfx_file_includer_clear(&inc);
+	gfx_file_clear(&file);
+
+	return success;
+}
+
+
+/****************************
+ * Helper to store a glTF cache.
+ */
+static bool store_cache(const char* path, const GFXGltfResult* result)
+{
+	GFXFile file;
+	if (!gfx_file_init(&file, path, "wb"))
+		return 0;
+
+	const bool success = gfx_store_gltf_cache(result, &file.writer);
+	gfx_file_clear(&file);
+
+	return success;
+}
+
+
+/****************************
+ * Helper to load a glTF cache.
+ */
+static bool load_cache(const char* path, GFXGltfResult* result)
+{
+	GFXFile file;
+	if (!gfx_file_init(&file, path, "rb"))
+		return 0;
+
+	const bool success = gfx_load_gltf_cache(
+		TEST_BASE.heap, TEST_BASE.sem,
+		0, GFX_IMAGE_SAMPLED, &file.reader, result);
+
+	gfx_file_clear(&file);
+
+	return success;
+}
+
+
+/****************************
+ * Helper to free all GPU resources of a glTF result.
+ */
+static void free_gltf(GFXGltfResult* result)
+{
+	for (size_t p = 0; p < result->numPrimitives; ++p)
+		gfx_free_prim(result->primitives[p].primitive);
+
+	for (size_t i = 0; i < result->numImages; ++i)
+		gfx_free_image(result->images[i]);
+
+	gfx_free_buffer(result->buffer);
+	gfx_free_buffer(result->meshlets);
+	gfx_release_gltf(result);
+}
+
+
+/****************************
+ * glTF binary cache round-trip benchmark.
+ */
+TEST_DESCRIBE(caching, t)
+{
+	bool success = 0;
+
+	const char* path = "tests/assets/DamagedHelmet.gltf";
+	const char* cachePath = "DamagedHelmet.gfxcache";
+
+	GFXGltfResult gltf;
+	GFXGltfResult cache;
+	bool loaded[2] = { 0, 0 };
+
+	// Time loading from source, storing & loading the cache.
+	int64_t start = gfx_time();
+	loaded[0] = load_gltf(path, &gltf);
+	const double source = elapsed_ms(start);
+
+	if (!loaded[0]) goto clean;
+
+	start = gfx_time();
+	const bool stored = store_cache(cachePath, &gltf);
+	const double storing = elapsed_ms(start);
+
+	if (!stored) goto clean;
+
+	start = gfx_time();
+	loaded[1] = load_cache(cachePath, &cache);
+	const double cached = elapsed_ms(start);
+
+	if (!loaded[1]) goto clean;
+
+	// Check the round-trip.
+	if (
+		gltf.numImages != cache.numImages ||
+		gltf.numMaterials != cache.numMaterials ||
+		gltf.numPrimitives != cache.numPrimitives ||
+		gltf.numNodes != cache.numNodes ||
+		gltf.numScenes != cache.numScenes)
+	{
+		goto clean;
+	}
+
+	for (size_t p = 0; p < gltf.numPrimitives; ++p)
+	{
+		const GFXPrimitive* l = gltf.primitives[p].primitive;
+		const GFXPrimitive* r = cache.primitives[p].primitive;
+
+		if (
+			l->numVertices != r->numVertices ||
+			l->numIndices != r->numIndices ||
+			gltf.primitives[p].numMeshlets != cache.primitives[p].numMeshlets ||
+			gltf.primitives[p].numLods != cache.primitives[p].numLods ||
+			gltf.primitives[p].numAttributes != cache.primitives[p].numAttributes)
+		{
+			goto clean;
+		}
+	}
+
+	gfx_log_info("\n"
+		"Loaded '%s':\n"
+		"    From source:   %.2f ms.\n"
+		"    Storing cache: %.2f ms.\n"
+		"    From cache:    %.2f ms (%.2fx).\n",
+		path, source, storing, cached, source / cached);
+
+	success = 1;
+
+
+	// Cleanup.
+clean:
+	// Wait for all uploads before freeing the resources.
+	if (gfx_heap_flush(t->heap))
+		gfx_heap_block(t->heap);
+
+	if (loaded[0]) free_gltf(&gltf);
+	if (loaded[1]) free_gltf(&cache);
+
+	remove(cachePath);
+
+	if (!success) TEST_FAIL();
+}
+
+
+/****************************
+ * Run the glTF cache benchmark.
+ */
+TEST_MAIN(caching);
@@ -0,0 +1,204 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include <string.h>
+
+#define TEST_SKIP_CREATE_WINDOW
+#include "test.h"
+
+
+// Number of variants to compile of each source.
+#define NUM_VARIANTS 64
+
+
+/****************************
+ * Helper to read a file into a NULL-terminated string.
+ */
+static char* read_file(const char* path)
+{
+	GFXFile file;
+	if (!gfx_file_init(&file, path, "rb"))
+		goto error;
+
+	const long long len = gfx_io_len(&file.reader);
+	char* str = len > 0 ? malloc((size_t)len + 1) : NULL;
+
+	if (str == NULL || gfx_io_read(&file.reader, str, (size_t)len) != len)
+	{
+		free(str);
+		gfx_file_clear(&file);
+		goto error;
+	}
+
+	str[len] = '\0';
+	gfx_file_clear(&file);
+
+	return str;
+
+
+	// Failure.
+error:
+	gfx_log_error("Failed to read '%s'", path);
+	return NULL;
+}
+
+
+/****************************
+ * Helper to create a distinct variant of a source,
+ * inserts a #define right after the #version directive.
+ */
+static char* make_variant(const char* src, unsigned int variant)
+{
+	const char* body = strchr(src, '\n');
+	body = (body == NULL) ? src + strlen(src) : body + 1;
+
+	const size_t head = (size_t)(body - src);
+	const size_t len = head + strlen(body) + 32;
+
+	char* str = malloc(len);
+	if (str == NULL) return NULL;
+
+	memcpy(str, src, head);
+	snprintf(str + head, len - head, "#define VARIANT %u\n%s", variant, body);
+
+	return str;
+}
+
+
+/****************************
+ * Helper to get the elapsed time in milliseconds.
+ */
+static double elapsed_ms(int64_t start)
+{
+	return (double)(gfx_time() - start) * 1000.0 / (double)gfx_time_frequency();
+}
+
+
+/****************************
+ * Batch shader compilation benchmark.
+ */
+TEST_DESCRIBE(compiling, t)
+{
+	bool success = 0;
+
+	// Read the default test shaders.
+	const GFXShaderStage stages[] = { GFX_STAGE_VERTEX, GFX_STAGE_FRAGMENT };
+	char* srcs[] = {
+		read_file("tests/shaders/basic.vert"),
+		read_file("tests/shaders/basic.frag")
+	};
+
+	// Make variants & allocate three sets of shaders.
+	enum { numShaders = 2 * NUM_VARIANTS };
+
+	char* variants[numShaders] = { NULL };
+	GFXStringReader strs[numShaders];
+	GFXShader* shaders[3][numShaders] = {{ NULL }};
+	GFXShaderSource sources[numShaders];
+
+	GFXShaderCache* cache = gfx_create_shader_cache(0);
+	if (cache == NULL || srcs[0] == NULL || srcs[1] == NULL)
+		goto clean;
+
+	for (size_t s = 0; s < numShaders; ++s)
+	{
+		variants[s] = make_variant(srcs[s % 2], (unsigned int)(s / 2));
+		if (variants[s] == NULL) goto clean;
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			shaders[i][s] = gfx_create_shader(stages[s % 2], t->device);
+			if (shaders[i][s] == NULL) goto clean;
+		}
+	}
+
+	// Compile all shaders one by one.
+	int64_t start = gfx_time();
+
+	for (size_t s = 0; s < numShaders; ++s)
+		if (!gfx_shader_compile(shaders[0][s], GFX_GLSL, 1,
+			gfx_string_reader(&strs[s], variants[s]), NULL, NULL, NULL))
+		{
+			goto clean;
+		}
+
+	const double serial = elapsed_ms(start);
+
+	// Compile all shaders in a batch, filling the cache.
+	for (size_t s = 0; s < numShaders; ++s)
+		sources[s] = (GFXShaderSource){
+			.shader = shaders[1][s],
+			.language = GFX_GLSL,
+			.optimize = 1,
+			.src = gfx_string_reader(&strs[s], variants[s]),
+			.out = NULL,
+			.err = NULL
+		};
+
+	start = gfx_time();
+
+	if (gfx_shader_compile_batch(numShaders, sources, cache, NULL, 0) != numShaders)
+		goto clean;
+
+	const double batch = elapsed_ms(start);
+
+	// And again, now all from the cache.
+	for (size_t s = 0; s < numShaders; ++s)
+	{
+		sources[s].shader = shaders[2][s];
+		sources[s].src = gfx_string_reader(&strs[s], variants[s]);
+	}
+
+	start = gfx_time();
+
+	if (gfx_shader_compile_batch(numShaders, sources, cache, NULL, 0) != numShaders)
+		goto clean;
+
+	const double cached = elapsed_ms(start);
+
+	// Report.
+	GFXShaderCacheStats stats = gfx_shader_cache_get_stats(cache);
+
+	gfx_log_info("\n"
+		"Compiled %d shaders:\n"
+		"    Serial: %.2f ms.\n"
+		"    Batch:  %.2f ms (%.2fx).\n"
+		"    Cached: %.2f ms (%.2fx).\n"
+		"    Cache:  %"GFX_PRIs" entries, %"GFX_PRIs" bytes, "
+		"%"PRIu64" hits, %"PRIu64" misses.\n",
+		numShaders,
+		serial,
+		batch, serial / batch,
+		cached, serial / cached,
+		stats.entries, stats.size, stats.hits, stats.misses);
+
+	success = stats.hits == numShaders;
+
+
+	// Cleanup.
+clean:
+	for (size_t s = 0; s < numShaders; ++s)
+	{
+		for (size_t i = 0; i < 3; ++i)
+			gfx_destroy_shader(shaders[i][s]);
+
+		free(variants[s]);
+	}
+
+	gfx_destroy_shader_cache(cache);
+	free(srcs[0]);
+	free(srcs[1]);
+
+	if (!success) TEST_FAIL();
+}
+
+
+/****************************
+ * Run the batch compilation benchmark.
+ */
+TEST_MAIN(compiling);
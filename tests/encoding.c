@@ -0,0 +1,183 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include <groufix/assets/image.h>
+#include <math.h>
+
+#define TEST_SKIP_CREATE_WINDOW
+#include "test.h"
+
+
+// Size of the generated sample texture.
+#define SAMPLE_SIZE 1024
+
+
+/****************************
+ * Helper to generate a sample RGBA texture, consisting of
+ * smooth gradients, hard edges and some noise.
+ */
+static unsigned char* make_sample(void)
+{
+	unsigned char* img = malloc(SAMPLE_SIZE * SAMPLE_SIZE * 4);
+	if (img == NULL) return NULL;
+
+	uint32_t seed = 1;
+
+	for (uint32_t y = 0; y < SAMPLE_SIZE; ++y)
+		for (uint32_t x = 0; x < SAMPLE_SIZE; ++x)
+		{
+			unsigned char* p = img + (y * SAMPLE_SIZE + x) * 4;
+			seed = seed * 1664525 + 1013904223;
+
+			const int noise = (int)(seed >> 28) - 8;
+			const bool edge = ((x / 64) + (y / 64)) & 1;
+			const int v[4] = {
+				(int)(x * 255 / SAMPLE_SIZE) + noise,
+				(int)(y * 255 / SAMPLE_SIZE) + noise,
+				edge ? 220 : 40,
+				edge ? 255 : (int)((x + y) * 255 / (2 * SAMPLE_SIZE))
+			};
+
+			for (int c = 0; c < 4; ++c)
+				p[c] = (unsigned char)GFX_CLAMP(v[c], 0, 255);
+		}
+
+	return img;
+}
+
+
+/****************************
+ * Helper to get the elapsed time in milliseconds.
+ */
+static double elapsed_ms(int64_t start)
+{
+	return (double)(gfx_time() - start) * 1000.0 / (double)gfx_time_frequency();
+}
+
+
+/****************************
+ * Helper to time loading an image with specific flags.
+ */
+static double time_load(const char* path, GFXImageFlags flags, GFXImage** image)
+{
+	GFXFile file;
+	if (!gfx_file_init(&file, path, "rb"))
+		return -1.0;
+
+	const int64_t start = gfx_time();
+
+	*image = gfx_load_image(
+		TEST_BASE.heap, TEST_BASE.sem,
+		flags, GFX_IMAGE_SAMPLED, &file.reader);
+
+	const double ms = elapsed_ms(start);
+	gfx_file_clear(&file);
+
+	return (*image != NULL) ? ms : -1.0;
+}
+
+
+/****************************
+ * BCn encoding quality/speed benchmark.
+ */
+TEST_DESCRIBE(encoding, t)
+{
+	bool success = 0;
+	GFXImage* images[3] = { NULL, NULL, NULL };
+
+	// Generate a sample & output buffer.
+	unsigned char* img = make_sample();
+	unsigned char* blocks = malloc((SAMPLE_SIZE / 4) * (SAMPLE_SIZE / 4) * 16);
+
+	if (img == NULL || blocks == NULL)
+		goto clean;
+
+	// Encode to all formats, single & multi-threaded.
+	const struct { const char* name; GFXFormat fmt; } formats[] = {
+		{ "BC1", GFX_FORMAT_BC1_RGB_UNORM },
+		{ "BC3", GFX_FORMAT_BC3_UNORM },
+		{ "BC4", GFX_FORMAT_BC4_UNORM },
+		{ "BC5", GFX_FORMAT_BC5_UNORM },
+		{ "BC7", GFX_FORMAT_BC7_UNORM }
+	};
+
+	gfx_log_info("\nEncoded %dx%d sample:", SAMPLE_SIZE, SAMPLE_SIZE);
+
+	for (size_t f = 0; f < sizeof(formats)/sizeof(formats[0]); ++f)
+	{
+		double mse;
+		int64_t start = gfx_time();
+
+		if (!gfx_encode_bcn(formats[f].fmt,
+			SAMPLE_SIZE, SAMPLE_SIZE, 4, img, blocks, 1, &mse))
+		{
+			goto clean;
+		}
+
+		const double serial = elapsed_ms(start);
+		start = gfx_time();
+
+		if (!gfx_encode_bcn(formats[f].fmt,
+			SAMPLE_SIZE, SAMPLE_SIZE, 4, img, blocks, 0, NULL))
+		{
+			goto clean;
+		}
+
+		const double threaded = elapsed_ms(start);
+		const double psnr = 10.0 * log10(255.0 * 255.0 / GFX_MAX(mse, 1e-6));
+
+		gfx_log_info("\n"
+			"    %s: %.2f ms serial, %.2f ms threaded (%.2fx), "
+			"PSNR %.2f dB.",
+			formats[f].name,
+			serial, threaded, serial / threaded,
+			psnr);
+
+		// Anything below this is clearly broken.
+		if (psnr < 25.0) goto clean;
+	}
+
+	// Time loading a real image, compressed & uncompressed.
+	const char* path = "tests/assets/Default_albedo.jpg";
+	const double plain = time_load(path, GFX_IMAGE_ANY_FORMAT, images + 0);
+	const double bcn = time_load(path, GFX_IMAGE_COMPRESS, images + 1);
+	const double bcnHQ = time_load(path, GFX_IMAGE_COMPRESS_HQ, images + 2);
+
+	if (plain < 0.0 || bcn < 0.0 || bcnHQ < 0.0)
+		goto clean;
+
+	gfx_log_info("\n"
+		"Loaded '%s':\n"
+		"    Uncompressed: %.2f ms.\n"
+		"    BCn:          %.2f ms.\n"
+		"    BCn (HQ):     %.2f ms.\n",
+		path, plain, bcn, bcnHQ);
+
+	success = 1;
+
+
+	// Cleanup.
+clean:
+	// Wait for all uploads before freeing the images.
+	if (gfx_heap_flush(t->heap))
+		gfx_heap_block(t->heap);
+
+	for (size_t i = 0; i < 3; ++i)
+		gfx_free_image(images[i]);
+
+	free(img);
+	free(blocks);
+
+	if (!success) TEST_FAIL();
+}
+
+
+/****************************
+ * Run the BCn encoding benchmark.
+ */
+TEST_MAIN(encoding);
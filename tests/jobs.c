@@ -0,0 +1,155 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include <stdlib.h>
+
+#define TEST_SKIP_CREATE_WINDOW
+#include "test.h"
+
+
+#define JOBS_DEPTH      12
+#define JOBS_LEAVES     (1 << JOBS_DEPTH)
+#define JOBS_LEAF_WORK  20000
+
+
+/****************************
+ * Recursive fork/join workload.
+ */
+typedef struct Task
+{
+	GFXJobs*  jobs;
+	uint32_t* out;
+	size_t    first;
+	size_t    count;
+
+} Task;
+
+
+/****************************
+ * Helper to get the elapsed time in milliseconds.
+ */
+static double elapsed_ms(int64_t start)
+{
+	return (double)(gfx_time() - start) * 1000.0 / (double)gfx_time_frequency();
+}
+
+
+/****************************
+ * Job that splits its range in two halves until a single leaf remains,
+ * at which point it does some CPU-bound work.
+ */
+static void task(void* arg)
+{
+	Task* t = arg;
+
+	if (t->count == 1)
+	{
+		uint32_t x = (uint32_t)t->first + 1;
+		for (int i = 0; i < JOBS_LEAF_WORK; ++i)
+			x = x * 1664525u + 1013904223u;
+
+		t->out[t->first] = x;
+		return;
+	}
+
+	const size_t half = t->count >> 1;
+	Task sub[2] = {
+		{ .jobs = t->jobs, .out = t->out, .first = t->first, .count = half },
+		{ .jobs = t->jobs, .out = t->out, .first = t->first + half, .count = t->count - half }
+	};
+
+	GFXJobCounter counter = {0};
+	gfx_jobs_fork(t->jobs, &counter, 2, task, sub, sizeof(Task));
+	gfx_jobs_join(t->jobs, &counter);
+}
+
+
+/****************************
+ * Helper to run the workload on a number of workers.
+ * @return Elapsed time in milliseconds, negative on failure.
+ */
+static double run(unsigned int numWorkers, uint32_t* out, uint32_t* sum)
+{
+	GFXJobs* jobs = gfx_create_jobs(numWorkers);
+	if (jobs == NULL) return -1.0;
+
+	Task root = { .jobs = jobs, .out = out, .first = 0, .count = JOBS_LEAVES };
+	GFXJobCounter counter = {0};
+
+	const int64_t start = gfx_time();
+	gfx_jobs_fork(jobs, &counter, 1, task, &root, 0);
+	gfx_jobs_join(jobs, &counter);
+	const double time = elapsed_ms(start);
+
+	gfx_destroy_jobs(jobs);
+
+	*sum = 0;
+	for (size_t l = 0; l < JOBS_LEAVES; ++l)
+		*sum ^= out[l];
+
+	return time;
+}
+
+
+/****************************
+ * Job scheduler scalability benchmark.
+ */
+TEST_DESCRIBE(jobs, t)
+{
+	uint32_t* out = malloc(sizeof(uint32_t) * JOBS_LEAVES);
+	if (out == NULL) TEST_FAIL();
+
+	// Get the number of logical cores.
+	GFXJobs* jobs = gfx_create_jobs(0);
+	if (jobs == NULL)
+	{
+		free(out);
+		TEST_FAIL();
+	}
+
+	const unsigned int maxWorkers = gfx_jobs_get_num_workers(jobs);
+	gfx_destroy_jobs(jobs);
+
+	// Run with 1, 2, 4, ... workers, always including the maximum.
+	uint32_t baseSum;
+	const double base = run(1, out, &baseSum);
+	if (base < 0.0)
+	{
+		free(out);
+		TEST_FAIL();
+	}
+
+	gfx_log_info("Job scheduler with 1 worker(s): %.2f ms.", base);
+
+	for (unsigned int w = 2; w <= maxWorkers; w <<= 1)
+	{
+		// Make sure the last run uses all workers.
+		if (w << 1 > maxWorkers) w = maxWorkers;
+
+		uint32_t sum;
+		const double time = run(w, out, &sum);
+
+		if (time < 0.0 || sum != baseSum)
+		{
+			free(out);
+			TEST_FAIL();
+		}
+
+		gfx_log_info(
+			"Job scheduler with %u worker(s): %.2f ms (%.2fx).",
+			w, time, base / time);
+	}
+
+	free(out);
+}
+
+
+/****************************
+ * Run the job scheduler benchmark.
+ */
+TEST_MAIN(jobs);
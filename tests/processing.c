@@ -0,0 +1,406 @@
+/**
+ * This file is part of groufix.
+ * Copyright (c) Stef Velzel. All rights reserved.
+ *
+ * groufix : graphics engine produced by Stef Velzel.
+ * www     : <www.vuzzel.nl>
+ */
+
+#include <groufix/assets/gltf.h>
+#include <groufix/assets/mesh.h>
+#include <math.h>
+#include <string.h>
+
+#define TEST_SKIP_CREATE_WINDOW
+#include "test.h"
+
+
+// Size of the generated grid, in quads per side.
+#define GRID_SIZE 64
+
+
+/****************************
+ * Helper to get the elapsed time in milliseconds.
+ */
+static double elapsed_ms(int64_t start)
+{
+	return (double)(gfx_time() - start) * 1000.0 / (double)gfx_time_frequency();
+}
+
+
+/****************************
+ * Helper to check that cache optimization improves the ACMR of a grid
+ * whose triangles are shuffled (i.e. with little vertex reuse).
+ */
+static bool check_acmr(void)
+{
+	const uint32_t width = GRID_SIZE + 1;
+	const size_t numVertices = (size_t)width * width;
+	const size_t numIndices = (size_t)GRID_SIZE * GRID_SIZE * 6;
+
+	uint32_t* indices = malloc(sizeof(uint32_t) * numIndices * 2);
+	if (indices == NULL) return 0;
+
+	uint32_t* optimized = indices + numIndices;
+
+	// Generate two triangles per quad.
+	for (uint32_t y = 0, i = 0; y < GRID_SIZE; ++y)
+		for (uint32_t x = 0; x < GRID_SIZE; ++x, i += 6)
+		{
+			const uint32_t v = y * width + x;
+			const uint32_t quad[6] = {
+				v, v + 1, v + width,
+				v + 1, v + width + 1, v + width
+			};
+
+			memcpy(indices + i, quad, sizeof(quad));
+		}
+
+	// Shuffle the triangles.
+	uint32_t seed = 1;
+
+	for (size_t t = numIndices / 3 - 1; t > 0; --t)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const size_t s = seed % (t + 1);
+
+		uint32_t tri[3];
+		memcpy(tri, indices + t * 3, sizeof(tri));
+		memcpy(indices + t * 3, indices + s * 3, sizeof(tri));
+		memcpy(indices + s * 3, tri, sizeof(tri));
+	}
+
+	// Optimize & compare.
+	const float before = gfx_mesh_acmr(
+		numIndices, indices, numVertices, GFX_MESH_CACHE_SIZE);
+
+	const bool success = gfx_mesh_optimize_cache(
+		numIndices, indices, optimized, numVertices, GFX_MESH_CACHE_SIZE);
+
+	const float after = !success ? before : gfx_mesh_acmr(
+		numIndices, optimized, numVertices, GFX_MESH_CACHE_SIZE);
+
+	gfx_log_info(
+		"Optimized shuffled %dx%d grid: ACMR %.3f -> %.3f.",
+		GRID_SIZE, GRID_SIZE, (double)before, (double)after);
+
+	free(indices);
+
+	return success && after < before;
+}
+
+
+/****************************
+ * Helper to check whether a format is supported as vertex attribute,
+ * returns the fallback format otherwise.
+ */
+static GFXFormat expect_format(GFXFormat fmt, GFXFormat fallback)
+{
+	return
+		(gfx_format_support(fmt, TEST_BASE.device) & GFX_FORMAT_VERTEX_BUFFER) ?
+		fmt : fallback;
+}
+
+
+/****************************
+ * Helper to read back an entire buffer.
+ * @return NULL on failure, must call free().
+ */
+static unsigned char* read_buffer(GFXBuffer* buffer)
+{
+	if (buffer == NULL) return NULL;
+
+	unsigned char* bin = malloc((size_t)buffer->size);
+	if (bin == NULL) return NULL;
+
+	const GFXRegion region = {
+		.offset = 0,
+		.size = buffer->size
+	};
+
+	if (!gfx_read(gfx_ref_buffer(buffer), bin,
+		GFX_TRANSFER_NONE, 1, 0, &region, &region, NULL))
+	{
+		free(bin);
+		return NULL;
+	}
+
+	return bin;
+}
+
+
+/****************************
+ * Helper to check the formats & positions of a quantized (not optimized)
+ * glTF result against the same glTF loaded with default options.
+ * Assumes attributes are ordered as POSITION, TEXCOORD.
+ */
+static bool check_quantized(const GFXGltfResult* base,
+                            const GFXGltfResult* quant)
+{
+	// Wait for all uploads before reading back.
+	if (!gfx_heap_flush(TEST_BASE.heap))
+		return 0;
+
+	gfx_heap_block(TEST_BASE.heap);
+
+	unsigned char* bin1 = read_buffer(base->buffer);
+	unsigned char* bin2 = read_buffer(quant->buffer);
+	bool success = bin1 != NULL && bin2 != NULL;
+
+	for (size_t p = 0; success && p < quant->numPrimitives; ++p)
+	{
+		const GFXGltfPrimitive* prim1 = base->primitives + p;
+		const GFXGltfPrimitive* prim2 = quant->primitives + p;
+		const size_t numVertices = prim1->primitive->numVertices;
+
+		if (
+			prim1->numAttributes != prim2->numAttributes ||
+			numVertices != prim2->primitive->numVertices)
+		{
+			success = 0;
+			break;
+		}
+
+		// Only float positions & texcoords are quantized.
+		const GFXAttribute* pos1 = prim1->attributes + 0;
+		const GFXAttribute* pos2 = prim2->attributes + 0;
+
+		if (
+			prim1->numAttributes < 1 ||
+			!GFX_FORMAT_IS_EQUAL(pos1->format, GFX_FORMAT_R32G32B32_SFLOAT))
+		{
+			continue;
+		}
+
+		const unsigned char* src1 = bin1 + pos1->buffer.offset + pos1->offset;
+		const unsigned char* src2 = bin2 + pos2->buffer.offset + pos2->offset;
+
+		// Positions must be RGBA UNORM16.
+		const GFXFormat posFmt = expect_format(
+			GFX_FORMAT_R16G16B16A16_UNORM, GFX_FORMAT_R32G32B32_SFLOAT);
+		const bool posQuant =
+			GFX_FORMAT_IS_EQUAL(posFmt, GFX_FORMAT_R16G16B16A16_UNORM);
+
+		if (!GFX_FORMAT_IS_EQUAL(pos2->format, posFmt))
+		{
+			gfx_log_error("Quantized positions are not RGBA UNORM16.");
+			success = 0;
+			break;
+		}
+
+		// Decoded positions must be within the quantization error.
+		const float error = posQuant ? prim2->posScale / 65535.0f : 0.0f;
+
+		for (size_t v = 0; success && v < numVertices; ++v)
+		{
+			float p1[3], p2[3];
+			memcpy(p1, src1 + v * pos1->stride, sizeof(p1));
+
+			if (posQuant)
+			{
+				uint16_t q[3];
+				memcpy(q, src2 + v * pos2->stride, sizeof(q));
+
+				for (size_t c = 0; c < 3; ++c)
+					p2[c] = (float)q[c] / 65535.0f * prim2->posScale +
+						prim2->posOffset[c];
+			}
+			else
+				memcpy(p2, src2 + v * pos2->stride, sizeof(p2));
+
+			for (size_t c = 0; c < 3; ++c)
+				if (!(fabsf(p1[c] - p2[c]) <= error))
+				{
+					gfx_log_error(
+						"Decoded position %"GFX_PRIs" is off by %f.",
+						v, (double)fabsf(p1[c] - p2[c]));
+
+					success = 0;
+					break;
+				}
+		}
+
+		// Texcoords must be RG UNORM16 if within [0,1], RG half otherwise.
+		if (
+			!success || prim1->numAttributes < 2 ||
+			!GFX_FORMAT_IS_EQUAL(
+				prim1->attributes[1].format, GFX_FORMAT_R32G32_SFLOAT))
+		{
+			continue;
+		}
+
+		const GFXAttribute* uv1 = prim1->attributes + 1;
+		src1 = bin1 + uv1->buffer.offset + uv1->offset;
+
+		bool unorm = 1;
+		for (size_t v = 0; unorm && v < numVertices; ++v)
+		{
+			float uv[2];
+			memcpy(uv, src1 + v * uv1->stride, sizeof(uv));
+
+			unorm =
+				uv[0] >= 0.0f && uv[0] <= 1.0f &&
+				uv[1] >= 0.0f && uv[1] <= 1.0f;
+		}
+
+		const GFXFormat uvFmt = expect_format(
+			unorm ? GFX_FORMAT_R16G16_UNORM : GFX_FORMAT_R16G16_SFLOAT,
+			GFX_FORMAT_R32G32_SFLOAT);
+
+		if (!GFX_FORMAT_IS_EQUAL(prim2->attributes[1].format, uvFmt))
+		{
+			gfx_log_error("Quantized texcoords are not RG %s.",
+				unorm ? "UNORM16" : "half");
+
+			success = 0;
+		}
+	}
+
+	free(bin1);
+	free(bin2);
+
+	return success;
+}
+
+
+/****************************
+ * Helper to load some glTF with the given options.
+ * Loads as readable, so the packed buffer can be read back.
+ */
+static bool load_gltf(const char* path, const GFXGltfOptions* opts,
+                      GFXGltfResult* result)
+{
+	// Open file.
+	GFXFile file;
+	if (!gfx_file_init(&file, path, "rb"))
+		goto error;
+
+	// Init includer.
+	GFXFileIncluder inc;
+	if (!gfx_file_includer_init(&inc, path, "rb"))
+		goto clean_file;
+
+	// Load glTF.
+	if (!gfx_load_gltf(
+		TEST_BASE.heap, TEST_BASE.sem, opts,
+		GFX_IMAGE_READABLE, GFX_IMAGE_SAMPLED,
+		&file.reader, &inc.includer, result))
+	{
+		goto clean_includer;
+	}
+
+	gfx_file_includer_clear(&inc);
+	gfx_file_clear(&file);
+
+	return 1;
+
+
+	// Cleanup on failure.
+clean_includer:
+	gfx_file_includer_clear(&inc);
+clean_file:
+	gfx_file_clear(&file);
+error:
+	gfx_log_error("Failed to load '%s'", path);
+	return 0;
+}
+
+
+/****************************
+ * glTF processing test, loads the same glTF serially with default options,
+ * in parallel with optimization, overdraw reordering and quantization, and
+ * with quantization only to check the quantized data.
+ */
+TEST_DESCRIBE(processing, t)
+{
+	const char* path = "tests/assets/DamagedHelmet.gltf";
+	const char* attributeOrder[] = {
+		"POSITION",
+		"TEXCOORD"
+	};
+
+	const GFXGltfOptions base = {
+		.maxAttributes = 2,
+		.orderSize = sizeof(attributeOrder)/sizeof(char*),
+		.attributeOrder = attributeOrder
+	};
+
+	const GFXGltfOptions processed = {
+		.maxAttributes = 2,
+		.orderSize = sizeof(attributeOrder)/sizeof(char*),
+		.attributeOrder = attributeOrder,
+		.parallel = 1,
+		.optimize = 1,
+		.overdraw = 1.05f,
+		.quantize = GFX_GLTF_QUANTIZE_TEXCOORDS
+	};
+
+	const GFXGltfOptions quantized = {
+		.maxAttributes = 2,
+		.orderSize = sizeof(attributeOrder)/sizeof(char*),
+		.attributeOrder = attributeOrder,
+		.quantize = GFX_GLTF_QUANTIZE_POSITIONS | GFX_GLTF_QUANTIZE_TEXCOORDS
+	};
+
+	// Cache optimization must actually improve things.
+	if (!check_acmr())
+		TEST_FAIL();
+
+	// Load all ways.
+	GFXGltfResult result1, result2, result3;
+
+	int64_t start = gfx_time();
+	if (!load_gltf(path, &base, &result1))
+		TEST_FAIL();
+
+	const double time1 = elapsed_ms(start);
+
+	start = gfx_time();
+	if (!load_gltf(path, &processed, &result2))
+	{
+		gfx_release_gltf(&result1);
+		TEST_FAIL();
+	}
+
+	const double time2 = elapsed_ms(start);
+
+	if (!load_gltf(path, &quantized, &result3))
+	{
+		gfx_release_gltf(&result1);
+		gfx_release_gltf(&result2);
+		TEST_FAIL();
+	}
+
+	gfx_log_info(
+		"Loaded '%s':\n"
+		"    Default options: %.2f ms.\n"
+		"    Parallel & processed: %.2f ms.\n",
+		path, time1, time2);
+
+	// Processing should not change what is loaded.
+	bool success =
+		result1.numPrimitives == result2.numPrimitives &&
+		result1.numPrimitives == result3.numPrimitives &&
+		result1.numImages == result2.numImages &&
+		result1.numMaterials == result2.numMaterials;
+
+	for (size_t p = 0; success && p < result2.numPrimitives; ++p)
+		success = result2.primitives[p].primitive != NULL;
+
+	// Quantization should only lose precision as documented.
+	success = success && check_quantized(&result1, &result3);
+
+	gfx_release_gltf(&result1);
+	gfx_release_gltf(&result2);
+	gfx_release_gltf(&result3);
+
+	// Flush all memory writes.
+	if (!success || !gfx_heap_flush(t->heap))
+		TEST_FAIL();
+}
+
+
+/****************************
+ * Run the glTF processing test.
+ */
+TEST_MAIN(processing);